@@ -0,0 +1,9 @@
+/////////////////////////////////////////////////////////////////////////
+// This file is checked in as bxversion.h.in.  The configure script
+// substitutes variables and creates bxversion.h.
+/////////////////////////////////////////////////////////////////////////
+
+#define VERSION       "3.0.devel"
+#define VER_DEVFLAG   1
+#define REL_STRING    "Built from GitHub snapshot after release 3.0"
+#define REL_TIMESTAMP "Sun Feb 16 10:00:00 CET 2025"
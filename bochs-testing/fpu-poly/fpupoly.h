@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_FPU_POLY_TEST_H
+#define BX_FPU_POLY_TEST_H
+
+// Common definitions of polycmp and polybench. The cpu/fpu sources are
+// compiled twice, as is and with -DBX_SOFTFLOAT_ONLY_POLY and all their
+// global functions renamed to ref_*, see Makefile.
+
+#include "bochs.h"
+#include "fpu/softfloat-specialize.h"
+#include "fpu/fpu_trans.h"
+#include "fpu/control_w.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern int ref_fsincos(floatx80 a, floatx80 *sin_a, floatx80 *cos_a, softfloat_status_t &status);
+extern int ref_ftan(floatx80 &a, softfloat_status_t &status);
+extern floatx80 ref_f2xm1(floatx80 a, softfloat_status_t &status);
+extern floatx80 ref_fyl2x(floatx80 a, floatx80 b, softfloat_status_t &status);
+extern floatx80 ref_fyl2xp1(floatx80 a, floatx80 b, softfloat_status_t &status);
+extern floatx80 ref_fpatan(floatx80 a, floatx80 b, softfloat_status_t &status);
+
+extern float128_t EvalPoly(float128_t x, const float128_t *arr, int n, softfloat_status_t &status);
+extern float128_t OddPoly(float128_t x, const float128_t *arr, int n, softfloat_status_t &status);
+extern float128_t ref_EvalPoly(float128_t x, const float128_t *arr, int n, softfloat_status_t &status);
+extern float128_t ref_OddPoly(float128_t x, const float128_t *arr, int n, softfloat_status_t &status);
+
+static Bit64u seed = BX_CONST64(0x0123456789abcdef);
+
+// xorshift generator
+static Bit64u rand64(void)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  return seed;
+}
+
+BX_CPP_INLINE floatx80 make_floatx80(int sign, int exp, Bit64u sig)
+{
+  floatx80 r;
+  r.signExp = (sign << 15) | exp;
+  r.signif = sig;
+  return r;
+}
+
+// i387cw_to_softfloat_status_word() as called by the transcendental
+// instructions in cpu/fpu/fpu_trans.cc, they ignore the precision control
+static softfloat_status_t status_word(Bit16u cw)
+{
+  softfloat_status_t status;
+  memset(&status, 0, sizeof(status));
+
+  status.extF80_roundingPrecision = 80;
+  status.softfloat_roundingMode = (cw & FPU_CW_RC) >> 10;
+  status.softfloat_exceptionMasks = cw & FPU_CW_Exceptions_Mask;
+  return status;
+}
+
+enum {
+  FN_FSINCOS,
+  FN_FPTAN,
+  FN_F2XM1,
+  FN_FYL2X,
+  FN_FYL2XP1,
+  FN_FPATAN,
+  FN_FSIN_FCOS,
+  FN_COUNT
+};
+
+static const struct {
+  const char *name;
+  int min_exp, max_exp; // interesting exponent range of the first operand
+} functions[FN_COUNT] = {
+  { "fsincos",   0x3f80, 0x4040 },
+  { "fptan",     0x3f80, 0x4040 },
+  { "f2xm1",     0x3fa0, 0x3fff },
+  { "fyl2x",     0x3f00, 0x40ff },
+  { "fyl2xp1",   0x3fa0, 0x3ffe },
+  { "fpatan",    0x3f00, 0x40ff },
+  { "fsin/fcos", 0x3f80, 0x4040 }
+};
+
+struct fpu_result {
+  floatx80 r1, r2;
+  int rc;
+  int flags;
+};
+
+static fpu_result run_function(int fn, bool ref, floatx80 a, floatx80 b, Bit16u cw)
+{
+  softfloat_status_t status = status_word(cw);
+
+  fpu_result r;
+  memset(&r, 0, sizeof(r));
+
+  switch(fn) {
+    case FN_FSINCOS:
+      r.rc = ref ? ref_fsincos(a, &r.r1, &r.r2, status) : fsincos(a, &r.r1, &r.r2, status);
+      break;
+    case FN_FPTAN:
+      r.r1 = a;
+      r.rc = ref ? ref_ftan(r.r1, status) : ftan(r.r1, status);
+      break;
+    case FN_F2XM1:
+      r.r1 = ref ? ref_f2xm1(a, status) : f2xm1(a, status);
+      break;
+    case FN_FYL2X:
+      r.r1 = ref ? ref_fyl2x(a, b, status) : fyl2x(a, b, status);
+      break;
+    case FN_FYL2XP1:
+      r.r1 = ref ? ref_fyl2xp1(a, b, status) : fyl2xp1(a, b, status);
+      break;
+    case FN_FPATAN:
+      r.r1 = ref ? ref_fpatan(a, b, status) : fpatan(a, b, status);
+      break;
+    case FN_FSIN_FCOS:
+      {
+        softfloat_status_t status2 = status;
+        r.r1 = r.r2 = a;
+        r.rc = ref ? ref_fsincos(a, &r.r1, NULL, status) : fsincos(a, &r.r1, NULL, status);
+        r.rc |= (ref ? ref_fsincos(a, NULL, &r.r2, status2) : fsincos(a, NULL, &r.r2, status2)) << 4;
+        r.flags = status2.softfloat_exceptionFlags << 8;
+      }
+      break;
+  }
+
+  r.flags |= status.softfloat_exceptionFlags;
+  return r;
+}
+
+#endif
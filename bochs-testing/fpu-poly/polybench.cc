@@ -0,0 +1,73 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Timing of the x87 transcendental instructions with the fast float128
+// polynomial evaluation of cpu/fpu/poly.cc against the generic SoftFloat
+// one. See README for building.
+
+#include "fpupoly.h"
+
+#include <sys/time.h>
+
+#define OPERANDS 4096
+
+static double elapsed_ns(const struct timeval &start, const struct timeval &stop)
+{
+  return (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_usec - start.tv_usec) * 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long iterations = 1000000;
+  if (argc > 1) iterations = strtoul(argv[1], NULL, 0);
+
+  static floatx80 a[OPERANDS], b[OPERANDS];
+
+  for (int fn=0; fn < FN_COUNT; fn++) {
+    // normal operands in the range where the polynomial is evaluated
+    for (int n=0; n < OPERANDS; n++) {
+      int min_exp = functions[fn].min_exp, max_exp = functions[fn].max_exp;
+      int sign = (fn == FN_FYL2X) ? 0 : (rand64() & 1);
+      a[n] = make_floatx80(sign, min_exp + (int)(rand64() % (max_exp - min_exp + 1)), rand64() | BX_CONST64(0x8000000000000000));
+      b[n] = make_floatx80(rand64() & 1, 0x3fff + (int)(rand64() % 16), rand64() | BX_CONST64(0x8000000000000000));
+    }
+
+    double ns[2];
+    for (int ref=0; ref < 2; ref++) {
+      struct timeval start, stop;
+      Bit64u sum = 0;
+      gettimeofday(&start, NULL);
+      for (unsigned long n=0; n < iterations; n++) {
+        fpu_result r = run_function(fn, ref != 0, a[n % OPERANDS], b[n % OPERANDS], 0x037f);
+        sum += r.r1.signif;
+      }
+      gettimeofday(&stop, NULL);
+      ns[ref] = elapsed_ns(start, stop) / iterations;
+      // keep the results alive
+      if (sum == 1) printf("\n");
+    }
+
+    printf("%-10s softfloat %7.1f ns  fast %7.1f ns  speedup %.2fx\n", functions[fn].name, ns[1], ns[0], ns[1] / ns[0]);
+  }
+
+  return 0;
+}
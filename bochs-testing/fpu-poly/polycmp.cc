@@ -0,0 +1,183 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Differential test of the x87 transcendental instructions: the float128
+// polynomial evaluation in cpu/fpu/poly.cc uses a fast path with host
+// 128-bit integers that must give bit identical results to the generic
+// SoftFloat f128_mul / f128_mulAdd. Compares results, condition codes and
+// exception flags of both builds for random and edge case operands in all
+// rounding modes, and the polynomial evaluation itself with forced
+// cancellation. See README for building.
+
+#include "fpupoly.h"
+
+static unsigned long errors = 0;
+
+// random operand, mostly normal numbers in the interesting exponent range
+// of the function with a share of special encodings
+static floatx80 rand_operand(int min_exp, int max_exp)
+{
+  int sign = rand64() & 1;
+  Bit64u sig = rand64() | BX_CONST64(0x8000000000000000);
+
+  switch(rand64() % 64) {
+    case 0: // zero
+      return make_floatx80(sign, 0, 0);
+    case 1: // denormal or pseudo denormal
+      return make_floatx80(sign, 0, rand64() >> (rand64() % 64));
+    case 2: // infinity
+      return make_floatx80(sign, 0x7fff, BX_CONST64(0x8000000000000000));
+    case 3: // SNaN or QNaN
+      return make_floatx80(sign, 0x7fff, sig | ((rand64() & 1) ? BX_CONST64(0x4000000000000000) : 0));
+    case 4: // unnormal
+      return make_floatx80(sign, rand64() & 0x7fff, rand64() & BX_CONST64(0x7fffffffffffffff));
+    case 5: // any exponent
+      return make_floatx80(sign, rand64() % 0x7fff, sig);
+    case 6: // close to 1.0
+      return make_floatx80(sign, 0x3fff + (int)(rand64() % 3) - 1, BX_CONST64(0x8000000000000000) + (rand64() % 5) - 2);
+    case 7: // close to multiples of pi/4
+      return make_floatx80(sign, 0x3ffe + (int)(rand64() % 8), BX_CONST64(0xc90fdaa22168c234) + (rand64() % 9) - 4);
+    case 8: // argument reduction limit
+      return make_floatx80(sign, 0x403d + (int)(rand64() % 3) - 1, sig);
+    default:
+      return make_floatx80(sign, min_exp + (int)(rand64() % (max_exp - min_exp + 1)), sig);
+  }
+}
+
+static bool same_result(const fpu_result &r1, const fpu_result &r2)
+{
+  return r1.r1.signExp == r2.r1.signExp && r1.r1.signif == r2.r1.signif &&
+         r1.r2.signExp == r2.r2.signExp && r1.r2.signif == r2.r2.signif &&
+         r1.rc == r2.rc && r1.flags == r2.flags;
+}
+
+static void test_function(int fn, unsigned long vectors)
+{
+  for (unsigned long n=0; n < vectors; n++) {
+    floatx80 a = rand_operand(functions[fn].min_exp, functions[fn].max_exp);
+    floatx80 b = rand_operand(0x3f00, 0x40ff);
+    // all rounding modes, exceptions masked or unmasked
+    Bit16u cw = (rand64() & FPU_CW_RC) | ((rand64() & 1) ? FPU_CW_Exceptions_Mask : 0x20);
+
+    fpu_result r1 = run_function(fn, true, a, b, cw);
+    fpu_result r2 = run_function(fn, false, a, b, cw);
+    if (! same_result(r1, r2)) {
+      if (errors++ < 20) {
+        printf("%s: cw=%04x a=%04x:%016llx b=%04x:%016llx\n", functions[fn].name, cw,
+          a.signExp, (unsigned long long) a.signif, b.signExp, (unsigned long long) b.signif);
+        printf("  softfloat: %04x:%016llx %04x:%016llx rc=%d flags=%04x\n",
+          r1.r1.signExp, (unsigned long long) r1.r1.signif, r1.r2.signExp, (unsigned long long) r1.r2.signif, r1.rc, r1.flags);
+        printf("  fast:      %04x:%016llx %04x:%016llx rc=%d flags=%04x\n",
+          r2.r1.signExp, (unsigned long long) r2.r1.signif, r2.r2.signExp, (unsigned long long) r2.r2.signif, r2.rc, r2.flags);
+      }
+    }
+  }
+}
+
+static float128_t rand_float128(int min_exp, int exp_range)
+{
+  float128_t a;
+  a.v0 = rand64();
+  a.v64 = (rand64() & BX_CONST64(0x8000ffffffffffff)) | ((Bit64u)(min_exp + (int)(rand64() % exp_range)) << 48);
+
+  // short significands give exact products
+  switch(rand64() % 16) {
+    case 0:
+      a.v0 = 0;
+      break;
+    case 1:
+      a.v0 = 0;
+      a.v64 &= BX_CONST64(0xffffff0000000000);
+      break;
+    case 2:
+      a.v0 |= 0xffffffff;
+      break;
+  }
+
+  return a;
+}
+
+// single multiply-add step c + a*x of EvalPoly and the final multiply of
+// OddPoly, including exact and nearly exact cancellation
+static void test_poly(unsigned long vectors)
+{
+  for (unsigned long n=0; n < vectors; n++) {
+    float128_t arr[2], x;
+    int range = (n & 1) ? 8 : 300;
+    x = rand_float128(0x3fff - range/2, range);
+    arr[1] = rand_float128(0x3fff - range/2, range);
+    arr[0] = rand_float128(0x3fff - 150 + (int)(rand64() % 300) - range/2, range);
+    if (rand64() % 4 == 0)
+      arr[0].v64 ^= BX_CONST64(0x8000000000000000);
+    if (rand64() % 8 == 0) {
+      softfloat_status_t status;
+      memset(&status, 0, sizeof(status));
+      arr[0] = f128_mul(arr[1], x, &status);
+      arr[0].v64 ^= BX_CONST64(0x8000000000000000);
+      arr[0].v0 += (rand64() % 5) - 2;
+    }
+
+    softfloat_status_t status1, status2;
+    memset(&status1, 0, sizeof(status1));
+    status1.softfloat_roundingMode = rand64() % 5;
+    status2 = status1;
+
+    float128_t r1, r2;
+    if (n & 2) {
+      r1 = ref_EvalPoly(x, arr, 2, status1);
+      r2 = EvalPoly(x, arr, 2, status2);
+    }
+    else {
+      r1 = ref_OddPoly(x, arr, 2, status1);
+      r2 = OddPoly(x, arr, 2, status2);
+    }
+
+    if (r1.v64 != r2.v64 || r1.v0 != r2.v0 || status1.softfloat_exceptionFlags != status2.softfloat_exceptionFlags) {
+      if (errors++ < 20) {
+        printf("%s: rm=%d x=%016llx:%016llx a=%016llx:%016llx c=%016llx:%016llx\n", (n & 2) ? "EvalPoly" : "OddPoly",
+          status1.softfloat_roundingMode, (unsigned long long) x.v64, (unsigned long long) x.v0,
+          (unsigned long long) arr[1].v64, (unsigned long long) arr[1].v0, (unsigned long long) arr[0].v64, (unsigned long long) arr[0].v0);
+        printf("  softfloat: %016llx:%016llx flags=%02x\n", (unsigned long long) r1.v64, (unsigned long long) r1.v0, status1.softfloat_exceptionFlags);
+        printf("  fast:      %016llx:%016llx flags=%02x\n", (unsigned long long) r2.v64, (unsigned long long) r2.v0, status2.softfloat_exceptionFlags);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  unsigned long vectors = 1000000;
+  if (argc > 1) vectors = strtoul(argv[1], NULL, 0);
+  if (argc > 2) seed = strtoull(argv[2], NULL, 0);
+
+  for (int fn=0; fn < FN_COUNT; fn++) {
+    unsigned long before = errors;
+    test_function(fn, vectors);
+    printf("%-10s %lu vectors: %s\n", functions[fn].name, vectors, (errors == before) ? "ok" : "FAILED");
+  }
+
+  unsigned long before = errors;
+  test_poly(vectors);
+  printf("%-10s %lu vectors: %s\n", "poly", vectors, (errors == before) ? "ok" : "FAILED");
+
+  return (errors != 0);
+}
@@ -0,0 +1,6 @@
+/*
+ * Builds with a single CPU reference the global CPU object from the
+ * instruction handlers included into hostcmp.cc. They are never called,
+ * the symbol only has to exist.
+ */
+char bx_cpu[1];
@@ -0,0 +1,223 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Compare the host CPU extension helpers of the instruction emulation
+// (cpu/hostcpu.h) with their portable implementation on random vectors.
+// The emulator itself only runs a known answer test at startup.
+//
+// The helper sources are included directly, so that the file static host
+// and portable functions can be called. See README for building.
+
+#include "cpu/aes.cc"
+#undef LOG_THIS
+#include "cpu/crc32.cc"
+#undef LOG_THIS
+#include "cpu/sha.cc"
+#undef LOG_THIS
+#include "cpu/hostcpu.cc"
+#include "cpu/simd_int.h"
+
+#include <stdlib.h>
+
+// the instruction handlers in the included files are never called
+logfunctions *genlog = NULL;
+void logfunctions::info(const char *fmt, ...) {}
+void logfunctions::error(const char *fmt, ...) {}
+#if BX_INSTRUMENTATION
+void bx_instr_before_execution(unsigned cpu, bxInstruction_c *i) {}
+void bx_instr_after_execution(unsigned cpu, bxInstruction_c *i) {}
+#endif
+
+static Bit64u seed = BX_CONST64(0x9e3779b97f4a7c15);
+
+// xorshift generator
+static Bit64u rand64(void)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  return seed;
+}
+
+static void rand_xmm(BxPackedXmmRegister *r)
+{
+  r->xmm64u(0) = rand64();
+  r->xmm64u(1) = rand64();
+}
+
+static unsigned errors = 0;
+
+static void compare(const char *name, unsigned n, const BxPackedXmmRegister *host, const BxPackedXmmRegister *portable)
+{
+  if (host->xmm64u(0) == portable->xmm64u(0) && host->xmm64u(1) == portable->xmm64u(1))
+    return;
+  if (errors++ < 10) {
+    printf("%s: vector %u: host %016llx%016llx portable %016llx%016llx\n", name, n,
+      (unsigned long long) host->xmm64u(1), (unsigned long long) host->xmm64u(0),
+      (unsigned long long) portable->xmm64u(1), (unsigned long long) portable->xmm64u(0));
+  }
+}
+
+static void compare32(const char *name, unsigned n, Bit32u host, Bit32u portable)
+{
+  if (host == portable)
+    return;
+  if (errors++ < 10) {
+    printf("%s: vector %u: host %08x portable %08x\n", name, n, host, portable);
+  }
+}
+
+static void test_aes(unsigned vectors)
+{
+  for (unsigned n=0; n < vectors; n++) {
+    BxPackedXmmRegister op1, op2, r1, r2;
+    rand_xmm(&op1);
+    rand_xmm(&op2);
+
+    r1 = op1; host_aesenc(&r1, &op2);
+    r2 = op1; xmm_aesenc_portable(&r2, &op2);
+    compare("AESENC", n, &r1, &r2);
+
+    r1 = op1; host_aesenclast(&r1, &op2);
+    r2 = op1; xmm_aesenclast_portable(&r2, &op2);
+    compare("AESENCLAST", n, &r1, &r2);
+
+    r1 = op1; host_aesdec(&r1, &op2);
+    r2 = op1; xmm_aesdec_portable(&r2, &op2);
+    compare("AESDEC", n, &r1, &r2);
+
+    r1 = op1; host_aesdeclast(&r1, &op2);
+    r2 = op1; xmm_aesdeclast_portable(&r2, &op2);
+    compare("AESDECLAST", n, &r1, &r2);
+
+    r1 = op1; host_aesimc(&r1);
+    r2 = op1; AES_InverseMixColumns(r2);
+    compare("AESIMC", n, &r1, &r2);
+
+    Bit32u rcon32 = op2.xmmubyte(n & 0xf);
+    host_aeskeygenassist(&r1, &op1, rcon32);
+    xmm_aeskeygenassist_portable(&r2, &op1, rcon32);
+    compare("AESKEYGENASSIST", n, &r1, &r2);
+  }
+}
+
+static void test_pclmul(unsigned vectors)
+{
+  for (unsigned n=0; n < vectors; n++) {
+    BxPackedXmmRegister r1, r2;
+    Bit64u a = rand64(), b = rand64();
+    // exercise the early exit of the portable loop as well
+    if (n & 1) b >>= (n % 64);
+
+    host_pclmulqdq(&r1, a, b);
+    xmm_pclmulqdq_portable(&r2, a, b);
+    compare("PCLMULQDQ", n, &r1, &r2);
+  }
+}
+
+static void test_crc32(unsigned vectors)
+{
+  for (unsigned n=0; n < vectors; n++) {
+    Bit64u val = rand64();
+    Bit32u crc = (Bit32u)(val >> 32), data = (Bit32u) val;
+
+    compare32("CRC32 (8-bit)", n, host_crc32_u8(crc, data & 0xff), crc32_u8_portable(crc, data & 0xff));
+    compare32("CRC32 (16-bit)", n, host_crc32_u16(crc, data & 0xffff), crc32_u16_portable(crc, data & 0xffff));
+    compare32("CRC32 (32-bit)", n, host_crc32_u32(crc, data), crc32_u32_portable(crc, data));
+  }
+}
+
+static void test_sha(unsigned vectors)
+{
+  for (unsigned n=0; n < vectors; n++) {
+    BxPackedXmmRegister op1, op2, wk, r1, r2;
+    rand_xmm(&op1);
+    rand_xmm(&op2);
+    rand_xmm(&wk);
+
+    r1 = op1; host_sha256rnds2(&r1, &op2, &wk);
+    r2 = op1; sha256rnds2_portable(&r2, &op2, &wk);
+    compare("SHA256RNDS2", n, &r1, &r2);
+
+    r1 = op1; host_sha1rnds4(&r1, &op2, n & 0x3);
+    r2 = op1; sha1rnds4_portable(&r2, &op2, n & 0x3);
+    compare("SHA1RNDS4", n, &r1, &r2);
+  }
+}
+
+// simd_int.h takes the portable path, all host features are cleared
+static void test_ssse3(unsigned vectors)
+{
+  for (unsigned n=0; n < vectors; n++) {
+    BxPackedXmmRegister op1, op2, r1, r2;
+    rand_xmm(&op1);
+    rand_xmm(&op2);
+
+    host_xmm_pshufb(&r1, &op1, &op2);
+    xmm_pshufb(&r2, &op1, &op2);
+    compare("PSHUFB", n, &r1, &r2);
+
+    r1 = op1; host_xmm_pmaddubsw(&r1, &op2);
+    r2 = op1; xmm_pmaddubsw(&r2, &op2);
+    compare("PMADDUBSW", n, &r1, &r2);
+
+    r1 = op1; host_xmm_pmulhrsw(&r1, &op2);
+    r2 = op1; xmm_pmulhrsw(&r2, &op2);
+    compare("PMULHRSW", n, &r1, &r2);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  static const struct {
+    Bit32u feature;
+    const char *name;
+    void (*test)(unsigned vectors);
+  } tests[] = {
+    { BX_HOST_CPU_SSSE3,  "SSSE3",     test_ssse3  },
+    { BX_HOST_CPU_SSE4_2, "CRC32",     test_crc32  },
+    { BX_HOST_CPU_AES,    "AES-NI",    test_aes    },
+    { BX_HOST_CPU_PCLMUL, "PCLMULQDQ", test_pclmul },
+    { BX_HOST_CPU_SHA,    "SHA",       test_sha    }
+  };
+  unsigned vectors = 1000000;
+
+  if (argc > 1) vectors = strtoul(argv[1], NULL, 0);
+  if (argc > 2) seed = strtoull(argv[2], NULL, 0);
+
+  // detects the host extensions and runs the startup known answer tests
+  bx_init_host_cpu_features();
+  Bit32u features = bx_host_cpu_features;
+  bx_host_cpu_features = 0;
+
+  for (unsigned n=0; n < sizeof(tests) / sizeof(tests[0]); n++) {
+    if (! (features & tests[n].feature)) {
+      printf("%-10s not supported by the host or failed the known answer test\n", tests[n].name);
+      continue;
+    }
+    unsigned before = errors;
+    tests[n].test(vectors);
+    printf("%-10s %u vectors: %s\n", tests[n].name, vectors, (errors == before) ? "ok" : "FAILED");
+  }
+
+  return (errors != 0);
+}
@@ -303,6 +303,10 @@ int bx_gdbstub_check(Bit64u eip);
 #endif
 #endif
 
+// sampling guest profiler (profiler.cc)
+void bx_profiler_init(void);
+void bx_profiler_exit(void);
+
 typedef struct {
   bool interrupts;
   bool exceptions;
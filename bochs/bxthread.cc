@@ -19,7 +19,12 @@
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
 /////////////////////////////////////////////////////////////////////////
 
+#ifdef BXIMAGE
+#include "config.h"
+#include "misc/bxcompat.h"
+#else
 #include "bochs.h"
+#endif
 #include "bxthread.h"
 
 // Bochs multi-threading support
@@ -100,6 +105,34 @@ void BOCHSAPI_MSVCONLY bx_wait_sem(bx_thread_sem_t *thread_sem)
 #endif
 }
 
+// returns 0 if the timeout has expired
+bool BOCHSAPI_MSVCONLY bx_wait_sem_timeout(bx_thread_sem_t *thread_sem, unsigned msec)
+{
+#if defined(WIN32)
+  return (WaitForSingleObject(thread_sem->sem, msec) == WAIT_OBJECT_0);
+#elif defined(__APPLE__)
+  // sem_timedwait() is not available
+  while (sem_trywait(&thread_sem->sem) != 0) {
+    if (msec-- == 0) return 0;
+    BX_MSLEEP(1);
+  }
+  return 1;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += msec / 1000;
+  ts.tv_nsec += (msec % 1000) * 1000000;
+  if (ts.tv_nsec >= 1000000000) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000;
+  }
+  while (sem_timedwait(&thread_sem->sem, &ts) != 0) {
+    if (errno != EINTR) return 0;
+  }
+  return 1;
+#endif
+}
+
 void BOCHSAPI_MSVCONLY bx_set_sem(bx_thread_sem_t *thread_sem)
 {
 #if defined(WIN32)
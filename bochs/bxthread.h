@@ -38,6 +38,7 @@
 #define BX_INIT_MUTEX(mutex) InitializeCriticalSection(&(mutex))
 #define BX_FINI_MUTEX(mutex) DeleteCriticalSection(&(mutex))
 #define BX_MSLEEP(val) Sleep(val)
+#define BX_MEMORY_BARRIER() MemoryBarrier()
 
 #else
 
@@ -57,6 +58,7 @@
 #define BX_INIT_MUTEX(mutex) pthread_mutex_init(&(mutex),NULL)
 #define BX_FINI_MUTEX(mutex) pthread_mutex_destroy(&(mutex))
 #define BX_MSLEEP(val) usleep(val*1000)
+#define BX_MEMORY_BARRIER() __sync_synchronize()
 
 #endif
 
@@ -86,6 +88,7 @@ bool BOCHSAPI_MSVCONLY bx_wait_for_event(bx_thread_event_t *thread_ev);
 bool BOCHSAPI_MSVCONLY bx_create_sem(bx_thread_sem_t *thread_sem);
 void BOCHSAPI_MSVCONLY bx_destroy_sem(bx_thread_sem_t *thread_sem);
 void BOCHSAPI_MSVCONLY bx_wait_sem(bx_thread_sem_t *thread_sem);
+bool BOCHSAPI_MSVCONLY bx_wait_sem_timeout(bx_thread_sem_t *thread_sem, unsigned msec);
 void BOCHSAPI_MSVCONLY bx_set_sem(bx_thread_sem_t *thread_sem);
 
 #endif
@@ -735,6 +735,13 @@ void bx_init_options()
       4, 8192,
       128);
   mem_block_size->set_ask_format("Enter memory block size (KB): [%d] ");
+
+  path = new bx_param_filename_c(ram,
+      "file",
+      "RAM backing file",
+      "Pathname of a file to map the guest RAM from (e.g. on hugetlbfs)",
+      "", BX_PATHNAME_LEN);
+  path->set_ask_format("Enter RAM backing file: [%s] ");
   ram->set_options(ram->SERIES_ASK);
 
   path = new bx_param_filename_c(rom,
@@ -1631,6 +1638,65 @@ void bx_init_options()
       0);
 #endif
 
+#if BX_RUNTIME_INSTRUMENTATION
+  // runtime instrumentation module
+  menu = new bx_list_c(misc, "instrument", "Instrumentation Module");
+  menu->set_options(menu->SHOW_PARENT);
+  path = new bx_param_filename_c(menu,
+      "module",
+      "Instrumentation module",
+      "Pathname of the instrumentation module attached at startup",
+      "", BX_PATHNAME_LEN);
+  path->set_ask_format("Enter instrumentation module: [%s] ");
+  new bx_param_string_c(menu,
+      "options",
+      "Module options",
+      "Options passed to the instrumentation module",
+      "", BX_PATHNAME_LEN);
+#endif
+
+  // sampling guest profiler
+  static const char *profiler_format_names[] = { "folded", "perf", NULL };
+  menu = new bx_list_c(misc, "profiler", "Guest Profiler Options");
+  menu->set_options(menu->SHOW_PARENT | menu->USE_BOX_TITLE);
+  enabled = new bx_param_bool_c(menu,
+    "enabled",
+    "Enable guest profiler",
+    "Sample the guest instruction pointer and call stack",
+    0);
+  path = new bx_param_filename_c(menu,
+    "file",
+    "Profile output file",
+    "Pathname of the file the samples are written to",
+    "bochsprof.txt", BX_PATHNAME_LEN);
+  path->set_ask_format("Enter profile output file: [%s] ");
+  new bx_param_enum_c(menu,
+    "format",
+    "Output format",
+    "Folded stacks (flamegraph) or 'perf script' text",
+    profiler_format_names,
+    0,
+    0);
+  new bx_param_num_c(menu,
+    "period",
+    "Sampling period",
+    "Number of instructions between samples",
+    1000, BX_MAX_BIT32U,
+    100000);
+  new bx_param_num_c(menu,
+    "depth",
+    "Stack depth",
+    "Maximum number of frame pointer frames unwound per sample (0 = none)",
+    0, 64,
+    32);
+  path = new bx_param_filename_c(menu,
+    "symbols",
+    "Symbol files",
+    "System.map or ELF files used for symbolization, separated by ';'",
+    "", BX_PATHNAME_LEN);
+  path->set_ask_format("Enter symbol files: [%s] ");
+  enabled->set_dependent_list(menu->clone());
+
   // GDB stub
   menu = new bx_list_c(misc, "gdbstub", "GDB Stub Options");
   menu->set_options(menu->SHOW_PARENT | menu->USE_BOX_TITLE);
@@ -3205,6 +3271,22 @@ static int parse_line_formatted(const char *context, int num_params, char *param
         PARSE_ERR(("%s: port_e9_hack directive malformed.", context));
       }
     }
+  } else if (!strcmp(params[0], "instrument")) {
+#if BX_RUNTIME_INSTRUMENTATION
+    for (i=1; i<num_params; i++) {
+      if (bx_parse_param_from_list(context, params[i], (bx_list_c*) SIM->get_param(BXPN_INSTRUMENT)) < 0) {
+        PARSE_ERR(("%s: instrument directive malformed.", context));
+      }
+    }
+#else
+    PARSE_WARN(("%s: Bochs is not compiled with runtime instrumentation support", context));
+#endif
+  } else if (!strcmp(params[0], "profiler")) {
+    for (i=1; i<num_params; i++) {
+      if (bx_parse_param_from_list(context, params[i], (bx_list_c*) SIM->get_param(BXPN_PROFILER)) < 0) {
+        PARSE_ERR(("%s: profiler directive malformed.", context));
+      }
+    }
   } else if (!strcmp(params[0], "iodebug")) {
 #if BX_SUPPORT_IODEBUG
     if (num_params != 2) {
@@ -3603,6 +3685,14 @@ int bx_write_configuration(const char *rc, int overwrite)
 #if BX_SUPPORT_IODEBUG
   fprintf(fp, "iodebug: all_rings=%d\n", SIM->get_param_bool(BXPN_IODEBUG_ALL_RINGS)->get());
 #endif
+#if BX_RUNTIME_INSTRUMENTATION
+  if (!SIM->get_param_string(BXPN_INSTRUMENT_MODULE)->isempty()) {
+    bx_write_param_list(fp, (bx_list_c*) SIM->get_param(BXPN_INSTRUMENT), NULL, 0);
+  }
+#endif
+  if (SIM->get_param_bool(BXPN_PROFILER_ENABLED)->get()) {
+    bx_write_param_list(fp, (bx_list_c*) SIM->get_param(BXPN_PROFILER), NULL, 0);
+  }
   fprintf(fp, "private_colormap: enabled=%d\n", SIM->get_param_bool(BXPN_PRIVATE_COLORMAP)->get());
 #if BX_WITH_AMIGAOS
   fprintf(fp, "fullscreen: enabled=%d\n", SIM->get_param_bool(BXPN_FULLSCREEN)->get());
@@ -29,6 +29,7 @@
 #if BX_CPU_LEVEL >= 6
 
 #include "simd_int.h"
+#include "hostcpu.h"
 
 //
 // XMM - Byte Representation of a 128-bit AES State
@@ -289,12 +290,234 @@ BX_CPP_INLINE Bit32u AES_RotWord(Bit32u x)
   return (x >> 8) | (x << 24);
 }
 
+static void xmm_aesenc_portable(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  AES_ShiftRows(*op1);
+  AES_SubstituteBytes(*op1);
+  AES_MixColumns(*op1);
+
+  xmm_xorps(op1, op2);
+}
+
+static void xmm_aesenclast_portable(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  AES_ShiftRows(*op1);
+  AES_SubstituteBytes(*op1);
+
+  xmm_xorps(op1, op2);
+}
+
+static void xmm_aesdec_portable(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  AES_InverseShiftRows(*op1);
+  AES_InverseSubstituteBytes(*op1);
+  AES_InverseMixColumns(*op1);
+
+  xmm_xorps(op1, op2);
+}
+
+static void xmm_aesdeclast_portable(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  AES_InverseShiftRows(*op1);
+  AES_InverseSubstituteBytes(*op1);
+
+  xmm_xorps(op1, op2);
+}
+
+static void xmm_aeskeygenassist_portable(BxPackedXmmRegister *r, const BxPackedXmmRegister *op, Bit32u rcon32)
+{
+  r->xmm32u(0) = AES_SubWord(op->xmm32u(1));
+  r->xmm32u(1) = AES_RotWord(r->xmm32u(0)) ^ rcon32;
+  r->xmm32u(2) = AES_SubWord(op->xmm32u(3));
+  r->xmm32u(3) = AES_RotWord(r->xmm32u(2)) ^ rcon32;
+}
+
+static void xmm_pclmulqdq_portable(BxPackedXmmRegister *r, Bit64u a, Bit64u b)
+{
+  BxPackedXmmRegister tmp;
+
+  tmp.xmm64u(0) = a;
+  tmp.xmm64u(1) = 0;
+
+  r->clear();
+
+  for (unsigned n = 0; b && n < 64; n++) {
+      if (b & 1) {
+          xmm_xorps(r, &tmp);
+      }
+      tmp.xmm64u(1) = (tmp.xmm64u(1) << 1) | (tmp.xmm64u(0) >> 63);
+      tmp.xmm64u(0) <<= 1;
+      b >>= 1;
+  }
+}
+
+#if BX_HAVE_X86_INTRINSICS
+
+BX_HOST_TARGET("aes") static void host_aesenc(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_STORE(op1, _mm_aesenc_si128(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2)));
+}
+
+BX_HOST_TARGET("aes") static void host_aesenclast(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_STORE(op1, _mm_aesenclast_si128(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2)));
+}
+
+BX_HOST_TARGET("aes") static void host_aesdec(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_STORE(op1, _mm_aesdec_si128(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2)));
+}
+
+BX_HOST_TARGET("aes") static void host_aesdeclast(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_STORE(op1, _mm_aesdeclast_si128(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2)));
+}
+
+BX_HOST_TARGET("aes") static void host_aesimc(BxPackedXmmRegister *op)
+{
+  BX_HOST_XMM_STORE(op, _mm_aesimc_si128(BX_HOST_XMM_LOAD(op)));
+}
+
+// the round constant is an immediate of the host instruction, apply it separately
+BX_HOST_TARGET("aes") static void host_aeskeygenassist(BxPackedXmmRegister *r, const BxPackedXmmRegister *op, Bit32u rcon32)
+{
+  __m128i tmp = _mm_aeskeygenassist_si128(BX_HOST_XMM_LOAD(op), 0);
+  BX_HOST_XMM_STORE(r, _mm_xor_si128(tmp, _mm_set_epi32(rcon32, 0, rcon32, 0)));
+}
+
+BX_HOST_TARGET("pclmul") static void host_pclmulqdq(BxPackedXmmRegister *r, Bit64u a, Bit64u b)
+{
+  __m128i tmp = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long) a), _mm_set_epi64x(0, (long long) b), 0x00);
+  BX_HOST_XMM_STORE(r, tmp);
+}
+
+bool bx_host_aes_selftest(void)
+{
+  BxPackedXmmRegister state, key, r;
+  bx_host_selftest_input(&state, &key);
+
+  r = state; host_aesenc(&r, &key);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0xa8311c2f9fdba3c5), BX_CONST64(0x8b104b58ded7e595)))
+    return false;
+
+  r = state; host_aesenclast(&r, &key);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0xc7fb881e938c5964), BX_CONST64(0x177ec42553fdc611)))
+    return false;
+
+  r = state; host_aesdec(&r, &key);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0x138ac342faea2787), BX_CONST64(0xb58eb95eb730392a)))
+    return false;
+
+  r = state; host_aesdeclast(&r, &key);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0xc5a391ef6b317f95), BX_CONST64(0xd410637b72a593d0)))
+    return false;
+
+  r = key; host_aesimc(&r);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0x597f8df109efaa15), BX_CONST64(0xf39bc5a119d859b6)))
+    return false;
+
+  // AESKEYGENASSIST example of the white paper
+  key.xmm64u(1) = BX_CONST64(0x3c4fcf098815f7ab);
+  key.xmm64u(0) = BX_CONST64(0xa6d2ae2816157e2b);
+  host_aeskeygenassist(&r, &key, 0x01);
+  return bx_host_selftest_expect(&r, BX_CONST64(0x01eb848beb848a01), BX_CONST64(0x3424b5e524b5e434));
+}
+
+bool bx_host_pclmul_selftest(void)
+{
+  BxPackedXmmRegister r;
+
+  host_pclmulqdq(&r, BX_CONST64(0x7b5b546573745665), BX_CONST64(0x4869285368617929));
+  return bx_host_selftest_expect(&r, BX_CONST64(0x1d1e1f2c592e7c45), BX_CONST64(0xd66ee03e410fd4ed));
+}
+
+#endif // BX_HAVE_X86_INTRINSICS
+
+// AES round helpers: op1 = AES round(op1) XOR op2
+
+BX_CPP_INLINE void xmm_aesenc(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_AES)) {
+    host_aesenc(op1, op2);
+    return;
+  }
+#endif
+  xmm_aesenc_portable(op1, op2);
+}
+
+BX_CPP_INLINE void xmm_aesenclast(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_AES)) {
+    host_aesenclast(op1, op2);
+    return;
+  }
+#endif
+  xmm_aesenclast_portable(op1, op2);
+}
+
+BX_CPP_INLINE void xmm_aesdec(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_AES)) {
+    host_aesdec(op1, op2);
+    return;
+  }
+#endif
+  xmm_aesdec_portable(op1, op2);
+}
+
+BX_CPP_INLINE void xmm_aesdeclast(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_AES)) {
+    host_aesdeclast(op1, op2);
+    return;
+  }
+#endif
+  xmm_aesdeclast_portable(op1, op2);
+}
+
+BX_CPP_INLINE void xmm_aesimc(BxPackedXmmRegister *op)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_AES)) {
+    host_aesimc(op);
+    return;
+  }
+#endif
+  AES_InverseMixColumns(*op);
+}
+
+BX_CPP_INLINE void xmm_aeskeygenassist(BxPackedXmmRegister *r, const BxPackedXmmRegister *op, Bit32u rcon32)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_AES)) {
+    host_aeskeygenassist(r, op, rcon32);
+    return;
+  }
+#endif
+  xmm_aeskeygenassist_portable(r, op, rcon32);
+}
+
+BX_CPP_INLINE void xmm_pclmulqdq(BxPackedXmmRegister *r, Bit64u a, Bit64u b)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_PCLMUL)) {
+    host_pclmulqdq(r, a, b);
+    return;
+  }
+#endif
+  xmm_pclmulqdq_portable(r, a, b);
+}
+
 /* 66 0F 38 DB */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESIMC_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op = BX_READ_XMM_REG(i->src());
 
-  AES_InverseMixColumns(op);
+  xmm_aesimc(&op);
 
   BX_WRITE_XMM_REGZ(i->dst(), op, i->getVL());
 
@@ -306,11 +529,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESENC_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_ShiftRows(op1);
-  AES_SubstituteBytes(op1);
-  AES_MixColumns(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesenc(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -324,11 +543,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESENC_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_ShiftRows(op1.vmm128(n));
-    AES_SubstituteBytes(op1.vmm128(n));
-    AES_MixColumns(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesenc(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -342,10 +557,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESENCLAST_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_ShiftRows(op1);
-  AES_SubstituteBytes(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesenclast(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -359,10 +571,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESENCLAST_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_ShiftRows(op1.vmm128(n));
-    AES_SubstituteBytes(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesenclast(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -376,11 +585,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESDEC_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_InverseShiftRows(op1);
-  AES_InverseSubstituteBytes(op1);
-  AES_InverseMixColumns(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesdec(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -394,11 +599,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESDEC_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_InverseShiftRows(op1.vmm128(n));
-    AES_InverseSubstituteBytes(op1.vmm128(n));
-    AES_InverseMixColumns(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesdec(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -412,10 +613,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESDECLAST_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
 
-  AES_InverseShiftRows(op1);
-  AES_InverseSubstituteBytes(op1);
-
-  xmm_xorps(&op1, &op2);
+  xmm_aesdeclast(&op1, &op2);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -429,10 +627,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VAESDECLAST_VdqHdqWdqR(bxInstruction_c *i)
   unsigned len = i->getVL();
 
   for (unsigned n=0; n < len; n++) {
-    AES_InverseShiftRows(op1.vmm128(n));
-    AES_InverseSubstituteBytes(op1.vmm128(n));
-
-    xmm_xorps(&op1.vmm128(n), &op2.vmm128(n));
+    xmm_aesdeclast(&op1.vmm128(n), &op2.vmm128(n));
   }
 
   BX_WRITE_AVX_REGZ(i->dst(), op1, len);
@@ -448,35 +643,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AESKEYGENASSIST_VdqWdqIbR(bxInstruction_c
 
   Bit32u rcon32 = i->Ib();
 
-  result.xmm32u(0) = AES_SubWord(op.xmm32u(1));
-  result.xmm32u(1) = AES_RotWord(result.xmm32u(0)) ^ rcon32;
-  result.xmm32u(2) = AES_SubWord(op.xmm32u(3));
-  result.xmm32u(3) = AES_RotWord(result.xmm32u(2)) ^ rcon32;
+  xmm_aeskeygenassist(&result, &op, rcon32);
 
   BX_WRITE_XMM_REGZ(i->dst(), result, i->getVL());
 
   BX_NEXT_INSTR(i);
 }
 
-BX_CPP_INLINE void xmm_pclmulqdq(BxPackedXmmRegister *r, Bit64u a, Bit64u b)
-{
-  BxPackedXmmRegister tmp;
-
-  tmp.xmm64u(0) = a;
-  tmp.xmm64u(1) = 0;
-
-  r->clear();
-
-  for (unsigned n = 0; b && n < 64; n++) {
-      if (b & 1) {
-          xmm_xorps(r, &tmp);
-      }
-      tmp.xmm64u(1) = (tmp.xmm64u(1) << 1) | (tmp.xmm64u(0) >> 63);
-      tmp.xmm64u(0) <<= 1;
-      b >>= 1;
-  }
-}
-
 /* 66 0F 3A 44 */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::PCLMULQDQ_VdqWdqIbR(bxInstruction_c *i)
 {
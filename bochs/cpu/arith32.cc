@@ -33,6 +33,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u erx = ++BX_READ_32BIT_REG(i->dst());
+  BX_CLEAR_64BIT_HIGH(i->dst());
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAP_ADD_32(erx - 1, 0, erx));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR(bxInstruction_c *i)
 {
   Bit32u erx = --BX_READ_32BIT_REG(i->dst());
@@ -42,6 +50,14 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u erx = --BX_READ_32BIT_REG(i->dst());
+  BX_CLEAR_64BIT_HIGH(i->dst());
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAP_SUB_32(erx + 1, 0, erx));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdGdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, sum_32;
@@ -73,6 +89,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32, sum_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  op2_32 = BX_READ_32BIT_REG(i->src());
+  sum_32 = op1_32 + op2_32;
+
+  BX_WRITE_32BIT_REGZ(i->dst(), sum_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GdEdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, sum_32;
@@ -240,6 +269,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32, diff_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  op2_32 = BX_READ_32BIT_REG(i->src());
+  diff_32 = op1_32 - op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), diff_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GdEdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, diff_32;
@@ -403,6 +444,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32, sum_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  op2_32 = i->Id();
+  sum_32 = op1_32 + op2_32;
+
+  BX_WRITE_32BIT_REGZ(i->dst(), sum_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADC_EdIdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32 = i->Id(), sum_32, temp_CF = getB_CF();
@@ -459,6 +513,17 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EdIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32 = i->Id(), diff_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  diff_32 = op1_32 - op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), diff_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EdIdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32, diff_32;
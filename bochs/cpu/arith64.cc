@@ -57,6 +57,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64, sum_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = BX_READ_64BIT_REG(i->src());
+  sum_64 = op1_64 + op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), sum_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_GqEqM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, sum_64;
@@ -234,6 +246,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64, diff_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = BX_READ_64BIT_REG(i->src());
+  diff_64 = op1_64 - op2_64;
+
+  BX_WRITE_64BIT_REG(i->dst(), diff_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_GqEqM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, diff_64;
@@ -397,6 +422,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64, sum_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = (Bit32s) i->Id();
+  sum_64 = op1_64 + op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), sum_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADC_EqIdM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, sum_64;
@@ -459,6 +496,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SUB_EqIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64, diff_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = (Bit32s) i->Id();
+  diff_64 = op1_64 - op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), diff_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EqIdM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64, diff_64;
@@ -532,6 +581,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::INC_EqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u rrx = ++BX_READ_64BIT_REG(i->dst());
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAP_ADD_64(rrx - 1, 0, rrx));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqM(bxInstruction_c *i)
 {
   bx_address eaddr = BX_CPU_RESOLVE_ADDR_64(i);
@@ -553,6 +609,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u rrx = --BX_READ_64BIT_REG(i->dst());
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAP_SUB_64(rrx + 1, 0, rrx));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMPXCHG_EqGqM(bxInstruction_c *i)
 {
   bx_address eaddr = BX_CPU_RESOLVE_ADDR_64(i);
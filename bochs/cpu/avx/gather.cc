@@ -48,6 +48,149 @@ bx_address BX_CPP_AttrRegparmN(2) BX_CPU_C::BxResolveGatherQ(bxInstruction_c *i,
     return (Bit32u) (BX_READ_32BIT_REG(i->sibBase()) + (index << i->sibScale()) + i->displ32s());
 }
 
+// Gather/scatter fast path: succeeds only when every active element lies
+// within a single page and all of them fall into at most two pages which
+// are already present in the TLB with the required permission. In that case
+// none of the element accesses can fault and the instruction may complete
+// with host loads/stores and a single mask update. Otherwise the caller
+// falls back to the element by element path with precise fault semantics.
+bool BX_CPU_C::BxResolveGatherHostPages(bxInstruction_c *i, Bit32u mask, unsigned num_elements, unsigned len, bool index64, unsigned rw, bx_address *laddr, bx_TLB_entry **tlbEntry)
+{
+  bx_TLB_entry *pageTLB[2] = { NULL, NULL };
+  bx_address pageLPF[2] = { BX_INVALID_TLB_ENTRY, BX_INVALID_TLB_ENTRY };
+  unsigned pages = 0;
+
+  bx_segment_reg_t *seg = &BX_CPU_THIS_PTR sregs[i->seg()];
+#if BX_SUPPORT_X86_64
+  bool long64 = (BX_CPU_THIS_PTR cpu_mode == BX_MODE_LONG_64);
+#endif
+
+  for (unsigned n=0; n < num_elements; n++, mask >>= 1)
+  {
+    if (! (mask & 0x1)) continue;
+
+    bx_address offset = index64 ? BxResolveGatherQ(i, n) : BxResolveGatherD(i, n);
+    bx_address lin;
+
+#if BX_SUPPORT_X86_64
+    if (long64) {
+      lin = get_laddr64(i->seg(), offset);
+    }
+    else
+#endif
+    {
+      if (! (seg->cache.valid & ((rw == BX_READ) ? SegAccessROK4G : SegAccessWOK4G))) {
+        if (! (seg->cache.valid & ((rw == BX_READ) ? SegAccessROK : SegAccessWOK)))
+          return false;
+        if ((Bit32u) offset > (seg->cache.u.segment.limit_scaled-len+1))
+          return false;
+      }
+      lin = get_laddr32(i->seg(), (Bit32u) offset);
+    }
+
+    // elements crossing page boundary always go through the slow path
+    if (PAGE_OFFSET(lin) > (0x1000 - len))
+      return false;
+
+    bx_address lpf = LPFOf(lin);
+    unsigned page;
+    for (page = 0; page < pages; page++) {
+      if (pageLPF[page] == lpf) break;
+    }
+
+    if (page == pages) {
+      if (pages == 2) return false;
+
+      bx_TLB_entry *entry = BX_DTLB_ENTRY_OF(lin, 0);
+      if (entry->lpf != lpf)
+        return false;
+      if (rw == BX_READ) {
+        if (! isReadOK(entry, USER_PL)) return false;
+      }
+      else {
+        if (! isWriteOK(entry, USER_PL)) return false;
+      }
+
+      pageLPF[pages] = lpf;
+      pageTLB[pages] = entry;
+      pages++;
+    }
+
+    laddr[n] = lin;
+    tlbEntry[n] = pageTLB[page];
+  }
+
+  return true;
+}
+
+bool BX_CPU_C::BxGatherHostFast(bxInstruction_c *i, Bit32u mask, unsigned num_elements, unsigned len, bool index64, BxPackedAvxRegister *dst)
+{
+  bx_address laddr[16];
+  bx_TLB_entry *tlbEntry[16];
+
+  if (! BxResolveGatherHostPages(i, mask, num_elements, len, index64, BX_READ, laddr, tlbEntry))
+    return false;
+
+  for (unsigned n=0; n < num_elements; n++, mask >>= 1)
+  {
+    if (! (mask & 0x1)) continue;
+
+    Bit32u pageOffset = PAGE_OFFSET(laddr[n]);
+    bx_phy_address pAddr = tlbEntry[n]->ppf | pageOffset;
+    if (len == 4) {
+      Bit32u *hostAddr = (Bit32u*) (tlbEntry[n]->hostPageAddr | pageOffset);
+      dst->vmm32u(n) = ReadHostDWordFromLittleEndian(hostAddr);
+      BX_NOTIFY_LIN_MEMORY_ACCESS(laddr[n], pAddr, 4, tlbEntry[n]->get_memtype(), BX_READ, (Bit8u*) &dst->vmm32u(n));
+    }
+    else {
+      Bit64u *hostAddr = (Bit64u*) (tlbEntry[n]->hostPageAddr | pageOffset);
+      dst->vmm64u(n) = ReadHostQWordFromLittleEndian(hostAddr);
+      BX_NOTIFY_LIN_MEMORY_ACCESS(laddr[n], pAddr, 8, tlbEntry[n]->get_memtype(), BX_READ, (Bit8u*) &dst->vmm64u(n));
+    }
+  }
+
+  return true;
+}
+
+#if BX_SUPPORT_EVEX
+
+bool BX_CPU_C::BxScatterHostFast(bxInstruction_c *i, Bit32u mask, unsigned num_elements, unsigned len, bool index64, const BxPackedAvxRegister *src)
+{
+  bx_address laddr[16];
+  bx_TLB_entry *tlbEntry[16];
+
+  if (! BxResolveGatherHostPages(i, mask, num_elements, len, index64, BX_WRITE, laddr, tlbEntry))
+    return false;
+
+  // elements are stored in order so overlapping indices keep
+  // the architectural result of the highest element
+  for (unsigned n=0; n < num_elements; n++, mask >>= 1)
+  {
+    if (! (mask & 0x1)) continue;
+
+    Bit32u pageOffset = PAGE_OFFSET(laddr[n]);
+    bx_phy_address pAddr = tlbEntry[n]->ppf | pageOffset;
+    if (len == 4) {
+      Bit32u data = src->vmm32u(n);
+      BX_NOTIFY_LIN_MEMORY_ACCESS(laddr[n], pAddr, 4, tlbEntry[n]->get_memtype(), BX_WRITE, (Bit8u*) &data);
+      Bit32u *hostAddr = (Bit32u*) (tlbEntry[n]->hostPageAddr | pageOffset);
+      pageWriteStampTable.decWriteStamp(pAddr, 4);
+      WriteHostDWordToLittleEndian(hostAddr, data);
+    }
+    else {
+      Bit64u data = src->vmm64u(n);
+      BX_NOTIFY_LIN_MEMORY_ACCESS(laddr[n], pAddr, 8, tlbEntry[n]->get_memtype(), BX_WRITE, (Bit8u*) &data);
+      Bit64u *hostAddr = (Bit64u*) (tlbEntry[n]->hostPageAddr | pageOffset);
+      pageWriteStampTable.decWriteStamp(pAddr, 8);
+      WriteHostQWordToLittleEndian(hostAddr, data);
+    }
+  }
+
+  return true;
+}
+
+#endif
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_VpsHps(bxInstruction_c *i)
 {
   if (i->sibIndex() == i->src2() || i->sibIndex() == i->dst() || i->src2() == i->dst()) {
@@ -64,35 +207,48 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_VpsHps(bxInstruction_c *i)
 
   unsigned n, num_elements = DWORD_ELEMENTS(i->getVL());
 
+  Bit32u gather_mask = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm32s(n) < 0)
+    if (mask->ymm32s(n) < 0) {
       mask->ymm32u(n) = 0xffffffff;
+      gather_mask |= (1 << n);
+    }
     else
       mask->ymm32u(n) = 0;
   }
 
+  if (BxGatherHostFast(i, gather_mask, num_elements, 4, false, &BX_AVX_REG(i->dst()))) {
+    // no element can fault, clear the whole mask at once
+    for (n=0; n < 8; n++) {
+      if (n >= num_elements) dest->ymm32u(n) = 0;
+      mask->ymm32u(n) = 0;
+    }
+  }
+  else {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0; n < 8; n++)
-  {
-    if (n >= num_elements) {
-        mask->ymm32u(n) = 0;
-        dest->ymm32u(n) = 0;
-        continue;
+    for (n=0; n < 8; n++)
+    {
+      if (n >= num_elements) {
+          mask->ymm32u(n) = 0;
+          dest->ymm32u(n) = 0;
+          continue;
+      }
+
+      if (mask->ymm32u(n)) {
+          dest->ymm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
+      }
+      mask->ymm32u(n) = 0;
     }
 
-    if (mask->ymm32u(n)) {
-        dest->ymm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
-    }
-    mask->ymm32u(n) = 0;
-  }
-
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_CLEAR_AVX_HIGH256(i->dst());
   BX_CLEAR_AVX_HIGH256(i->src2());
@@ -115,35 +271,48 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPS_VpsHps(bxInstruction_c *i)
   BxPackedYmmRegister *mask = &BX_YMM_REG(i->src2()), *dest = &BX_YMM_REG(i->dst());
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  Bit32u gather_mask = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm32s(n) < 0)
+    if (mask->ymm32s(n) < 0) {
       mask->ymm32u(n) = 0xffffffff;
+      gather_mask |= (1 << n);
+    }
     else
       mask->ymm32u(n) = 0;
   }
 
+  if (BxGatherHostFast(i, gather_mask, num_elements, 4, true, &BX_AVX_REG(i->dst()))) {
+    // no element can fault, clear the whole mask at once
+    for (n=0; n < 4; n++) {
+      if (n >= num_elements) dest->ymm32u(n) = 0;
+      mask->ymm32u(n) = 0;
+    }
+  }
+  else {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0; n < 4; n++)
-  {
-    if (n >= num_elements) {
-        mask->ymm32u(n) = 0;
-        dest->ymm32u(n) = 0;
-        continue;
-    }
-
-    if (mask->ymm32u(n)) {
-        dest->ymm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
+    for (n=0; n < 4; n++)
+    {
+      if (n >= num_elements) {
+          mask->ymm32u(n) = 0;
+          dest->ymm32u(n) = 0;
+          continue;
+      }
+
+      if (mask->ymm32u(n)) {
+          dest->ymm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
+      }
+      mask->ymm32u(n) = 0;
     }
-    mask->ymm32u(n) = 0;
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_CLEAR_AVX_HIGH128(i->dst());
   BX_CLEAR_AVX_HIGH128(i->src2());
@@ -166,35 +335,48 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPD_VpdHpd(bxInstruction_c *i)
   BxPackedYmmRegister *mask = &BX_YMM_REG(i->src2()), *dest = &BX_YMM_REG(i->dst());
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  Bit32u gather_mask = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm64s(n) < 0)
+    if (mask->ymm64s(n) < 0) {
       mask->ymm64u(n) = BX_CONST64(0xffffffffffffffff);
+      gather_mask |= (1 << n);
+    }
     else
       mask->ymm64u(n) = 0;
   }
 
+  if (BxGatherHostFast(i, gather_mask, num_elements, 8, false, &BX_AVX_REG(i->dst()))) {
+    // no element can fault, clear the whole mask at once
+    for (n=0; n < 4; n++) {
+      if (n >= num_elements) dest->ymm64u(n) = 0;
+      mask->ymm64u(n) = 0;
+    }
+  }
+  else {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (unsigned n=0; n < 4; n++)
-  {
-    if (n >= num_elements) {
-        mask->ymm64u(n) = 0;
-        dest->ymm64u(n) = 0;
-        continue;
-    }
-
-    if (mask->ymm64u(n)) {
-        dest->ymm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
+    for (n=0; n < 4; n++)
+    {
+      if (n >= num_elements) {
+          mask->ymm64u(n) = 0;
+          dest->ymm64u(n) = 0;
+          continue;
+      }
+
+      if (mask->ymm64u(n)) {
+          dest->ymm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
+      }
+      mask->ymm64u(n) = 0;
     }
-    mask->ymm64u(n) = 0;
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_CLEAR_AVX_HIGH256(i->dst());
   BX_CLEAR_AVX_HIGH256(i->src2());
@@ -217,35 +399,48 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPD_VpdHpd(bxInstruction_c *i)
   BxPackedYmmRegister *mask = &BX_YMM_REG(i->src2()), *dest = &BX_YMM_REG(i->dst());
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  Bit32u gather_mask = 0;
+
   for (n=0; n < num_elements; n++) {
-    if (mask->ymm64s(n) < 0)
+    if (mask->ymm64s(n) < 0) {
       mask->ymm64u(n) = BX_CONST64(0xffffffffffffffff);
+      gather_mask |= (1 << n);
+    }
     else
       mask->ymm64u(n) = 0;
   }
 
+  if (BxGatherHostFast(i, gather_mask, num_elements, 8, true, &BX_AVX_REG(i->dst()))) {
+    // no element can fault, clear the whole mask at once
+    for (n=0; n < 4; n++) {
+      if (n >= num_elements) dest->ymm64u(n) = 0;
+      mask->ymm64u(n) = 0;
+    }
+  }
+  else {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0; n < 4; n++)
-  {
-    if (n >= num_elements) {
-        mask->ymm64u(n) = 0;
-        dest->ymm64u(n) = 0;
-        continue;
-    }
-
-    if (mask->ymm64u(n)) {
-        dest->ymm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
+    for (n=0; n < 4; n++)
+    {
+      if (n >= num_elements) {
+          mask->ymm64u(n) = 0;
+          dest->ymm64u(n) = 0;
+          continue;
+      }
+
+      if (mask->ymm64u(n)) {
+          dest->ymm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
+      }
+      mask->ymm64u(n) = 0;
     }
-    mask->ymm64u(n) = 0;
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_CLEAR_AVX_HIGH256(i->dst());
   BX_CLEAR_AVX_HIGH256(i->src2());
@@ -273,23 +468,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPS_MASK_VpsVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = DWORD_ELEMENTS(len);
 
+  if (! BxGatherHostFast(i, (Bit32u) opmask, num_elements, 4, false, dest)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      dest->vmm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        dest->vmm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherD(i, n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_CLEAR_AVX_REGZ(i->dst(), len);
@@ -314,23 +511,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPS_MASK_VpsVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = QWORD_ELEMENTS(len);
 
+  if (! BxGatherHostFast(i, (Bit32u) opmask, num_elements, 4, true, dest)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      dest->vmm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        dest->vmm32u(n) = read_virtual_dword(i->seg(), BxResolveGatherQ(i, n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   // ensure correct upper part clearing of the destination register
   if (len == BX_VL128) dest->vmm64u(1) = 0;
@@ -359,23 +558,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERDPD_MASK_VpdVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = QWORD_ELEMENTS(len);
 
+  if (! BxGatherHostFast(i, (Bit32u) opmask, num_elements, 8, false, dest)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      dest->vmm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        dest->vmm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherD(i, n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_CLEAR_AVX_REGZ(i->dst(), len);
@@ -400,23 +601,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VGATHERQPD_MASK_VpdVSib(bxInstruction_c *i
 
   unsigned n, len = i->getVL(), num_elements = QWORD_ELEMENTS(len);
 
+  if (! BxGatherHostFast(i, (Bit32u) opmask, num_elements, 8, true, dest)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      dest->vmm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        dest->vmm64u(n) = read_virtual_qword(i->seg(), BxResolveGatherQ(i, n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_CLEAR_AVX_REGZ(i->dst(), len);
@@ -436,23 +639,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERDPS_MASK_VSibVps(bxInstruction_c *
 
   unsigned n, num_elements = DWORD_ELEMENTS(i->getVL());
 
+  if (! BxScatterHostFast(i, (Bit32u) opmask, num_elements, 4, false, src)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      write_virtual_dword(i->seg(), BxResolveGatherD(i, n), src->vmm32u(n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        write_virtual_dword(i->seg(), BxResolveGatherD(i, n), src->vmm32u(n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_NEXT_INSTR(i);
@@ -471,23 +676,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERQPS_MASK_VSibVps(bxInstruction_c *
 
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  if (! BxScatterHostFast(i, (Bit32u) opmask, num_elements, 4, true, src)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      write_virtual_dword(i->seg(), BxResolveGatherQ(i, n), src->vmm32u(n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        write_virtual_dword(i->seg(), BxResolveGatherQ(i, n), src->vmm32u(n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_NEXT_INSTR(i);
@@ -506,23 +713,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERDPD_MASK_VSibVpd(bxInstruction_c *
 
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  if (! BxScatterHostFast(i, (Bit32u) opmask, num_elements, 8, false, src)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      write_virtual_qword(i->seg(), BxResolveGatherD(i, n), src->vmm64u(n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        write_virtual_qword(i->seg(), BxResolveGatherD(i, n), src->vmm64u(n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_NEXT_INSTR(i);
@@ -541,23 +750,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::VSCATTERQPD_MASK_VSibVpd(bxInstruction_c *
 
   unsigned n, num_elements = QWORD_ELEMENTS(i->getVL());
 
+  if (! BxScatterHostFast(i, (Bit32u) opmask, num_elements, 8, true, src)) {
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
-  BX_CPU_THIS_PTR alignment_check_mask = 0;
+    unsigned save_alignment_check_mask = BX_CPU_THIS_PTR alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = 0;
 #endif
 
-  for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
-  {
-    if (opmask & mask) {
-      write_virtual_qword(i->seg(), BxResolveGatherQ(i, n), src->vmm64u(n));
-      opmask &= ~mask;
-      BX_WRITE_OPMASK(i->opmask(), opmask);
+    for (n=0, mask = 0x1; n < num_elements; n++, mask <<= 1)
+    {
+      if (opmask & mask) {
+        write_virtual_qword(i->seg(), BxResolveGatherQ(i, n), src->vmm64u(n));
+        opmask &= ~mask;
+        BX_WRITE_OPMASK(i->opmask(), opmask);
+      }
     }
-  }
 
 #if BX_SUPPORT_ALIGNMENT_CHECK
-  BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
+    BX_CPU_THIS_PTR alignment_check_mask = save_alignment_check_mask;
 #endif
+  }
 
   BX_WRITE_OPMASK(i->opmask(), 0);
   BX_NEXT_INSTR(i);
@@ -100,15 +100,23 @@ void BX_CPU_C::cpu_loop_debugger(void)
       if (BX_CPU_THIS_PTR trace)
         debug_disasm_instruction(BX_CPU_THIS_PTR prev_rip);
 
-      // want to allow changing of the instruction inside instrumentation callback
-      BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
-      RIP += i->ilen();
-      BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+#if BX_RUNTIME_INSTRUMENTATION && BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+      if (BX_INSTR_SUBSCRIBED(BX_INSTR_EV_EXECUTION)) {
+        instrumentedExecute(i);
+      }
+      else
+#endif
+      {
+        // want to allow changing of the instruction inside instrumentation callback
+        BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
+        RIP += i->ilen();
+        BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS == 0
-      BX_CPU_THIS_PTR prev_rip = RIP; // commit new RIP
-      BX_INSTR_AFTER_EXECUTION(BX_CPU_ID, i);
-      BX_CPU_THIS_PTR icount++;
+        BX_CPU_THIS_PTR prev_rip = RIP; // commit new RIP
+        BX_INSTR_AFTER_EXECUTION(BX_CPU_ID, i);
+        BX_CPU_THIS_PTR icount++;
 #endif
+      }
       if (BX_SMP_PROCESSORS == 1) BX_TICK1();
 
       // note instructions generating exceptions never reach this point
@@ -128,7 +136,7 @@ void BX_CPU_C::cpu_loop_debugger(void)
 
 void BX_CPU_C::cpu_loop(void)
 {
-#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_HANDLERS_CHAINING_STACK_GUARD
   volatile Bit8u stack_anchor = 0;
 
   BX_CPU_THIS_PTR cpuloop_stack_anchor = &stack_anchor;
@@ -179,17 +187,43 @@ void BX_CPU_C::cpu_loop(void)
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
     for(;;) {
-      // want to allow changing of the instruction inside instrumentation callback
-      BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
-      RIP += i->ilen();
-      // when handlers chaining is enabled this single call will execute entire trace
-      BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+#if BX_GDBSTUB
+      // gdbstub checks for breakpoints after every instruction,
+      // stop the handlers chain after a single instruction
+      if (bx_dbg.gdbstub_enabled)
+        BX_CPU_THIS_PTR async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+#endif
+#if BX_SUPPORT_JIT
+      // traces entered from here often enough are translated to host code,
+      // no trace is executing at this point so the arena can be recycled
+      if (++entry->jitCount == BX_JIT_HOT_TRACE_THRESHOLD)
+        jitTranslate(entry);
+#endif
+#if BX_RUNTIME_INSTRUMENTATION
+      if (BX_INSTR_SUBSCRIBED(BX_INSTR_EV_EXECUTION)) {
+        instrumentedExecute(i);
+      }
+      else
+#endif
+      {
+        // want to allow changing of the instruction inside instrumentation callback
+        BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
+        RIP += i->ilen();
+        // when handlers chaining is enabled this single call will execute entire trace
+        BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+      }
 
       BX_SYNC_TIME_IF_SINGLE_PROCESSOR(0);
 
+      // note instructions generating exceptions never reach this point
+#if BX_GDBSTUB
+      if (gdbstub_instruction_epilog()) return;
+#endif
+
       if (BX_CPU_THIS_PTR async_event) break;
 
-      i = getICacheEntry()->i;
+      entry = getICacheEntry();
+      i = entry->i;
     }
 #else // BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS == 0
 
@@ -245,11 +279,23 @@ void BX_CPU_C::cpu_run_trace(void)
   bxInstruction_c *i = entry->i;
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
-  // want to allow changing of the instruction inside instrumentation callback
-  BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
-  RIP += i->ilen();
-  // when handlers chaining is enabled this single call will execute entire trace
-  BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+#if BX_SUPPORT_JIT
+  if (++entry->jitCount == BX_JIT_HOT_TRACE_THRESHOLD)
+    jitTranslate(entry);
+#endif
+#if BX_RUNTIME_INSTRUMENTATION
+  if (BX_INSTR_SUBSCRIBED(BX_INSTR_EV_EXECUTION)) {
+    instrumentedExecute(i);
+  }
+  else
+#endif
+  {
+    // want to allow changing of the instruction inside instrumentation callback
+    BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
+    RIP += i->ilen();
+    // when handlers chaining is enabled this single call will execute entire trace
+    BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+  }
 
   if (BX_CPU_THIS_PTR async_event) {
     // clear stop trace magic indication that probably was set by repeat or branch32/64
@@ -280,6 +326,30 @@ void BX_CPU_C::cpu_run_trace(void)
 
 #endif
 
+#if BX_RUNTIME_INSTRUMENTATION && BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+
+// Execute a single instruction for the runtime instrumentation modules
+// subscribed to the execution events. The handlers chain is stopped after
+// it, so the lazy flags are computed and fused instruction pairs are split
+// like for the debugger. The instruction is reported as executed when it
+// was committed, not when it faulted or a repeat iteration was interrupted.
+void BX_CPU_C::instrumentedExecute(bxInstruction_c *i)
+{
+  Bit64u icount = BX_CPU_THIS_PTR icount;
+
+  BX_CPU_THIS_PTR async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+
+  // want to allow changing of the instruction inside instrumentation callback
+  BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, i);
+  RIP += i->ilen();
+  BX_CPU_CALL_METHOD(i->execute1, (i)); // might iterate repeat instruction
+
+  if (BX_CPU_THIS_PTR icount != icount)
+    BX_INSTR_AFTER_EXECUTION(BX_CPU_ID, i);
+}
+
+#endif
+
 #include "decoder/ia_opcodes.h"
 
 bxICacheEntry_c* BX_CPU_C::getICacheEntry(void)
@@ -324,7 +394,9 @@ bxICacheEntry_c* BX_CPU_C::getICacheEntry(void)
 // The function is called after taken branch instructions and tries to link the branch to the next trace
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::linkTrace(bxInstruction_c *i)
 {
+#if BX_HANDLERS_CHAINING_STACK_GUARD
   volatile Bit8u stack_anchor = 0;
+#endif
 
   if (bx_dbg.debugger_active)
     return;
@@ -345,13 +417,16 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::linkTrace(bxInstruction_c *i)
     return;
   }
 
+#if BX_HANDLERS_CHAINING_STACK_GUARD
 #define BX_HANDLERS_CHAINING_MAX_STACK_DEPTH 0x10000
 
+  // not needed when every handler is entered through a guaranteed tail call
   size_t stack_depth = BX_CPU_THIS_PTR cpuloop_stack_anchor - &stack_anchor;
   if (stack_depth > BX_HANDLERS_CHAINING_MAX_STACK_DEPTH) {
     linkDepth = 0;
     return;
   }
+#endif
 
   Bit32u delta = (Bit32u) (BX_CPU_THIS_PTR icount - BX_CPU_THIS_PTR icount_last_sync);
   if(delta >= bx_pc_system.getNumCpuTicksLeftNextEvent()) {
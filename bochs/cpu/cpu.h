@@ -1260,6 +1260,14 @@ public: // for now...
   const volatile Bit8u *cpuloop_stack_anchor = NULL;
 #endif
 
+#if BX_SUPPORT_JIT
+  // executable memory for translated traces, see jit.cc
+  Bit8u *jit_arena = NULL;
+  Bit32u jit_arena_used = 0;
+  Bit32u jit_generation = 0;
+  bool   jit_disabled = false;
+#endif
+
   // Boundaries of current code page, based on EIP
   bx_address eipPageBias;
   Bit32u     eipPageWindowSize;
@@ -1687,6 +1695,14 @@ public: // for now...
   BX_SMF void JLE_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void JNLE_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
+  // instruction fused with the following Jcc
+  BX_SMF void CMP_GdEdR_Jcc_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void CMP_EdIdR_Jcc_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void TEST_EdGdR_Jcc_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void TEST_EdIdR_Jcc_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void ADD_EdIdR_Jcc_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void DEC_EdR_Jcc_Jd(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
   BX_SMF void SETO_EbR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void SETNO_EbR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void SETB_EbR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -2003,6 +2019,23 @@ public: // for now...
   BX_SMF void SHR_EdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void SAR_EdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
+  // arithmetic flags found dead at trace build time
+  BX_SMF void ADD_GdEdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SUB_GdEdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void AND_GdEdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void OR_GdEdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void XOR_GdEdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void ADD_EdIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SUB_EdIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void AND_EdIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void OR_EdIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void XOR_EdIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void INC_EdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void DEC_EdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SHL_EdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SHR_EdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SAR_EdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
   BX_SMF void TEST_EbIbR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void TEST_EwIwR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void TEST_EdIdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -3994,6 +4027,10 @@ public: // for now...
   BX_SMF void CMOVLE_GdEdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void CMOVNLE_GdEdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
+  // instruction fused with the following CMOVcc
+  BX_SMF void CMP_GdEdR_CMOVcc_GdEdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void CMP_EdIdR_CMOVcc_GdEdR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
   BX_SMF void CWDE(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void CDQ(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
@@ -4196,6 +4233,20 @@ public: // for now...
   BX_SMF void JLE_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void JNLE_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
+  // instruction fused with the following Jcc
+  BX_SMF void CMP_GdEdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void CMP_EdIdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void TEST_EdGdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void TEST_EdIdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void ADD_EdIdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void DEC_EdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void CMP_GqEqR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void CMP_EqIdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void TEST_EqGqR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void TEST_EqIdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void ADD_EqIdR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void DEC_EqR_Jcc_Jq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
   BX_SMF void ENTER64_IwIb(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void LEAVE64(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void IRET64(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -4272,6 +4323,23 @@ public: // for now...
   BX_SMF void SHR_EqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void SAR_EqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
+  // arithmetic flags found dead at trace build time
+  BX_SMF void ADD_GqEqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SUB_GqEqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void AND_GqEqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void OR_GqEqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void XOR_GqEqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void ADD_EqIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SUB_EqIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void AND_EqIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void OR_EqIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void XOR_EqIdR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void INC_EqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void DEC_EqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SHL_EqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SHR_EqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void SAR_EqR_NoFlags(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
   BX_SMF void NOT_EqM(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void NEG_EqM(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void NOT_EqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -4327,6 +4395,10 @@ public: // for now...
   BX_SMF void CMOVLE_GqEqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void CMOVNLE_GqEqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 
+  // instruction fused with the following CMOVcc
+  BX_SMF void CMP_GqEqR_CMOVcc_GqEqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void CMP_EqIdR_CMOVcc_GqEqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+
   BX_SMF void MOV_RRXIq(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void PUSH_EqM(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void PUSH_EqR(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -4418,6 +4490,11 @@ public: // for now...
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
   BX_SMF void BxEndTrace(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
 #endif
+#if BX_SUPPORT_JIT
+  BX_SMF void BxJitTrace(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void BxJitResume(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+  BX_SMF void BxJitHelperReturn(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
+#endif
 
   BX_SMF void BxNoFPU(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
   BX_SMF void BxNoMMX(bxInstruction_c *) BX_CPP_AttrRegparmN(1);
@@ -4442,6 +4519,11 @@ public: // for now...
 #if BX_SUPPORT_AVX
   BX_SMF bx_address BxResolveGatherD(bxInstruction_c *, unsigned) BX_CPP_AttrRegparmN(2);
   BX_SMF bx_address BxResolveGatherQ(bxInstruction_c *, unsigned) BX_CPP_AttrRegparmN(2);
+  BX_SMF bool BxResolveGatherHostPages(bxInstruction_c *, Bit32u mask, unsigned num_elements, unsigned len, bool index64, unsigned rw, bx_address *laddr, bx_TLB_entry **tlbEntry);
+  BX_SMF bool BxGatherHostFast(bxInstruction_c *, Bit32u mask, unsigned num_elements, unsigned len, bool index64, BxPackedAvxRegister *dst);
+#if BX_SUPPORT_EVEX
+  BX_SMF bool BxScatterHostFast(bxInstruction_c *, Bit32u mask, unsigned num_elements, unsigned len, bool index64, const BxPackedAvxRegister *src);
+#endif
 #endif
 // <TAG-CLASS-CPU-END>
 
@@ -4483,6 +4565,9 @@ public: // for now...
 #endif
 #if BX_SUPPORT_SMP
   BX_SMF void cpu_run_trace(void);
+#endif
+#if BX_RUNTIME_INSTRUMENTATION && BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+  BX_SMF void instrumentedExecute(bxInstruction_c *i);
 #endif
   BX_SMF bool handleAsyncEvent(void);
   BX_SMF bool handleWaitForEvent(void);
@@ -4494,8 +4579,17 @@ public: // for now...
   BX_SMF bxICacheEntry_c *serveICacheMiss(Bit32u eipBiased, bx_phy_address pAddr);
   BX_SMF bxICacheEntry_c* getICacheEntry(void);
   BX_SMF bool mergeTraces(bxICacheEntry_c *entry, bxInstruction_c *i, bx_phy_address pAddr);
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+  BX_SMF void removeDeadFlags(bxICacheEntry_c *entry);
+  BX_SMF void fuseInstructions(bxICacheEntry_c *entry);
+#endif
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS && BX_ENABLE_TRACE_LINKING
   BX_SMF void linkTrace(bxInstruction_c *i) BX_CPP_AttrRegparmN(1);
+#endif
+#if BX_SUPPORT_JIT
+  BX_SMF void jitTranslate(bxICacheEntry_c *entry);
+  BX_SMF void jitRestoreInstruction(bxInstruction_c *i);
+  BX_SMF void jitFreeArena(void);
 #endif
   BX_SMF void prefetch(void);
   BX_SMF void updateFetchModeMask(void);
@@ -5880,16 +5974,43 @@ class bxInstruction_c;
 
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
 
+// Chained handlers call the next handler as their last action. When the
+// compiler guarantees the tail call (configure --enable-musttail) the caller
+// frame is always replaced and the chain never grows the host stack,
+// otherwise it relies on the optimizer and linkTrace() watches the stack depth.
+#if BX_HAVE_MUSTTAIL
+  #define BX_TAIL_CALL __attribute__((musttail)) return
+#else
+  #define BX_TAIL_CALL return
+#endif
+
+#if BX_HAVE_MUSTTAIL == 0 || BX_SUPPORT_JIT
+  #define BX_HANDLERS_CHAINING_STACK_GUARD 1
+#else
+  #define BX_HANDLERS_CHAINING_STACK_GUARD 0
+#endif
+
+#if BX_RUNTIME_INSTRUMENTATION
+// Runtime instrumentation modules get the execution events from cpu_loop,
+// which stops the handlers chain after every instruction while a module is
+// subscribed to them, see BX_CPU_C::instrumentedExecute()
+#define BX_INSTR_CHAINED_BEFORE_EXECUTION(cpu_id, i)
+#define BX_INSTR_CHAINED_AFTER_EXECUTION(cpu_id, i)
+#else
+#define BX_INSTR_CHAINED_BEFORE_EXECUTION(cpu_id, i) BX_INSTR_BEFORE_EXECUTION(cpu_id, i)
+#define BX_INSTR_CHAINED_AFTER_EXECUTION(cpu_id, i)  BX_INSTR_AFTER_EXECUTION(cpu_id, i)
+#endif
+
 #define BX_COMMIT_INSTRUCTION(i) {                     \
   BX_CPU_THIS_PTR prev_rip = RIP; /* commit new RIP */ \
-  BX_INSTR_AFTER_EXECUTION(BX_CPU_ID, (i));            \
+  BX_INSTR_CHAINED_AFTER_EXECUTION(BX_CPU_ID, (i));    \
   BX_CPU_THIS_PTR icount++;                            \
 }
 
 #define BX_EXECUTE_INSTRUCTION(i) {                    \
-  BX_INSTR_BEFORE_EXECUTION(BX_CPU_ID, (i));           \
+  BX_INSTR_CHAINED_BEFORE_EXECUTION(BX_CPU_ID, (i));   \
   RIP += (i)->ilen();                                  \
-  return BX_CPU_CALL_METHOD(i->execute1, (i));         \
+  BX_TAIL_CALL BX_CPU_CALL_METHOD(i->execute1, (i));   \
 }
 
 #define BX_NEXT_TRACE(i) {                             \
@@ -5897,14 +6018,14 @@ class bxInstruction_c;
   return;                                              \
 }
 
-#if BX_ENABLE_TRACE_LINKING == 0
-#define linkTrace(i)
-#endif
-
+#if BX_ENABLE_TRACE_LINKING
 #define BX_LINK_TRACE(i) {                             \
   BX_COMMIT_INSTRUCTION(i);                            \
-  return linkTrace(i);                                 \
+  BX_TAIL_CALL linkTrace(i);                           \
 }
+#else
+#define BX_LINK_TRACE(i) BX_NEXT_TRACE(i)
+#endif
 
 #define BX_NEXT_INSTR(i) {                             \
   BX_COMMIT_INSTRUCTION(i);                            \
@@ -5913,10 +6034,35 @@ class bxInstruction_c;
   BX_EXECUTE_INSTRUCTION(i);                           \
 }
 
+// The next instruction in the trace overwrites all the arithmetic flags,
+// they have to be computed only when the chain returns to cpu_loop here.
+#define BX_NEXT_INSTR_NOFLAGS(i, set_flags) {          \
+  BX_COMMIT_INSTRUCTION(i);                            \
+  if (BX_CPU_THIS_PTR async_event) {                   \
+    set_flags;                                         \
+    return;                                            \
+  }                                                    \
+  ++i;                                                 \
+  BX_EXECUTE_INSTRUCTION(i);                           \
+}
+
+// Fused instruction pair: commit the first instruction and continue with
+// the second one in the same handler. The pair is split when an event has
+// to be handled in between, cpu_loop resumes at the second instruction.
+#define BX_NEXT_FUSED_INSTR(i) {                       \
+  BX_COMMIT_INSTRUCTION(i);                            \
+  if (BX_CPU_THIS_PTR async_event) return;             \
+  ++i;                                                 \
+  BX_INSTR_CHAINED_BEFORE_EXECUTION(BX_CPU_ID, (i));   \
+  RIP += (i)->ilen();                                  \
+}
+
 #else // BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
 
 #define BX_NEXT_TRACE(i) { return; }
 #define BX_NEXT_INSTR(i) { return; }
+#define BX_NEXT_INSTR_NOFLAGS(i, set_flags) { set_flags; return; }
+#define BX_NEXT_FUSED_INSTR(i) { return; }
 #define BX_LINK_TRACE(i) { return; }
 
 #endif
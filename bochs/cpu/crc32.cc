@@ -28,6 +28,8 @@
 
 #if BX_CPU_LEVEL >= 6
 
+#include "hostcpu.h"
+
 // 3-byte opcodes
 
 const Bit64u CRC32_POLYNOMIAL = BX_CONST64(0x11edc6f41);
@@ -72,51 +74,118 @@ static Bit32u mod2_64bit(Bit64u divisor, Bit64u dividend)
   return (Bit32u) remainder;
 }
 
-void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEbR(bxInstruction_c *i)
+static Bit32u crc32_u8_portable(Bit32u crc, Bit8u data)
 {
-  Bit8u op1 = BX_READ_8BIT_REGx(i->src(), i->extend8bitL());
+  Bit64u tmp1 = ((Bit64u) BitReflect8 (data)) << 32;
+  Bit64u tmp2 = ((Bit64u) BitReflect32(crc)) <<  8;
+  Bit64u tmp3 = tmp1 ^ tmp2;
 
-  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
+  return BitReflect32(mod2_64bit(CRC32_POLYNOMIAL, tmp3));
+}
+
+static Bit32u crc32_u16_portable(Bit32u crc, Bit16u data)
+{
+  Bit64u tmp1 = ((Bit64u) BitReflect16(data)) << 32;
+  Bit64u tmp2 = ((Bit64u) BitReflect32(crc)) << 16;
+  Bit64u tmp3 = tmp1 ^ tmp2;
+
+  return BitReflect32(mod2_64bit(CRC32_POLYNOMIAL, tmp3));
+}
 
-  Bit64u tmp1 = ((Bit64u) BitReflect8 (op1)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) <<  8;
+static Bit32u crc32_u32_portable(Bit32u crc, Bit32u data)
+{
+  Bit64u tmp1 = ((Bit64u) BitReflect32(data)) << 32;
+  Bit64u tmp2 = ((Bit64u) BitReflect32(crc))  << 32;
   Bit64u tmp3 = tmp1 ^ tmp2;
-  op2 = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
 
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  return BitReflect32(mod2_64bit(CRC32_POLYNOMIAL, tmp3));
+}
+
+#if BX_HAVE_X86_INTRINSICS
+
+BX_HOST_TARGET("sse4.2") static Bit32u host_crc32_u8(Bit32u crc, Bit8u data)
+{
+  return _mm_crc32_u8(crc, data);
+}
+
+BX_HOST_TARGET("sse4.2") static Bit32u host_crc32_u16(Bit32u crc, Bit16u data)
+{
+  return _mm_crc32_u16(crc, data);
+}
+
+BX_HOST_TARGET("sse4.2") static Bit32u host_crc32_u32(Bit32u crc, Bit32u data)
+{
+  return _mm_crc32_u32(crc, data);
+}
+
+// CRC-32C check value of "123456789"
+bool bx_host_crc32_selftest(void)
+{
+  Bit32u crc = 0xffffffff;
+
+  crc = host_crc32_u32(crc, 0x34333231); // "1234"
+  crc = host_crc32_u16(crc, 0x3635);     // "56"
+  crc = host_crc32_u16(crc, 0x3837);     // "78"
+  crc = host_crc32_u8(crc, 0x39);        // "9"
+
+  return ~crc == 0xe3069283;
+}
+
+#endif // BX_HAVE_X86_INTRINSICS
+
+BX_CPP_INLINE Bit32u crc32_u8(Bit32u crc, Bit8u data)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_SSE4_2))
+    return host_crc32_u8(crc, data);
+#endif
+  return crc32_u8_portable(crc, data);
+}
+
+BX_CPP_INLINE Bit32u crc32_u16(Bit32u crc, Bit16u data)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_SSE4_2))
+    return host_crc32_u16(crc, data);
+#endif
+  return crc32_u16_portable(crc, data);
+}
+
+BX_CPP_INLINE Bit32u crc32_u32(Bit32u crc, Bit32u data)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_SSE4_2))
+    return host_crc32_u32(crc, data);
+#endif
+  return crc32_u32_portable(crc, data);
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEbR(bxInstruction_c *i)
+{
+  Bit8u op1 = BX_READ_8BIT_REGx(i->src(), i->extend8bitL());
+  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
+
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_u8(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEwR(bxInstruction_c *i)
 {
-  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
   Bit16u op1 = BX_READ_16BIT_REG(i->src());
+  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
 
-  Bit64u tmp1 = ((Bit64u) BitReflect16(op1)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) << 16;
-  Bit64u tmp3 = tmp1 ^ tmp2;
-  op2 = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_u16(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEdR(bxInstruction_c *i)
 {
-  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
   Bit32u op1 = BX_READ_32BIT_REG(i->src());
+  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
 
-  Bit64u tmp1 = ((Bit64u) BitReflect32(op1)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) << 32;
-  Bit64u tmp3 = tmp1 ^ tmp2;
-  op2 = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), crc32_u32(op2, op1));
 
   BX_NEXT_INSTR(i);
 }
@@ -125,20 +194,13 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEdR(bxInstruction_c *i)
 
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::CRC32_GdEqR(bxInstruction_c *i)
 {
-  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
-  op2 = BitReflect32(op2);
   Bit64u op1 = BX_READ_64BIT_REG(i->src());
+  Bit32u op2 = BX_READ_32BIT_REG(i->dst());
 
-  Bit64u tmp1 = ((Bit64u) BitReflect32(op1 & 0xffffffff)) << 32;
-  Bit64u tmp2 = ((Bit64u) op2) << 32;
-  Bit64u tmp3 = tmp1 ^ tmp2;
-  op2  = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
-  tmp1 = ((Bit64u) BitReflect32(op1 >> 32)) << 32;
-  tmp2 = ((Bit64u) op2) << 32;
-  tmp3 = tmp1 ^ tmp2;
-  op2  = mod2_64bit(CRC32_POLYNOMIAL, tmp3);
+  op2 = crc32_u32(op2, (Bit32u) op1);
+  op2 = crc32_u32(op2, (Bit32u)(op1 >> 32));
 
-  BX_WRITE_32BIT_REGZ(i->dst(), BitReflect32(op2));
+  BX_WRITE_32BIT_REGZ(i->dst(), op2);
 
   BX_NEXT_INSTR(i);
 }
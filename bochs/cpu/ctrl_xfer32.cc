@@ -487,6 +487,78 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::JNLE_Jd(bxInstruction_c *i)
   BX_NEXT_INSTR(i); // trace can continue over non-taken branch
 }
 
+// Fused compare/test and branch: the first instruction is committed by
+// BX_NEXT_FUSED_INSTR and the branch condition is computed from its operands
+// and result (see lazy_flags.h), without dispatching the Jcc handler. The
+// flags are still written for the following instructions.
+#define BX_FUSED_JCC_Jd(i, cond) {                            \
+  BX_NEXT_FUSED_INSTR(i);                                     \
+  if (cond) {                                                 \
+    Bit32u new_EIP = EIP + (Bit32s) i->Id();                  \
+    branch_near32(new_EIP);                                   \
+    BX_INSTR_CNEAR_BRANCH_TAKEN(BX_CPU_ID, PREV_RIP, new_EIP); \
+    BX_LINK_TRACE(i);                                         \
+  }                                                           \
+  BX_INSTR_CNEAR_BRANCH_NOT_TAKEN(BX_CPU_ID, PREV_RIP);       \
+  BX_NEXT_INSTR(i);                                           \
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GdEdR_Jcc_Jd(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = BX_READ_32BIT_REG(i->src());
+  Bit32u diff_32 = op1_32 - op2_32;
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_FUSED_JCC_Jd(i, bx_cond_sub(i->fusedCond(), op1_32, op2_32, diff_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EdIdR_Jcc_Jd(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = i->Id();
+  Bit32u diff_32 = op1_32 - op2_32;
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_FUSED_JCC_Jd(i, bx_cond_sub(i->fusedCond(), op1_32, op2_32, diff_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdGdR_Jcc_Jd(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst()) & BX_READ_32BIT_REG(i->src());
+  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+
+  BX_FUSED_JCC_Jd(i, bx_cond_logic(i->fusedCond(), op1_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdIdR_Jcc_Jd(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst()) & i->Id();
+  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+
+  BX_FUSED_JCC_Jd(i, bx_cond_logic(i->fusedCond(), op1_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR_Jcc_Jd(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = i->Id();
+  Bit32u sum_32 = op1_32 + op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), sum_32);
+  SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32);
+
+  BX_FUSED_JCC_Jd(i, bx_cond_add(i->fusedCond(), op1_32, op2_32, sum_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR_Jcc_Jd(bxInstruction_c *i)
+{
+  Bit32u erx = --BX_READ_32BIT_REG(i->dst());
+  SET_FLAGS_OSZAP_SUB_32(erx + 1, 0, erx);
+  BX_CLEAR_64BIT_HIGH(i->dst());
+
+  BX_FUSED_JCC_Jd(i, bx_cond_dec(i->fusedCond(), erx, BX_CPU_THIS_PTR oszapc));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::JMP_Ap(bxInstruction_c *i)
 {
   BX_ASSERT(BX_CPU_THIS_PTR cpu_mode != BX_MODE_LONG_64);
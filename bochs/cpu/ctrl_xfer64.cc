@@ -407,6 +407,129 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::JNLE_Jq(bxInstruction_c *i)
   BX_NEXT_INSTR(i); // trace can continue over non-taken branch
 }
 
+// Fused compare/test and branch, see ctrl_xfer32.cc
+#define BX_FUSED_JCC_Jq(i, cond) {                            \
+  BX_NEXT_FUSED_INSTR(i);                                     \
+  if (cond) {                                                 \
+    branch_near64(i);                                         \
+    BX_INSTR_CNEAR_BRANCH_TAKEN(BX_CPU_ID, PREV_RIP, RIP);    \
+    BX_LINK_TRACE(i);                                         \
+  }                                                           \
+  BX_INSTR_CNEAR_BRANCH_NOT_TAKEN(BX_CPU_ID, PREV_RIP);       \
+  BX_NEXT_INSTR(i);                                           \
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GdEdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = BX_READ_32BIT_REG(i->src());
+  Bit32u diff_32 = op1_32 - op2_32;
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_sub(i->fusedCond(), op1_32, op2_32, diff_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EdIdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = i->Id();
+  Bit32u diff_32 = op1_32 - op2_32;
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_sub(i->fusedCond(), op1_32, op2_32, diff_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdGdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst()) & BX_READ_32BIT_REG(i->src());
+  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_logic(i->fusedCond(), op1_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdIdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst()) & i->Id();
+  SET_FLAGS_OSZAPC_LOGIC_32(op1_32);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_logic(i->fusedCond(), op1_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EdIdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = i->Id();
+  Bit32u sum_32 = op1_32 + op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), sum_32);
+  SET_FLAGS_OSZAPC_ADD_32(op1_32, op2_32, sum_32);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_add(i->fusedCond(), op1_32, op2_32, sum_32));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit32u erx = --BX_READ_32BIT_REG(i->dst());
+  SET_FLAGS_OSZAP_SUB_32(erx + 1, 0, erx);
+  BX_CLEAR_64BIT_HIGH(i->dst());
+
+  BX_FUSED_JCC_Jq(i, bx_cond_dec(i->fusedCond(), erx, BX_CPU_THIS_PTR oszapc));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GqEqR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = BX_READ_64BIT_REG(i->src());
+  Bit64u diff_64 = op1_64 - op2_64;
+  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_sub(i->fusedCond(), op1_64, op2_64, diff_64));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EqIdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = (Bit32s) i->Id();
+  Bit64u diff_64 = op1_64 - op2_64;
+  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_sub(i->fusedCond(), op1_64, op2_64, diff_64));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqGqR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst()) & BX_READ_64BIT_REG(i->src());
+  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_logic(i->fusedCond(), op1_64));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqIdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst()) & (Bit64u) (Bit32s) i->Id();
+  SET_FLAGS_OSZAPC_LOGIC_64(op1_64);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_logic(i->fusedCond(), op1_64));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::ADD_EqIdR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = (Bit32s) i->Id();
+  Bit64u sum_64 = op1_64 + op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), sum_64);
+  SET_FLAGS_OSZAPC_ADD_64(op1_64, op2_64, sum_64);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_add(i->fusedCond(), op1_64, op2_64, sum_64));
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::DEC_EqR_Jcc_Jq(bxInstruction_c *i)
+{
+  Bit64u rrx = --BX_READ_64BIT_REG(i->dst());
+  SET_FLAGS_OSZAP_SUB_64(rrx + 1, 0, rrx);
+
+  BX_FUSED_JCC_Jq(i, bx_cond_dec(i->fusedCond(), rrx, BX_CPU_THIS_PTR oszapc));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::JMP_EqR(bxInstruction_c *i)
 {
   Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
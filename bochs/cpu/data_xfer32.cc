@@ -379,3 +379,37 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMOVNLE_GdEdR(bxInstruction_c *i)
 
   BX_NEXT_INSTR(i);
 }
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GdEdR_CMOVcc_GdEdR(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = BX_READ_32BIT_REG(i->src());
+  Bit32u diff_32 = op1_32 - op2_32;
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_NEXT_FUSED_INSTR(i);
+
+  if (bx_cond_sub(i->fusedCond(), op1_32, op2_32, diff_32))
+    BX_WRITE_32BIT_REGZ(i->dst(), BX_READ_32BIT_REG(i->src()));
+
+  BX_CLEAR_64BIT_HIGH(i->dst()); // always clear upper part of the register
+
+  BX_NEXT_INSTR(i);
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EdIdR_CMOVcc_GdEdR(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u op2_32 = i->Id();
+  Bit32u diff_32 = op1_32 - op2_32;
+  SET_FLAGS_OSZAPC_SUB_32(op1_32, op2_32, diff_32);
+
+  BX_NEXT_FUSED_INSTR(i);
+
+  if (bx_cond_sub(i->fusedCond(), op1_32, op2_32, diff_32))
+    BX_WRITE_32BIT_REGZ(i->dst(), BX_READ_32BIT_REG(i->src()));
+
+  BX_CLEAR_64BIT_HIGH(i->dst()); // always clear upper part of the register
+
+  BX_NEXT_INSTR(i);
+}
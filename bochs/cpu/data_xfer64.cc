@@ -442,4 +442,34 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMOVNLE_GqEqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_GqEqR_CMOVcc_GqEqR(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = BX_READ_64BIT_REG(i->src());
+  Bit64u diff_64 = op1_64 - op2_64;
+  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+
+  BX_NEXT_FUSED_INSTR(i);
+
+  if (bx_cond_sub(i->fusedCond(), op1_64, op2_64, diff_64))
+    BX_WRITE_64BIT_REG(i->dst(), BX_READ_64BIT_REG(i->src()));
+
+  BX_NEXT_INSTR(i);
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::CMP_EqIdR_CMOVcc_GqEqR(bxInstruction_c *i)
+{
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u op2_64 = (Bit32s) i->Id();
+  Bit64u diff_64 = op1_64 - op2_64;
+  SET_FLAGS_OSZAPC_SUB_64(op1_64, op2_64, diff_64);
+
+  BX_NEXT_FUSED_INSTR(i);
+
+  if (bx_cond_sub(i->fusedCond(), op1_64, op2_64, diff_64))
+    BX_WRITE_64BIT_REG(i->dst(), BX_READ_64BIT_REG(i->src()));
+
+  BX_NEXT_INSTR(i);
+}
+
 #endif /* if BX_SUPPORT_X86_64 */
@@ -90,7 +90,8 @@ public:
     BX_INSTR_METADATA_SEG   = 4,
     BX_INSTR_METADATA_BASE  = 5,
     BX_INSTR_METADATA_INDEX = 6,
-    BX_INSTR_METADATA_SCALE = 7
+    BX_INSTR_METADATA_SCALE = 7,
+    BX_INSTR_METADATA_FUSED_COND = 7 // share scale, no memory operand
   };
 
   // using 5-bit field for registers (16 regs in 64-bit, RIP, NIL)
@@ -175,6 +176,15 @@ public:
     return modRMForm.Iw[0] >> 8;
   }
 
+  // condition code of Jcc or register form CMOVcc fused with the
+  // previous instruction
+  BX_CPP_INLINE void setFusedCond(unsigned cc) {
+    metaData[BX_INSTR_METADATA_FUSED_COND] = cc;
+  }
+  BX_CPP_INLINE unsigned fusedCond() const {
+    return metaData[BX_INSTR_METADATA_FUSED_COND];
+  }
+
   BX_CPP_INLINE void setSibScale(unsigned scale) {
     metaData[BX_INSTR_METADATA_SCALE] = scale;
   }
@@ -27,6 +27,205 @@ these four paragraphs for those parts of this code that are retained.
 
 #include "softfloat3e/include/softfloat.h"
 
+// BX_SOFTFLOAT_ONLY_POLY builds the generic SoftFloat evaluation only, the
+// differential test in bochs-testing/fpu-poly compares both variants
+#if defined(__SIZEOF_INT128__) && !defined(BX_SOFTFLOAT_ONLY_POLY)
+#define BX_FAST_F128_POLY
+#endif
+
+#ifdef BX_FAST_F128_POLY
+
+/*----------------------------------------------------------------------------
+| Fast float128 multiply and fused multiply-add for the polynomial evaluation
+| below. Only finite normal operands producing a finite normal result are
+| handled; everything else goes to the generic SoftFloat routines. Both
+| compute the exact result and truncate it the same way Bochs' trimmed
+| softfloat_roundPackToF128 does, so the results are bit identical to
+| f128_mul / f128_mulAdd, just computed with host 128-bit integer arithmetic
+| and without repacking the accumulator between the Horner steps.
+|
+| Operands are kept unpacked as value = sig * 2^(exp - 0x3FFF - 112) with the
+| 113-bit significand normalized to [2^112, 2^113). Intermediate sums are
+| 256-bit fixed point numbers with the leading bit at position 253, which
+| leaves the low 28 bits of any exact product free so that alignment shifts of
+| nearly equal operands never lose bits before a possible cancellation.
+*----------------------------------------------------------------------------*/
+
+typedef unsigned __int128 f128_uint128;
+
+struct f128_unpacked {
+    bool sign;
+    int32_t exp;
+    f128_uint128 sig;
+};
+
+struct f128_uint256 {
+    f128_uint128 hi, lo;
+};
+
+#define F128_SIG_TOP     112
+#define F128_FIXED_TOP   253
+
+// softfloat_roundPackToF128 is trimmed for Bochs: results are truncated to
+// 80 fraction bits, no rounding and no inexact flag
+#define F128_TRUNC_MASK  BX_CONST64(0xFFFFFFFF)
+
+BX_CPP_INLINE bool f128_unpack(float128_t a, f128_unpacked &z)
+{
+    z.sign = (a.v64 >> 63) != 0;
+    z.exp = (int32_t) ((a.v64 >> 48) & 0x7FFF);
+    if (z.exp == 0 || z.exp == 0x7FFF) return false;
+    z.sig = ((f128_uint128) ((a.v64 & BX_CONST64(0x0000FFFFFFFFFFFF)) | BX_CONST64(0x0001000000000000)) << 64) | a.v0;
+    return true;
+}
+
+BX_CPP_INLINE float128_t f128_pack(const f128_unpacked &a)
+{
+    float128_t z;
+    z.v64 = ((uint64_t) a.sign << 63) | ((uint64_t) a.exp << 48) | ((uint64_t) (a.sig >> 64) & BX_CONST64(0x0000FFFFFFFFFFFF));
+    z.v0 = (uint64_t) a.sig;
+    return z;
+}
+
+BX_CPP_INLINE int f128_clz128(f128_uint128 a)
+{
+    uint64_t hi = (uint64_t) (a >> 64);
+    return hi ? __builtin_clzll(hi) : 64 + __builtin_clzll((uint64_t) a);
+}
+
+BX_CPP_INLINE void f128_shiftRightJam256(f128_uint256 &a, int dist)
+{
+    if (dist < 128) {
+        if (! dist) return;
+        f128_uint128 lost = a.lo << (128 - dist);
+        a.lo = (a.lo >> dist) | (a.hi << (128 - dist)) | (lost != 0);
+        a.hi >>= dist;
+    }
+    else if (dist < 256) {
+        f128_uint128 lost = (dist == 128) ? a.lo : (a.lo | (a.hi << (256 - dist)));
+        a.lo = (a.hi >> (dist - 128)) | (lost != 0);
+        a.hi = 0;
+    }
+    else {
+        a.lo = (a.hi | a.lo) != 0;
+        a.hi = 0;
+    }
+}
+
+/* exact product of two significands as a fixed point number, returns
+   the exponent of the fixed point frame */
+BX_CPP_INLINE int32_t f128_mulSig(const f128_unpacked &a, const f128_unpacked &b, f128_uint256 &z)
+{
+    uint64_t a1 = (uint64_t) (a.sig >> 64), a0 = (uint64_t) a.sig;
+    uint64_t b1 = (uint64_t) (b.sig >> 64), b0 = (uint64_t) b.sig;
+
+    f128_uint128 p00 = (f128_uint128) a0 * b0;
+    f128_uint128 mid = (f128_uint128) a1 * b0 + (f128_uint128) a0 * b1 + (p00 >> 64);
+    z.hi = (f128_uint128) a1 * b1 + (mid >> 64);
+    z.lo = (mid << 64) | (uint64_t) p00;
+
+    // the product is in [2^224, 2^226), move its leading bit to F128_FIXED_TOP
+    int32_t exp = a.exp + b.exp - 0x3FFF;
+    int shift = F128_FIXED_TOP - 224;
+    if ((z.hi >> (225 - 128)) & 1) {
+        shift--;
+        exp++;
+    }
+    z.hi = (z.hi << shift) | (z.lo >> (128 - shift));
+    z.lo <<= shift;
+    return exp;
+}
+
+/* truncate a non zero fixed point number to the precision kept by
+   softfloat_roundPackToF128, returns false if the result would not be
+   a finite normal number */
+BX_CPP_INLINE bool f128_truncFixed(bool sign, int32_t exp, const f128_uint256 &a, f128_unpacked &z)
+{
+    int top = a.hi ? 255 - f128_clz128(a.hi) : 127 - f128_clz128(a.lo);
+    int shift = top - F128_SIG_TOP;
+    f128_uint128 sig;
+
+    if (shift <= 0)
+        sig = a.lo << -shift;
+    else if (shift >= 128)
+        sig = a.hi >> (shift - 128);
+    else
+        sig = (a.lo >> shift) | (a.hi << (128 - shift));
+
+    int32_t zexp = exp + top - F128_FIXED_TOP;
+    if (zexp <= 0 || zexp >= 0x7FFF) return false;
+
+    z.sign = sign;
+    z.exp = zexp;
+    z.sig = sig & ~(f128_uint128) F128_TRUNC_MASK;
+    return true;
+}
+
+/* z = a * b */
+BX_CPP_INLINE bool f128_mulFast(const f128_unpacked &a, const f128_unpacked &b, f128_unpacked &z)
+{
+    f128_uint256 p;
+    int32_t exp = f128_mulSig(a, b, p);
+    return f128_truncFixed(a.sign ^ b.sign, exp, p, z);
+}
+
+/* z = a * b + c */
+static bool f128_mulAddFast(const f128_unpacked &a, const f128_unpacked &b, const f128_unpacked &c, f128_unpacked &z)
+{
+    f128_uint256 p, q;
+    int32_t expP = f128_mulSig(a, b, p);
+    bool signP = a.sign ^ b.sign;
+
+    int32_t expQ = c.exp;
+    q.hi = c.sig << (F128_FIXED_TOP - F128_SIG_TOP - 128);
+    q.lo = 0;
+
+    int32_t expZ;
+    int32_t expDiff = expP - expQ;
+    if (expDiff >= 0) {
+        f128_shiftRightJam256(q, expDiff > 256 ? 256 : expDiff);
+        expZ = expP;
+    }
+    else {
+        f128_shiftRightJam256(p, -expDiff > 256 ? 256 : -expDiff);
+        expZ = expQ;
+    }
+
+    f128_uint256 r;
+    bool signZ = signP;
+    if (signP == c.sign) {
+        r.lo = p.lo + q.lo;
+        r.hi = p.hi + q.hi + (r.lo < p.lo);
+    }
+    else {
+        // both were normalized to the same leading bit before the alignment
+        bool p_less = (expDiff < 0) || (! expDiff && ((p.hi < q.hi) || (p.hi == q.hi && p.lo < q.lo)));
+        if (p_less) {
+            f128_uint256 t = p; p = q; q = t;
+            signZ = c.sign;
+        }
+        r.lo = p.lo - q.lo;
+        r.hi = p.hi - q.hi - (p.lo < q.lo);
+        // exact zero result takes its sign from the rounding mode
+        if (! r.hi && ! r.lo) return false;
+    }
+
+    return f128_truncFixed(signZ, expZ, r, z);
+}
+
+#endif
+
+static float128_t f128_mul_poly(float128_t a, float128_t b, softfloat_status_t &status)
+{
+#ifdef BX_FAST_F128_POLY
+    f128_unpacked ua, ub, uz;
+    if (f128_unpack(a, ua) && f128_unpack(b, ub) && f128_mulFast(ua, ub, uz))
+        return f128_pack(uz);
+#endif
+
+    return f128_mul(a, b, &status);
+}
+
 //                            2         3         4               n
 // f(x) ~ C + (C * x) + (C * x) + (C * x) + (C * x) + ... + (C * x)
 //         0    1         2         3         4               n
@@ -42,12 +241,20 @@ float128_t EvalPoly(float128_t x, const float128_t *arr, int n, softfloat_status
 {
     float128_t r = arr[--n];
 
-    do {
+#ifdef BX_FAST_F128_POLY
+    // keep the accumulator unpacked while the fast path applies
+    f128_unpacked ux, ur, uc;
+    if (f128_unpack(x, ux) && f128_unpack(r, ur)) {
+        while (n > 0 && f128_unpack(arr[n-1], uc) && f128_mulAddFast(ur, ux, uc, ur)) n--;
+        r = f128_pack(ur);
+    }
+#endif
+
+    while (n > 0) {
         r = f128_mulAdd(r, x, arr[--n], 0, &status);
 //      r = f128_mul(r, x, &status);
 //      r = f128_add(r, arr[--n], &status);
-
-    } while (n > 0);
+    }
 
     return r;
 }
@@ -66,7 +273,7 @@ float128_t EvalPoly(float128_t x, const float128_t *arr, int n, softfloat_status
 
 float128_t EvenPoly(float128_t x, const float128_t *arr, int n, softfloat_status_t &status)
 {
-     return EvalPoly(f128_mul(x, x, &status), arr, n, status);
+     return EvalPoly(f128_mul_poly(x, x, status), arr, n, status);
 }
 
 //                        3         5         7         9               2n+1
@@ -86,5 +293,5 @@ float128_t EvenPoly(float128_t x, const float128_t *arr, int n, softfloat_status
 
 float128_t OddPoly(float128_t x, const float128_t *arr, int n, softfloat_status_t &status)
 {
-     return f128_mul(x, EvenPoly(x, arr, n, status), &status);
+     return f128_mul_poly(x, EvenPoly(x, arr, n, status), status);
 }
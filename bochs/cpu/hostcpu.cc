@@ -0,0 +1,139 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#include "bochs.h"
+#include "cpu.h"
+#include "hostcpu.h"
+
+#define LOG_THIS genlog->
+
+Bit32u bx_host_cpu_features = 0;
+
+#if BX_HAVE_X86_INTRINSICS
+
+static void host_cpuid(Bit32u function, Bit32u subfunction, Bit32u regs[4])
+{
+  __asm__ __volatile__("cpuid"
+    : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+    : "a" (function), "c" (subfunction));
+}
+
+static Bit32u detect_host_cpu_features(void)
+{
+  Bit32u regs[4], features = 0;
+
+  host_cpuid(0, 0, regs);
+  Bit32u max_function = regs[0];
+  if (max_function < 1) return 0;
+
+  host_cpuid(1, 0, regs);
+  if (regs[2] & (1 <<  9)) features |= BX_HOST_CPU_SSSE3;
+  if (regs[2] & (1 << 20)) features |= BX_HOST_CPU_SSE4_2;
+  if (regs[2] & (1 << 25)) features |= BX_HOST_CPU_AES;
+  if (regs[2] & (1 <<  1)) features |= BX_HOST_CPU_PCLMUL;
+
+  if (max_function >= 7) {
+    host_cpuid(7, 0, regs);
+    if (regs[1] & (1 << 29)) features |= BX_HOST_CPU_SHA;
+  }
+
+  return features;
+}
+
+#if BX_CPU_LEVEL >= 6
+
+// SSSE3 packed integer helpers (simd_int.h)
+
+BX_HOST_TARGET("ssse3") void host_xmm_pshufb(BxPackedXmmRegister *r, const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_STORE(r, _mm_shuffle_epi8(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2)));
+}
+
+BX_HOST_TARGET("ssse3") void host_xmm_pmaddubsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_OP2(op1, op2, _mm_maddubs_epi16);
+}
+
+BX_HOST_TARGET("ssse3") void host_xmm_pmulhrsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
+{
+  BX_HOST_XMM_OP2(op1, op2, _mm_mulhrs_epi16);
+}
+
+bool bx_host_ssse3_selftest(void)
+{
+  BxPackedXmmRegister op1, op2, r;
+  bx_host_selftest_input(&op1, &op2);
+
+  host_xmm_pshufb(&r, &op1, &op2);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0x6556655d65475656), BX_CONST64(0x73636f6f537b5b54)))
+    return false;
+
+  r = op1; host_xmm_pmaddubsw(&r, &op2);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0x47eb2ddf5aac38d3), BX_CONST64(0x435d5fb54d67404b)))
+    return false;
+
+  r = op1; host_xmm_pmulhrsw(&r, &op2);
+  return bx_host_selftest_expect(&r, BX_CONST64(0x45c81a965e2651c7), BX_CONST64(0x46ec6636536f3d88));
+}
+
+#endif
+
+#endif
+
+void bx_init_host_cpu_features(void)
+{
+  static bool initialized = false;
+  if (initialized) return;
+  initialized = true;
+
+#if BX_HAVE_X86_INTRINSICS
+#if BX_CPU_LEVEL >= 6
+  Bit32u features = detect_host_cpu_features();
+
+  static const struct {
+    Bit32u feature;
+    const char *name;
+    bool (*selftest)(void);
+  } host_helpers[] = {
+    { BX_HOST_CPU_SSSE3,  "SSSE3",     bx_host_ssse3_selftest  },
+    { BX_HOST_CPU_SSE4_2, "CRC32",     bx_host_crc32_selftest  },
+    { BX_HOST_CPU_AES,    "AES-NI",    bx_host_aes_selftest    },
+    { BX_HOST_CPU_PCLMUL, "PCLMULQDQ", bx_host_pclmul_selftest },
+    { BX_HOST_CPU_SHA,    "SHA",       bx_host_sha_selftest    }
+  };
+
+  for (unsigned n=0; n < sizeof(host_helpers) / sizeof(host_helpers[0]); n++) {
+    if (! (features & host_helpers[n].feature)) continue;
+    if (host_helpers[n].selftest()) {
+      BX_INFO(("using host %s for instruction emulation", host_helpers[n].name));
+    }
+    else {
+      BX_ERROR(("host %s results differ from the emulation, not used", host_helpers[n].name));
+      features &= ~host_helpers[n].feature;
+    }
+  }
+
+  // enabled only now, the self tests call the host helpers directly
+  bx_host_cpu_features = features;
+#endif
+#endif
+}
@@ -0,0 +1,147 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_HOSTCPU_H
+#define BX_HOSTCPU_H
+
+// Host CPU extensions usable by the instruction emulation helpers.
+//
+// The accelerated helpers are compiled for the required extension with a
+// function target attribute and selected at runtime from host CPUID, the
+// portable implementation is kept as fallback. Every extension found has to
+// pass a known answer test before it is used. The comparison against the
+// portable code on random vectors is in bochs-testing/host-helpers.
+//
+// SSE2 is part of the x86-64 baseline, helpers using only SSE2 are inlined
+// without any runtime check (BX_HOST_SSE2).
+
+enum {
+  BX_HOST_CPU_SSE4_2 = (1 << 0),
+  BX_HOST_CPU_AES    = (1 << 1),
+  BX_HOST_CPU_PCLMUL = (1 << 2),
+  BX_HOST_CPU_SHA    = (1 << 3),
+  BX_HOST_CPU_SSSE3  = (1 << 4)
+};
+
+extern Bit32u bx_host_cpu_features;
+
+extern void bx_init_host_cpu_features(void);
+
+BX_CPP_INLINE bool bx_host_cpu_supports(Bit32u features)
+{
+  return (bx_host_cpu_features & features) == features;
+}
+
+#if BX_HAVE_X86_INTRINSICS
+
+#include <immintrin.h>
+
+#define BX_HOST_TARGET(isa) __attribute__((target(isa)))
+
+#define BX_HOST_XMM_LOAD(reg)      _mm_loadu_si128((const __m128i*) (reg))
+#define BX_HOST_XMM_STORE(reg, v)  _mm_storeu_si128((__m128i*) (reg), (v))
+
+// op1 = func(op1, op2)
+#define BX_HOST_XMM_OP2(op1, op2, func) \
+  BX_HOST_XMM_STORE((op1), func(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2)))
+
+// call the host helper and return when the host extension is present
+#define BX_HOST_DISPATCH(feature, call) \
+  if (bx_host_cpu_supports(feature)) { call; return; }
+
+#if BX_CPU_LEVEL >= 6
+extern void host_xmm_pshufb(BxPackedXmmRegister *r, const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+extern void host_xmm_pmaddubsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+extern void host_xmm_pmulhrsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2);
+
+// known answer test input: the AES round example of the Intel AES-NI white paper
+BX_CPP_INLINE void bx_host_selftest_input(BxPackedXmmRegister *state, BxPackedXmmRegister *key)
+{
+  state->xmm64u(1) = BX_CONST64(0x7b5b546573745665);
+  state->xmm64u(0) = BX_CONST64(0x63746f725d53475d);
+  key->xmm64u(1)   = BX_CONST64(0x4869285368617929);
+  key->xmm64u(0)   = BX_CONST64(0x5b477565726f6e5d);
+}
+
+BX_CPP_INLINE bool bx_host_selftest_expect(const BxPackedXmmRegister *r, Bit64u hi, Bit64u lo)
+{
+  return r->xmm64u(1) == hi && r->xmm64u(0) == lo;
+}
+
+extern bool bx_host_aes_selftest(void);
+extern bool bx_host_pclmul_selftest(void);
+extern bool bx_host_crc32_selftest(void);
+extern bool bx_host_sha_selftest(void);
+extern bool bx_host_ssse3_selftest(void);
+#endif
+
+#endif
+
+#if BX_HAVE_X86_INTRINSICS == 0
+  #define BX_HOST_DISPATCH(feature, call)
+#endif
+
+#if BX_HAVE_X86_INTRINSICS && defined(__SSE2__)
+  #define BX_HOST_SSE2 1
+#else
+  #define BX_HOST_SSE2 0
+#endif
+
+#if BX_HOST_SSE2
+
+// blend under a byte/word/dword/qword element mask: (m & b) | (~m & a)
+BX_CPP_INLINE __m128i bx_host_blend(__m128i a, __m128i b, __m128i m)
+{
+  return _mm_or_si128(_mm_and_si128(m, b), _mm_andnot_si128(m, a));
+}
+
+// expand the low 16/8/4/2 mask bits to all-ones byte/word/dword/qword elements
+
+BX_CPP_INLINE __m128i bx_host_expand_mask_b(Bit32u mask)
+{
+  const __m128i bits = _mm_set1_epi64x((Bit64s) BX_CONST64(0x8040201008040201));
+  __m128i m = _mm_set_epi64x((Bit64s)(((mask >> 8) & 0xff) * BX_CONST64(0x0101010101010101)),
+                             (Bit64s)(((mask)      & 0xff) * BX_CONST64(0x0101010101010101)));
+  return _mm_cmpeq_epi8(_mm_and_si128(m, bits), bits);
+}
+
+BX_CPP_INLINE __m128i bx_host_expand_mask_w(Bit32u mask)
+{
+  const __m128i bits = _mm_setr_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+  return _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16((short) mask), bits), bits);
+}
+
+BX_CPP_INLINE __m128i bx_host_expand_mask_d(Bit32u mask)
+{
+  const __m128i bits = _mm_setr_epi32(0x1, 0x2, 0x4, 0x8);
+  return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int) mask), bits), bits);
+}
+
+BX_CPP_INLINE __m128i bx_host_expand_mask_q(Bit32u mask)
+{
+  const __m128i bits = _mm_setr_epi32(0x1, 0x1, 0x2, 0x2);
+  return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int) mask), bits), bits);
+}
+
+#endif
+
+#endif
@@ -59,6 +59,100 @@ void handleSMC(bx_phy_address pAddr, Bit32u mask)
   }
 }
 
+void bxPageWriteStampTable::trackWrite(bx_phy_address pAddr)
+{
+  Bit32u index = hash(pAddr);
+
+  if (writeTrackFlags[index] & BX_WRITE_TRACK_CODE) {
+    // the page (or another page sharing the same write stamp) has been
+    // marked by the icache as well, conservatively invalidate all traces
+    handleSMC(pAddr, 0xffffffff);
+  }
+  writeTrackFlags[index] = 0;
+  fineGranularityMapping[index] = 0;
+
+  for (unsigned n=0; n<BX_MAX_WRITE_TRACK_REGIONS; n++) {
+    bxWriteTrackRegion *region = &writeTrackRegion[n];
+    Bit32u page = index - hash(region->base);
+    if (page < region->num_pages)
+      region->dirty[page >> 5] |= (1 << (page & 31));
+  }
+}
+
+int bxPageWriteStampTable::registerWriteTracking(bx_phy_address base, Bit32u len)
+{
+  if (len == 0) return -1;
+  if ((hash(base) + ((PAGE_OFFSET(base) + len + 0xfff) >> 12)) > PHY_MEM_PAGES_IN_4G_SPACE)
+    return -1;
+
+  for (unsigned n=0; n<BX_MAX_WRITE_TRACK_REGIONS; n++) {
+    bxWriteTrackRegion *region = &writeTrackRegion[n];
+    if (region->num_pages == 0) {
+      if (writeTrackFlags == NULL) {
+        writeTrackFlags = new Bit8u[PHY_MEM_PAGES_IN_4G_SPACE];
+        memset(writeTrackFlags, 0, PHY_MEM_PAGES_IN_4G_SPACE);
+      }
+      region->base = LPFOf(base);
+      region->num_pages = (PAGE_OFFSET(base) + len + 0xfff) >> 12;
+      region->dirty = new Bit32u[(region->num_pages + 31) >> 5];
+      memset(region->dirty, 0, ((region->num_pages + 31) >> 5) * sizeof(Bit32u));
+      Bit32u index = hash(region->base);
+      for (Bit32u page=0; page < region->num_pages; page++, index++) {
+        writeTrackFlags[index] |= BX_WRITE_TRACK_ARMED;
+        fineGranularityMapping[index] = 0xffffffff;
+      }
+      return n;
+    }
+  }
+
+  return -1;
+}
+
+void bxPageWriteStampTable::unregisterWriteTracking(int handle)
+{
+  if (handle < 0 || handle >= BX_MAX_WRITE_TRACK_REGIONS) return;
+
+  bxWriteTrackRegion *region = &writeTrackRegion[handle];
+  Bit32u index = hash(region->base);
+  for (Bit32u page=0; page < region->num_pages; page++, index++) {
+    if (writeTrackFlags[index] & BX_WRITE_TRACK_ARMED) {
+      writeTrackFlags[index] &= ~BX_WRITE_TRACK_ARMED;
+      if (! (writeTrackFlags[index] & BX_WRITE_TRACK_CODE))
+        fineGranularityMapping[index] = 0;
+    }
+  }
+  region->num_pages = 0;
+  delete [] region->dirty;
+  region->dirty = NULL;
+}
+
+bool bxPageWriteStampTable::getDirtyPages(int handle, Bit32u *bitmap)
+{
+  if (handle < 0 || handle >= BX_MAX_WRITE_TRACK_REGIONS) return false;
+
+  bxWriteTrackRegion *region = &writeTrackRegion[handle];
+  Bit32u base_index = hash(region->base);
+  bool dirty = false;
+
+  for (Bit32u n=0; n < ((region->num_pages + 31) >> 5); n++) {
+    Bit32u mask = region->dirty[n];
+    bitmap[n] = mask;
+    if (! mask) continue;
+    dirty = true;
+    region->dirty[n] = 0;
+    // re-arm written pages
+    for (unsigned bit=0; bit < 32; bit++) {
+      if (mask & (1 << bit)) {
+        Bit32u index = base_index + (n << 5) + bit;
+        writeTrackFlags[index] |= BX_WRITE_TRACK_ARMED;
+        fineGranularityMapping[index] = 0xffffffff;
+      }
+    }
+  }
+
+  return dirty;
+}
+
 void flushSMC(bxICacheEntry_c *e)
 {
   if (e->pAddr != BX_ICACHE_INVALID_PHY_ADDRESS) {
@@ -88,6 +182,247 @@ void genDummyICacheEntry(bxInstruction_c *i)
   i->execute1 = &BX_CPU_C::BxEndTrace;
 }
 
+#if BX_INSTRUMENTATION == 0 || BX_RUNTIME_INSTRUMENTATION
+
+// Handlers which compute all the arithmetic flags and cannot fault
+static const BxExecutePtr_tR bxFlagsOverwriters[] = {
+  &BX_CPU_C::ADD_GdEdR, &BX_CPU_C::SUB_GdEdR, &BX_CPU_C::CMP_GdEdR,
+  &BX_CPU_C::AND_GdEdR, &BX_CPU_C::OR_GdEdR,  &BX_CPU_C::XOR_GdEdR,
+  &BX_CPU_C::ADD_EdIdR, &BX_CPU_C::SUB_EdIdR, &BX_CPU_C::CMP_EdIdR,
+  &BX_CPU_C::AND_EdIdR, &BX_CPU_C::OR_EdIdR,  &BX_CPU_C::XOR_EdIdR,
+  &BX_CPU_C::TEST_EdGdR, &BX_CPU_C::TEST_EdIdR, &BX_CPU_C::ZERO_IDIOM_GdR,
+#if BX_SUPPORT_X86_64
+  &BX_CPU_C::ADD_GqEqR, &BX_CPU_C::SUB_GqEqR, &BX_CPU_C::CMP_GqEqR,
+  &BX_CPU_C::AND_GqEqR, &BX_CPU_C::OR_GqEqR,  &BX_CPU_C::XOR_GqEqR,
+  &BX_CPU_C::ADD_EqIdR, &BX_CPU_C::SUB_EqIdR, &BX_CPU_C::CMP_EqIdR,
+  &BX_CPU_C::AND_EqIdR, &BX_CPU_C::OR_EqIdR,  &BX_CPU_C::XOR_EqIdR,
+  &BX_CPU_C::TEST_EqGqR, &BX_CPU_C::TEST_EqIdR,
+#endif
+};
+
+struct bxNoFlagsHandler {
+  BxExecutePtr_tR handler;
+  BxExecutePtr_tR noflags;
+};
+
+static const bxNoFlagsHandler bxNoFlagsHandlers[] = {
+  { &BX_CPU_C::ADD_GdEdR, &BX_CPU_C::ADD_GdEdR_NoFlags },
+  { &BX_CPU_C::SUB_GdEdR, &BX_CPU_C::SUB_GdEdR_NoFlags },
+  { &BX_CPU_C::AND_GdEdR, &BX_CPU_C::AND_GdEdR_NoFlags },
+  { &BX_CPU_C::OR_GdEdR,  &BX_CPU_C::OR_GdEdR_NoFlags  },
+  { &BX_CPU_C::XOR_GdEdR, &BX_CPU_C::XOR_GdEdR_NoFlags },
+  { &BX_CPU_C::ADD_EdIdR, &BX_CPU_C::ADD_EdIdR_NoFlags },
+  { &BX_CPU_C::SUB_EdIdR, &BX_CPU_C::SUB_EdIdR_NoFlags },
+  { &BX_CPU_C::AND_EdIdR, &BX_CPU_C::AND_EdIdR_NoFlags },
+  { &BX_CPU_C::OR_EdIdR,  &BX_CPU_C::OR_EdIdR_NoFlags  },
+  { &BX_CPU_C::XOR_EdIdR, &BX_CPU_C::XOR_EdIdR_NoFlags },
+  { &BX_CPU_C::INC_EdR,   &BX_CPU_C::INC_EdR_NoFlags   },
+  { &BX_CPU_C::DEC_EdR,   &BX_CPU_C::DEC_EdR_NoFlags   },
+  { &BX_CPU_C::SHL_EdR,   &BX_CPU_C::SHL_EdR_NoFlags   },
+  { &BX_CPU_C::SHR_EdR,   &BX_CPU_C::SHR_EdR_NoFlags   },
+  { &BX_CPU_C::SAR_EdR,   &BX_CPU_C::SAR_EdR_NoFlags   },
+#if BX_SUPPORT_X86_64
+  { &BX_CPU_C::ADD_GqEqR, &BX_CPU_C::ADD_GqEqR_NoFlags },
+  { &BX_CPU_C::SUB_GqEqR, &BX_CPU_C::SUB_GqEqR_NoFlags },
+  { &BX_CPU_C::AND_GqEqR, &BX_CPU_C::AND_GqEqR_NoFlags },
+  { &BX_CPU_C::OR_GqEqR,  &BX_CPU_C::OR_GqEqR_NoFlags  },
+  { &BX_CPU_C::XOR_GqEqR, &BX_CPU_C::XOR_GqEqR_NoFlags },
+  { &BX_CPU_C::ADD_EqIdR, &BX_CPU_C::ADD_EqIdR_NoFlags },
+  { &BX_CPU_C::SUB_EqIdR, &BX_CPU_C::SUB_EqIdR_NoFlags },
+  { &BX_CPU_C::AND_EqIdR, &BX_CPU_C::AND_EqIdR_NoFlags },
+  { &BX_CPU_C::OR_EqIdR,  &BX_CPU_C::OR_EqIdR_NoFlags  },
+  { &BX_CPU_C::XOR_EqIdR, &BX_CPU_C::XOR_EqIdR_NoFlags },
+  { &BX_CPU_C::INC_EqR,   &BX_CPU_C::INC_EqR_NoFlags   },
+  { &BX_CPU_C::DEC_EqR,   &BX_CPU_C::DEC_EqR_NoFlags   },
+  { &BX_CPU_C::SHL_EqR,   &BX_CPU_C::SHL_EqR_NoFlags   },
+  { &BX_CPU_C::SHR_EqR,   &BX_CPU_C::SHR_EqR_NoFlags   },
+  { &BX_CPU_C::SAR_EqR,   &BX_CPU_C::SAR_EqR_NoFlags   },
+#endif
+};
+
+static bool overwritesAllFlags(BxExecutePtr_tR handler)
+{
+  for (unsigned n=0; n < sizeof(bxFlagsOverwriters)/sizeof(bxFlagsOverwriters[0]); n++) {
+    if (handler == bxFlagsOverwriters[n]) return true;
+  }
+
+  // the no-flags variant writes the flags whenever they could be observed
+  for (unsigned n=0; n < sizeof(bxNoFlagsHandlers)/sizeof(bxNoFlagsHandlers[0]); n++) {
+    if (handler == bxNoFlagsHandlers[n].noflags)
+      return overwritesAllFlags(bxNoFlagsHandlers[n].handler);
+  }
+
+  return false;
+}
+
+#endif
+
+// Flag liveness: the arithmetic flags of an instruction are dead when the
+// next instruction of the trace overwrites all of them. Only the immediate
+// successor is considered because the chain may return to cpu_loop on any
+// instruction boundary (interrupt, debugger, end of quantum), the no-flags
+// handlers compute the flags in that case. The overwriters never fault, so
+// no exception frame can capture the skipped flags either. Runtime
+// instrumentation modules see the instructions one at a time, with the
+// flags computed.
+void BX_CPU_C::removeDeadFlags(bxICacheEntry_c *entry)
+{
+#if BX_INSTRUMENTATION == 0 || BX_RUNTIME_INSTRUMENTATION
+  bxInstruction_c *i = entry->i;
+
+  for (unsigned n=0; n+1 < entry->tlen; n++) {
+    if (! overwritesAllFlags(i[n+1].execute1)) continue;
+
+    for (unsigned k=0; k < sizeof(bxNoFlagsHandlers)/sizeof(bxNoFlagsHandlers[0]); k++) {
+      if (i[n].execute1 == bxNoFlagsHandlers[k].handler) {
+        i[n].execute1 = bxNoFlagsHandlers[k].noflags;
+        break;
+      }
+    }
+  }
+#endif
+}
+
+// Macro-op fusion: compare/test/arithmetic instruction followed by Jcc or
+// CMOVcc is executed by a single handler of the first instruction
+
+enum {
+  BX_FUSED_Jd = 0,
+  BX_FUSED_Jq,
+  BX_FUSED_CMOV_GdEd,
+  BX_FUSED_CMOV_GqEq
+};
+
+struct bxFusedHandler {
+  BxExecutePtr_tR handler;
+  unsigned kind;
+  BxExecutePtr_tR fused;
+};
+
+static const bxFusedHandler bxFusedHandlers[] = {
+  { &BX_CPU_C::CMP_GdEdR,     BX_FUSED_Jd,         &BX_CPU_C::CMP_GdEdR_Jcc_Jd },
+  { &BX_CPU_C::CMP_EdIdR,     BX_FUSED_Jd,         &BX_CPU_C::CMP_EdIdR_Jcc_Jd },
+  { &BX_CPU_C::TEST_EdGdR,    BX_FUSED_Jd,         &BX_CPU_C::TEST_EdGdR_Jcc_Jd },
+  { &BX_CPU_C::TEST_EdIdR,    BX_FUSED_Jd,         &BX_CPU_C::TEST_EdIdR_Jcc_Jd },
+  { &BX_CPU_C::ADD_EdIdR,     BX_FUSED_Jd,         &BX_CPU_C::ADD_EdIdR_Jcc_Jd },
+  { &BX_CPU_C::DEC_EdR,       BX_FUSED_Jd,         &BX_CPU_C::DEC_EdR_Jcc_Jd },
+  { &BX_CPU_C::CMP_GdEdR,     BX_FUSED_CMOV_GdEd,  &BX_CPU_C::CMP_GdEdR_CMOVcc_GdEdR },
+  { &BX_CPU_C::CMP_EdIdR,     BX_FUSED_CMOV_GdEd,  &BX_CPU_C::CMP_EdIdR_CMOVcc_GdEdR },
+#if BX_SUPPORT_X86_64
+  { &BX_CPU_C::CMP_GdEdR,     BX_FUSED_Jq,         &BX_CPU_C::CMP_GdEdR_Jcc_Jq },
+  { &BX_CPU_C::CMP_EdIdR,     BX_FUSED_Jq,         &BX_CPU_C::CMP_EdIdR_Jcc_Jq },
+  { &BX_CPU_C::TEST_EdGdR,    BX_FUSED_Jq,         &BX_CPU_C::TEST_EdGdR_Jcc_Jq },
+  { &BX_CPU_C::TEST_EdIdR,    BX_FUSED_Jq,         &BX_CPU_C::TEST_EdIdR_Jcc_Jq },
+  { &BX_CPU_C::ADD_EdIdR,     BX_FUSED_Jq,         &BX_CPU_C::ADD_EdIdR_Jcc_Jq },
+  { &BX_CPU_C::DEC_EdR,       BX_FUSED_Jq,         &BX_CPU_C::DEC_EdR_Jcc_Jq },
+  { &BX_CPU_C::CMP_GqEqR,     BX_FUSED_Jq,         &BX_CPU_C::CMP_GqEqR_Jcc_Jq },
+  { &BX_CPU_C::CMP_EqIdR,     BX_FUSED_Jq,         &BX_CPU_C::CMP_EqIdR_Jcc_Jq },
+  { &BX_CPU_C::TEST_EqGqR,    BX_FUSED_Jq,         &BX_CPU_C::TEST_EqGqR_Jcc_Jq },
+  { &BX_CPU_C::TEST_EqIdR,    BX_FUSED_Jq,         &BX_CPU_C::TEST_EqIdR_Jcc_Jq },
+  { &BX_CPU_C::ADD_EqIdR,     BX_FUSED_Jq,         &BX_CPU_C::ADD_EqIdR_Jcc_Jq },
+  { &BX_CPU_C::DEC_EqR,       BX_FUSED_Jq,         &BX_CPU_C::DEC_EqR_Jcc_Jq },
+  { &BX_CPU_C::CMP_GqEqR,     BX_FUSED_CMOV_GqEq,  &BX_CPU_C::CMP_GqEqR_CMOVcc_GqEqR },
+  { &BX_CPU_C::CMP_EqIdR,     BX_FUSED_CMOV_GqEq,  &BX_CPU_C::CMP_EqIdR_CMOVcc_GqEqR },
+#endif
+};
+
+struct bxFusedCondition {
+  BxExecutePtr_tR handler;
+  unsigned kind;
+};
+
+// Jcc and CMOVcc handlers ordered by condition code
+static const bxFusedCondition bxFusedConditions[] = {
+  { &BX_CPU_C::JO_Jd,         BX_FUSED_Jd },
+  { &BX_CPU_C::JNO_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JB_Jd,         BX_FUSED_Jd },
+  { &BX_CPU_C::JNB_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JZ_Jd,         BX_FUSED_Jd },
+  { &BX_CPU_C::JNZ_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JBE_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JNBE_Jd,       BX_FUSED_Jd },
+  { &BX_CPU_C::JS_Jd,         BX_FUSED_Jd },
+  { &BX_CPU_C::JNS_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JP_Jd,         BX_FUSED_Jd },
+  { &BX_CPU_C::JNP_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JL_Jd,         BX_FUSED_Jd },
+  { &BX_CPU_C::JNL_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JLE_Jd,        BX_FUSED_Jd },
+  { &BX_CPU_C::JNLE_Jd,       BX_FUSED_Jd },
+  { &BX_CPU_C::CMOVO_GdEdR,   BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNO_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVB_GdEdR,   BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNB_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVZ_GdEdR,   BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNZ_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVBE_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNBE_GdEdR, BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVS_GdEdR,   BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNS_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVP_GdEdR,   BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNP_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVL_GdEdR,   BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNL_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVLE_GdEdR,  BX_FUSED_CMOV_GdEd },
+  { &BX_CPU_C::CMOVNLE_GdEdR, BX_FUSED_CMOV_GdEd },
+#if BX_SUPPORT_X86_64
+  { &BX_CPU_C::JO_Jq,         BX_FUSED_Jq },
+  { &BX_CPU_C::JNO_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JB_Jq,         BX_FUSED_Jq },
+  { &BX_CPU_C::JNB_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JZ_Jq,         BX_FUSED_Jq },
+  { &BX_CPU_C::JNZ_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JBE_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JNBE_Jq,       BX_FUSED_Jq },
+  { &BX_CPU_C::JS_Jq,         BX_FUSED_Jq },
+  { &BX_CPU_C::JNS_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JP_Jq,         BX_FUSED_Jq },
+  { &BX_CPU_C::JNP_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JL_Jq,         BX_FUSED_Jq },
+  { &BX_CPU_C::JNL_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JLE_Jq,        BX_FUSED_Jq },
+  { &BX_CPU_C::JNLE_Jq,       BX_FUSED_Jq },
+  { &BX_CPU_C::CMOVO_GqEqR,   BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNO_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVB_GqEqR,   BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNB_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVZ_GqEqR,   BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNZ_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVBE_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNBE_GqEqR, BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVS_GqEqR,   BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNS_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVP_GqEqR,   BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNP_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVL_GqEqR,   BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNL_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVLE_GqEqR,  BX_FUSED_CMOV_GqEq },
+  { &BX_CPU_C::CMOVNLE_GqEqR, BX_FUSED_CMOV_GqEq },
+#endif
+};
+
+void BX_CPU_C::fuseInstructions(bxICacheEntry_c *entry)
+{
+  bxInstruction_c *i = entry->i;
+
+  for (unsigned n=0; n+1 < entry->tlen; n++) {
+    unsigned k;
+    for (k=0; k < sizeof(bxFusedConditions)/sizeof(bxFusedConditions[0]); k++) {
+      if (i[n+1].execute1 == bxFusedConditions[k].handler) break;
+    }
+    if (k == sizeof(bxFusedConditions)/sizeof(bxFusedConditions[0])) continue;
+
+    unsigned kind = bxFusedConditions[k].kind;
+    for (unsigned f=0; f < sizeof(bxFusedHandlers)/sizeof(bxFusedHandlers[0]); f++) {
+      if (i[n].execute1 == bxFusedHandlers[f].handler && kind == bxFusedHandlers[f].kind) {
+        i[n].execute1 = bxFusedHandlers[f].fused;
+        i[n+1].setFusedCond(k % 16);
+        break;
+      }
+    }
+  }
+}
+
 #endif
 
 bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAddr)
@@ -100,6 +435,9 @@ bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAdd
   // trace from incoming instruction bytes stream !
   entry->pAddr = pAddr;
   entry->traceMask = 0;
+#if BX_SUPPORT_JIT
+  entry->jitCount = 0;
+#endif
 
   unsigned remainingInPage = BX_CPU_THIS_PTR eipPageWindowSize - eipBiased;
   const Bit8u *fetchPtr = BX_CPU_THIS_PTR eipFetchPtr + eipBiased;
@@ -192,6 +530,10 @@ bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAdd
     if (!bx_dbg.debugger_active) {
       if (remainingInPage >= 15) { // avoid merging with page split trace
         if (mergeTraces(entry, i, pAddr)) {
+#if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
+          removeDeadFlags(entry);
+          fuseInstructions(entry);
+#endif
           entry->traceMask |= traceMask;
           pageWriteStampTable.markICacheMask(pAddr, entry->traceMask);
           BX_CPU_THIS_PTR iCache.commit_trace(entry->tlen);
@@ -209,6 +551,8 @@ bxICacheEntry_c* BX_CPU_C::serveICacheMiss(Bit32u eipBiased, bx_phy_address pAdd
 #if BX_SUPPORT_HANDLERS_CHAINING_SPEEDUPS
     entry->tlen++; /* Add the inserted end of trace opcode */
     genDummyICacheEntry(i);
+    removeDeadFlags(entry);
+    fuseInstructions(entry);
 #endif
   }
 
@@ -238,6 +582,10 @@ bool BX_CPU_C::mergeTraces(bxICacheEntry_c *entry, bxInstruction_c *i, bx_phy_ad
 #endif
 
     memcpy(i, e->i, sizeof(bxInstruction_c)*max_length);
+#if BX_SUPPORT_JIT
+    // the merged copy must execute the instruction itself, not the translation
+    jitRestoreInstruction(i);
+#endif
     entry->tlen += max_length;
     BX_ASSERT(entry->tlen <= BX_MAX_TRACE_LENGTH);
 
@@ -26,17 +26,48 @@
 
 extern void handleSMC(bx_phy_address pAddr, Bit32u mask);
 
+// Write tracking for device memory (e.g. video memory) accessed by the CPU
+// through direct host pointers. A tracked page is "armed" by setting all the
+// fine granularity bits, so the first store into the page leaves the
+// decWriteStamp() fast path and marks the page dirty. The page is re-armed
+// when the device consumes its dirty bitmap.
+#define BX_MAX_WRITE_TRACK_REGIONS 4
+
+#define BX_WRITE_TRACK_ARMED  0x01
+#define BX_WRITE_TRACK_CODE   0x02
+
+struct bxWriteTrackRegion {
+  bx_phy_address base;
+  Bit32u num_pages;
+  Bit32u *dirty;        // one bit per page
+};
+
 class bxPageWriteStampTable
 {
   const Bit32u PHY_MEM_PAGES_IN_4G_SPACE;
   Bit32u *fineGranularityMapping;
 
+  Bit8u *writeTrackFlags; // allocated on first registered region
+  bxWriteTrackRegion writeTrackRegion[BX_MAX_WRITE_TRACK_REGIONS];
+
+  void trackWrite(bx_phy_address pAddr);
+
 public:
   bxPageWriteStampTable(): PHY_MEM_PAGES_IN_4G_SPACE(1024*1024) {
     fineGranularityMapping = new Bit32u[PHY_MEM_PAGES_IN_4G_SPACE];
+    writeTrackFlags = NULL;
+    for (unsigned n=0; n<BX_MAX_WRITE_TRACK_REGIONS; n++) {
+      writeTrackRegion[n].num_pages = 0;
+      writeTrackRegion[n].dirty = NULL;
+    }
     resetWriteStamps();
   }
- ~bxPageWriteStampTable() { delete [] fineGranularityMapping; }
+ ~bxPageWriteStampTable() {
+    delete [] fineGranularityMapping;
+    for (unsigned n=0; n<BX_MAX_WRITE_TRACK_REGIONS; n++)
+      delete [] writeTrackRegion[n].dirty;
+    delete [] writeTrackFlags;
+  }
 
   BX_CPP_INLINE static Bit32u hash(bx_phy_address pAddr) {
     // can share writeStamps between multiple pages if >32 bit phy address
@@ -48,17 +79,28 @@ public:
     return fineGranularityMapping[hash(pAddr)];
   }
 
+#if BX_SUPPORT_JIT
+  // translated stores check the mapping without calling into the table
+  BX_CPP_INLINE const Bit32u *getFineGranularityMappingTable() const
+  {
+    return fineGranularityMapping;
+  }
+#endif
+
   BX_CPP_INLINE void markICache(bx_phy_address pAddr, unsigned len)
   {
     Bit32u mask  = 1 << (PAGE_OFFSET((Bit32u) pAddr) >> 7);
            mask |= 1 << (PAGE_OFFSET((Bit32u) pAddr + len - 1) >> 7);
 
-    fineGranularityMapping[hash(pAddr)] |= mask;
+    markICacheMask(pAddr, mask);
   }
 
   BX_CPP_INLINE void markICacheMask(bx_phy_address pAddr, Bit32u mask)
   {
-    fineGranularityMapping[hash(pAddr)] |= mask;
+    Bit32u index = hash(pAddr);
+    fineGranularityMapping[index] |= mask;
+    if (writeTrackFlags)
+      writeTrackFlags[index] |= BX_WRITE_TRACK_CODE;
   }
 
   // whole page is being altered
@@ -67,6 +109,10 @@ public:
     Bit32u index = hash(pAddr);
 
     if (fineGranularityMapping[index]) {
+      if (writeTrackFlags && (writeTrackFlags[index] & BX_WRITE_TRACK_ARMED)) {
+        trackWrite(pAddr);
+        return;
+      }
       handleSMC(pAddr, 0xffffffff); // one of the CPUs might be running trace from this page
       fineGranularityMapping[index] = 0;
     }
@@ -78,6 +124,11 @@ public:
     Bit32u index = hash(pAddr);
 
     if (fineGranularityMapping[index]) {
+       if (writeTrackFlags && (writeTrackFlags[index] & BX_WRITE_TRACK_ARMED)) {
+          trackWrite(pAddr);
+          return;
+       }
+
        Bit32u mask  = 1 << (PAGE_OFFSET((Bit32u) pAddr) >> 7);
               mask |= 1 << (PAGE_OFFSET((Bit32u) pAddr + len - 1) >> 7);
 
@@ -90,6 +141,13 @@ public:
   }
 
   BX_CPP_INLINE void resetWriteStamps(void);
+
+  // returns region handle or -1 if no free region slot available
+  int  registerWriteTracking(bx_phy_address base, Bit32u len);
+  void unregisterWriteTracking(int handle);
+  // copy dirty page bitmap of the region into <bitmap>, clear it and re-arm
+  // the dirty pages, returns false if no page was written since last call
+  bool getDirtyPages(int handle, Bit32u *bitmap);
 };
 
 BX_CPP_INLINE void bxPageWriteStampTable::resetWriteStamps(void)
@@ -97,6 +155,15 @@ BX_CPP_INLINE void bxPageWriteStampTable::resetWriteStamps(void)
   for (Bit32u i=0; i<PHY_MEM_PAGES_IN_4G_SPACE; i++) {
     fineGranularityMapping[i] = 0;
   }
+
+  if (writeTrackFlags) {
+    // icache is empty now, keep tracked pages armed
+    for (Bit32u i=0; i<PHY_MEM_PAGES_IN_4G_SPACE; i++) {
+      writeTrackFlags[i] &= ~BX_WRITE_TRACK_CODE;
+      if (writeTrackFlags[i] & BX_WRITE_TRACK_ARMED)
+        fineGranularityMapping[i] = 0xffffffff;
+    }
+  }
 }
 
 extern bxPageWriteStampTable pageWriteStampTable;
@@ -111,10 +178,18 @@ struct bxICacheEntry_c
 
   Bit32u tlen;          // Trace length in instructions
   bxInstruction_c *i;
+#if BX_SUPPORT_JIT
+  Bit32u jitCount;      // Number of times the trace was entered from cpu_loop
+#endif
 };
 
 #define BX_MAX_TRACE_LENGTH 32
 
+#if BX_SUPPORT_JIT
+// number of trace entries from cpu_loop before the trace is translated
+#define BX_JIT_HOT_TRACE_THRESHOLD 32
+#endif
+
 static const bx_phy_address BX_ICACHE_INVALID_PHY_ADDRESS = bx_phy_address(-1);
 
 void flushSMC(bxICacheEntry_c *e);
@@ -127,6 +202,12 @@ public:
 
   Bit32u traceLinkTimeStamp;
 
+#if BX_SUPPORT_JIT
+  // incremented on every flush, the translated code of older generations
+  // is no longer reachable and its memory can be reused
+  Bit32u jitGeneration;
+#endif
+
 #define BX_ICACHE_PAGE_SPLIT_ENTRIES 8 /* must be power of two */
   struct pageSplitEntryIndex {
     bx_phy_address ppf; // Physical address of 2nd page of the trace
@@ -135,7 +216,12 @@ public:
   int nextPageSplitIndex;
 
 public:
-  bxICache_c() { flushICacheEntries(); }
+  bxICache_c() {
+#if BX_SUPPORT_JIT
+    jitGeneration = 0;
+#endif
+    flushICacheEntries();
+  }
 
   BX_CPP_INLINE static unsigned hash(bx_phy_address pAddr, unsigned fetchModeMask)
   {
@@ -215,6 +301,10 @@ BX_CPP_INLINE void bxICache_c::flushICacheEntries(void)
   mpindex = 0;
 
   traceLinkTimeStamp = 0;
+
+#if BX_SUPPORT_JIT
+  jitGeneration++;
+#endif
 }
 
 BX_CPP_INLINE void bxICache_c::handleSMC(bx_phy_address pAddr, Bit32u mask)
@@ -28,6 +28,7 @@
 #include "gui/siminterface.h"
 #include "param_names.h"
 #include "cpustats.h"
+#include "hostcpu.h"
 
 #if BX_SUPPORT_APIC
 #include "apic.h"
@@ -177,6 +178,8 @@ void BX_CPU_C::add_remove_cpuid_features(const char *input, bool add)
 // BX_CPU_C constructor
 void BX_CPU_C::initialize(void)
 {
+  bx_init_host_cpu_features();
+
 #if BX_CPU_LEVEL >= 4
   BX_CPU_THIS_PTR cpuid = cpuid_factory(this);
   if (! BX_CPU_THIS_PTR cpuid) {
@@ -849,6 +852,10 @@ BX_CPU_C::~BX_CPU_C()
   destroy_MSRs();
 #endif
 
+#if BX_SUPPORT_JIT
+  jitFreeArena();
+#endif
+
   BX_INSTR_EXIT(BX_CPU_ID);
   BX_DEBUG(("Exit."));
 }
@@ -0,0 +1,999 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//   Copyright (c) 2025 The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA B 02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NEED_CPU_REG_SHORTCUTS 1
+#include "bochs.h"
+#include "cpu.h"
+#define LOG_THIS BX_CPU_THIS_PTR
+
+#include "bx_debug/debug.h"
+
+#if BX_SUPPORT_JIT
+
+#include "decoder/ia_opcodes.h"
+
+#if !defined(__x86_64__)
+  #error "JIT requires an x86-64 host"
+#endif
+
+#include <sys/mman.h>
+
+// Hot trace translator.
+//
+// Traces entered from cpu_loop BX_JIT_HOT_TRACE_THRESHOLD times are
+// translated to host x86-64 code. Register-only integer instructions and
+// 64-bit mode MOV loads and stores are emitted inline and operate directly
+// on the guest state in BX_CPU_C (the lazy flags are computed exactly like
+// the interpreter does). All other instructions are executed by calling
+// their regular handler on a private copy of the bxInstruction_c, followed
+// by a stub instruction which tells the translated code that the handler
+// went through BX_NEXT_INSTR. When the stub is not reached (branch taken,
+// async event, end of trace) the translated code returns immediately, the
+// handler already committed the instruction. The last instruction of the
+// trace is entered through its original icache copy, so trace linking
+// keeps working.
+//
+// The first instruction of the icache entry is patched to BxJitTrace.
+// Flushing the entry (SMC) replaces it with the end-of-trace opcode as
+// before, flushing the whole icache bumps its generation and the arena is
+// recycled by the next translation.
+
+#define BX_JIT_ARENA_SIZE     (16 * 1024 * 1024)
+#define BX_JIT_MAX_INSN_CODE  512 /* worst case host code per instruction */
+
+#if BX_DEBUGGER
+// memory watchpoints and memory tracing are only seen by the interpreter
+#define BX_JIT_DEBUGGER_BYPASS \
+  (num_read_watchpoints || num_write_watchpoints || BX_CPU_THIS_PTR trace_mem)
+#else
+#define BX_JIT_DEBUGGER_BYPASS 0
+#endif
+
+#if BX_RUNTIME_INSTRUMENTATION
+// inline memory accesses are not reported to instrumentation modules, the
+// execution events stop the handlers chain and bypass the translation too
+#define BX_JIT_INSTR_BYPASS \
+  BX_INSTR_SUBSCRIBED(BX_INSTR_EV_LIN_ACCESS | BX_INSTR_EV_PHY_ACCESS)
+#else
+#define BX_JIT_INSTR_BYPASS 0
+#endif
+
+typedef void (*bxJitCodePtr)(BX_CPU_C *cpu);
+
+struct bxJitTrace {
+  bxJitCodePtr code;
+  // copy of the first instruction followed by a BxJitResume stub, used
+  // when the trace is entered with an async event pending
+  bxInstruction_c insn[2];
+  // followed by (copy, BxJitHelperReturn stub) pairs for helper calls
+};
+
+// host registers
+enum {
+  HOST_RAX = 0, HOST_RCX = 1, HOST_RDX = 2, HOST_RBX = 3,
+  HOST_RSP = 4, HOST_RBP = 5, HOST_RSI = 6, HOST_RDI = 7
+};
+
+// ALU opcodes (reg/mem, reg form) and matching group 1 extensions
+enum {
+  JIT_ALU_ADD = 0,
+  JIT_ALU_OR,
+  JIT_ALU_AND,
+  JIT_ALU_SUB,
+  JIT_ALU_XOR,
+  JIT_ALU_CMP,
+  JIT_ALU_TEST
+};
+
+static const Bit8u jit_alu_opcode[] = { 0x01, 0x09, 0x21, 0x29, 0x31, 0x29, 0x21 };
+static const Bit8u jit_alu_ext[]    = {    0,    1,    4,    5,    6,    5,    4 };
+
+enum {
+  JIT_OP_NONE = 0,
+  JIT_OP_NOP,
+  JIT_OP_MOV32_RR,
+  JIT_OP_MOV32_RI,
+  JIT_OP_MOV64_RR,
+  JIT_OP_MOV64_RI,   // sign extended imm32
+  JIT_OP_MOV64_RIQ,
+  JIT_OP_MOVSX64_R32,
+  JIT_OP_MOVZX32_R16,
+  JIT_OP_MOVZX32_R8,
+  JIT_OP_ZERO32,
+  JIT_OP_LEA32,
+  JIT_OP_LEA64,
+  JIT_OP_ALU32_RR,
+  JIT_OP_ALU32_RI,
+  JIT_OP_ALU64_RR,
+  JIT_OP_ALU64_RI,
+  JIT_OP_INC32,
+  JIT_OP_DEC32,
+  JIT_OP_INC64,
+  JIT_OP_DEC64,
+  JIT_OP_NOT32,
+  JIT_OP_NOT64,
+  JIT_OP_LOAD32,
+  JIT_OP_LOAD64,
+  JIT_OP_STORE32,
+  JIT_OP_STORE64
+};
+
+struct bxJitOpcode {
+  BxExecutePtr_tR handler;
+  Bit8u op;
+  Bit8u alu;
+  BxExecutePtr_tR unfused; // first instruction of a fused pair
+};
+
+static const bxJitOpcode jit_opcodes[] = {
+  { &BX_CPU_C::NOP,            JIT_OP_NOP,         0 },
+  { &BX_CPU_C::MOV_GdEdR,      JIT_OP_MOV32_RR,    0 },
+  { &BX_CPU_C::MOV_EdIdR,      JIT_OP_MOV32_RI,    0 },
+  { &BX_CPU_C::MOV_GqEqR,      JIT_OP_MOV64_RR,    0 },
+  { &BX_CPU_C::MOV_EqIdR,      JIT_OP_MOV64_RI,    0 },
+  { &BX_CPU_C::MOV_RRXIq,      JIT_OP_MOV64_RIQ,   0 },
+  { &BX_CPU_C::MOVSX_GqEdR,    JIT_OP_MOVSX64_R32, 0 },
+  { &BX_CPU_C::MOVZX_GdEwR,    JIT_OP_MOVZX32_R16, 0 },
+  { &BX_CPU_C::MOVZX_GdEbR,    JIT_OP_MOVZX32_R8,  0 },
+  { &BX_CPU_C::ZERO_IDIOM_GdR, JIT_OP_ZERO32,      0 },
+  { &BX_CPU_C::LEA_GdM,        JIT_OP_LEA32,       0 },
+  { &BX_CPU_C::LEA_GqM,        JIT_OP_LEA64,       0 },
+
+  { &BX_CPU_C::ADD_GdEdR,      JIT_OP_ALU32_RR, JIT_ALU_ADD  },
+  { &BX_CPU_C::OR_GdEdR,       JIT_OP_ALU32_RR, JIT_ALU_OR   },
+  { &BX_CPU_C::AND_GdEdR,      JIT_OP_ALU32_RR, JIT_ALU_AND  },
+  { &BX_CPU_C::SUB_GdEdR,      JIT_OP_ALU32_RR, JIT_ALU_SUB  },
+  { &BX_CPU_C::XOR_GdEdR,      JIT_OP_ALU32_RR, JIT_ALU_XOR  },
+  { &BX_CPU_C::CMP_GdEdR,      JIT_OP_ALU32_RR, JIT_ALU_CMP  },
+  { &BX_CPU_C::TEST_EdGdR,     JIT_OP_ALU32_RR, JIT_ALU_TEST },
+  { &BX_CPU_C::ADD_EdIdR,      JIT_OP_ALU32_RI, JIT_ALU_ADD  },
+  { &BX_CPU_C::OR_EdIdR,       JIT_OP_ALU32_RI, JIT_ALU_OR   },
+  { &BX_CPU_C::AND_EdIdR,      JIT_OP_ALU32_RI, JIT_ALU_AND  },
+  { &BX_CPU_C::SUB_EdIdR,      JIT_OP_ALU32_RI, JIT_ALU_SUB  },
+  { &BX_CPU_C::XOR_EdIdR,      JIT_OP_ALU32_RI, JIT_ALU_XOR  },
+  { &BX_CPU_C::CMP_EdIdR,      JIT_OP_ALU32_RI, JIT_ALU_CMP  },
+  { &BX_CPU_C::TEST_EdIdR,     JIT_OP_ALU32_RI, JIT_ALU_TEST },
+  { &BX_CPU_C::ADD_GqEqR,      JIT_OP_ALU64_RR, JIT_ALU_ADD  },
+  { &BX_CPU_C::OR_GqEqR,       JIT_OP_ALU64_RR, JIT_ALU_OR   },
+  { &BX_CPU_C::AND_GqEqR,      JIT_OP_ALU64_RR, JIT_ALU_AND  },
+  { &BX_CPU_C::SUB_GqEqR,      JIT_OP_ALU64_RR, JIT_ALU_SUB  },
+  { &BX_CPU_C::XOR_GqEqR,      JIT_OP_ALU64_RR, JIT_ALU_XOR  },
+  { &BX_CPU_C::CMP_GqEqR,      JIT_OP_ALU64_RR, JIT_ALU_CMP  },
+  { &BX_CPU_C::TEST_EqGqR,     JIT_OP_ALU64_RR, JIT_ALU_TEST },
+  { &BX_CPU_C::ADD_EqIdR,      JIT_OP_ALU64_RI, JIT_ALU_ADD  },
+  { &BX_CPU_C::OR_EqIdR,       JIT_OP_ALU64_RI, JIT_ALU_OR   },
+  { &BX_CPU_C::AND_EqIdR,      JIT_OP_ALU64_RI, JIT_ALU_AND  },
+  { &BX_CPU_C::SUB_EqIdR,      JIT_OP_ALU64_RI, JIT_ALU_SUB  },
+  { &BX_CPU_C::XOR_EqIdR,      JIT_OP_ALU64_RI, JIT_ALU_XOR  },
+  { &BX_CPU_C::CMP_EqIdR,      JIT_OP_ALU64_RI, JIT_ALU_CMP  },
+  { &BX_CPU_C::TEST_EqIdR,     JIT_OP_ALU64_RI, JIT_ALU_TEST },
+
+  { &BX_CPU_C::INC_EdR,        JIT_OP_INC32, 0 },
+  { &BX_CPU_C::DEC_EdR,        JIT_OP_DEC32, 0 },
+  { &BX_CPU_C::INC_EqR,        JIT_OP_INC64, 0 },
+  { &BX_CPU_C::DEC_EqR,        JIT_OP_DEC64, 0 },
+  { &BX_CPU_C::NOT_EdR,        JIT_OP_NOT32, 0 },
+  { &BX_CPU_C::NOT_EqR,        JIT_OP_NOT64, 0 },
+
+  // only decoded in 64-bit mode, no segment limit checks
+  { &BX_CPU_C::MOV64_GdEdM,    JIT_OP_LOAD32,  0 },
+  { &BX_CPU_C::MOV_GqEqM,      JIT_OP_LOAD64,  0 },
+  { &BX_CPU_C::MOV64_EdGdM,    JIT_OP_STORE32, 0 },
+  { &BX_CPU_C::MOV_EqGqM,      JIT_OP_STORE64, 0 },
+
+  // the translation always computes the flags
+  { &BX_CPU_C::ADD_GdEdR_NoFlags, JIT_OP_ALU32_RR, JIT_ALU_ADD },
+  { &BX_CPU_C::OR_GdEdR_NoFlags,  JIT_OP_ALU32_RR, JIT_ALU_OR  },
+  { &BX_CPU_C::AND_GdEdR_NoFlags, JIT_OP_ALU32_RR, JIT_ALU_AND },
+  { &BX_CPU_C::SUB_GdEdR_NoFlags, JIT_OP_ALU32_RR, JIT_ALU_SUB },
+  { &BX_CPU_C::XOR_GdEdR_NoFlags, JIT_OP_ALU32_RR, JIT_ALU_XOR },
+  { &BX_CPU_C::ADD_EdIdR_NoFlags, JIT_OP_ALU32_RI, JIT_ALU_ADD },
+  { &BX_CPU_C::OR_EdIdR_NoFlags,  JIT_OP_ALU32_RI, JIT_ALU_OR  },
+  { &BX_CPU_C::AND_EdIdR_NoFlags, JIT_OP_ALU32_RI, JIT_ALU_AND },
+  { &BX_CPU_C::SUB_EdIdR_NoFlags, JIT_OP_ALU32_RI, JIT_ALU_SUB },
+  { &BX_CPU_C::XOR_EdIdR_NoFlags, JIT_OP_ALU32_RI, JIT_ALU_XOR },
+  { &BX_CPU_C::ADD_GqEqR_NoFlags, JIT_OP_ALU64_RR, JIT_ALU_ADD },
+  { &BX_CPU_C::OR_GqEqR_NoFlags,  JIT_OP_ALU64_RR, JIT_ALU_OR  },
+  { &BX_CPU_C::AND_GqEqR_NoFlags, JIT_OP_ALU64_RR, JIT_ALU_AND },
+  { &BX_CPU_C::SUB_GqEqR_NoFlags, JIT_OP_ALU64_RR, JIT_ALU_SUB },
+  { &BX_CPU_C::XOR_GqEqR_NoFlags, JIT_OP_ALU64_RR, JIT_ALU_XOR },
+  { &BX_CPU_C::ADD_EqIdR_NoFlags, JIT_OP_ALU64_RI, JIT_ALU_ADD },
+  { &BX_CPU_C::OR_EqIdR_NoFlags,  JIT_OP_ALU64_RI, JIT_ALU_OR  },
+  { &BX_CPU_C::AND_EqIdR_NoFlags, JIT_OP_ALU64_RI, JIT_ALU_AND },
+  { &BX_CPU_C::SUB_EqIdR_NoFlags, JIT_OP_ALU64_RI, JIT_ALU_SUB },
+  { &BX_CPU_C::XOR_EqIdR_NoFlags, JIT_OP_ALU64_RI, JIT_ALU_XOR },
+  { &BX_CPU_C::INC_EdR_NoFlags,   JIT_OP_INC32, 0 },
+  { &BX_CPU_C::DEC_EdR_NoFlags,   JIT_OP_DEC32, 0 },
+  { &BX_CPU_C::INC_EqR_NoFlags,   JIT_OP_INC64, 0 },
+  { &BX_CPU_C::DEC_EqR_NoFlags,   JIT_OP_DEC64, 0 },
+
+  // fused pairs, the second instruction is translated on its own
+  { &BX_CPU_C::CMP_GdEdR_Jcc_Jd,
+    JIT_OP_ALU32_RR, JIT_ALU_CMP, &BX_CPU_C::CMP_GdEdR },
+  { &BX_CPU_C::CMP_EdIdR_Jcc_Jd,
+    JIT_OP_ALU32_RI, JIT_ALU_CMP, &BX_CPU_C::CMP_EdIdR },
+  { &BX_CPU_C::TEST_EdGdR_Jcc_Jd,
+    JIT_OP_ALU32_RR, JIT_ALU_TEST, &BX_CPU_C::TEST_EdGdR },
+  { &BX_CPU_C::TEST_EdIdR_Jcc_Jd,
+    JIT_OP_ALU32_RI, JIT_ALU_TEST, &BX_CPU_C::TEST_EdIdR },
+  { &BX_CPU_C::ADD_EdIdR_Jcc_Jd,
+    JIT_OP_ALU32_RI, JIT_ALU_ADD, &BX_CPU_C::ADD_EdIdR },
+  { &BX_CPU_C::DEC_EdR_Jcc_Jd,
+    JIT_OP_DEC32, 0, &BX_CPU_C::DEC_EdR },
+  { &BX_CPU_C::CMP_GdEdR_CMOVcc_GdEdR,
+    JIT_OP_ALU32_RR, JIT_ALU_CMP, &BX_CPU_C::CMP_GdEdR },
+  { &BX_CPU_C::CMP_EdIdR_CMOVcc_GdEdR,
+    JIT_OP_ALU32_RI, JIT_ALU_CMP, &BX_CPU_C::CMP_EdIdR },
+  { &BX_CPU_C::CMP_GdEdR_Jcc_Jq,
+    JIT_OP_ALU32_RR, JIT_ALU_CMP, &BX_CPU_C::CMP_GdEdR },
+  { &BX_CPU_C::CMP_EdIdR_Jcc_Jq,
+    JIT_OP_ALU32_RI, JIT_ALU_CMP, &BX_CPU_C::CMP_EdIdR },
+  { &BX_CPU_C::TEST_EdGdR_Jcc_Jq,
+    JIT_OP_ALU32_RR, JIT_ALU_TEST, &BX_CPU_C::TEST_EdGdR },
+  { &BX_CPU_C::TEST_EdIdR_Jcc_Jq,
+    JIT_OP_ALU32_RI, JIT_ALU_TEST, &BX_CPU_C::TEST_EdIdR },
+  { &BX_CPU_C::ADD_EdIdR_Jcc_Jq,
+    JIT_OP_ALU32_RI, JIT_ALU_ADD, &BX_CPU_C::ADD_EdIdR },
+  { &BX_CPU_C::DEC_EdR_Jcc_Jq,
+    JIT_OP_DEC32, 0, &BX_CPU_C::DEC_EdR },
+  { &BX_CPU_C::CMP_GqEqR_Jcc_Jq,
+    JIT_OP_ALU64_RR, JIT_ALU_CMP, &BX_CPU_C::CMP_GqEqR },
+  { &BX_CPU_C::CMP_EqIdR_Jcc_Jq,
+    JIT_OP_ALU64_RI, JIT_ALU_CMP, &BX_CPU_C::CMP_EqIdR },
+  { &BX_CPU_C::TEST_EqGqR_Jcc_Jq,
+    JIT_OP_ALU64_RR, JIT_ALU_TEST, &BX_CPU_C::TEST_EqGqR },
+  { &BX_CPU_C::TEST_EqIdR_Jcc_Jq,
+    JIT_OP_ALU64_RI, JIT_ALU_TEST, &BX_CPU_C::TEST_EqIdR },
+  { &BX_CPU_C::ADD_EqIdR_Jcc_Jq,
+    JIT_OP_ALU64_RI, JIT_ALU_ADD, &BX_CPU_C::ADD_EqIdR },
+  { &BX_CPU_C::DEC_EqR_Jcc_Jq,
+    JIT_OP_DEC64, 0, &BX_CPU_C::DEC_EqR },
+  { &BX_CPU_C::CMP_GqEqR_CMOVcc_GqEqR,
+    JIT_OP_ALU64_RR, JIT_ALU_CMP, &BX_CPU_C::CMP_GqEqR },
+  { &BX_CPU_C::CMP_EqIdR_CMOVcc_GqEqR,
+    JIT_OP_ALU64_RI, JIT_ALU_CMP, &BX_CPU_C::CMP_EqIdR }
+};
+
+static unsigned jit_lookup_opcode(const bxInstruction_c *i, unsigned *alu)
+{
+  for (unsigned n=0; n < sizeof(jit_opcodes)/sizeof(jit_opcodes[0]); n++) {
+    if (i->execute1 == jit_opcodes[n].handler) {
+      *alu = jit_opcodes[n].alu;
+      return jit_opcodes[n].op;
+    }
+  }
+
+  return JIT_OP_NONE;
+}
+
+static BxExecutePtr_tR jit_unfused_handler(const bxInstruction_c *i)
+{
+  for (unsigned n=0; n < sizeof(jit_opcodes)/sizeof(jit_opcodes[0]); n++) {
+    if (i->execute1 == jit_opcodes[n].handler && jit_opcodes[n].unfused)
+      return jit_opcodes[n].unfused;
+  }
+
+  return i->execute1;
+}
+
+// entry point of a CPU method for a direct call from translated code
+template <typename T> static const void *jit_method_address(T method)
+{
+#if BX_USE_CPU_SMF
+  // static member function
+  const void *ptr;
+  memcpy(&ptr, &method, sizeof(ptr));
+  return ptr;
+#else
+  // Itanium C++ ABI pointer to member function
+  struct {
+    Bit64u ptr;
+    Bit64s adj;
+  } pmf;
+  static_assert(sizeof(T) == sizeof(pmf), "unexpected pointer to member function layout");
+  memcpy(&pmf, &method, sizeof(pmf));
+  if ((pmf.ptr & 1) || pmf.adj != 0)
+    return NULL; // virtual method or this pointer adjustment
+  return (const void *) pmf.ptr;
+#endif
+}
+
+class bxJitEmitter {
+public:
+  Bit8u *ptr;
+
+  bxJitEmitter(Bit8u *code): ptr(code) {}
+
+  void byte(Bit8u b) { *ptr++ = b; }
+  void dword(Bit32u d) { memcpy(ptr, &d, 4); ptr += 4; }
+  void qword(Bit64u q) { memcpy(ptr, &q, 8); ptr += 8; }
+
+  void rex(bool w) { if (w) byte(0x48); }
+
+  // <opcode> reg, [base + disp32]
+  void mem(Bit8u opcode, unsigned reg, unsigned base, Bit32s disp, bool w) {
+    rex(w);
+    byte(opcode);
+    byte(0x80 | (reg << 3) | base);
+    if (base == HOST_RSP) byte(0x24);
+    dword((Bit32u) disp);
+  }
+  // 0x0f <opcode> reg, [base + disp32]
+  void mem0f(Bit8u opcode, unsigned reg, unsigned base, Bit32s disp) {
+    byte(0x0f);
+    mem(opcode, reg, base, disp, false);
+  }
+  // <opcode> dst, src (dst in r/m field)
+  void rr(Bit8u opcode, unsigned dst, unsigned src, bool w) {
+    rex(w);
+    byte(opcode);
+    byte(0xc0 | (src << 3) | dst);
+  }
+  // group 1 <ext> dst, imm32
+  void ri(unsigned ext, unsigned dst, Bit32u imm, bool w) {
+    rex(w);
+    byte(0x81);
+    byte(0xc0 | (ext << 3) | dst);
+    dword(imm);
+  }
+  // group 2 <ext> dst, imm8
+  void shift(unsigned ext, unsigned dst, Bit8u imm, bool w) {
+    rex(w);
+    byte(0xc1);
+    byte(0xc0 | (ext << 3) | dst);
+    byte(imm);
+  }
+
+  void load32(unsigned reg, Bit32s disp) { mem(0x8b, reg, HOST_RBX, disp, false); }
+  void load64(unsigned reg, Bit32s disp) { mem(0x8b, reg, HOST_RBX, disp, true); }
+  void store32(unsigned reg, Bit32s disp) { mem(0x89, reg, HOST_RBX, disp, false); }
+  void store64(unsigned reg, Bit32s disp) { mem(0x89, reg, HOST_RBX, disp, true); }
+
+  // mov qword [rbx + disp32], sign extended imm32
+  void store64_imm(Bit32s disp, Bit32u imm) { mem(0xc7, 0, HOST_RBX, disp, true); dword(imm); }
+  // add qword [rbx + disp32], sign extended imm32
+  void add64_imm(Bit32s disp, Bit32u imm) { mem(0x81, 0, HOST_RBX, disp, true); dword(imm); }
+
+  void mov(unsigned dst, unsigned src, bool w) { rr(0x89, dst, src, w); }
+  void mov_imm32(unsigned dst, Bit32u imm) { byte(0xb8 + dst); dword(imm); }
+  void mov_imm64(unsigned dst, Bit64u imm) { byte(0x48); byte(0xb8 + dst); qword(imm); }
+  void mov_ptr(unsigned dst, const void *ptr) { mov_imm64(dst, (Bit64u) ptr); }
+
+  void not_(unsigned dst, bool w) { rex(w); byte(0xf7); byte(0xd0 | dst); }
+
+  void call(const void *target) { mov_ptr(HOST_RAX, target); byte(0xff); byte(0xd0); }
+  void jump(const void *target) { mov_ptr(HOST_RAX, target); byte(0xff); byte(0xe0); }
+
+  // jcc/jmp rel32 to be patched later, returns the patch location
+  Bit8u *jcc(Bit8u cc) { byte(0x0f); byte(0x80 | cc); dword(0); return ptr; }
+  Bit8u *jmp() { byte(0xe9); dword(0); return ptr; }
+  void bind(Bit8u *site) { bind(site, ptr); }
+  static void bind(Bit8u *site, Bit8u *target) {
+    Bit32s rel = (Bit32s)(target - site);
+    memcpy(site - 4, &rel, 4);
+  }
+};
+
+enum { CC_E = 0x4, CC_NE = 0x5 };
+
+// state of the translation, counts the guest instructions not yet committed
+// to RIP / prev_rip / icount in BX_CPU_C
+struct bxJitState {
+  bxJitEmitter *e;
+  Bit32s off_rip, off_prev_rip, off_icount;
+  Bit32u rip_delta;  // pending RIP advance, includes the current instruction
+  Bit32u icount;     // pending committed instructions
+
+  // write the pending state before calling out while executing an
+  // instruction of <ilen> bytes, keep the pending counters
+  void sync(unsigned ilen) {
+    if (rip_delta) e->add64_imm(off_rip, rip_delta);
+    if (icount) {
+      // prev_rip was not updated by the inlined instructions
+      e->load64(HOST_RAX, off_rip);
+      e->ri(5 /* sub */, HOST_RAX, ilen, true);
+      e->store64(HOST_RAX, off_prev_rip);
+      e->add64_imm(off_icount, icount);
+    }
+  }
+  // undo sync() when the call returned into the translated code
+  void unsync(void) {
+    if (rip_delta) e->add64_imm(off_rip, (Bit32u) -(Bit32s) rip_delta);
+    if (icount) e->add64_imm(off_icount, (Bit32u) -(Bit32s) icount);
+  }
+  void flush(unsigned ilen) {
+    sync(ilen);
+    rip_delta = 0;
+    icount = 0;
+  }
+};
+
+#define BX_JIT_REG_OFFSET(reg) \
+  ((Bit32s)((Bit8u *) &BX_CPU_THIS_PTR gen_reg[reg] - cpu_base))
+#define BX_JIT_OFFSET(field) \
+  ((Bit32s)((Bit8u *) &BX_CPU_THIS_PTR field - cpu_base))
+
+void BX_CPU_C::jitTranslate(bxICacheEntry_c *entry)
+{
+  if (BX_CPU_THIS_PTR jit_disabled || bx_dbg.debugger_active || BX_JIT_DEBUGGER_BYPASS || BX_JIT_INSTR_BYPASS)
+    return;
+
+  // traces end with the inserted end-of-trace opcode, keep at least two
+  // real instructions so there is something to translate before the
+  // last one which is always executed through its handler
+  if (entry->tlen < 3) return;
+
+  bxInstruction_c *i = entry->i;
+  unsigned n = entry->tlen - 1;
+
+  if (i->execute1 == &BX_CPU_C::BxJitTrace) return;
+  if (i[n].getIaOpcode() != BX_INSERTED_OPCODE) return;
+
+  unsigned alu, inlined = 0, helpers = 0;
+  for (unsigned k=0; k < n-1; k++) {
+    if (jit_lookup_opcode(&i[k], &alu) != JIT_OP_NONE)
+      inlined++;
+    else
+      helpers++;
+  }
+  if (! inlined) return;
+
+  if (BX_CPU_THIS_PTR jit_arena == NULL) {
+    void *arena = mmap(NULL, BX_JIT_ARENA_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+      BX_ERROR(("JIT: cannot allocate executable memory, translation disabled"));
+      BX_CPU_THIS_PTR jit_disabled = true;
+      return;
+    }
+    BX_CPU_THIS_PTR jit_arena = (Bit8u *) arena;
+    BX_CPU_THIS_PTR jit_arena_used = 0;
+    BX_CPU_THIS_PTR jit_generation = BX_CPU_THIS_PTR iCache.jitGeneration;
+  }
+
+  if (BX_CPU_THIS_PTR jit_generation != BX_CPU_THIS_PTR iCache.jitGeneration) {
+    // the icache was flushed, nothing refers to the translated code anymore
+    BX_CPU_THIS_PTR jit_arena_used = 0;
+    BX_CPU_THIS_PTR jit_generation = BX_CPU_THIS_PTR iCache.jitGeneration;
+  }
+
+  Bit32u header_size = sizeof(bxJitTrace) + 2 * helpers * sizeof(bxInstruction_c);
+  header_size = (header_size + 63) & ~63;
+  Bit32u max_size = header_size + (n + 1) * BX_JIT_MAX_INSN_CODE;
+
+  if (BX_CPU_THIS_PTR jit_arena_used + max_size > BX_JIT_ARENA_SIZE) {
+    // recycle the arena, the current trace is executed by the interpreter
+    BX_CPU_THIS_PTR iCache.flushICacheEntries();
+    BX_CPU_THIS_PTR jit_arena_used = 0;
+    BX_CPU_THIS_PTR jit_generation = BX_CPU_THIS_PTR iCache.jitGeneration;
+    return;
+  }
+
+  Bit8u *block = BX_CPU_THIS_PTR jit_arena + BX_CPU_THIS_PTR jit_arena_used;
+  bxJitTrace *trace = (bxJitTrace *) block;
+  bxInstruction_c *helper = (bxInstruction_c *)(trace + 1);
+
+  Bit8u *cpu_base = (Bit8u *) BX_CPU_THIS;
+
+  bxJitEmitter e(block + header_size);
+  bxJitState state;
+  state.e = &e;
+  state.off_rip = BX_JIT_REG_OFFSET(BX_64BIT_REG_RIP);
+  state.off_prev_rip = BX_JIT_OFFSET(prev_rip);
+  state.off_icount = BX_JIT_OFFSET(icount);
+  state.rip_delta = 0;
+  state.icount = 0;
+
+  const Bit32s off_result  = BX_JIT_OFFSET(oszapc.result);
+  const Bit32s off_auxbits = BX_JIT_OFFSET(oszapc.auxbits);
+  const Bit32s off_async   = BX_JIT_OFFSET(async_event);
+
+  Bit8u *exit_sites[BX_MAX_TRACE_LENGTH * 2];
+  unsigned num_exit_sites = 0;
+
+  trace->code = (bxJitCodePtr) e.ptr;
+
+  // prologue, keeps the host stack 16 byte aligned for the calls
+  e.byte(0x53);          // push rbx
+  e.mov(HOST_RBX, HOST_RDI, true); // mov rbx, rdi
+
+  for (unsigned k=0; k < n; k++) {
+    bxInstruction_c *insn = &i[k];
+    // RIP in BX_CPU_C already points after the first instruction
+    if (k > 0) state.rip_delta += insn->ilen();
+
+    if (k == n-1) {
+      // leave through the original handler of the last instruction
+      const void *handler = jit_method_address(insn->execute1);
+      if (! handler) return;
+      state.flush(insn->ilen());
+#if BX_USE_CPU_SMF
+      e.mov_ptr(HOST_RDI, insn);
+#else
+      e.mov(HOST_RDI, HOST_RBX, true);
+      e.mov_ptr(HOST_RSI, insn);
+#endif
+      e.byte(0x5b); // pop rbx
+      e.jump(handler);
+      break;
+    }
+
+    unsigned op = jit_lookup_opcode(insn, &alu);
+    bool w = false;
+
+    switch(op) {
+    case JIT_OP_NOP:
+      break;
+
+    case JIT_OP_MOV32_RR:
+      e.load32(HOST_RAX, BX_JIT_REG_OFFSET(insn->src()));
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_MOV32_RI:
+      e.mov_imm32(HOST_RAX, insn->Id());
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_MOV64_RR:
+      e.load64(HOST_RAX, BX_JIT_REG_OFFSET(insn->src()));
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_MOV64_RI:
+      e.store64_imm(BX_JIT_REG_OFFSET(insn->dst()), insn->Id());
+      break;
+
+    case JIT_OP_MOV64_RIQ:
+      e.mov_imm64(HOST_RAX, insn->Iq());
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_MOVSX64_R32:
+      e.mem(0x63, HOST_RAX, HOST_RBX, BX_JIT_REG_OFFSET(insn->src()), true); // movsxd
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_MOVZX32_R16:
+      e.mem0f(0xb7, HOST_RAX, HOST_RBX, BX_JIT_REG_OFFSET(insn->src()));
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_MOVZX32_R8:
+    {
+      unsigned src = insn->src();
+      Bit8u *reg8;
+      if ((src & 4) == 0 || insn->extend8bitL())
+        reg8 = &BX_CPU_THIS_PTR gen_reg[src].word.byte.rl;
+      else
+        reg8 = &BX_CPU_THIS_PTR gen_reg[src-4].word.byte.rh;
+      e.mem0f(0xb6, HOST_RAX, HOST_RBX, (Bit32s)(reg8 - cpu_base));
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+    }
+
+    case JIT_OP_ZERO32:
+      e.store64_imm(BX_JIT_REG_OFFSET(insn->dst()), 0);
+      e.store64_imm(off_result, 0);
+      e.store64_imm(off_auxbits, 0);
+      break;
+
+    case JIT_OP_NOT64:
+      w = true;
+      // fall through
+    case JIT_OP_NOT32:
+      e.mem(0x8b, HOST_RAX, HOST_RBX, BX_JIT_REG_OFFSET(insn->dst()), w);
+      e.not_(HOST_RAX, w);
+      e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      break;
+
+    case JIT_OP_ALU64_RR:
+    case JIT_OP_ALU64_RI:
+      w = true;
+      // fall through
+    case JIT_OP_ALU32_RR:
+    case JIT_OP_ALU32_RI:
+    {
+      e.mem(0x8b, HOST_RAX, HOST_RBX, BX_JIT_REG_OFFSET(insn->dst()), w);   // op1
+      if (op == JIT_OP_ALU32_RR || op == JIT_OP_ALU64_RR)
+        e.mem(0x8b, HOST_RCX, HOST_RBX, BX_JIT_REG_OFFSET(insn->src()), w); // op2
+      else if (w)
+        e.mov_imm64(HOST_RCX, (Bit64u)(Bit64s)(Bit32s) insn->Id());
+      else
+        e.mov_imm32(HOST_RCX, insn->Id());
+      e.mov(HOST_RDX, HOST_RAX, w);
+      e.rr(jit_alu_opcode[alu], HOST_RDX, HOST_RCX, w);                     // result
+      if (alu != JIT_ALU_CMP && alu != JIT_ALU_TEST)
+        e.store64(HOST_RDX, BX_JIT_REG_OFFSET(insn->dst()));
+
+      if (w) {
+        e.store64(HOST_RDX, off_result);
+      }
+      else {
+        e.rr(0x63, HOST_RDX, HOST_RSI, true);                               // movsxd rsi, edx
+        e.store64(HOST_RSI, off_result);
+      }
+
+      if (alu == JIT_ALU_ADD) {
+        // (op1 & op2) | ((op1 | op2) & ~result)
+        e.mov(HOST_RSI, HOST_RAX, w);
+        e.rr(0x21, HOST_RSI, HOST_RCX, w);
+        e.rr(0x09, HOST_RAX, HOST_RCX, w);
+        e.mov(HOST_RDI, HOST_RDX, w);
+        e.not_(HOST_RDI, w);
+        e.rr(0x21, HOST_RAX, HOST_RDI, w);
+        e.rr(0x09, HOST_RAX, HOST_RSI, w);
+      }
+      else if (alu == JIT_ALU_SUB || alu == JIT_ALU_CMP) {
+        // (~op1 & op2) | ((~op1 ^ op2) & result)
+        e.not_(HOST_RAX, w);
+        e.mov(HOST_RSI, HOST_RAX, w);
+        e.rr(0x21, HOST_RSI, HOST_RCX, w);
+        e.rr(0x31, HOST_RAX, HOST_RCX, w);
+        e.rr(0x21, HOST_RAX, HOST_RDX, w);
+        e.rr(0x09, HOST_RAX, HOST_RSI, w);
+      }
+      else {
+        // logical operations have no carries
+        e.store64_imm(off_auxbits, 0);
+        break;
+      }
+
+      if (w) {
+        // (carries & LF_MASK_AF) | ((carries >> 62) << LF_BIT_PO)
+        e.mov(HOST_RSI, HOST_RAX, true);
+        e.ri(4 /* and */, HOST_RSI, LF_MASK_AF, false);
+        e.shift(5 /* shr */, HOST_RAX, 62, true);
+        e.shift(4 /* shl */, HOST_RAX, LF_BIT_PO, false);
+        e.rr(0x09, HOST_RAX, HOST_RSI, false);
+      }
+      else {
+        e.ri(4 /* and */, HOST_RAX, ~(LF_MASK_PDB | LF_MASK_SD), false);
+      }
+      e.store64(HOST_RAX, off_auxbits);
+      break;
+    }
+
+    case JIT_OP_INC64:
+    case JIT_OP_DEC64:
+      w = true;
+      // fall through
+    case JIT_OP_INC32:
+    case JIT_OP_DEC32:
+    {
+      bool inc = (op == JIT_OP_INC32 || op == JIT_OP_INC64);
+      e.mem(0x8b, HOST_RAX, HOST_RBX, BX_JIT_REG_OFFSET(insn->dst()), w);
+      e.mov(HOST_RDX, HOST_RAX, w);
+      e.ri(inc ? 0 /* add */ : 5 /* sub */, HOST_RDX, 1, w);
+      e.store64(HOST_RDX, BX_JIT_REG_OFFSET(insn->dst()));
+
+      if (w) {
+        e.store64(HOST_RDX, off_result);
+      }
+      else {
+        e.rr(0x63, HOST_RDX, HOST_RSI, true);                               // movsxd rsi, edx
+        e.store64(HOST_RSI, off_result);
+      }
+
+      if (inc) {
+        // op1 & ~result
+        e.mov(HOST_RCX, HOST_RDX, w);
+        e.not_(HOST_RCX, w);
+        e.rr(0x21, HOST_RAX, HOST_RCX, w);
+      }
+      else {
+        // ~op1 & result
+        e.not_(HOST_RAX, w);
+        e.rr(0x21, HOST_RAX, HOST_RDX, w);
+      }
+
+      if (w) {
+        e.mov(HOST_RSI, HOST_RAX, true);
+        e.ri(4 /* and */, HOST_RSI, LF_MASK_AF, false);
+        e.shift(5 /* shr */, HOST_RAX, 62, true);
+        e.shift(4 /* shl */, HOST_RAX, LF_BIT_PO, false);
+        e.rr(0x09, HOST_RAX, HOST_RSI, false);
+      }
+      else {
+        e.ri(4 /* and */, HOST_RAX, ~(LF_MASK_PDB | LF_MASK_SD), false);
+      }
+
+      // keep CF, PO follows the new OF
+      e.load64(HOST_RCX, off_auxbits);
+      e.rr(0x31, HOST_RCX, HOST_RAX, false);
+      e.ri(4 /* and */, HOST_RCX, LF_MASK_CF, false);
+      e.mov(HOST_RSI, HOST_RCX, false);
+      e.shift(5 /* shr */, HOST_RSI, 1, false);
+      e.rr(0x31, HOST_RCX, HOST_RSI, false);
+      e.rr(0x31, HOST_RAX, HOST_RCX, false);
+      e.store64(HOST_RAX, off_auxbits);
+      break;
+    }
+
+    case JIT_OP_LEA32:
+    case JIT_OP_LEA64:
+    case JIT_OP_LOAD32:
+    case JIT_OP_LOAD64:
+    case JIT_OP_STORE32:
+    case JIT_OP_STORE64:
+    {
+      // effective address -> rax
+      unsigned base = insn->sibBase(), index = insn->sibIndex();
+      bool as64 = insn->as64L();
+
+      e.load64(HOST_RAX, BX_JIT_REG_OFFSET(base));
+      if (base == BX_64BIT_REG_RIP && state.rip_delta)
+        e.ri(0 /* add */, HOST_RAX, state.rip_delta, true);
+      if (insn->displ32s())
+        e.ri(0 /* add */, HOST_RAX, (Bit32u) insn->displ32s(), as64);
+      if (index != 4) {
+        e.mem(0x8b, HOST_RCX, HOST_RBX, BX_JIT_REG_OFFSET(index), as64);
+        if (insn->sibScale())
+          e.shift(4 /* shl */, HOST_RCX, insn->sibScale(), as64);
+        e.rr(0x01, HOST_RAX, HOST_RCX, as64);
+      }
+      if (! as64) {
+        if (insn->asize_mask() == 0xffff) {
+          e.byte(0x0f); e.byte(0xb7); e.byte(0xc0); // movzx eax, ax
+        }
+        else {
+          e.mov(HOST_RAX, HOST_RAX, false); // zero extend
+        }
+      }
+
+      if (op == JIT_OP_LEA32) {
+        e.mov(HOST_RAX, HOST_RAX, false);
+        e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+        break;
+      }
+      if (op == JIT_OP_LEA64) {
+        e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+        break;
+      }
+
+      unsigned seg = insn->seg();
+      if (seg >= BX_SEG_REG_FS)
+        e.mem(0x03, HOST_RAX, HOST_RBX, BX_JIT_OFFSET(sregs[seg].cache.u.segment.base), true);
+
+      bool store = (op == JIT_OP_STORE32 || op == JIT_OP_STORE64);
+      bool qword = (op == JIT_OP_LOAD64 || op == JIT_OP_STORE64);
+      unsigned len = qword ? 8 : 4;
+
+      // TLB lookup, same as the fast path of read/write_linear_qword/dword
+      bx_TLB_entry *tlb = &BX_CPU_THIS_PTR DTLB.entry[0];
+      Bit8u *tlb_base = (Bit8u *) tlb;
+
+      e.mov(HOST_RCX, HOST_RAX, false);
+      e.ri(0 /* add */, HOST_RCX, len - 1, false);
+      e.ri(4 /* and */, HOST_RCX, (BX_DTLB_SIZE-1) << 12, false);
+      e.shift(5 /* shr */, HOST_RCX, 12, false);
+      // imul rsi, rcx, sizeof(bx_TLB_entry)
+      e.rex(true); e.byte(0x69); e.byte(0xc0 | (HOST_RSI << 3) | HOST_RCX);
+      e.dword(sizeof(bx_TLB_entry));
+      e.rr(0x01, HOST_RSI, HOST_RBX, true);
+      e.ri(0 /* add */, HOST_RSI, (Bit32u)(tlb_base - cpu_base), true);
+
+#if BX_SUPPORT_ALIGNMENT_CHECK && BX_CPU_LEVEL >= 4
+      e.load32(HOST_RDX, BX_JIT_OFFSET(alignment_check_mask));
+      e.ri(4 /* and */, HOST_RDX, len - 1, false);
+      e.ri(1 /* or */, HOST_RDX, (Bit32u) LPF_MASK, true);
+      e.rr(0x21, HOST_RDX, HOST_RAX, true);
+#else
+      e.mov(HOST_RDX, HOST_RAX, true);
+      e.ri(4 /* and */, HOST_RDX, (Bit32u) LPF_MASK, true);
+#endif
+      e.mem(0x3b, HOST_RDX, HOST_RSI, (Bit32s)((Bit8u *) &tlb->lpf - tlb_base), true); // cmp rdx, [rsi + lpf]
+      Bit8u *miss1 = e.jcc(CC_NE);
+
+      e.mem(0x8b, HOST_RDX, HOST_RSI, (Bit32s)((Bit8u *) &tlb->accessBits - tlb_base), false);
+#if BX_SUPPORT_PKEYS
+      e.mem(0x8b, HOST_RCX, HOST_RSI, (Bit32s)((Bit8u *) &tlb->pkey - tlb_base), false);
+      // and edx, [rbx + rcx*4 + rd/wr_pkey]
+      e.byte(0x23); e.byte(0x84 | (HOST_RDX << 3)); e.byte(0x80 | (HOST_RCX << 3) | HOST_RBX);
+      e.dword(store ? BX_JIT_OFFSET(wr_pkey) : BX_JIT_OFFSET(rd_pkey));
+#endif
+      e.mem0f(0xb6, HOST_RCX, HOST_RBX, BX_JIT_OFFSET(user_pl));
+      e.rex(false); e.byte(0xd3); e.byte(0xe8 | HOST_RDX);           // shr edx, cl
+      e.byte(0xf6); e.byte(0xc0 | HOST_RDX); e.byte(store ? TLB_SysWriteOK : TLB_SysReadOK); // test dl, imm8
+      Bit8u *miss2 = e.jcc(CC_E);
+      Bit8u *miss3 = NULL;
+
+      if (store) {
+        // pages holding decoded instructions are written by the slow path
+        // which takes care of self modifying code
+        e.mem(0x8b, HOST_RDX, HOST_RSI, (Bit32s)((Bit8u *) &tlb->ppf - tlb_base), false);
+        e.shift(5 /* shr */, HOST_RDX, 12, false);
+        e.mov_ptr(HOST_RDI, pageWriteStampTable.getFineGranularityMappingTable());
+        // cmp dword [rdi + rdx*4], 0
+        e.byte(0x83); e.byte(0x3c); e.byte(0x80 | (HOST_RDX << 3) | HOST_RDI); e.byte(0);
+        miss3 = e.jcc(CC_NE);
+      }
+
+      e.mem(0x8b, HOST_RDX, HOST_RSI, (Bit32s)((Bit8u *) &tlb->hostPageAddr - tlb_base), true);
+      e.mov(HOST_RCX, HOST_RAX, false);
+      e.ri(4 /* and */, HOST_RCX, 0xfff, false);
+      e.rr(0x09, HOST_RDX, HOST_RCX, true);
+      if (store) {
+        e.mem(0x8b, HOST_RAX, HOST_RBX, BX_JIT_REG_OFFSET(insn->src()), qword);
+        e.rex(qword); e.byte(0x89); e.byte(0x00 | (HOST_RAX << 3) | HOST_RDX);  // mov [rdx], rax
+      }
+      else {
+        e.rex(qword); e.byte(0x8b); e.byte(0x00 | (HOST_RAX << 3) | HOST_RDX);  // mov rax, [rdx]
+        e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      }
+      Bit8u *done = e.jmp();
+
+      const void *access;
+      if (store)
+        access = qword ? jit_method_address(&BX_CPU_C::write_linear_qword) :
+                         jit_method_address(&BX_CPU_C::write_linear_dword);
+      else
+        access = qword ? jit_method_address(&BX_CPU_C::read_linear_qword) :
+                         jit_method_address(&BX_CPU_C::read_linear_dword);
+      if (! access) return;
+
+#if BX_USE_CPU_SMF
+      const unsigned arg0 = HOST_RDI, arg1 = HOST_RSI, arg2 = HOST_RDX;
+#else
+      const unsigned arg0 = HOST_RSI, arg1 = HOST_RDX, arg2 = HOST_RCX;
+#endif
+
+      // slow path: the linear address is still in rax, sync() uses rax
+      e.bind(miss1);
+      e.bind(miss2);
+      if (miss3) e.bind(miss3);
+      e.mov(arg1, HOST_RAX, true);
+      state.sync(insn->ilen());
+#if BX_USE_CPU_SMF == 0
+      e.mov(HOST_RDI, HOST_RBX, true);
+#endif
+      e.mov_imm32(arg0, seg);
+      if (store)
+        e.mem(0x8b, arg2, HOST_RBX, BX_JIT_REG_OFFSET(insn->src()), qword);
+      e.call(access);
+      if (! store) {
+        if (! qword) e.mov(HOST_RAX, HOST_RAX, false); // Bit32u return value
+        e.store64(HOST_RAX, BX_JIT_REG_OFFSET(insn->dst()));
+      }
+
+      // the access might have raised an event or hit translated code,
+      // complete the instruction and return to cpu_loop
+      e.mem(0x83, 7 /* cmp */, HOST_RBX, off_async, false); e.byte(0);
+      Bit8u *no_event = e.jcc(CC_E);
+      e.load64(HOST_RAX, state.off_rip);
+      e.store64(HOST_RAX, state.off_prev_rip);
+      e.add64_imm(state.off_icount, 1);
+      e.byte(0x5b); // pop rbx
+      e.byte(0xc3); // ret
+      e.bind(no_event);
+      state.unsync();
+      e.bind(done);
+      break;
+    }
+
+    default:
+    {
+      // execute the instruction handler on a private copy, followed by a stub
+      // which reports that the handler continued to the next instruction
+      const void *handler = jit_method_address(insn->execute1);
+      if (! handler || insn->execute1 == &BX_CPU_C::BxJitTrace) return;
+
+      bxInstruction_c *copy = helper;
+      bxInstruction_c *stub = helper + 1;
+      helper += 2;
+
+      *copy = *insn;
+      memset(stub, 0, sizeof(bxInstruction_c));
+      stub->setIaOpcode(BX_INSERTED_OPCODE);
+      stub->setILen(0);
+      stub->execute1 = &BX_CPU_C::BxJitHelperReturn;
+      stub->modRMForm.Id = 0;
+
+      state.flush(insn->ilen());
+#if BX_USE_CPU_SMF
+      e.mov_ptr(HOST_RDI, copy);
+#else
+      e.mov(HOST_RDI, HOST_RBX, true);
+      e.mov_ptr(HOST_RSI, copy);
+#endif
+      e.call(handler);
+      // cmp dword [stub->Id], 0 ; mov dword [stub->Id], 0 ; je exit
+      e.mov_ptr(HOST_RAX, &stub->modRMForm.Id);
+      e.byte(0x83); e.byte(0x38); e.byte(0);
+      e.byte(0xc7); e.byte(0x00); e.dword(0);
+      exit_sites[num_exit_sites++] = e.jcc(CC_E);
+      continue;
+    }
+    }
+
+    // inlined instruction completed
+    state.icount++;
+  }
+
+  // shared exit when a helper did not continue with the next instruction
+  for (unsigned k=0; k < num_exit_sites; k++)
+    e.bind(exit_sites[k]);
+  e.byte(0x5b); // pop rbx
+  e.byte(0xc3); // ret
+
+  Bit32u size = (Bit32u)(e.ptr - block);
+  BX_ASSERT(size <= max_size);
+  BX_CPU_THIS_PTR jit_arena_used += (size + 63) & ~63;
+
+  // patch the first instruction of the trace
+  trace->insn[0] = i[0];
+  // the copy is followed by the resume stub, not by the second instruction
+  // of a fused pair
+  trace->insn[0].execute1 = jit_unfused_handler(&i[0]);
+  memset(&trace->insn[1], 0, sizeof(bxInstruction_c));
+  trace->insn[1].setIaOpcode(BX_INSERTED_OPCODE);
+  trace->insn[1].setILen(0);
+  trace->insn[1].execute1 = &BX_CPU_C::BxJitResume;
+  trace->insn[1].handlers.next = &i[1];
+
+  i->execute1 = &BX_CPU_C::BxJitTrace;
+  i->handlers.next = (bxInstruction_c *) trace;
+}
+
+void BX_CPU_C::jitRestoreInstruction(bxInstruction_c *i)
+{
+  if (i->execute1 == &BX_CPU_C::BxJitTrace)
+    *i = ((bxJitTrace *) i->handlers.next)->insn[0];
+}
+
+void BX_CPU_C::jitFreeArena(void)
+{
+  if (BX_CPU_THIS_PTR jit_arena) {
+    munmap(BX_CPU_THIS_PTR jit_arena, BX_JIT_ARENA_SIZE);
+    BX_CPU_THIS_PTR jit_arena = NULL;
+  }
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::BxJitTrace(bxInstruction_c *i)
+{
+  bxJitTrace *trace = (bxJitTrace *) i->handlers.next;
+
+  if (BX_CPU_THIS_PTR async_event || BX_JIT_DEBUGGER_BYPASS || BX_JIT_INSTR_BYPASS) {
+    // pending event or single stepping, execute the original instructions
+    i = trace->insn;
+    BX_CPU_CALL_METHOD(i->execute1, (i));
+    return;
+  }
+
+  trace->code(BX_CPU_THIS);
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::BxJitResume(bxInstruction_c *i)
+{
+  // continue with the second instruction of the original trace
+  bxInstruction_c *next = i->handlers.next;
+  BX_EXECUTE_INSTRUCTION(next);
+}
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::BxJitHelperReturn(bxInstruction_c *i)
+{
+  // reached through BX_NEXT_INSTR of the helper call, tell the translated
+  // code to continue with the next instruction
+  i->modRMForm.Id = 1;
+}
+
+#endif // BX_SUPPORT_JIT
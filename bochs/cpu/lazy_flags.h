@@ -400,4 +400,98 @@ BX_CPP_INLINE void bx_lazyflags_entry::assert_CF(void)
   set_flags_OxxxxC(temp_of, 1);
 }
 
+// Jcc/CMOVcc condition of a fused instruction pair (see icache.cc) computed
+// from the operands and the result of the first instruction instead of being
+// read back from the lazy flags. cc is the condition code, odd conditions
+// are negated.
+
+template <typename T> BX_CPP_INLINE bool bx_cond_sign(T val)
+{
+  return (val >> (sizeof(T) * 8 - 1)) & 1;
+}
+
+BX_CPP_INLINE bool bx_cond_parity(Bit8u val_8)
+{
+  return (0x9669U >> ((val_8 ^ (val_8 >> 4)) & 0x0F)) & 1;
+}
+
+// CMP: result = op1 - op2
+template <typename T> BX_CPP_INLINE bool bx_cond_sub(unsigned cc, T op1, T op2, T result)
+{
+  const T sign = (T) 1 << (sizeof(T) * 8 - 1);
+  bool cond;
+
+  switch(cc >> 1) {
+  case 0: cond = bx_cond_sign((op1 ^ op2) & (op1 ^ result)); break;
+  case 1: cond = (op1 < op2); break;
+  case 2: cond = (result == 0); break;
+  case 3: cond = (op1 <= op2); break;
+  case 4: cond = bx_cond_sign(result); break;
+  case 5: cond = bx_cond_parity((Bit8u) result); break;
+  case 6: cond = ((op1 ^ sign) < (op2 ^ sign)); break; // signed less
+  default:
+    cond = ((op1 ^ sign) <= (op2 ^ sign)); break;
+  }
+  return cond ^ (cc & 1);
+}
+
+// TEST: OF and CF are cleared
+template <typename T> BX_CPP_INLINE bool bx_cond_logic(unsigned cc, T result)
+{
+  bool cond;
+
+  switch(cc >> 1) {
+  case 0:
+  case 1: cond = 0; break;
+  case 2:
+  case 3: cond = (result == 0); break;
+  case 4:
+  case 6: cond = bx_cond_sign(result); break;
+  case 5: cond = bx_cond_parity((Bit8u) result); break;
+  default:
+    cond = (result == 0) || bx_cond_sign(result); break;
+  }
+  return cond ^ (cc & 1);
+}
+
+// ADD: result = op1 + op2
+template <typename T> BX_CPP_INLINE bool bx_cond_add(unsigned cc, T op1, T op2, T result)
+{
+  bool cond;
+
+  switch(cc >> 1) {
+  case 0: cond = bx_cond_sign(~(op1 ^ op2) & (op1 ^ result)); break;
+  case 1: cond = (result < op1); break;
+  case 2: cond = (result == 0); break;
+  case 3: cond = (result < op1) || (result == 0); break;
+  case 4: cond = bx_cond_sign(result); break;
+  case 5: cond = bx_cond_parity((Bit8u) result); break;
+  case 6: cond = bx_cond_sign(result) ^ bx_cond_sign(~(op1 ^ op2) & (op1 ^ result)); break;
+  default:
+    cond = (result == 0) || (bx_cond_sign(result) ^ bx_cond_sign(~(op1 ^ op2) & (op1 ^ result))); break;
+  }
+  return cond ^ (cc & 1);
+}
+
+// DEC: CF is not changed by the instruction, it is only read for the
+// conditions using it
+template <typename T> BX_CPP_INLINE bool bx_cond_dec(unsigned cc, T result, const bx_lazyflags_entry &flags)
+{
+  const T max_signed = ((T) 1 << (sizeof(T) * 8 - 1)) - 1;
+  bool cond;
+
+  switch(cc >> 1) {
+  case 0: cond = (result == max_signed); break;
+  case 1: cond = flags.getB_CF(); break;
+  case 2: cond = (result == 0); break;
+  case 3: cond = (result == 0) || flags.getB_CF(); break;
+  case 4: cond = bx_cond_sign(result); break;
+  case 5: cond = bx_cond_parity((Bit8u) result); break;
+  case 6: cond = bx_cond_sign(result) ^ (result == max_signed); break;
+  default:
+    cond = (result == 0) || (bx_cond_sign(result) ^ (result == max_signed)); break;
+  }
+  return cond ^ (cc & 1);
+}
+
 #endif // BX_LAZY_FLAGS_DEF
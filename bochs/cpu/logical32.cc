@@ -61,6 +61,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  op2_32 = BX_READ_32BIT_REG(i->src());
+  op1_32 ^= op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GdEdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
@@ -103,6 +115,15 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EdIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  op1_32 ^= i->Id();
+  BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdM(bxInstruction_c *i)
 {
   Bit32u op1_32;
@@ -129,6 +150,15 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EdIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  op1_32 |= i->Id();
+  BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::NOT_EdM(bxInstruction_c *i)
 {
   bx_address eaddr = BX_CPU_RESOLVE_ADDR(i);
@@ -179,6 +209,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  op2_32 = BX_READ_32BIT_REG(i->src());
+  op1_32 |= op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GdEdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
@@ -225,6 +267,18 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32, op2_32;
+
+  op1_32 = BX_READ_32BIT_REG(i->dst());
+  op2_32 = BX_READ_32BIT_REG(i->src());
+  op1_32 &= op2_32;
+  BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GdEdM(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
@@ -267,6 +321,15 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EdIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  op1_32 &= i->Id();
+  BX_WRITE_32BIT_REGZ(i->dst(), op1_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_32(op1_32));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EdGdR(bxInstruction_c *i)
 {
   Bit32u op1_32, op2_32;
@@ -57,6 +57,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = BX_READ_64BIT_REG(i->src());
+  op1_64 ^= op2_64;
+
+  BX_WRITE_64BIT_REG(i->dst(), op1_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_GqEqM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
@@ -102,6 +115,17 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::XOR_EqIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64 = (Bit32s) i->Id();
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op1_64 ^= op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), op1_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64 = (Bit32s) i->Id();
@@ -130,6 +154,17 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_EqIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64 = (Bit32s) i->Id();
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op1_64 |= op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), op1_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::NOT_EqM(bxInstruction_c *i)
 {
   bx_address eaddr = BX_CPU_RESOLVE_ADDR_64(i);
@@ -181,6 +216,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = BX_READ_64BIT_REG(i->src());
+  op1_64 |= op2_64;
+
+  BX_WRITE_64BIT_REG(i->dst(), op1_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::OR_GqEqM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
@@ -229,6 +277,19 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64;
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op2_64 = BX_READ_64BIT_REG(i->src());
+  op1_64 &= op2_64;
+
+  BX_WRITE_64BIT_REG(i->dst(), op1_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_GqEqM(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
@@ -274,6 +335,17 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::AND_EqIdR_NoFlags(bxInstruction_c *i)
+{
+  Bit64u op1_64, op2_64 = (Bit32s) i->Id();
+
+  op1_64 = BX_READ_64BIT_REG(i->dst());
+  op1_64 &= op2_64;
+  BX_WRITE_64BIT_REG(i->dst(), op1_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, SET_FLAGS_OSZAPC_LOGIC_64(op1_64));
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::TEST_EqGqR(bxInstruction_c *i)
 {
   Bit64u op1_64, op2_64;
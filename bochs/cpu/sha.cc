@@ -29,6 +29,7 @@
 #if BX_CPU_LEVEL >= 6
 
 #include "scalar_arith.h"
+#include "hostcpu.h"
 
 //
 // sha_f0(): A bit oriented logical operation that derives a new dword from three SHA1 state variables (dword).
@@ -117,6 +118,154 @@ BX_CPP_INLINE Bit32u sha256_transformation_rrs(Bit32u val_32, unsigned rotate1,
   return ror32(val_32, rotate1) ^ ror32(val_32, rotate2) ^ (val_32 >> shr);
 }
 
+static void sha256rnds2_portable(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *wk)
+{
+  Bit32u A[3], B[3], C[3], D[3], E[3], F[3], G[3], H[3];
+
+  A[0] = op2->xmm32u(3);
+  B[0] = op2->xmm32u(2);
+  E[0] = op2->xmm32u(1);
+  F[0] = op2->xmm32u(0);
+
+  C[0] = op1->xmm32u(3);
+  D[0] = op1->xmm32u(2);
+  G[0] = op1->xmm32u(1);
+  H[0] = op1->xmm32u(0);
+
+  for (unsigned n=0; n < 2; n++) {
+    Bit32u   tmp = sha_ch (E[n], F[n], G[n]) + sha256_transformation_rrr(E[n], 6, 11, 25) + wk->xmm32u(n) + H[n];
+    A[n+1] = tmp + sha_maj(A[n], B[n], C[n]) + sha256_transformation_rrr(A[n], 2, 13, 22);
+    B[n+1] = A[n];
+    C[n+1] = B[n];
+    D[n+1] = C[n];
+    E[n+1] = tmp + D[n];
+    F[n+1] = E[n];
+    G[n+1] = F[n];
+    H[n+1] = G[n];
+  }
+
+  op1->xmm32u(0) = F[2];
+  op1->xmm32u(1) = E[2];
+  op1->xmm32u(2) = B[2];
+  op1->xmm32u(3) = A[2];
+}
+
+static void sha1rnds4_portable(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, unsigned imm)
+{
+  // SHA1 Constants dependent on immediate i
+  static const Bit32u sha_Ki[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+  Bit32u K = sha_Ki[imm];
+
+  Bit32u A, B, C, D, E, W[4];
+
+  A = op1->xmm32u(3);
+  B = op1->xmm32u(2);
+  C = op1->xmm32u(1);
+  D = op1->xmm32u(0);
+  E = 0;
+
+  W[0] = op2->xmm32u(3);
+  W[1] = op2->xmm32u(2);
+  W[2] = op2->xmm32u(1);
+  W[3] = op2->xmm32u(0);
+
+  for (unsigned n=0; n < 4; n++) {
+    Bit32u A_next = sha_f(B, C, D, imm) + rol32(A, 5) + W[n] + E + K;
+
+    E = D;
+    D = C;
+    C = rol32(B, 30);
+    B = A;
+    A = A_next;
+  }
+
+  op1->xmm32u(3) = A;
+  op1->xmm32u(2) = B;
+  op1->xmm32u(1) = C;
+  op1->xmm32u(0) = D;
+}
+
+#if BX_HAVE_X86_INTRINSICS
+
+BX_HOST_TARGET("sha") static void host_sha256rnds2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *wk)
+{
+  BX_HOST_XMM_STORE(op1, _mm_sha256rnds2_epu32(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), BX_HOST_XMM_LOAD(wk)));
+}
+
+// the round function selector is an immediate of the host instruction
+BX_HOST_TARGET("sha") static void host_sha1rnds4(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, unsigned imm)
+{
+  __m128i abcd = BX_HOST_XMM_LOAD(op1), w = BX_HOST_XMM_LOAD(op2);
+
+  switch(imm) {
+  case 0:
+    abcd = _mm_sha1rnds4_epu32(abcd, w, 0);
+    break;
+  case 1:
+    abcd = _mm_sha1rnds4_epu32(abcd, w, 1);
+    break;
+  case 2:
+    abcd = _mm_sha1rnds4_epu32(abcd, w, 2);
+    break;
+  default:
+    abcd = _mm_sha1rnds4_epu32(abcd, w, 3);
+    break;
+  }
+
+  BX_HOST_XMM_STORE(op1, abcd);
+}
+
+bool bx_host_sha_selftest(void)
+{
+  static const Bit64u sha1rnds4_result[4][2] = {
+    { BX_CONST64(0xd80be11fc27a282f), BX_CONST64(0x4c98cee8df735d84) },
+    { BX_CONST64(0x409004f2d437bb54), BX_CONST64(0xde692e185c0047bb) },
+    { BX_CONST64(0x64d93e13414edfff), BX_CONST64(0x67293f52ed98ee54) },
+    { BX_CONST64(0xb99cd9c11bab84b7), BX_CONST64(0xd1921550b2e27d48) }
+  };
+  BxPackedXmmRegister op1, op2, wk, r;
+  bx_host_selftest_input(&op1, &op2);
+  wk.xmm64u(1) = BX_CONST64(0x0123456789abcdef);
+  wk.xmm64u(0) = BX_CONST64(0xfedcba9876543210);
+
+  r = op1; host_sha256rnds2(&r, &op2, &wk);
+  if (! bx_host_selftest_expect(&r, BX_CONST64(0xa71ccf287d266c37), BX_CONST64(0x92d40b90541005bf)))
+    return false;
+
+  for (unsigned imm=0; imm < 4; imm++) {
+    r = op1; host_sha1rnds4(&r, &op2, imm);
+    if (! bx_host_selftest_expect(&r, sha1rnds4_result[imm][0], sha1rnds4_result[imm][1]))
+      return false;
+  }
+
+  return true;
+}
+
+#endif // BX_HAVE_X86_INTRINSICS
+
+BX_CPP_INLINE void sha256rnds2(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *wk)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_SHA)) {
+    host_sha256rnds2(op1, op2, wk);
+    return;
+  }
+#endif
+  sha256rnds2_portable(op1, op2, wk);
+}
+
+BX_CPP_INLINE void sha1rnds4(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, unsigned imm)
+{
+#if BX_HAVE_X86_INTRINSICS
+  if (bx_host_cpu_supports(BX_HOST_CPU_SHA)) {
+    host_sha1rnds4(op1, op2, imm);
+    return;
+  }
+#endif
+  sha1rnds4_portable(op1, op2, imm);
+}
+
 /* 0F 38 C8 */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA1NEXTE_VdqWdqR(bxInstruction_c *i)
 {
@@ -164,34 +313,7 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256RNDS2_VdqWdqR(bxInstruction_c *i)
 {
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src()), wk = BX_READ_XMM_REG(0);
 
-  Bit32u A[3], B[3], C[3], D[3], E[3], F[3], G[3], H[3];
-
-  A[0] = op2.xmm32u(3);
-  B[0] = op2.xmm32u(2);
-  E[0] = op2.xmm32u(1);
-  F[0] = op2.xmm32u(0);
-
-  C[0] = op1.xmm32u(3);
-  D[0] = op1.xmm32u(2);
-  G[0] = op1.xmm32u(1);
-  H[0] = op1.xmm32u(0);
-
-  for (unsigned n=0; n < 2; n++) {
-    Bit32u   tmp = sha_ch (E[n], F[n], G[n]) + sha256_transformation_rrr(E[n], 6, 11, 25) + wk.xmm32u(n) + H[n];
-    A[n+1] = tmp + sha_maj(A[n], B[n], C[n]) + sha256_transformation_rrr(A[n], 2, 13, 22);
-    B[n+1] = A[n];
-    C[n+1] = B[n];
-    D[n+1] = C[n];
-    E[n+1] = tmp + D[n];
-    F[n+1] = E[n];
-    G[n+1] = F[n];
-    H[n+1] = G[n];
-  }
-
-  op1.xmm32u(0) = F[2];
-  op1.xmm32u(1) = E[2];
-  op1.xmm32u(2) = B[2];
-  op1.xmm32u(3) = A[2];
+  sha256rnds2(&op1, &op2, &wk);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
@@ -232,40 +354,9 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA256MSG2_VdqWdqR(bxInstruction_c *i)
 /* 0F 3A CC */
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHA1RNDS4_VdqWdqIbR(bxInstruction_c *i)
 {
-  // SHA1 Constants dependent on immediate i
-  static const Bit32u sha_Ki[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
-
   BxPackedXmmRegister op1 = BX_READ_XMM_REG(i->dst()), op2 = BX_READ_XMM_REG(i->src());
-  unsigned imm = i->Ib() & 0x3;
-  Bit32u K = sha_Ki[imm];
-
-  Bit32u A, B, C, D, E, W[4];
-
-  A = op1.xmm32u(3);
-  B = op1.xmm32u(2);
-  C = op1.xmm32u(1);
-  D = op1.xmm32u(0);
-  E = 0;
-
-  W[0] = op2.xmm32u(3);
-  W[1] = op2.xmm32u(2);
-  W[2] = op2.xmm32u(1);
-  W[3] = op2.xmm32u(0);
-
-  for (unsigned n=0; n < 4; n++) {
-    Bit32u A_next = sha_f(B, C, D, imm) + rol32(A, 5) + W[n] + E + K;
-
-    E = D;
-    D = C;
-    C = rol32(B, 30);
-    B = A;
-    A = A_next;
-  }
 
-  op1.xmm32u(3) = A;
-  op1.xmm32u(2) = B;
-  op1.xmm32u(1) = C;
-  op1.xmm32u(0) = D;
+  sha1rnds4(&op1, &op2, i->Ib() & 0x3);
 
   BX_WRITE_XMM_REG(i->dst(), op1);
 
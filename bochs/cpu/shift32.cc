@@ -499,6 +499,29 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHL_EdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHL_EdR_NoFlags(bxInstruction_c *i)
+{
+  unsigned count;
+
+  if (i->getIaOpcode() == BX_IA_SHL_Ed)
+    count = CL;
+  else
+    count = i->Ib();
+
+  count &= 0x1f;
+
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u result_32 = (op1_32 << count);
+  BX_WRITE_32BIT_REGZ(i->dst(), result_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, if (count) {
+    unsigned cf = (op1_32 >> (32 - count)) & 0x1;
+    unsigned of = cf ^ (result_32 >> 31);
+    SET_FLAGS_OSZAPC_LOGIC_32(result_32);
+    BX_CPU_THIS_PTR oszapc.set_flags_OxxxxC(of, cf);
+  });
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHR_EdM(bxInstruction_c *i)
 {
   unsigned count;
@@ -562,6 +585,29 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHR_EdR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHR_EdR_NoFlags(bxInstruction_c *i)
+{
+  unsigned count;
+
+  if (i->getIaOpcode() == BX_IA_SHR_Ed)
+    count = CL;
+  else
+    count = i->Ib();
+
+  count &= 0x1f;
+
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u result_32 = (op1_32 >> count);
+  BX_WRITE_32BIT_REGZ(i->dst(), result_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, if (count) {
+    unsigned cf = (op1_32 >> (count - 1)) & 0x1;
+    unsigned of = ((result_32 << 1) ^ result_32) >> 31;
+    SET_FLAGS_OSZAPC_LOGIC_32(result_32);
+    BX_CPU_THIS_PTR oszapc.set_flags_OxxxxC(of, cf);
+  });
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SAR_EdM(bxInstruction_c *i)
 {
   unsigned count;
@@ -620,3 +666,25 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SAR_EdR(bxInstruction_c *i)
 
   BX_NEXT_INSTR(i);
 }
+
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SAR_EdR_NoFlags(bxInstruction_c *i)
+{
+  unsigned count;
+
+  if (i->getIaOpcode() == BX_IA_SAR_Ed)
+    count = CL;
+  else
+    count = i->Ib();
+
+  count &= 0x1f;
+
+  Bit32u op1_32 = BX_READ_32BIT_REG(i->dst());
+  Bit32u result_32 = ((Bit32s) op1_32) >> count;
+  BX_WRITE_32BIT_REGZ(i->dst(), result_32);
+
+  BX_NEXT_INSTR_NOFLAGS(i, if (count) {
+    unsigned cf = (op1_32 >> (count - 1)) & 1;
+    SET_FLAGS_OSZAPC_LOGIC_32(result_32);
+    BX_CPU_THIS_PTR oszapc.set_flags_OxxxxC(0, cf);
+  });
+}
@@ -484,6 +484,29 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHL_EqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHL_EqR_NoFlags(bxInstruction_c *i)
+{
+  unsigned count;
+
+  if (i->getIaOpcode() == BX_IA_SHL_Eq)
+    count = CL;
+  else
+    count = i->Ib();
+
+  count &= 0x3f;
+
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u result_64 = (op1_64 << count);
+  BX_WRITE_64BIT_REG(i->dst(), result_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, if (count) {
+    unsigned cf = (op1_64 >> (64 - count)) & 0x1;
+    unsigned of = cf ^ (result_64 >> 63);
+    SET_FLAGS_OSZAPC_LOGIC_64(result_64);
+    BX_CPU_THIS_PTR oszapc.set_flags_OxxxxC(of, cf);
+  });
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHR_EqM(bxInstruction_c *i)
 {
   unsigned count;
@@ -544,6 +567,29 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHR_EqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SHR_EqR_NoFlags(bxInstruction_c *i)
+{
+  unsigned count;
+
+  if (i->getIaOpcode() == BX_IA_SHR_Eq)
+    count = CL;
+  else
+    count = i->Ib();
+
+  count &= 0x3f;
+
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u result_64 = (op1_64 >> count);
+  BX_WRITE_64BIT_REG(i->dst(), result_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, if (count) {
+    unsigned cf = (op1_64 >> (count - 1)) & 0x1;
+    unsigned of = ((result_64 << 1) ^ result_64) >> 63;
+    SET_FLAGS_OSZAPC_LOGIC_64(result_64);
+    BX_CPU_THIS_PTR oszapc.set_flags_OxxxxC(of, cf);
+  });
+}
+
 void BX_CPP_AttrRegparmN(1) BX_CPU_C::SAR_EqM(bxInstruction_c *i)
 {
   unsigned count;
@@ -600,4 +646,26 @@ void BX_CPP_AttrRegparmN(1) BX_CPU_C::SAR_EqR(bxInstruction_c *i)
   BX_NEXT_INSTR(i);
 }
 
+void BX_CPP_AttrRegparmN(1) BX_CPU_C::SAR_EqR_NoFlags(bxInstruction_c *i)
+{
+  unsigned count;
+
+  if (i->getIaOpcode() == BX_IA_SAR_Eq)
+    count = CL;
+  else
+    count = i->Ib();
+
+  count &= 0x3f;
+
+  Bit64u op1_64 = BX_READ_64BIT_REG(i->dst());
+  Bit64u result_64 = ((Bit64s) op1_64) >> count;
+  BX_WRITE_64BIT_REG(i->dst(), result_64);
+
+  BX_NEXT_INSTR_NOFLAGS(i, if (count) {
+    unsigned cf = (op1_64 >> (count - 1)) & 1;
+    SET_FLAGS_OSZAPC_LOGIC_64(result_64);
+    BX_CPU_THIS_PTR oszapc.set_flags_OxxxxC(0, cf);
+  });
+}
+
 #endif /* if BX_SUPPORT_X86_64 */
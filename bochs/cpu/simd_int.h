@@ -24,27 +24,44 @@
 #ifndef BX_SIMD_INT_FUNCTIONS_H
 #define BX_SIMD_INT_FUNCTIONS_H
 
+#include "hostcpu.h"
+
 // absolute value
 
 BX_CPP_INLINE void xmm_pabsb(BxPackedXmmRegister *op)
 {
+#if BX_HOST_SSE2
+  __m128i x = BX_HOST_XMM_LOAD(op);
+  BX_HOST_XMM_STORE(op, _mm_min_epu8(x, _mm_sub_epi8(_mm_setzero_si128(), x)));
+#else
   for(unsigned n=0; n<16; n++) {
     if(op->xmmsbyte(n) < 0) op->xmmubyte(n) = -op->xmmsbyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pabsw(BxPackedXmmRegister *op)
 {
+#if BX_HOST_SSE2
+  __m128i x = BX_HOST_XMM_LOAD(op);
+  BX_HOST_XMM_STORE(op, _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x)));
+#else
   for(unsigned n=0; n<8; n++) {
     if(op->xmm16s(n) < 0) op->xmm16u(n) = -op->xmm16s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pabsd(BxPackedXmmRegister *op)
 {
+#if BX_HOST_SSE2
+  __m128i x = BX_HOST_XMM_LOAD(op), sign = _mm_srai_epi32(x, 31);
+  BX_HOST_XMM_STORE(op, _mm_sub_epi32(_mm_xor_si128(x, sign), sign));
+#else
   for(unsigned n=0; n<4; n++) {
     if(op->xmm32s(n) < 0) op->xmm32u(n) = -op->xmm32s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pabsq(BxPackedXmmRegister *op)
@@ -58,44 +75,74 @@ BX_CPP_INLINE void xmm_pabsq(BxPackedXmmRegister *op)
 
 BX_CPP_INLINE void xmm_pminsb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(a, b, _mm_cmpgt_epi8(a, b)));
+#else
   for(unsigned n=0; n<16; n++) {
     if(op2->xmmsbyte(n) < op1->xmmsbyte(n)) op1->xmmubyte(n) = op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pminub(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_min_epu8);
+#else
   for(unsigned n=0; n<16; n++) {
     if(op2->xmmubyte(n) < op1->xmmubyte(n)) op1->xmmubyte(n) = op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pminsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_min_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     if(op2->xmm16s(n) < op1->xmm16s(n)) op1->xmm16s(n) = op2->xmm16s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pminuw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  const __m128i bias = _mm_set1_epi16((short) 0x8000);
+  __m128i a = _mm_xor_si128(BX_HOST_XMM_LOAD(op1), bias), b = _mm_xor_si128(BX_HOST_XMM_LOAD(op2), bias);
+  BX_HOST_XMM_STORE(op1, _mm_xor_si128(_mm_min_epi16(a, b), bias));
+#else
   for(unsigned n=0; n<8; n++) {
     if(op2->xmm16u(n) < op1->xmm16u(n)) op1->xmm16s(n) = op2->xmm16s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pminsd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(a, b, _mm_cmpgt_epi32(a, b)));
+#else
   for(unsigned n=0; n<4; n++) {
     if(op2->xmm32s(n) < op1->xmm32s(n)) op1->xmm32u(n) = op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pminud(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  const __m128i bias = _mm_set1_epi32((int) 0x80000000);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(a, b, _mm_cmpgt_epi32(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias))));
+#else
   for(unsigned n=0; n<4; n++) {
     if(op2->xmm32u(n) < op1->xmm32u(n)) op1->xmm32u(n) = op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pminsq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -114,44 +161,74 @@ BX_CPP_INLINE void xmm_pminuq(BxPackedXmmRegister *op1, const BxPackedXmmRegiste
 
 BX_CPP_INLINE void xmm_pmaxsb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(a, b, _mm_cmpgt_epi8(b, a)));
+#else
   for(unsigned n=0; n<16; n++) {
     if(op2->xmmsbyte(n) > op1->xmmsbyte(n)) op1->xmmubyte(n) = op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmaxub(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_max_epu8);
+#else
   for(unsigned n=0; n<16; n++) {
     if(op2->xmmubyte(n) > op1->xmmubyte(n)) op1->xmmubyte(n) = op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmaxsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_max_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     if(op2->xmm16s(n) > op1->xmm16s(n)) op1->xmm16s(n) = op2->xmm16s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmaxuw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  const __m128i bias = _mm_set1_epi16((short) 0x8000);
+  __m128i a = _mm_xor_si128(BX_HOST_XMM_LOAD(op1), bias), b = _mm_xor_si128(BX_HOST_XMM_LOAD(op2), bias);
+  BX_HOST_XMM_STORE(op1, _mm_xor_si128(_mm_max_epi16(a, b), bias));
+#else
   for(unsigned n=0; n<8; n++) {
     if(op2->xmm16u(n) > op1->xmm16u(n)) op1->xmm16s(n) = op2->xmm16s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmaxsd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(a, b, _mm_cmpgt_epi32(b, a)));
+#else
   for(unsigned n=0; n<4; n++) {
     if(op2->xmm32s(n) > op1->xmm32s(n)) op1->xmm32u(n) = op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmaxud(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  const __m128i bias = _mm_set1_epi32((int) 0x80000000);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(a, b, _mm_cmpgt_epi32(_mm_xor_si128(b, bias), _mm_xor_si128(a, bias))));
+#else
   for(unsigned n=0; n<4; n++) {
     if(op2->xmm32u(n) > op1->xmm32u(n)) op1->xmm32u(n) = op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmaxsq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -172,34 +249,53 @@ BX_CPP_INLINE void xmm_pmaxuq(BxPackedXmmRegister *op1, const BxPackedXmmRegiste
 
 BX_CPP_INLINE void xmm_unpcklps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpacklo_epi32);
+#else
   op1->xmm32u(3) = op2->xmm32u(1);
   op1->xmm32u(2) = op1->xmm32u(1);
   op1->xmm32u(1) = op2->xmm32u(0);
 //op1->xmm32u(0) = op1->xmm32u(0);
+#endif
 }
 
 BX_CPP_INLINE void xmm_unpckhps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpackhi_epi32);
+#else
   op1->xmm32u(0) = op1->xmm32u(2);
   op1->xmm32u(1) = op2->xmm32u(2);
   op1->xmm32u(2) = op1->xmm32u(3);
   op1->xmm32u(3) = op2->xmm32u(3);
+#endif
 }
 
 BX_CPP_INLINE void xmm_unpcklpd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpacklo_epi64);
+#else
 //op1->xmm64u(0) = op1->xmm64u(0);
   op1->xmm64u(1) = op2->xmm64u(0);
+#endif
 }
 
 BX_CPP_INLINE void xmm_unpckhpd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpackhi_epi64);
+#else
   op1->xmm64u(0) = op1->xmm64u(1);
   op1->xmm64u(1) = op2->xmm64u(1);
+#endif
 }
 
 BX_CPP_INLINE void xmm_punpcklbw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpacklo_epi8);
+#else
   op1->xmmubyte(0xF) = op2->xmmubyte(7);
   op1->xmmubyte(0xE) = op1->xmmubyte(7);
   op1->xmmubyte(0xD) = op2->xmmubyte(6);
@@ -216,10 +312,14 @@ BX_CPP_INLINE void xmm_punpcklbw(BxPackedXmmRegister *op1, const BxPackedXmmRegi
   op1->xmmubyte(0x2) = op1->xmmubyte(1);
   op1->xmmubyte(0x1) = op2->xmmubyte(0);
 //op1->xmmubyte(0x0) = op1->xmmubyte(0);
+#endif
 }
 
 BX_CPP_INLINE void xmm_punpckhbw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpackhi_epi8);
+#else
   op1->xmmubyte(0x0) = op1->xmmubyte(0x8);
   op1->xmmubyte(0x1) = op2->xmmubyte(0x8);
   op1->xmmubyte(0x2) = op1->xmmubyte(0x9);
@@ -236,10 +336,14 @@ BX_CPP_INLINE void xmm_punpckhbw(BxPackedXmmRegister *op1, const BxPackedXmmRegi
   op1->xmmubyte(0xD) = op2->xmmubyte(0xE);
   op1->xmmubyte(0xE) = op1->xmmubyte(0xF);
   op1->xmmubyte(0xF) = op2->xmmubyte(0xF);
+#endif
 }
 
 BX_CPP_INLINE void xmm_punpcklwd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpacklo_epi16);
+#else
   op1->xmm16u(7) = op2->xmm16u(3);
   op1->xmm16u(6) = op1->xmm16u(3);
   op1->xmm16u(5) = op2->xmm16u(2);
@@ -248,10 +352,14 @@ BX_CPP_INLINE void xmm_punpcklwd(BxPackedXmmRegister *op1, const BxPackedXmmRegi
   op1->xmm16u(2) = op1->xmm16u(1);
   op1->xmm16u(1) = op2->xmm16u(0);
 //op1->xmm16u(0) = op1->xmm16u(0);
+#endif
 }
 
 BX_CPP_INLINE void xmm_punpckhwd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_unpackhi_epi16);
+#else
   op1->xmm16u(0) = op1->xmm16u(4);
   op1->xmm16u(1) = op2->xmm16u(4);
   op1->xmm16u(2) = op1->xmm16u(5);
@@ -260,12 +368,16 @@ BX_CPP_INLINE void xmm_punpckhwd(BxPackedXmmRegister *op1, const BxPackedXmmRegi
   op1->xmm16u(5) = op2->xmm16u(6);
   op1->xmm16u(6) = op1->xmm16u(7);
   op1->xmm16u(7) = op2->xmm16u(7);
+#endif
 }
 
 // pack
 
 BX_CPP_INLINE void xmm_packuswb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_packus_epi16);
+#else
   op1->xmmubyte(0x0) = SaturateWordSToByteU(op1->xmm16s(0));
   op1->xmmubyte(0x1) = SaturateWordSToByteU(op1->xmm16s(1));
   op1->xmmubyte(0x2) = SaturateWordSToByteU(op1->xmm16s(2));
@@ -283,10 +395,14 @@ BX_CPP_INLINE void xmm_packuswb(BxPackedXmmRegister *op1, const BxPackedXmmRegis
   op1->xmmubyte(0xD) = SaturateWordSToByteU(op2->xmm16s(5));
   op1->xmmubyte(0xE) = SaturateWordSToByteU(op2->xmm16s(6));
   op1->xmmubyte(0xF) = SaturateWordSToByteU(op2->xmm16s(7));
+#endif
 }
 
 BX_CPP_INLINE void xmm_packsswb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_packs_epi16);
+#else
   op1->xmmsbyte(0x0) = SaturateWordSToByteS(op1->xmm16s(0));
   op1->xmmsbyte(0x1) = SaturateWordSToByteS(op1->xmm16s(1));
   op1->xmmsbyte(0x2) = SaturateWordSToByteS(op1->xmm16s(2));
@@ -304,10 +420,22 @@ BX_CPP_INLINE void xmm_packsswb(BxPackedXmmRegister *op1, const BxPackedXmmRegis
   op1->xmmsbyte(0xD) = SaturateWordSToByteS(op2->xmm16s(5));
   op1->xmmsbyte(0xE) = SaturateWordSToByteS(op2->xmm16s(6));
   op1->xmmsbyte(0xF) = SaturateWordSToByteS(op2->xmm16s(7));
+#endif
 }
 
 BX_CPP_INLINE void xmm_packusdw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  // clamp to [0, 0xffff] and pack with a bias, SSE2 has only the signed form
+  const __m128i max = _mm_set1_epi32(0xffff), bias32 = _mm_set1_epi32(0x8000);
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  a = _mm_andnot_si128(_mm_srai_epi32(a, 31), a);
+  b = _mm_andnot_si128(_mm_srai_epi32(b, 31), b);
+  a = bx_host_blend(a, max, _mm_cmpgt_epi32(a, max));
+  b = bx_host_blend(b, max, _mm_cmpgt_epi32(b, max));
+  __m128i r = _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32));
+  BX_HOST_XMM_STORE(op1, _mm_xor_si128(r, _mm_set1_epi16((short) 0x8000)));
+#else
   op1->xmm16u(0) = SaturateDwordSToWordU(op1->xmm32s(0));
   op1->xmm16u(1) = SaturateDwordSToWordU(op1->xmm32s(1));
   op1->xmm16u(2) = SaturateDwordSToWordU(op1->xmm32s(2));
@@ -317,10 +445,14 @@ BX_CPP_INLINE void xmm_packusdw(BxPackedXmmRegister *op1, const BxPackedXmmRegis
   op1->xmm16u(5) = SaturateDwordSToWordU(op2->xmm32s(1));
   op1->xmm16u(6) = SaturateDwordSToWordU(op2->xmm32s(2));
   op1->xmm16u(7) = SaturateDwordSToWordU(op2->xmm32s(3));
+#endif
 }
 
 BX_CPP_INLINE void xmm_packssdw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_packs_epi32);
+#else
   op1->xmm16s(0) = SaturateDwordSToWordS(op1->xmm32s(0));
   op1->xmm16s(1) = SaturateDwordSToWordS(op1->xmm32s(1));
   op1->xmm16s(2) = SaturateDwordSToWordS(op1->xmm32s(2));
@@ -330,12 +462,15 @@ BX_CPP_INLINE void xmm_packssdw(BxPackedXmmRegister *op1, const BxPackedXmmRegis
   op1->xmm16s(5) = SaturateDwordSToWordS(op2->xmm32s(1));
   op1->xmm16s(6) = SaturateDwordSToWordS(op2->xmm32s(2));
   op1->xmm16s(7) = SaturateDwordSToWordS(op2->xmm32s(3));
+#endif
 }
 
 // shuffle
 
 BX_CPP_INLINE void xmm_pshufb(BxPackedXmmRegister *r, const BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+  BX_HOST_DISPATCH(BX_HOST_CPU_SSSE3, host_xmm_pshufb(r, op1, op2));
+
   for(unsigned n=0; n<16; n++)
   {
     unsigned mask = op2->xmmubyte(n);
@@ -428,26 +563,47 @@ BX_CPP_INLINE void ymm_vpermq(BxPackedYmmRegister *r, const BxPackedYmmRegister
 
 BX_CPP_INLINE void xmm_psignb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2), zero = _mm_setzero_si128();
+  __m128i neg = _mm_cmpgt_epi8(zero, b);
+  a = _mm_sub_epi8(_mm_xor_si128(a, neg), neg);
+  BX_HOST_XMM_STORE(op1, _mm_andnot_si128(_mm_cmpeq_epi8(b, zero), a));
+#else
   for(unsigned n=0; n<16; n++) {
     int sign = (op2->xmmsbyte(n) > 0) - (op2->xmmsbyte(n) < 0);
     op1->xmmsbyte(n) *= sign;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psignw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2), zero = _mm_setzero_si128();
+  __m128i neg = _mm_cmpgt_epi16(zero, b);
+  a = _mm_sub_epi16(_mm_xor_si128(a, neg), neg);
+  BX_HOST_XMM_STORE(op1, _mm_andnot_si128(_mm_cmpeq_epi16(b, zero), a));
+#else
   for(unsigned n=0; n<8; n++) {
     int sign = (op2->xmm16s(n) > 0) - (op2->xmm16s(n) < 0);
     op1->xmm16s(n) *= sign;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psignd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2), zero = _mm_setzero_si128();
+  __m128i neg = _mm_cmpgt_epi32(zero, b);
+  a = _mm_sub_epi32(_mm_xor_si128(a, neg), neg);
+  BX_HOST_XMM_STORE(op1, _mm_andnot_si128(_mm_cmpeq_epi32(b, zero), a));
+#else
   for(unsigned n=0; n<4; n++) {
     int sign = (op2->xmm32s(n) > 0) - (op2->xmm32s(n) < 0);
     op1->xmm32s(n) *= sign;
   }
+#endif
 }
 
 // mask creation
@@ -545,289 +701,468 @@ BX_CPP_INLINE void xmm_pmovm2q(BxPackedXmmRegister *dst, Bit32u mask)
 
 BX_CPP_INLINE void xmm_pblendb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), bx_host_expand_mask_b(mask)));
+#else
   for (unsigned n=0; n < 16; n++, mask >>= 1) {
     if (mask & 0x1) op1->xmmubyte(n) = op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_zero_pblendb(BxPackedXmmRegister *dst, const BxPackedXmmRegister *op, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(dst, _mm_and_si128(BX_HOST_XMM_LOAD(op), bx_host_expand_mask_b(mask)));
+#else
   for (unsigned n=0; n < 16; n++, mask >>= 1) {
     dst->xmmubyte(n) = (mask & 0x1) ? op->xmmubyte(n) : 0;
   }
+#endif
 }
 
 #if BX_SUPPORT_EVEX
 BX_CPP_INLINE void simd_pblendb(BxPackedAvxRegister *op1, const BxPackedAvxRegister *op2, Bit64u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 16, mask >>= 16) {
+    BxPackedXmmRegister *r = &op1->vmm128(n / 16);
+    BX_HOST_XMM_STORE(r, bx_host_blend(BX_HOST_XMM_LOAD(r), BX_HOST_XMM_LOAD(&op2->vmm128(n / 16)), bx_host_expand_mask_b((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     if (mask & 0x1) op1->vmmubyte(n) = op2->vmmubyte(n);
     mask >>= 1;
   }
+#endif
 }
 
 BX_CPP_INLINE void simd_zero_pblendb(BxPackedAvxRegister *dst, const BxPackedAvxRegister *op, Bit64u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 16, mask >>= 16) {
+    BX_HOST_XMM_STORE(&dst->vmm128(n / 16), _mm_and_si128(BX_HOST_XMM_LOAD(&op->vmm128(n / 16)), bx_host_expand_mask_b((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     dst->vmmubyte(n) = (mask & 0x1) ? op->vmmubyte(n) : 0;
     mask >>= 1;
   }
+#endif
 }
 #endif
 
 BX_CPP_INLINE void xmm_pblendw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), bx_host_expand_mask_w(mask)));
+#else
   for (unsigned n=0; n < 8; n++, mask >>= 1) {
     if (mask & 0x1) op1->xmm16u(n) = op2->xmm16u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_zero_pblendw(BxPackedXmmRegister *dst, const BxPackedXmmRegister *op, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(dst, _mm_and_si128(BX_HOST_XMM_LOAD(op), bx_host_expand_mask_w(mask)));
+#else
   for (unsigned n=0; n < 8; n++, mask >>= 1) {
     dst->xmm16u(n) = (mask & 0x1) ? op->xmm16u(n) : 0;
   }
+#endif
 }
 
 #if BX_SUPPORT_EVEX
 BX_CPP_INLINE void simd_pblendw(BxPackedAvxRegister *op1, const BxPackedAvxRegister *op2, Bit32u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 8, mask >>= 8) {
+    BxPackedXmmRegister *r = &op1->vmm128(n / 8);
+    BX_HOST_XMM_STORE(r, bx_host_blend(BX_HOST_XMM_LOAD(r), BX_HOST_XMM_LOAD(&op2->vmm128(n / 8)), bx_host_expand_mask_w((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     if (mask & 0x1) op1->vmm16u(n) = op2->vmm16u(n);
     mask >>= 1;
   }
+#endif
 }
 
 BX_CPP_INLINE void simd_zero_pblendw(BxPackedAvxRegister *dst, const BxPackedAvxRegister *op, Bit32u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 8, mask >>= 8) {
+    BX_HOST_XMM_STORE(&dst->vmm128(n / 8), _mm_and_si128(BX_HOST_XMM_LOAD(&op->vmm128(n / 8)), bx_host_expand_mask_w((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     dst->vmm16u(n) = (mask & 0x1) ? op->vmm16u(n) : 0;
     mask >>= 1;
   }
+#endif
 }
 #endif
 
 BX_CPP_INLINE void xmm_blendps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), bx_host_expand_mask_d(mask)));
+#else
   for (unsigned n=0; n < 4; n++, mask >>= 1) {
     if (mask & 0x1) op1->xmm32u(n) = op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_zero_blendps(BxPackedXmmRegister *dst, const BxPackedXmmRegister *op, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(dst, _mm_and_si128(BX_HOST_XMM_LOAD(op), bx_host_expand_mask_d(mask)));
+#else
   for (unsigned n=0; n < 4; n++, mask >>= 1) {
     dst->xmm32u(n) = (mask & 0x1) ? op->xmm32u(n) : 0;
   }
+#endif
 }
 
 #if BX_SUPPORT_EVEX
 BX_CPP_INLINE void simd_blendps(BxPackedAvxRegister *op1, const BxPackedAvxRegister *op2, Bit32u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 4, mask >>= 4) {
+    BxPackedXmmRegister *r = &op1->vmm128(n / 4);
+    BX_HOST_XMM_STORE(r, bx_host_blend(BX_HOST_XMM_LOAD(r), BX_HOST_XMM_LOAD(&op2->vmm128(n / 4)), bx_host_expand_mask_d((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     if (mask & 0x1) op1->vmm32u(n) = op2->vmm32u(n);
     mask >>= 1;
   }
+#endif
 }
 
 BX_CPP_INLINE void simd_zero_blendps(BxPackedAvxRegister *dst, const BxPackedAvxRegister *op, Bit32u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 4, mask >>= 4) {
+    BX_HOST_XMM_STORE(&dst->vmm128(n / 4), _mm_and_si128(BX_HOST_XMM_LOAD(&op->vmm128(n / 4)), bx_host_expand_mask_d((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     dst->vmm32u(n) = (mask & 0x1) ? op->vmm32u(n) : 0;
     mask >>= 1;
   }
+#endif
 }
 #endif
 
 BX_CPP_INLINE void xmm_blendpd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), bx_host_expand_mask_q(mask)));
+#else
   for (unsigned n=0; n < 2; n++, mask >>= 1) {
     if (mask & 0x1) op1->xmm64u(n) = op2->xmm64u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_zero_blendpd(BxPackedXmmRegister *dst, const BxPackedXmmRegister *op, Bit32u mask)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(dst, _mm_and_si128(BX_HOST_XMM_LOAD(op), bx_host_expand_mask_q(mask)));
+#else
   for (unsigned n=0; n < 2; n++, mask >>= 1) {
     dst->xmm64u(n) = (mask & 0x1) ? op->xmm64u(n) : 0;
   }
+#endif
 }
 
 #if BX_SUPPORT_EVEX
 BX_CPP_INLINE void simd_blendpd(BxPackedAvxRegister *op1, const BxPackedAvxRegister *op2, Bit32u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 2, mask >>= 2) {
+    BxPackedXmmRegister *r = &op1->vmm128(n / 2);
+    BX_HOST_XMM_STORE(r, bx_host_blend(BX_HOST_XMM_LOAD(r), BX_HOST_XMM_LOAD(&op2->vmm128(n / 2)), bx_host_expand_mask_q((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     if (mask & 0x1) op1->vmm64u(n) = op2->vmm64u(n);
     mask >>= 1;
   }
+#endif
 }
 
 BX_CPP_INLINE void simd_zero_blendpd(BxPackedAvxRegister *dst, const BxPackedAvxRegister *op, Bit32u mask, unsigned len)
 {
+#if BX_HOST_SSE2
+  for (unsigned n=0; n < len; n += 2, mask >>= 2) {
+    BX_HOST_XMM_STORE(&dst->vmm128(n / 2), _mm_and_si128(BX_HOST_XMM_LOAD(&op->vmm128(n / 2)), bx_host_expand_mask_q((Bit32u) mask)));
+  }
+#else
   for (unsigned n=0; n < len; n++) {
     dst->vmm64u(n) = (mask & 0x1) ? op->vmm64u(n) : 0;
     mask >>= 1;
   }
+#endif
 }
 #endif
 
 BX_CPP_INLINE void xmm_pblendvb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *mask)
 {
+#if BX_HOST_SSE2
+  __m128i m = _mm_cmplt_epi8(BX_HOST_XMM_LOAD(mask), _mm_setzero_si128());
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), m));
+#else
   for(unsigned n=0; n<16; n++) {
     if (mask->xmmsbyte(n) < 0) op1->xmmubyte(n) = op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pblendvw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *mask)
 {
+#if BX_HOST_SSE2
+  __m128i m = _mm_srai_epi16(BX_HOST_XMM_LOAD(mask), 15);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), m));
+#else
   for(unsigned n=0; n<8; n++) {
     if (mask->xmm16s(n) < 0) op1->xmm16u(n) = op2->xmm16u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_blendvps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *mask)
 {
+#if BX_HOST_SSE2
+  __m128i m = _mm_srai_epi32(BX_HOST_XMM_LOAD(mask), 31);
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), m));
+#else
   for(unsigned n=0; n<4; n++) {
     if (mask->xmm32s(n) < 0) op1->xmm32u(n) = op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_blendvpd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2, const BxPackedXmmRegister *mask)
 {
+#if BX_HOST_SSE2
+  __m128i m = _mm_shuffle_epi32(_mm_srai_epi32(BX_HOST_XMM_LOAD(mask), 31), _MM_SHUFFLE(3,3,1,1));
+  BX_HOST_XMM_STORE(op1, bx_host_blend(BX_HOST_XMM_LOAD(op1), BX_HOST_XMM_LOAD(op2), m));
+#else
   if (mask->xmm32s(1) < 0) op1->xmm64u(0) = op2->xmm64u(0);
   if (mask->xmm32s(3) < 0) op1->xmm64u(1) = op2->xmm64u(1);
+#endif
 }
 
 // arithmetic (logic)
 
 BX_CPP_INLINE void xmm_andps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_and_si128);
+#else
   for (unsigned n=0; n < 2; n++)
     op1->xmm64u(n) &= op2->xmm64u(n);
+#endif
 }
 
 BX_CPP_INLINE void xmm_andnps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_andnot_si128);
+#else
   for (unsigned n=0; n < 2; n++)
     op1->xmm64u(n) = ~(op1->xmm64u(n)) & op2->xmm64u(n);
+#endif
 }
 
 BX_CPP_INLINE void xmm_orps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_or_si128);
+#else
   for (unsigned n=0; n < 2; n++)
     op1->xmm64u(n) |= op2->xmm64u(n);
+#endif
 }
 
 BX_CPP_INLINE void xmm_xorps(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_xor_si128);
+#else
   for (unsigned n=0; n < 2; n++)
     op1->xmm64u(n) ^= op2->xmm64u(n);
+#endif
 }
 
 // arithmetic (add/sub)
 
 BX_CPP_INLINE void xmm_paddb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_add_epi8);
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) += op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_paddw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_add_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) += op2->xmm16u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_paddd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_add_epi32);
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32u(n) += op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_paddq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_add_epi64);
+#else
   for(unsigned n=0; n<2; n++) {
     op1->xmm64u(n) += op2->xmm64u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_sub_epi8);
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) -= op2->xmmubyte(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_sub_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) -= op2->xmm16u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_sub_epi32);
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32u(n) -= op2->xmm32u(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_sub_epi64);
+#else
   for(unsigned n=0; n<2; n++) {
     op1->xmm64u(n) -= op2->xmm64u(n);
   }
+#endif
 }
 
 // arithmetic (add/sub with saturation)
 
 BX_CPP_INLINE void xmm_paddsb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_adds_epi8);
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmsbyte(n) = SaturateWordSToByteS(Bit16s(op1->xmmsbyte(n)) + Bit16s(op2->xmmsbyte(n)));
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_paddsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_adds_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16s(n) = SaturateDwordSToWordS(Bit32s(op1->xmm16s(n)) + Bit32s(op2->xmm16s(n)));
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_paddusb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_adds_epu8);
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) = SaturateWordSToByteU(Bit16s(op1->xmmubyte(n)) + Bit16s(op2->xmmubyte(n)));
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_paddusw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_adds_epu16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = SaturateDwordSToWordU(Bit32s(op1->xmm16u(n)) + Bit32s(op2->xmm16u(n)));
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubsb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_subs_epi8);
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmsbyte(n) = SaturateWordSToByteS(Bit16s(op1->xmmsbyte(n)) - Bit16s(op2->xmmsbyte(n)));
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_subs_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16s(n) = SaturateDwordSToWordS(Bit32s(op1->xmm16s(n)) - Bit32s(op2->xmm16s(n)));
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubusb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_subs_epu8);
+#else
   for(unsigned n=0; n<16; n++)
   {
     if(op1->xmmubyte(n) > op2->xmmubyte(n))
@@ -835,10 +1170,14 @@ BX_CPP_INLINE void xmm_psubusb(BxPackedXmmRegister *op1, const BxPackedXmmRegist
     else
       op1->xmmubyte(n) = 0;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psubusw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_subs_epu16);
+#else
   for(unsigned n=0; n<8; n++)
   {
     if(op1->xmm16u(n) > op2->xmm16u(n))
@@ -846,6 +1185,7 @@ BX_CPP_INLINE void xmm_psubusw(BxPackedXmmRegister *op1, const BxPackedXmmRegist
     else
       op1->xmm16u(n) = 0;
   }
+#endif
 }
 
 // arithmetic (horizontal add/sub)
@@ -922,48 +1262,76 @@ BX_CPP_INLINE void xmm_phsubsw(BxPackedXmmRegister *op1, const BxPackedXmmRegist
 
 BX_CPP_INLINE void xmm_pavgb(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_avg_epu8);
+#else
   for(unsigned n=0; n<16; n++) {
     op1->xmmubyte(n) = (op1->xmmubyte(n) + op2->xmmubyte(n) + 1) >> 1;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pavgw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_avg_epu16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = (op1->xmm16u(n) + op2->xmm16u(n) + 1) >> 1;
   }
+#endif
 }
 
 // multiply
 
 BX_CPP_INLINE void xmm_pmullw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_mullo_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     op1->xmm16s(n) *= op2->xmm16s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmulhw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_mulhi_epi16);
+#else
   for(unsigned n=0; n<8; n++) {
     Bit32s product = Bit32s(op1->xmm16s(n)) * Bit32s(op2->xmm16s(n));
     op1->xmm16u(n) = (Bit16u)(product >> 16);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmulhuw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_mulhi_epu16);
+#else
   for(unsigned n=0; n<8; n++) {
     Bit32u product = Bit32u(op1->xmm16u(n)) * Bit32u(op2->xmm16u(n));
     op1->xmm16u(n) = (Bit16u)(product >> 16);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmulld(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  __m128i a = BX_HOST_XMM_LOAD(op1), b = BX_HOST_XMM_LOAD(op2);
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  BX_HOST_XMM_STORE(op1, _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                                            _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0,0,2,0))));
+#else
   for(unsigned n=0; n<4; n++) {
     op1->xmm32s(n) *= op2->xmm32s(n);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmullq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
@@ -981,12 +1349,18 @@ BX_CPP_INLINE void xmm_pmuldq(BxPackedXmmRegister *op1, const BxPackedXmmRegiste
 
 BX_CPP_INLINE void xmm_pmuludq(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_mul_epu32);
+#else
   op1->xmm64u(0) = Bit64u(op1->xmm32u(0)) * Bit64u(op2->xmm32u(0));
   op1->xmm64u(1) = Bit64u(op1->xmm32u(2)) * Bit64u(op2->xmm32u(2));
+#endif
 }
 
 BX_CPP_INLINE void xmm_pmulhrsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+  BX_HOST_DISPATCH(BX_HOST_CPU_SSSE3, host_xmm_pmulhrsw(op1, op2));
+
   for(unsigned n=0; n<8; n++) {
     op1->xmm16u(n) = (((Bit32s(op1->xmm16s(n)) * Bit32s(op2->xmm16s(n))) >> 14) + 1) >> 1;
   }
@@ -996,6 +1370,8 @@ BX_CPP_INLINE void xmm_pmulhrsw(BxPackedXmmRegister *op1, const BxPackedXmmRegis
 
 BX_CPP_INLINE void xmm_pmaddubsw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+  BX_HOST_DISPATCH(BX_HOST_CPU_SSSE3, host_xmm_pmaddubsw(op1, op2));
+
   for(unsigned n=0; n<8; n++)
   {
     Bit32s temp = Bit32s(op1->xmmubyte(n*2))   * Bit32s(op2->xmmsbyte(n*2)) +
@@ -1007,11 +1383,15 @@ BX_CPP_INLINE void xmm_pmaddubsw(BxPackedXmmRegister *op1, const BxPackedXmmRegi
 
 BX_CPP_INLINE void xmm_pmaddwd(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_madd_epi16);
+#else
   for(unsigned n=0; n<4; n++)
   {
     op1->xmm32u(n) = Bit32s(op1->xmm16s(n*2))   * Bit32s(op2->xmm16s(n*2)) +
                      Bit32s(op1->xmm16s(n*2+1)) * Bit32s(op2->xmm16s(n*2+1));
   }
+#endif
 }
 
 // broadcast
@@ -1078,6 +1458,9 @@ BX_CPP_INLINE void simd_pbroadcastq(BxPackedAvxRegister *op, Bit64u val_64, unsi
 
 BX_CPP_INLINE void xmm_psadbw(BxPackedXmmRegister *op1, const BxPackedXmmRegister *op2)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_OP2(op1, op2, _mm_sad_epu8);
+#else
   unsigned temp = 0;
   for (unsigned n=0; n < 8; n++)
     temp += abs(op1->xmmubyte(n) - op2->xmmubyte(n));
@@ -1089,6 +1472,7 @@ BX_CPP_INLINE void xmm_psadbw(BxPackedXmmRegister *op1, const BxPackedXmmRegiste
     temp += abs(op1->xmmubyte(n) - op2->xmmubyte(n));
 
   op1->xmm64u(1) = Bit64u(temp);
+#endif
 }
 
 // multiple sum of absolute differences (MSAD)
@@ -1268,6 +1652,9 @@ BX_CPP_INLINE void xmm_psrlvq(BxPackedXmmRegister *op1, const BxPackedXmmRegiste
 
 BX_CPP_INLINE void xmm_psraw(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_sra_epi16(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 15) {
     for (unsigned n=0; n < 8; n++)
       op->xmm16u(n) = (op->xmm16s(n) < 0) ? 0xffff : 0;
@@ -1279,10 +1666,14 @@ BX_CPP_INLINE void xmm_psraw(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 8; n++)
       op->xmm16u(n) = (Bit16u)(op->xmm16s(n) >> shift);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psrad(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_sra_epi32(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 31) {
     for (unsigned n=0; n < 4; n++)
       op->xmm32u(n) = (op->xmm32s(n) < 0) ? 0xffffffff : 0;
@@ -1294,6 +1685,7 @@ BX_CPP_INLINE void xmm_psrad(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 4; n++)
       op->xmm32u(n) = (Bit32u)(op->xmm32s(n) >> shift);
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psraq(BxPackedXmmRegister *op, Bit64u shift_64)
@@ -1313,6 +1705,9 @@ BX_CPP_INLINE void xmm_psraq(BxPackedXmmRegister *op, Bit64u shift_64)
 
 BX_CPP_INLINE void xmm_psrlw(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_srl_epi16(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 15) op->clear();
   else
   {
@@ -1321,10 +1716,14 @@ BX_CPP_INLINE void xmm_psrlw(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 8; n++)
       op->xmm16u(n) >>= shift;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psrld(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_srl_epi32(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 31) op->clear();
   else
   {
@@ -1333,11 +1732,15 @@ BX_CPP_INLINE void xmm_psrld(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 4; n++)
       op->xmm32u(n) >>= shift;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psrlq(BxPackedXmmRegister *op, Bit64u shift_64)
 {
-  if(shift_64 > 64) op->clear();
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_srl_epi64(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
+  if(shift_64 > 63) op->clear();
   else
   {
     Bit8u shift = (Bit8u) shift_64;
@@ -1345,10 +1748,14 @@ BX_CPP_INLINE void xmm_psrlq(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 2; n++)
       op->xmm64u(n) >>= shift;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psllw(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_sll_epi16(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 15) op->clear();
   else
   {
@@ -1357,10 +1764,14 @@ BX_CPP_INLINE void xmm_psllw(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 8; n++)
       op->xmm16u(n) <<= shift;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_pslld(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_sll_epi32(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 31) op->clear();
   else
   {
@@ -1369,10 +1780,14 @@ BX_CPP_INLINE void xmm_pslld(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 4; n++)
       op->xmm32u(n) <<= shift;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psllq(BxPackedXmmRegister *op, Bit64u shift_64)
 {
+#if BX_HOST_SSE2
+  BX_HOST_XMM_STORE(op, _mm_sll_epi64(BX_HOST_XMM_LOAD(op), _mm_set_epi64x(0, (Bit64s) shift_64)));
+#else
   if(shift_64 > 63) op->clear();
   else
   {
@@ -1381,6 +1796,7 @@ BX_CPP_INLINE void xmm_psllq(BxPackedXmmRegister *op, Bit64u shift_64)
     for (unsigned n=0; n < 2; n++)
       op->xmm64u(n) <<= shift;
   }
+#endif
 }
 
 BX_CPP_INLINE void xmm_psrldq(BxPackedXmmRegister *op, Bit64u shift)
@@ -48,6 +48,10 @@
 
 #include "bxthread.h"
 
+#if BX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 
 class bx_rfb_gui_c : public bx_gui_c {
 public:
@@ -176,6 +180,29 @@ static SOCKET sGlobal;
 static Bit32u clientEncodingsCount = 0;
 static Bit32u *clientEncodings = NULL;
 
+// Encoder thread stuff
+static BX_THREAD_VAR(rfbEncoderThreadVar);
+static BX_MUTEX(rfbUpdateMutex);   // protects rfbShadowScreen and rfbPendingRegion
+static BX_MUTEX(rfbSendMutex);     // serializes server messages on sGlobal
+static bx_thread_sem_t rfbEncoderSem;
+static char *rfbShadowScreen;      // screen contents handed over to the encoder
+static char *rfbClientScreen;      // screen contents known by the client
+static struct _rfbUpdateRegion rfbPendingRegion;
+static bool rfbClientScreenValid = 0;
+static Bit32u rfbScreenEpoch = 0;
+static Bit32u rfbPreferredEncoding = rfbEncodingRaw;
+static bool rfbCopyRectEnabled = 0;
+#if BX_HAVE_ZLIB
+static z_stream rfbZrleStream;     // ZRLE uses one zlib stream per connection
+static bool rfbZrleStreamValid = 0;
+#endif
+
+typedef struct {
+  char *data;
+  unsigned len;
+  unsigned size;
+} rfbOutBuffer;
+
 #ifdef BX_RFB_WIN32
 bool StopWinsock();
 #endif
@@ -192,6 +219,11 @@ void UpdateScreen(unsigned char *newBits, int x, int y, int width, int height,
 void SendUpdate(int x, int y, int width, int height, Bit32u encoding);
 void rfbSetUpdateRegion(unsigned x0, unsigned y0, unsigned w, unsigned h);
 void rfbAddUpdateRegion(unsigned x0, unsigned y0, unsigned w, unsigned h);
+static void rfbMergeRegion(struct _rfbUpdateRegion *region, unsigned x0, unsigned y0, unsigned w, unsigned h);
+void rfbQueueUpdate(unsigned x, unsigned y, unsigned width, unsigned height);
+void rfbResizeScreen(unsigned x, unsigned y);
+void rfbResetZrleStream(void);
+void rfbStartEncoderThread();
 void rfbSetStatusText(int element, const char *text, bool active, Bit8u color = 0);
 static Bit32u convertStringToRfbKey(const char *string);
 #if BX_SHOW_IPS && defined(WIN32)
@@ -263,9 +295,12 @@ void bx_rfb_gui_c::specific_init(int argc, char **argv, unsigned headerbar_y)
   }
 
   rfbScreen = new char[rfbWindowX * rfbWindowY];
+  rfbShadowScreen = new char[rfbWindowX * rfbWindowY];
+  rfbClientScreen = new char[rfbWindowX * rfbWindowY];
   memset(&rfbPalette, 0, sizeof(rfbPalette));
 
   rfbSetUpdateRegion(rfbWindowX, rfbWindowY, 0, 0);
+  rfbPendingRegion.updated = 0;
 
   clientEncodingsCount=0;
   clientEncodings=NULL;
@@ -273,6 +308,9 @@ void bx_rfb_gui_c::specific_init(int argc, char **argv, unsigned headerbar_y)
   keep_alive = 1;
   client_connected = 0;
   desktop_resizable = 0;
+  BX_INIT_MUTEX(rfbUpdateMutex);
+  BX_INIT_MUTEX(rfbSendMutex);
+  rfbStartEncoderThread();
   rfbStartThread();
 
 #ifdef WIN32
@@ -343,8 +381,8 @@ void bx_rfb_gui_c::handle_events(void)
 void bx_rfb_gui_c::flush(void)
 {
   if (rfbUpdateRegion.updated) {
-    SendUpdate(rfbUpdateRegion.x, rfbUpdateRegion.y, rfbUpdateRegion.width,
-               rfbUpdateRegion.height, rfbEncodingRaw);
+    rfbQueueUpdate(rfbUpdateRegion.x, rfbUpdateRegion.y, rfbUpdateRegion.width,
+                   rfbUpdateRegion.height);
     rfbSetUpdateRegion(rfbWindowX, rfbWindowY, 0, 0);
   }
 }
@@ -452,12 +490,7 @@ void bx_rfb_gui_c::dimension_update(unsigned x, unsigned y, unsigned fheight, un
       if ((x > BX_RFB_MAX_XDIM) || (y > BX_RFB_MAX_YDIM)) {
         BX_PANIC(("dimension_update(): RFB doesn't support graphics mode %dx%d", x, y));
       }
-      rfbDimensionX = x;
-      rfbDimensionY = y;
-      rfbWindowX = rfbDimensionX;
-      rfbWindowY = rfbDimensionY + rfbHeaderbarY + rfbStatusbarY;
-      delete [] rfbScreen;
-      rfbScreen = new char[rfbWindowX * rfbWindowY];
+      rfbResizeScreen(x, y);
       SendUpdate(0, 0, rfbWindowX, rfbWindowY, rfbEncodingDesktopSize);
       bx_gui->show_headerbar();
       rfbSetUpdateRegion(0, 0, rfbWindowX, rfbWindowY);
@@ -466,7 +499,7 @@ void bx_rfb_gui_c::dimension_update(unsigned x, unsigned y, unsigned fheight, un
         BX_PANIC(("dimension_update(): RFB doesn't support graphics mode %dx%d", x, y));
       }
       clear_screen();
-      SendUpdate(0, rfbHeaderbarY, rfbDimensionX, rfbDimensionY, rfbEncodingRaw);
+      flush();
       rfbDimensionX = x;
       rfbDimensionY = y;
     }
@@ -571,7 +604,15 @@ void bx_rfb_gui_c::exit(void)
 #ifdef BX_RFB_WIN32
   StopWinsock();
 #endif
+  bx_set_sem(&rfbEncoderSem);
+  BX_THREAD_JOIN(rfbEncoderThreadVar);
+  bx_destroy_sem(&rfbEncoderSem);
+  BX_FINI_MUTEX(rfbUpdateMutex);
+  BX_FINI_MUTEX(rfbSendMutex);
+  rfbResetZrleStream();
   delete [] rfbScreen;
+  delete [] rfbShadowScreen;
+  delete [] rfbClientScreen;
   for(i = 0; i < rfbBitmapCount; i++) {
     free(rfbBitmaps[i].bmap);
   }
@@ -1270,8 +1311,14 @@ void HandleRfbClient(SOCKET sClient)
     return;
   }
 
+  BX_LOCK(rfbSendMutex);
+  rfbPreferredEncoding = rfbEncodingRaw;
+  rfbCopyRectEnabled = 0;
+  rfbClientScreenValid = 0;
+  rfbResetZrleStream();
   client_connected = 1;
   sGlobal = sClient;
+  BX_UNLOCK(rfbSendMutex);
   while (keep_alive) {
     U8 msgType;
     int n;
@@ -1354,6 +1401,28 @@ void HandleRfbClient(SOCKET sClient)
             clientEncodings[i]=ntohl(enc);
           }
 
+          // select the first encoding of the client list we are able to send,
+          // the encoder thread reads the selection with rfbSendMutex held
+          BX_LOCK(rfbSendMutex);
+          rfbPreferredEncoding = rfbEncodingRaw;
+          rfbCopyRectEnabled = 0;
+          for (i = 0; i < clientEncodingsCount; i++) {
+            if ((clientEncodings[i] == rfbEncodingHextile) ||
+#if BX_HAVE_ZLIB
+                (clientEncodings[i] == rfbEncodingZRLE) ||
+#endif
+                (clientEncodings[i] == rfbEncodingRaw)) {
+              rfbPreferredEncoding = clientEncodings[i];
+              break;
+            }
+          }
+          for (i = 0; i < clientEncodingsCount; i++) {
+            if (clientEncodings[i] == rfbEncodingCopyRect) {
+              rfbCopyRectEnabled = 1;
+            }
+          }
+          BX_UNLOCK(rfbSendMutex);
+
           // print supported encodings
           BX_INFO(("rfbSetEncodings : client supported encodings:"));
           for (i = 0; i < clientEncodingsCount; i++) {
@@ -1371,6 +1440,9 @@ void HandleRfbClient(SOCKET sClient)
             }
             if (!found) BX_INFO(("%08x Unknown", clientEncodings[i]));
           }
+          BX_INFO(("using %s encoding%s", (rfbPreferredEncoding == rfbEncodingHextile) ? "Hextile" :
+                   (rfbPreferredEncoding == rfbEncodingZRLE) ? "ZRLE" : "Raw",
+                   rfbCopyRectEnabled ? " and CopyRect" : ""));
           break;
         }
       case rfbFramebufferUpdateRequest:
@@ -1566,19 +1638,7 @@ void UpdateScreen(unsigned char *newBits, int x, int y, int width, int height,
     y++;
   }
   if (update_client) {
-    if(sGlobal == INVALID_SOCKET) return;
-    rfbFramebufferUpdateMessage fum;
-    rfbFramebufferUpdateRectHeader furh;
-    fum.messageType = rfbFramebufferUpdate;
-    fum.numberOfRectangles = htons(1);
-    WriteExact(sGlobal, (char *)&fum, rfbFramebufferUpdateMessageSize);
-    furh.r.xPosition = htons(x0);
-    furh.r.yPosition = htons(y0);
-    furh.r.width = htons((short)width);
-    furh.r.height = htons((short)height);
-    furh.r.encodingType = htonl(rfbEncodingRaw);
-    WriteExact(sGlobal, (char *)&furh, rfbFramebufferUpdateRectHeaderSize);
-    WriteExact(sGlobal, (char *)newBits, width * height);
+    rfbQueueUpdate(x0, y0, width, height);
   }
 }
 
@@ -1589,6 +1649,7 @@ void SendUpdate(int x, int y, int width, int height, Bit32u encoding)
     if(x < 0 || y < 0 || (x + width) > (int)rfbWindowX || (y + height) > (int)rfbWindowY) {
         BX_ERROR(("Dimensions out of bounds.  x=%i y=%i w=%i h=%i", x, y, width, height));
     }
+    BX_LOCK(rfbSendMutex);
     if(sGlobal != INVALID_SOCKET) {
         rfbFramebufferUpdateMessage fum;
         rfbFramebufferUpdateRectHeader furh;
@@ -1615,6 +1676,501 @@ void SendUpdate(int x, int y, int width, int height, Bit32u encoding)
           delete [] newBits;
         }
     }
+    BX_UNLOCK(rfbSendMutex);
+}
+
+// Encoder thread: the simulation thread hands over the updated screen regions
+// with rfbQueueUpdate(), the encoder thread compresses them with the encoding
+// preferred by the client and sends them.
+
+void rfbQueueUpdate(unsigned x, unsigned y, unsigned width, unsigned height)
+{
+  if ((x >= rfbWindowX) || (y >= rfbWindowY) || (width == 0) || (height == 0))
+    return;
+  if ((x + width) > rfbWindowX) width = rfbWindowX - x;
+  if ((y + height) > rfbWindowY) height = rfbWindowY - y;
+
+  BX_LOCK(rfbUpdateMutex);
+  for (unsigned i = 0; i < height; i++) {
+    memcpy(&rfbShadowScreen[(y + i) * rfbWindowX + x], &rfbScreen[(y + i) * rfbWindowX + x], width);
+  }
+  rfbMergeRegion(&rfbPendingRegion, x, y, width, height);
+  BX_UNLOCK(rfbUpdateMutex);
+  bx_set_sem(&rfbEncoderSem);
+}
+
+// Change the screen size. The client and encoder threads read the window
+// size and the screen buffers, so all of them change in one critical section.
+void rfbResizeScreen(unsigned x, unsigned y)
+{
+  BX_LOCK(rfbSendMutex);
+  BX_LOCK(rfbUpdateMutex);
+  rfbDimensionX = x;
+  rfbDimensionY = y;
+  rfbWindowX = rfbDimensionX;
+  rfbWindowY = rfbDimensionY + rfbHeaderbarY + rfbStatusbarY;
+  delete [] rfbScreen;
+  rfbScreen = new char[rfbWindowX * rfbWindowY];
+  delete [] rfbShadowScreen;
+  delete [] rfbClientScreen;
+  rfbShadowScreen = new char[rfbWindowX * rfbWindowY];
+  rfbClientScreen = new char[rfbWindowX * rfbWindowY];
+  rfbPendingRegion.updated = 0;
+  rfbClientScreenValid = 0;
+  rfbScreenEpoch++;
+  BX_UNLOCK(rfbUpdateMutex);
+  BX_UNLOCK(rfbSendMutex);
+}
+
+static void rfbOutAppend(rfbOutBuffer *out, const void *data, unsigned len)
+{
+  if ((out->len + len) > out->size) {
+    unsigned newsize = (out->size > 0) ? out->size : 4096;
+    while (newsize < (out->len + len)) newsize <<= 1;
+    char *newdata = new char[newsize];
+    if (out->len > 0) memcpy(newdata, out->data, out->len);
+    delete [] out->data;
+    out->data = newdata;
+    out->size = newsize;
+  }
+  memcpy(out->data + out->len, data, len);
+  out->len += len;
+}
+
+static void rfbOutRectHeader(rfbOutBuffer *out, unsigned x, unsigned y, unsigned w,
+                             unsigned h, Bit32u encoding)
+{
+  rfbFramebufferUpdateRectHeader furh;
+
+  furh.r.xPosition = htons(x);
+  furh.r.yPosition = htons(y);
+  furh.r.width = htons((short)w);
+  furh.r.height = htons((short)h);
+  furh.r.encodingType = htonl(encoding);
+  rfbOutAppend(out, &furh, rfbFramebufferUpdateRectHeaderSize);
+}
+
+// Encode one hextile tile (8 bpp) of size w x h. Returns false if the tile
+// has to be sent raw.
+static bool rfbHextileEncodeTile(rfbOutBuffer *out, const Bit8u *ptr, unsigned pitch,
+                                 unsigned w, unsigned h, int *bg, int *fg)
+{
+  Bit8u tile[256], subrects[255 * 3];
+  unsigned hist[256];
+  unsigned x, y, i, j, colours = 0, count = 0, len = 0;
+  Bit8u newbg, newfg = 0, subenc = 0;
+  bool coloured = 0;
+
+  memset(hist, 0, sizeof(hist));
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      Bit8u c = ptr[y * pitch + x];
+      tile[y * w + x] = c;
+      if (hist[c]++ == 0) colours++;
+    }
+  }
+  // most frequent colour becomes the background
+  newbg = tile[0];
+  for (i = 0; i < w * h; i++) {
+    if (hist[tile[i]] > hist[newbg]) newbg = tile[i];
+  }
+  if (colours == 2) {
+    for (i = 0; i < w * h; i++) {
+      if (tile[i] != newbg) {
+        newfg = tile[i];
+        break;
+      }
+    }
+  } else if (colours > 2) {
+    coloured = 1;
+  }
+
+  if (colours > 1) {
+    // greedy search for rectangles of identical colour
+    for (y = 0; y < h; y++) {
+      for (x = 0; x < w; x++) {
+        Bit8u c = tile[y * w + x];
+        if (c == newbg) continue;
+        unsigned rw = 1, rh = 1;
+        while (((x + rw) < w) && (tile[y * w + x + rw] == c)) rw++;
+        bool extend = 1;
+        while (extend && ((y + rh) < h)) {
+          for (i = 0; i < rw; i++) {
+            if (tile[(y + rh) * w + x + i] != c) {
+              extend = 0;
+              break;
+            }
+          }
+          if (extend) rh++;
+        }
+        for (j = 0; j < rh; j++) {
+          memset(&tile[(y + j) * w + x], newbg, rw);
+        }
+        if ((count == 255) || ((len + 3) > (w * h))) return 0;
+        if (coloured) subrects[len++] = c;
+        subrects[len++] = rfbHextilePackXY(x, y);
+        subrects[len++] = rfbHextilePackWH(rw, rh);
+        count++;
+      }
+    }
+  }
+
+  if (*bg != newbg) {
+    subenc |= rfbHextileBackgroundSpecified;
+  }
+  if (count > 0) {
+    subenc |= rfbHextileAnySubrects;
+    if (coloured) {
+      subenc |= rfbHextileSubrectsColoured;
+    } else if (*fg != newfg) {
+      subenc |= rfbHextileForegroundSpecified;
+    }
+  }
+  rfbOutAppend(out, &subenc, 1);
+  if (subenc & rfbHextileBackgroundSpecified) {
+    rfbOutAppend(out, &newbg, 1);
+    *bg = newbg;
+  }
+  if (subenc & rfbHextileForegroundSpecified) {
+    rfbOutAppend(out, &newfg, 1);
+    *fg = newfg;
+  }
+  if (count > 0) {
+    Bit8u cnt = (Bit8u)count;
+    rfbOutAppend(out, &cnt, 1);
+    rfbOutAppend(out, subrects, len);
+    // foreground colour is undefined after coloured subrects
+    if (coloured) *fg = -1;
+  }
+  return 1;
+}
+
+#if BX_HAVE_ZLIB
+// ZRLE run length: (length - 1) as a sum of bytes, all but the last are 255
+static unsigned rfbZrleRunLength(rfbOutBuffer *out, unsigned len)
+{
+  Bit8u b = 255;
+  unsigned bytes = 1;
+
+  for (len--; len >= 255; len -= 255) {
+    if (out != NULL) rfbOutAppend(out, &b, 1);
+    bytes++;
+  }
+  b = (Bit8u)len;
+  if (out != NULL) rfbOutAppend(out, &b, 1);
+  return bytes;
+}
+
+// Encode one ZRLE tile (8 bpp, a CPIXEL is one byte) of size w x h with the
+// smallest of the raw, solid, packed palette, plain RLE and palette RLE
+// subencodings. Runs continue from one row to the next.
+static void rfbZrleEncodeTile(rfbOutBuffer *out, const Bit8u *ptr, unsigned pitch,
+                              unsigned w, unsigned h)
+{
+  Bit8u tile[64 * 64], palette[128], subenc, b;
+  int index[256];
+  unsigned i, x, y, run, n = w * h, colours = 0;
+  unsigned raw_size = n, packed_size = n + 1, rle_size = 0, prle_size = 0;
+  unsigned bits = 0;
+
+  for (i = 0; i < 256; i++) index[i] = -1;
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      Bit8u c = ptr[y * pitch + x];
+      tile[y * w + x] = c;
+      if (index[c] < 0) {
+        index[c] = colours;
+        if (colours < 128) palette[colours] = c;
+        colours++;
+      }
+    }
+  }
+
+  if (colours == 1) {
+    subenc = 1;
+    rfbOutAppend(out, &subenc, 1);
+    rfbOutAppend(out, &tile[0], 1);
+    return;
+  }
+
+  for (i = 0; i < n; i += run) {
+    for (run = 1; ((i + run) < n) && (tile[i + run] == tile[i]); run++);
+    rle_size += 1 + rfbZrleRunLength(NULL, run);
+    prle_size += 1 + ((run > 1) ? rfbZrleRunLength(NULL, run) : 0);
+  }
+  if (colours <= 16) {
+    bits = (colours == 2) ? 1 : (colours <= 4) ? 2 : 4;
+    packed_size = colours + h * ((w * bits + 7) / 8);
+  }
+  if (colours <= 127) {
+    prle_size += colours;
+  } else {
+    prle_size = n + 1;
+  }
+
+  if ((packed_size <= raw_size) && (packed_size <= rle_size) && (packed_size <= prle_size)) {
+    subenc = (Bit8u)colours;
+    rfbOutAppend(out, &subenc, 1);
+    rfbOutAppend(out, palette, colours);
+    // rows start at a byte boundary, the first pixel is in the high bits
+    for (y = 0; y < h; y++) {
+      unsigned shift = 8;
+      b = 0;
+      for (x = 0; x < w; x++) {
+        shift -= bits;
+        b |= index[tile[y * w + x]] << shift;
+        if (shift == 0) {
+          rfbOutAppend(out, &b, 1);
+          shift = 8;
+          b = 0;
+        }
+      }
+      if (shift < 8) rfbOutAppend(out, &b, 1);
+    }
+  } else if ((prle_size <= raw_size) && (prle_size <= rle_size)) {
+    subenc = (Bit8u)(128 + colours);
+    rfbOutAppend(out, &subenc, 1);
+    rfbOutAppend(out, palette, colours);
+    for (i = 0; i < n; i += run) {
+      for (run = 1; ((i + run) < n) && (tile[i + run] == tile[i]); run++);
+      b = (Bit8u)index[tile[i]];
+      if (run > 1) {
+        b |= 128;
+        rfbOutAppend(out, &b, 1);
+        rfbZrleRunLength(out, run);
+      } else {
+        rfbOutAppend(out, &b, 1);
+      }
+    }
+  } else if (rle_size < raw_size) {
+    subenc = 128;
+    rfbOutAppend(out, &subenc, 1);
+    for (i = 0; i < n; i += run) {
+      for (run = 1; ((i + run) < n) && (tile[i + run] == tile[i]); run++);
+      rfbOutAppend(out, &tile[i], 1);
+      rfbZrleRunLength(out, run);
+    }
+  } else {
+    subenc = 0;
+    rfbOutAppend(out, &subenc, 1);
+    rfbOutAppend(out, tile, n);
+  }
+}
+
+// Called with rfbSendMutex held when a client connects and at exit
+void rfbResetZrleStream(void)
+{
+  if (rfbZrleStreamValid) {
+    deflateEnd(&rfbZrleStream);
+    rfbZrleStreamValid = 0;
+  }
+}
+
+// ZRLE rectangle: 64x64 tiles compressed with the zlib stream of the
+// connection, flushed at the end of each rectangle
+static void rfbZrleEncodeRect(rfbOutBuffer *out, const Bit8u *bits, unsigned pitch,
+                              unsigned x, unsigned y, unsigned w, unsigned h)
+{
+  rfbOutBuffer tiles = {NULL, 0, 0};
+  Bit8u chunk[4096];
+  unsigned tx, ty, start;
+  Bit32u len;
+
+  for (ty = 0; ty < h; ty += 64) {
+    for (tx = 0; tx < w; tx += 64) {
+      rfbZrleEncodeTile(&tiles, bits + ty * pitch + tx, pitch,
+                        ((w - tx) > 64) ? 64 : (w - tx), ((h - ty) > 64) ? 64 : (h - ty));
+    }
+  }
+
+  if (!rfbZrleStreamValid) {
+    memset(&rfbZrleStream, 0, sizeof(rfbZrleStream));
+    if (deflateInit(&rfbZrleStream, Z_BEST_SPEED) != Z_OK) {
+      BX_PANIC(("ZRLE: deflateInit() failed"));
+    }
+    rfbZrleStreamValid = 1;
+  }
+
+  rfbOutRectHeader(out, x, y, w, h, rfbEncodingZRLE);
+  start = out->len;
+  len = 0;
+  rfbOutAppend(out, &len, 4);
+  rfbZrleStream.next_in = (Bytef*)tiles.data;
+  rfbZrleStream.avail_in = tiles.len;
+  do {
+    rfbZrleStream.next_out = chunk;
+    rfbZrleStream.avail_out = sizeof(chunk);
+    deflate(&rfbZrleStream, Z_SYNC_FLUSH);
+    rfbOutAppend(out, chunk, sizeof(chunk) - rfbZrleStream.avail_out);
+  } while (rfbZrleStream.avail_out == 0);
+  len = htonl(out->len - start - 4);
+  memcpy(out->data + start, &len, 4);
+  delete [] tiles.data;
+}
+#else
+void rfbResetZrleStream(void) {}
+#endif
+
+static void rfbEncodeRect(rfbOutBuffer *out, const Bit8u *bits, unsigned pitch,
+                          unsigned x, unsigned y, unsigned w, unsigned h)
+{
+  unsigned i, tx, ty, tw, th;
+
+  if (rfbPreferredEncoding == rfbEncodingHextile) {
+    int bg = -1, fg = -1;
+    rfbOutRectHeader(out, x, y, w, h, rfbEncodingHextile);
+    for (ty = 0; ty < h; ty += 16) {
+      th = ((h - ty) > 16) ? 16 : (h - ty);
+      for (tx = 0; tx < w; tx += 16) {
+        tw = ((w - tx) > 16) ? 16 : (w - tx);
+        const Bit8u *tptr = bits + ty * pitch + tx;
+        unsigned start = out->len;
+        if (!rfbHextileEncodeTile(out, tptr, pitch, tw, th, &bg, &fg)) {
+          Bit8u subenc = rfbHextileRaw;
+          out->len = start;
+          rfbOutAppend(out, &subenc, 1);
+          for (i = 0; i < th; i++) {
+            rfbOutAppend(out, tptr + i * pitch, tw);
+          }
+          // colours are undefined after a raw tile
+          bg = fg = -1;
+        }
+      }
+    }
+#if BX_HAVE_ZLIB
+  } else if (rfbPreferredEncoding == rfbEncodingZRLE) {
+    rfbZrleEncodeRect(out, bits, pitch, x, y, w, h);
+#endif
+  } else {
+    rfbOutRectHeader(out, x, y, w, h, rfbEncodingRaw);
+    for (i = 0; i < h; i++) {
+      rfbOutAppend(out, bits + i * pitch, w);
+    }
+  }
+}
+
+// Look for a screen area scrolled up (e.g. text console) that can be sent as
+// CopyRect. Returns the scroll distance in lines or 0 if not found.
+static unsigned rfbFindScroll(const Bit8u *bits, unsigned x, unsigned y, unsigned w, unsigned h)
+{
+  unsigned anchor, line, s, matched;
+
+  if (!rfbCopyRectEnabled || !rfbClientScreenValid || (h < 32))
+    return 0;
+
+  // use the first non-uniform line as anchor
+  for (anchor = 0; anchor < (h / 2); anchor++) {
+    const Bit8u *p = bits + anchor * w;
+    for (line = 1; line < w; line++) {
+      if (p[line] != p[0]) break;
+    }
+    if (line < w) break;
+  }
+  if (anchor == (h / 2)) return 0;
+
+  for (s = 1; (anchor + s) < h; s++) {
+    const char *old = rfbClientScreen + (y + anchor + s) * rfbWindowX + x;
+    if (memcmp(old, bits + anchor * w, w) != 0) continue;
+    matched = 0;
+    for (line = 0; line < (h - s); line++) {
+      old = rfbClientScreen + (y + line + s) * rfbWindowX + x;
+      if (memcmp(old, bits + line * w, w) == 0) matched++;
+    }
+    if (matched >= (h / 2)) return s;
+  }
+  return 0;
+}
+
+static void rfbSendRegion(const Bit8u *bits, unsigned x, unsigned y, unsigned w, unsigned h)
+{
+  rfbOutBuffer out = {NULL, 0, 0};
+  rfbFramebufferUpdateMessage fum;
+  unsigned line, start, rects = 0, scroll;
+
+  fum.messageType = rfbFramebufferUpdate;
+  fum.padding = 0;
+  fum.numberOfRectangles = 0;
+  rfbOutAppend(&out, &fum, rfbFramebufferUpdateMessageSize);
+
+  scroll = rfbFindScroll(bits, x, y, w, h);
+  if (scroll > 0) {
+    rfbCopyRect cr;
+    rfbOutRectHeader(&out, x, y, w, h - scroll, rfbEncodingCopyRect);
+    cr.srcXPosition = htons(x);
+    cr.srcYPosition = htons(y + scroll);
+    rfbOutAppend(&out, &cr, rfbCopyRectSize);
+    rects++;
+    // the client screen now contains the moved lines
+    for (line = 0; line < (h - scroll); line++) {
+      memcpy(rfbClientScreen + (y + line) * rfbWindowX + x,
+             rfbClientScreen + (y + line + scroll) * rfbWindowX + x, w);
+    }
+    // send the lines that still differ
+    line = 0;
+    while (line < h) {
+      while ((line < h) && (memcmp(rfbClientScreen + (y + line) * rfbWindowX + x, bits + line * w, w) == 0))
+        line++;
+      if (line == h) break;
+      start = line;
+      while ((line < h) && (memcmp(rfbClientScreen + (y + line) * rfbWindowX + x, bits + line * w, w) != 0))
+        line++;
+      rfbEncodeRect(&out, bits + start * w, w, x, y + start, w, line - start);
+      rects++;
+    }
+  } else {
+    rfbEncodeRect(&out, bits, w, x, y, w, h);
+    rects++;
+  }
+
+  fum.numberOfRectangles = htons(rects);
+  memcpy(out.data, &fum, rfbFramebufferUpdateMessageSize);
+  WriteExact(sGlobal, out.data, out.len);
+  delete [] out.data;
+
+  for (line = 0; line < h; line++) {
+    memcpy(rfbClientScreen + (y + line) * rfbWindowX + x, bits + line * w, w);
+  }
+  if ((x == 0) && (y == 0) && (w == rfbWindowX) && (h == rfbWindowY)) {
+    rfbClientScreenValid = 1;
+  }
+}
+
+BX_THREAD_FUNC(rfbEncoderThread, indata)
+{
+  while (keep_alive) {
+    bx_wait_sem(&rfbEncoderSem);
+    if (!keep_alive) break;
+
+    BX_LOCK(rfbUpdateMutex);
+    if (!rfbPendingRegion.updated) {
+      BX_UNLOCK(rfbUpdateMutex);
+      continue;
+    }
+    unsigned x = rfbPendingRegion.x, y = rfbPendingRegion.y;
+    unsigned w = rfbPendingRegion.width, h = rfbPendingRegion.height;
+    Bit32u epoch = rfbScreenEpoch;
+    Bit8u *bits = new Bit8u[w * h];
+    for (unsigned i = 0; i < h; i++) {
+      memcpy(&bits[i * w], &rfbShadowScreen[(y + i) * rfbWindowX + x], w);
+    }
+    rfbPendingRegion.updated = 0;
+    BX_UNLOCK(rfbUpdateMutex);
+
+    BX_LOCK(rfbSendMutex);
+    // drop the update if the screen size has changed in the meantime
+    if ((sGlobal != INVALID_SOCKET) && (epoch == rfbScreenEpoch)) {
+      rfbSendRegion(bits, x, y, w, h);
+    }
+    BX_UNLOCK(rfbSendMutex);
+    delete [] bits;
+  }
+  BX_THREAD_EXIT;
+}
+
+void rfbStartEncoderThread()
+{
+  bx_create_sem(&rfbEncoderSem);
+  BX_THREAD_CREATE(rfbEncoderThread, NULL, rfbEncoderThreadVar);
 }
 
 void rfbSetUpdateRegion(unsigned x0, unsigned y0, unsigned w, unsigned h)
@@ -1627,37 +2183,46 @@ void rfbSetUpdateRegion(unsigned x0, unsigned y0, unsigned w, unsigned h)
 }
 
 void rfbAddUpdateRegion(unsigned x0, unsigned y0, unsigned w, unsigned h)
+{
+  rfbMergeRegion(&rfbUpdateRegion, x0, y0, w, h);
+}
+
+static void rfbMergeRegion(struct _rfbUpdateRegion *region, unsigned x0, unsigned y0, unsigned w, unsigned h)
 {
   unsigned x1, y1;
 
-  if (!rfbUpdateRegion.updated) {
-    rfbSetUpdateRegion(x0, y0, w, h);
+  if (!region->updated) {
+    region->x = x0;
+    region->y = y0;
+    region->width  = w;
+    region->height = h;
+    region->updated = ((w > 0) && (h > 0));
   } else {
-    x1 = rfbUpdateRegion.x + rfbUpdateRegion.width;
-    y1 = rfbUpdateRegion.y + rfbUpdateRegion.height;
-    if (x0 < rfbUpdateRegion.x) {
-      rfbUpdateRegion.x = x0;
+    x1 = region->x + region->width;
+    y1 = region->y + region->height;
+    if (x0 < region->x) {
+      region->x = x0;
     }
-    if (y0 < rfbUpdateRegion.y) {
-      rfbUpdateRegion.y = y0;
+    if (y0 < region->y) {
+      region->y = y0;
     }
     if ((x0 + w) > x1) {
-      rfbUpdateRegion.width = x0 + w - rfbUpdateRegion.x;
+      region->width = x0 + w - region->x;
     } else {
-      rfbUpdateRegion.width= x1 - rfbUpdateRegion.x;
+      region->width= x1 - region->x;
     }
     if ((y0 + h) > y1) {
-      rfbUpdateRegion.height = y0 + h - rfbUpdateRegion.y;
+      region->height = y0 + h - region->y;
     } else {
-      rfbUpdateRegion.height = y1 - rfbUpdateRegion.y;
+      region->height = y1 - region->y;
     }
-    if ((rfbUpdateRegion.x + rfbUpdateRegion.width) > rfbWindowX) {
-      rfbUpdateRegion.width = rfbWindowX - rfbUpdateRegion.x;
+    if ((region->x + region->width) > rfbWindowX) {
+      region->width = rfbWindowX - region->x;
     }
-    if ((rfbUpdateRegion.y + rfbUpdateRegion.height) > rfbWindowY) {
-      rfbUpdateRegion.height = rfbWindowY - rfbUpdateRegion.y;
+    if ((region->y + region->height) > rfbWindowY) {
+      region->height = rfbWindowY - region->y;
     }
-    rfbUpdateRegion.updated = 1;
+    region->updated = 1;
   }
 }
 
@@ -0,0 +1,531 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+/////////////////////////////////////////////////////////////////////////
+
+// Headless display library publishing the guest screen in a memory-mapped
+// file. External tools can take screenshots and inject keyboard / mouse
+// events without a network connection. See shmem.h for the file layout and
+// the access protocol.
+//
+// bochsrc example:
+//   display_library: shmem, options="file=/dev/shm/bochs-vm1"
+
+// Define BX_PLUGGABLE in files that can be compiled into plugins.  For
+// platforms that require a special tag on exported symbols, BX_PLUGGABLE
+// is used to know when we are exporting symbols and when we are importing.
+#define BX_PLUGGABLE
+
+#include "bochs.h"
+#include "param_names.h"
+#include "iodev.h"
+#if BX_WITH_SHMEM
+
+#include "icon_bochs.h"
+#include "font/vga.bitmap.h"
+#include "shmem.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+class bx_shmem_gui_c : public bx_gui_c {
+public:
+  bx_shmem_gui_c(void) {}
+  DECLARE_GUI_VIRTUAL_METHODS()
+  DECLARE_GUI_NEW_VIRTUAL_METHODS()
+  virtual void draw_char(Bit8u ch, Bit8u fc, Bit8u bc, Bit16u xc, Bit16u yc,
+                         Bit8u fw, Bit8u fh, Bit8u fx, Bit8u fy,
+                         bool gfxcharw9, Bit8u cs, Bit8u ce, bool curs, bool font2);
+  virtual void get_capabilities(Bit16u *xres, Bit16u *yres, Bit16u *bpp);
+  virtual void set_mouse_mode_absxy(bool mode);
+private:
+  void add_dirty_rect(unsigned x, unsigned y, unsigned w, unsigned h);
+  void handle_input_event(bx_shmem_event_t *ev);
+};
+
+// declare one instance of the gui object and call macro to insert the
+// plugin code
+static bx_shmem_gui_c *theGui = NULL;
+IMPLEMENT_GUI_PLUGIN_CODE(shmem)
+
+#define LOG_THIS theGui->
+
+#define BX_SHMEM_DEF_XRES 640
+#define BX_SHMEM_DEF_YRES 480
+
+static char shmFileName[BX_PATHNAME_LEN];
+static int shmFd = -1;
+static size_t shmMapSize = 0;
+static bx_shmem_header_t *shmHeader = NULL;
+static Bit32u *shmSharedFb = NULL;
+// the screen is rendered into a private buffer and published on flush()
+static Bit32u *shmScreen = NULL;
+static Bit32u shmPalette[256];
+static unsigned shmPitch;
+static unsigned shmNumRects = 0;
+static bool shmFullUpdate = 0;
+static bx_shmem_rect_t shmRects[BX_SHMEM_MAX_RECTS];
+static bool shmMouseModeAbsXY = 0;
+
+
+// SHMEM implementation of the bx_gui_c methods (see nogui.cc for details)
+
+void bx_shmem_gui_c::specific_init(int argc, char **argv, unsigned headerbar_y)
+{
+  int i;
+  size_t hdrsize;
+
+  put("SHMEM");
+  UNUSED(headerbar_y);
+  UNUSED(bochs_icon_bits);
+
+  for (i = 0; i < 256; i++) {
+    for (int j = 0; j < 16; j++) {
+      vga_charmap[0][i * 32 + j] = reverse_bitorder(bx_vgafont[i].data[j]);
+      vga_charmap[1][i * 32 + j] = reverse_bitorder(bx_vgafont[i].data[j]);
+    }
+  }
+
+#ifdef __linux__
+  sprintf(shmFileName, "/dev/shm/bochs-%d", (int)getpid());
+#else
+  sprintf(shmFileName, "/tmp/bochs-%d", (int)getpid());
+#endif
+
+  // parse shmem specific options
+  if (argc > 1) {
+    for (i = 1; i < argc; i++) {
+      if (!parse_common_gui_options(argv[i], 0)) {
+        if (!strncmp(argv[i], "file=", 5)) {
+          strncpy(shmFileName, &argv[i][5], BX_PATHNAME_LEN - 1);
+          shmFileName[BX_PATHNAME_LEN - 1] = 0;
+        } else {
+          BX_PANIC(("Unknown shmem option '%s'", argv[i]));
+        }
+      }
+    }
+  }
+
+  if (SIM->get_param_bool(BXPN_PRIVATE_COLORMAP)->get()) {
+    BX_INFO(("private_colormap option ignored."));
+  }
+
+  max_xres = BX_SHMEM_MAX_XRES;
+  max_yres = BX_SHMEM_MAX_YRES;
+  shmPitch = max_xres * 4;
+  hdrsize = (sizeof(bx_shmem_header_t) + 4095) & ~4095;
+  shmMapSize = hdrsize + shmPitch * max_yres;
+
+  shmFd = open(shmFileName, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (shmFd < 0) {
+    BX_PANIC(("Could not create shared memory file '%s'", shmFileName));
+    return;
+  }
+  if (ftruncate(shmFd, shmMapSize) < 0) {
+    BX_PANIC(("Could not set size of shared memory file '%s'", shmFileName));
+    return;
+  }
+  void *ptr = mmap(NULL, shmMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmFd, 0);
+  if (ptr == MAP_FAILED) {
+    BX_PANIC(("Could not map shared memory file '%s'", shmFileName));
+    return;
+  }
+  shmHeader = (bx_shmem_header_t *)ptr;
+  shmSharedFb = (Bit32u *)((Bit8u *)ptr + hdrsize);
+  shmScreen = new Bit32u[max_xres * max_yres];
+  memset(shmScreen, 0, shmPitch * max_yres);
+
+  shmHeader->fb_offset = (Bit32u)hdrsize;
+  shmHeader->fb_size = shmPitch * max_yres;
+  shmHeader->max_xres = max_xres;
+  shmHeader->max_yres = max_yres;
+  shmHeader->pid = (Bit32u)getpid();
+  shmHeader->pitch = shmPitch;
+  shmHeader->xres = BX_SHMEM_DEF_XRES;
+  shmHeader->yres = BX_SHMEM_DEF_YRES;
+  shmHeader->guest_bpp = 8;
+  shmHeader->version = BX_SHMEM_VERSION;
+  // the magic value tells the readers that the header is valid
+  BX_SHMEM_BARRIER();
+  shmHeader->magic = BX_SHMEM_MAGIC;
+  BX_INFO(("screen published in shared memory file '%s'", shmFileName));
+
+  guest_xres = BX_SHMEM_DEF_XRES;
+  guest_yres = BX_SHMEM_DEF_YRES;
+  guest_bpp = 8;
+
+  new_gfx_api = 1;
+  new_text_api = 1;
+}
+
+void bx_shmem_gui_c::handle_input_event(bx_shmem_event_t *ev)
+{
+  switch (ev->type) {
+    case BX_SHMEM_EV_KEY:
+      DEV_kbd_gen_scancode(ev->key);
+      break;
+    case BX_SHMEM_EV_MOUSE:
+      DEV_mouse_motion(ev->dx, ev->dy, ev->dz, ev->buttons, 0);
+      break;
+    case BX_SHMEM_EV_MOUSE_ABS:
+      if (shmMouseModeAbsXY) {
+        DEV_mouse_motion(ev->dx, ev->dy, ev->dz, ev->buttons, 1);
+      } else {
+        BX_ERROR(("absolute mouse event ignored - no absolute pointing device"));
+      }
+      break;
+    default:
+      BX_ERROR(("unknown input event type %u", ev->type));
+  }
+}
+
+void bx_shmem_gui_c::handle_events(void)
+{
+  bx_shmem_event_t ev;
+  Bit32u head, tail;
+
+  if (shmHeader == NULL) return;
+  head = shmHeader->in_head;
+  tail = shmHeader->in_tail;
+  if (head == tail) return;
+  if ((head - tail) > BX_SHMEM_INPUT_SLOTS) {
+    BX_ERROR(("input queue corrupted - dropping events"));
+    shmHeader->in_tail = head;
+    return;
+  }
+  // make sure the event data is read after the producer index
+  BX_SHMEM_BARRIER();
+  while (tail != head) {
+    memcpy(&ev, &shmHeader->event[tail % BX_SHMEM_INPUT_SLOTS], sizeof(ev));
+    handle_input_event(&ev);
+    tail++;
+  }
+  BX_SHMEM_BARRIER();
+  shmHeader->in_tail = tail;
+}
+
+void bx_shmem_gui_c::add_dirty_rect(unsigned x, unsigned y, unsigned w, unsigned h)
+{
+  bx_shmem_rect_t *r;
+  unsigned i;
+
+  if (shmFullUpdate) return;
+  // tiles arrive in rows, so try to extend the last rectangle first
+  if (shmNumRects > 0) {
+    r = &shmRects[shmNumRects - 1];
+    if ((r->y == y) && (r->h == h) && ((unsigned)(r->x + r->w) == x)) {
+      r->w += w;
+      return;
+    }
+  }
+  for (i = 0; i < shmNumRects; i++) {
+    r = &shmRects[i];
+    if ((x >= r->x) && (y >= r->y) && ((x + w) <= (unsigned)(r->x + r->w)) &&
+        ((y + h) <= (unsigned)(r->y + r->h))) {
+      return;
+    }
+    if ((r->x == x) && (r->w == w) && ((unsigned)(r->y + r->h) == y)) {
+      r->h += h;
+      return;
+    }
+  }
+  if (shmNumRects == BX_SHMEM_MAX_RECTS) {
+    shmFullUpdate = 1;
+    return;
+  }
+  r = &shmRects[shmNumRects++];
+  r->x = x;
+  r->y = y;
+  r->w = w;
+  r->h = h;
+}
+
+void bx_shmem_gui_c::flush(void)
+{
+  unsigned i, line, offset;
+  bx_shmem_rect_t *r;
+
+  if ((shmHeader == NULL) || (!shmFullUpdate && (shmNumRects == 0))) return;
+
+  shmHeader->seq++;
+  BX_SHMEM_BARRIER();
+  if (shmFullUpdate) {
+    for (line = 0; line < guest_yres; line++) {
+      memcpy(&shmSharedFb[line * max_xres], &shmScreen[line * max_xres], guest_xres * 4);
+    }
+    shmHeader->num_rects = BX_SHMEM_MAX_RECTS + 1;
+  } else {
+    for (i = 0; i < shmNumRects; i++) {
+      r = &shmRects[i];
+      for (line = 0; line < r->h; line++) {
+        offset = (r->y + line) * max_xres + r->x;
+        memcpy(&shmSharedFb[offset], &shmScreen[offset], r->w * 4);
+      }
+      shmHeader->rect[i] = *r;
+    }
+    shmHeader->num_rects = shmNumRects;
+  }
+  shmHeader->xres = guest_xres;
+  shmHeader->yres = guest_yres;
+  shmHeader->guest_bpp = guest_bpp;
+  shmHeader->textmode = guest_textmode;
+  shmHeader->frame++;
+  BX_SHMEM_BARRIER();
+  shmHeader->seq++;
+
+  shmNumRects = 0;
+  shmFullUpdate = 0;
+}
+
+void bx_shmem_gui_c::clear_screen(void)
+{
+  if (shmScreen == NULL) return;
+  memset(shmScreen, 0, shmPitch * guest_yres);
+  shmFullUpdate = 1;
+}
+
+void bx_shmem_gui_c::draw_char(Bit8u ch, Bit8u fc, Bit8u bc, Bit16u xc, Bit16u yc,
+                               Bit8u fw, Bit8u fh, Bit8u fx, Bit8u fy,
+                               bool gfxcharw9, Bit8u cs, Bit8u ce, bool curs, bool font2)
+{
+  Bit32u *buf, fgcolor, bgcolor;
+  Bit16u font_row, mask;
+  Bit8u *font_ptr, fontpixels, h = fh;
+  bool dwidth;
+
+  buf = shmScreen + yc * max_xres + xc;
+  fgcolor = shmPalette[fc];
+  bgcolor = shmPalette[bc];
+  dwidth = (guest_fwidth > 9);
+  if (font2) {
+    font_ptr = &vga_charmap[1][(ch << 5) + fy];
+  } else {
+    font_ptr = &vga_charmap[0][(ch << 5) + fy];
+  }
+  do {
+    font_row = *font_ptr++;
+    if (gfxcharw9) {
+      font_row = (font_row << 1) | (font_row & 0x01);
+    } else {
+      font_row <<= 1;
+    }
+    if (fx > 0) {
+      font_row <<= fx;
+    }
+    fontpixels = fw;
+    if (curs && (fy >= cs) && (fy <= ce))
+      mask = 0x100;
+    else
+      mask = 0x00;
+    do {
+      if ((font_row & 0x100) == mask)
+        *buf = bgcolor;
+      else
+        *buf = fgcolor;
+      buf++;
+      if (!dwidth || (fontpixels & 1)) font_row <<= 1;
+    } while (--fontpixels);
+    buf += (max_xres - fw);
+    fy++;
+  } while (--fh);
+  add_dirty_rect(xc, yc, fw, h);
+}
+
+void bx_shmem_gui_c::text_update(Bit8u *old_text, Bit8u *new_text,
+                                 unsigned long cursor_x, unsigned long cursor_y,
+                                 bx_vga_tminfo_t *tm_info)
+{
+  // present for compatibility
+}
+
+int bx_shmem_gui_c::get_clipboard_text(Bit8u **bytes, Bit32s *nbytes)
+{
+  UNUSED(bytes);
+  UNUSED(nbytes);
+  return 0;
+}
+
+int bx_shmem_gui_c::set_clipboard_text(char *text_snapshot, Bit32u len)
+{
+  UNUSED(text_snapshot);
+  UNUSED(len);
+  return 0;
+}
+
+bool bx_shmem_gui_c::palette_change(Bit8u index, Bit8u red, Bit8u green, Bit8u blue)
+{
+  shmPalette[index] = (red << 16) | (green << 8) | blue;
+  return 1;
+}
+
+void bx_shmem_gui_c::graphics_tile_update(Bit8u *tile, unsigned x0, unsigned y0)
+{
+  Bit32u *buf, *buf_row;
+  unsigned w, h, i, j;
+
+  if (graphics_tile_get(x0, y0, &w, &h) == NULL) return;
+  buf = shmScreen + y0 * max_xres + x0;
+
+  switch (guest_bpp) {
+    case 8: /* 8 bpp */
+      for (i = 0; i < h; i++) {
+        buf_row = buf;
+        for (j = 0; j < w; j++) {
+          *buf++ = shmPalette[tile[j]];
+        }
+        tile += x_tilesize;
+        buf = buf_row + max_xres;
+      }
+      break;
+    default:
+      BX_PANIC(("%u bpp modes handled by new graphics API", guest_bpp));
+      return;
+  }
+  add_dirty_rect(x0, y0, w, h);
+}
+
+bx_svga_tileinfo_t *bx_shmem_gui_c::graphics_tile_info(bx_svga_tileinfo_t *info)
+{
+  info->bpp = 32;
+  info->pitch = shmPitch;
+  info->red_shift = 24;
+  info->green_shift = 16;
+  info->blue_shift = 8;
+  info->red_mask = 0xff0000;
+  info->green_mask = 0x00ff00;
+  info->blue_mask = 0x0000ff;
+  info->is_indexed = 0;
+#ifdef BX_LITTLE_ENDIAN
+  info->is_little_endian = 1;
+#else
+  info->is_little_endian = 0;
+#endif
+  return info;
+}
+
+Bit8u *bx_shmem_gui_c::graphics_tile_get(unsigned x0, unsigned y0, unsigned *w, unsigned *h)
+{
+  if ((x0 >= guest_xres) || (y0 >= guest_yres)) {
+    *w = *h = 0;
+    return NULL;
+  }
+  if ((x0 + x_tilesize) > guest_xres) {
+    *w = guest_xres - x0;
+  } else {
+    *w = x_tilesize;
+  }
+  if ((y0 + y_tilesize) > guest_yres) {
+    *h = guest_yres - y0;
+  } else {
+    *h = y_tilesize;
+  }
+  return (Bit8u *)(shmScreen + y0 * max_xres + x0);
+}
+
+void bx_shmem_gui_c::graphics_tile_update_in_place(unsigned x0, unsigned y0,
+                                                   unsigned w, unsigned h)
+{
+  add_dirty_rect(x0, y0, w, h);
+}
+
+void bx_shmem_gui_c::dimension_update(unsigned x, unsigned y, unsigned fheight, unsigned fwidth, unsigned bpp)
+{
+  if ((bpp == 8) || (bpp == 15) || (bpp == 16) || (bpp == 24) || (bpp == 32)) {
+    guest_bpp = bpp;
+  } else {
+    BX_PANIC(("%d bpp graphics mode not supported", bpp));
+  }
+  if ((x > max_xres) || (y > max_yres)) {
+    BX_PANIC(("dimension_update(): shmem doesn't support graphics mode %dx%d", x, y));
+    return;
+  }
+  guest_textmode = (fheight > 0);
+  guest_fwidth = fwidth;
+  guest_fheight = fheight;
+  guest_xres = x;
+  guest_yres = y;
+  shmFullUpdate = 1;
+}
+
+unsigned bx_shmem_gui_c::create_bitmap(const unsigned char *bmap, unsigned xdim, unsigned ydim)
+{
+  UNUSED(bmap);
+  UNUSED(xdim);
+  UNUSED(ydim);
+  return 0;
+}
+
+unsigned bx_shmem_gui_c::headerbar_bitmap(unsigned bmap_id, unsigned alignment, void (*f)(void))
+{
+  UNUSED(bmap_id);
+  UNUSED(alignment);
+  UNUSED(f);
+  return 0;
+}
+
+void bx_shmem_gui_c::show_headerbar(void)
+{
+}
+
+void bx_shmem_gui_c::replace_bitmap(unsigned hbar_id, unsigned bmap_id)
+{
+  UNUSED(hbar_id);
+  UNUSED(bmap_id);
+}
+
+void bx_shmem_gui_c::exit(void)
+{
+  if (shmHeader != NULL) {
+    shmHeader->magic = 0;
+    munmap(shmHeader, shmMapSize);
+    shmHeader = NULL;
+    shmSharedFb = NULL;
+  }
+  if (shmFd >= 0) {
+    close(shmFd);
+    unlink(shmFileName);
+    shmFd = -1;
+  }
+  if (shmScreen != NULL) {
+    delete [] shmScreen;
+    shmScreen = NULL;
+  }
+  BX_DEBUG(("bx_shmem_gui_c::exit()"));
+}
+
+void bx_shmem_gui_c::mouse_enabled_changed_specific(bool val)
+{
+}
+
+void bx_shmem_gui_c::get_capabilities(Bit16u *xres, Bit16u *yres, Bit16u *bpp)
+{
+  *xres = BX_SHMEM_MAX_XRES;
+  *yres = BX_SHMEM_MAX_YRES;
+  *bpp = 32;
+}
+
+void bx_shmem_gui_c::set_mouse_mode_absxy(bool mode)
+{
+  shmMouseModeAbsXY = mode;
+}
+
+#endif /* if BX_WITH_SHMEM */
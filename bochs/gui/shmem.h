@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+/////////////////////////////////////////////////////////////////////////
+
+// Layout of the memory-mapped file used by the "shmem" display library.
+// This header is also meant to be used by external tools reading the
+// screen and injecting input. Outside of Bochs the types Bit16u, Bit32u and
+// Bit32s must be defined before including it.
+//
+// The file starts with bx_shmem_header_t, followed by the framebuffer at
+// offset 'fb_offset'. The framebuffer always has 32 bpp (0x00RRGGBB, host
+// byte order) and 'max_xres * 4' bytes per line.
+//
+// Screen update (Bochs is the only writer):
+//   'seq' is a sequence lock. It is odd while Bochs copies the changed screen
+//   areas into the framebuffer and updates the display info and the dirty
+//   rectangle list. A reader must retry if 'seq' was odd or has changed
+//   after reading:
+//
+//     do {
+//       do { s = hdr->seq; } while (s & 1);
+//       BX_SHMEM_BARRIER();
+//       ... copy display info, dirty rectangles and framebuffer data ...
+//       BX_SHMEM_BARRIER();
+//     } while (hdr->seq != s);
+//
+//   'frame' is incremented with each published update. The rectangle list
+//   only describes the changes since the previous frame. If a reader missed
+//   one or more frames or 'num_rects' is greater than BX_SHMEM_MAX_RECTS,
+//   the whole screen must be read.
+//
+// Input injection (the external tool is the only writer):
+//   The event queue is a single producer / single consumer ring. The tool
+//   writes the event to 'event[in_head % BX_SHMEM_INPUT_SLOTS]' and then
+//   increments 'in_head'. Bochs consumes the events and increments 'in_tail'.
+//   The queue is full if 'in_head - in_tail == BX_SHMEM_INPUT_SLOTS'.
+
+#ifndef BX_GUI_SHMEM_H
+#define BX_GUI_SHMEM_H
+
+#define BX_SHMEM_MAGIC        0x4d485342  // "BSHM"
+#define BX_SHMEM_VERSION      1
+
+#define BX_SHMEM_MAX_XRES     2560
+#define BX_SHMEM_MAX_YRES     1600
+#define BX_SHMEM_MAX_RECTS    64
+#define BX_SHMEM_INPUT_SLOTS  256
+
+// event types
+#define BX_SHMEM_EV_KEY       1  // 'key' is BX_KEY_* ORed with BX_KEY_RELEASED
+#define BX_SHMEM_EV_MOUSE     2  // relative motion in 'dx', 'dy' and 'dz'
+#define BX_SHMEM_EV_MOUSE_ABS 3  // absolute position 0 ... 0x7fff in 'dx', 'dy'
+
+#if defined(__GNUC__)
+#define BX_SHMEM_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#define BX_SHMEM_BARRIER() MemoryBarrier()
+#endif
+
+typedef struct {
+  Bit16u x, y, w, h;
+} bx_shmem_rect_t;
+
+typedef struct {
+  Bit32u type;
+  Bit32u key;
+  Bit32s dx, dy, dz;
+  Bit32u buttons;
+} bx_shmem_event_t;
+
+typedef struct {
+  // constant after initialization
+  Bit32u magic;
+  Bit32u version;
+  Bit32u fb_offset;
+  Bit32u fb_size;
+  Bit32u max_xres;
+  Bit32u max_yres;
+  Bit32u pid;
+  Bit32u reserved;
+  // display info and dirty rectangles (protected by 'seq')
+  volatile Bit32u seq;
+  Bit32u frame;
+  Bit32u xres;
+  Bit32u yres;
+  Bit32u pitch;
+  Bit32u guest_bpp;
+  Bit32u textmode;
+  Bit32u num_rects;
+  bx_shmem_rect_t rect[BX_SHMEM_MAX_RECTS];
+  // input event queue
+  volatile Bit32u in_head;
+  volatile Bit32u in_tail;
+  bx_shmem_event_t event[BX_SHMEM_INPUT_SLOTS];
+} bx_shmem_header_t;
+
+#endif
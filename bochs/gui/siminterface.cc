@@ -1368,20 +1368,23 @@ bool bx_real_sim_c::restore_bochs_param(bx_list_c *root, const char *sr_path, co
                   fp2 = fopen(devdata, "rb");
                   if (fp2 != NULL) {
                     FILE **fpp = ((bx_shadow_filedata_c*)param)->get_fpp();
-                    // If the temporary backing store file wasn't created, do it now.
-                    if (*fpp == NULL) {
-                      *fpp = tmpfile64();
-                    } else {
-                      fseeko64(*fpp, 0, SEEK_SET);
-                    }
-                    if (*fpp != NULL) {
-                      char *buffer = new char[4096];
-                      while (!feof(fp2)) {
-                        size_t chars = fread(buffer, 1, 4096, fp2);
-                        fwrite(buffer, 1, chars, *fpp);
+                    // Without backing store the restore handler reads the file itself.
+                    if (fpp != NULL) {
+                      // If the temporary backing store file wasn't created, do it now.
+                      if (*fpp == NULL) {
+                        *fpp = tmpfile64();
+                      } else {
+                        fseeko64(*fpp, 0, SEEK_SET);
+                      }
+                      if (*fpp != NULL) {
+                        char *buffer = new char[4096];
+                        while (!feof(fp2)) {
+                          size_t chars = fread(buffer, 1, 4096, fp2);
+                          fwrite(buffer, 1, chars, *fpp);
+                        }
+                        delete [] buffer;
+                        fflush(*fpp);
                       }
-                      delete [] buffer;
-                      fflush(*fpp);
                     }
                     ((bx_shadow_filedata_c*)param)->restore(fp2);
                     fclose(fp2);
@@ -1423,7 +1426,7 @@ bool bx_real_sim_c::restore_hardware()
 bool bx_real_sim_c::save_sr_param(FILE *fp, bx_param_c *node, const char *sr_path, int level)
 {
   int i, j;
-  char pname[BX_PATHNAME_LEN], tmpstr[BX_PATHNAME_LEN+1];
+  char pname[BX_PATHNAME_LEN], tmpstr[BX_PATHNAME_LEN+1], tmpname[BX_PATHNAME_LEN+5];
   FILE *fp2;
 
   for (i=0; i<level; i++)
@@ -1488,11 +1491,14 @@ bool bx_real_sim_c::save_sr_param(FILE *fp, bx_param_c *node, const char *sr_pat
         sprintf(tmpstr, "%s/%s.%s", sr_path, node->get_parent()->get_name(), node->get_name());
       else
         sprintf(tmpstr, "%s.%s", node->get_parent()->get_name(), node->get_name());
-      fp2 = fopen(tmpstr, "wb");
+      // The file of a restored state may still be mapped (guest RAM), so it
+      // must not be truncated. Write a new file and replace the old one.
+      sprintf(tmpname, "%s.tmp", tmpstr);
+      fp2 = fopen(tmpname, "wb");
       if (fp2 != NULL) {
         FILE **fpp = ((bx_shadow_filedata_c*)node)->get_fpp();
         // If the backing store hasn't been created, just save an empty 0 byte placeholder file.
-        if (*fpp != NULL) {
+        if ((fpp != NULL) && (*fpp != NULL)) {
           char *buffer = new char[4096];
           fseeko64(*fpp, 0, SEEK_SET);
           while (!feof(*fpp)) {
@@ -1503,6 +1509,14 @@ bool bx_real_sim_c::save_sr_param(FILE *fp, bx_param_c *node, const char *sr_pat
         }
         ((bx_shadow_filedata_c*)node)->save(fp2);
         fclose(fp2);
+#ifdef WIN32
+        remove(tmpstr);
+#endif
+        if (rename(tmpname, tmpstr) < 0) {
+          BX_ERROR(("save_sr_param(): cannot rename '%s' to '%s'", tmpname, tmpstr));
+          remove(tmpname);
+          return 0;
+        }
       }
       break;
     case BXT_LIST:
@@ -0,0 +1,174 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+/////////////////////////////////////////////////////////////////////////
+
+// Interface between Bochs configured with --enable-instrumentation=runtime
+// and the instrumentation modules it loads at runtime. This header is also
+// used to build the modules. Outside of Bochs the types Bit8u ... Bit64u,
+// bx_address and bx_phy_address must be defined before including it (the
+// generated config.h does that).
+//
+// A module is a shared library exporting
+//
+//   extern "C" int bx_instr_module_init(bx_instr_module_t *module,
+//                  const bx_instr_services_t *services, const char *options);
+//
+// It is called with a zeroed 'module', fills in the name, the callbacks and
+// the subscribed events and returns 0, or a negative value to refuse being
+// attached. Modules are attached from bochsrc ("instrument: module=...") or
+// from the debugger ("instrument attach ...") and only see the events they
+// are subscribed to. The subscription can be changed at any time with
+// services->subscribe(), for example to trace the executed instructions
+// only for a while. The callbacks have the arguments of the bx_instr_*
+// functions described in instrument/instrumentation.txt.
+//
+// While no module subscribes to an event, its hook costs a predictable
+// branch. The execution events cost nothing: the CPU stops the handlers
+// chain after every instruction only while a module subscribes to
+// BX_INSTR_EV_BEFORE_EXECUTION or BX_INSTR_EV_AFTER_EXECUTION.
+//
+// The module must access the simulation through 'services' only, Bochs
+// does not export its symbols to the loaded libraries.
+
+#ifndef BX_INSTR_MODULE_H
+#define BX_INSTR_MODULE_H
+
+#define BX_INSTR_MODULE_VERSION 1
+
+#define BX_INSTR_MODULE_INIT "bx_instr_module_init"
+
+// event subscription bits
+#define BX_INSTR_EV_RESET                   (1 << 0)
+#define BX_INSTR_EV_HLT                     (1 << 1)
+#define BX_INSTR_EV_MWAIT                   (1 << 2)
+#define BX_INSTR_EV_CNEAR_BRANCH_TAKEN      (1 << 3)
+#define BX_INSTR_EV_CNEAR_BRANCH_NOT_TAKEN  (1 << 4)
+#define BX_INSTR_EV_UCNEAR_BRANCH           (1 << 5)
+#define BX_INSTR_EV_FAR_BRANCH              (1 << 6)
+#define BX_INSTR_EV_OPCODE                  (1 << 7)
+#define BX_INSTR_EV_INTERRUPT               (1 << 8)
+#define BX_INSTR_EV_EXCEPTION               (1 << 9)
+#define BX_INSTR_EV_HWINTERRUPT             (1 << 10)
+#define BX_INSTR_EV_TLB_CNTRL               (1 << 11)
+#define BX_INSTR_EV_CACHE_CNTRL             (1 << 12)
+#define BX_INSTR_EV_PREFETCH_HINT           (1 << 13)
+#define BX_INSTR_EV_CLFLUSH                 (1 << 14)
+#define BX_INSTR_EV_CPUID                   (1 << 15)
+#define BX_INSTR_EV_BEFORE_EXECUTION        (1 << 16)
+#define BX_INSTR_EV_AFTER_EXECUTION         (1 << 17)
+#define BX_INSTR_EV_REPEAT_ITERATION        (1 << 18)
+#define BX_INSTR_EV_INP                     (1 << 19)
+#define BX_INSTR_EV_INP2                    (1 << 20)
+#define BX_INSTR_EV_OUTP                    (1 << 21)
+#define BX_INSTR_EV_LIN_ACCESS              (1 << 22)
+#define BX_INSTR_EV_PHY_ACCESS              (1 << 23)
+#define BX_INSTR_EV_WRMSR                   (1 << 24)
+#define BX_INSTR_EV_VMEXIT                  (1 << 25)
+
+#define BX_INSTR_EV_BRANCH (BX_INSTR_EV_CNEAR_BRANCH_TAKEN | \
+  BX_INSTR_EV_CNEAR_BRANCH_NOT_TAKEN | BX_INSTR_EV_UCNEAR_BRANCH | BX_INSTR_EV_FAR_BRANCH)
+
+#define BX_INSTR_EV_EXECUTION \
+  (BX_INSTR_EV_BEFORE_EXECUTION | BX_INSTR_EV_AFTER_EXECUTION)
+
+class bxInstruction_c;
+
+struct bx_instr_module_t;
+
+typedef struct {
+  Bit32u version;     // BX_INSTR_MODULE_VERSION
+  unsigned num_cpus;
+
+  // change the events the module is subscribed to
+  void (*subscribe)(struct bx_instr_module_t *module, Bit32u events);
+
+  // write a message to the Bochs log
+  void (*log)(const char *msg);
+
+  Bit64u (*get_icount)(unsigned cpu);
+  bx_address (*get_rip)(unsigned cpu);
+  // general purpose registers in the BX_64BIT_REG_RAX ... R15 order
+  Bit64u (*get_reg)(unsigned cpu, unsigned reg);
+  bx_phy_address (*get_cr3)(unsigned cpu);
+  unsigned (*get_cpl)(unsigned cpu);
+  // BX_MODE_IA32_REAL ... BX_MODE_LONG_64
+  unsigned (*get_cpu_mode)(unsigned cpu);
+
+  // read guest memory through the current page tables without side
+  // effects, false if a page is not present
+  bool (*read_linear)(unsigned cpu, bx_address laddr, unsigned len, Bit8u *buf);
+
+  unsigned (*insn_length)(const bxInstruction_c *i);
+  const char *(*insn_name)(const bxInstruction_c *i);
+} bx_instr_services_t;
+
+typedef struct bx_instr_module_t {
+  const char *name;
+  Bit32u events;
+
+  // called before the module is unloaded
+  void (*exit_module)(void);
+
+  void (*initialize)(unsigned cpu);
+  void (*exit)(unsigned cpu);
+  void (*reset)(unsigned cpu, unsigned type);
+  void (*hlt)(unsigned cpu);
+  void (*mwait)(unsigned cpu, bx_phy_address addr, unsigned len, Bit32u flags);
+
+  void (*debug_promt)(void);
+  void (*debug_cmd)(const char *cmd);
+
+  void (*cnear_branch_taken)(unsigned cpu, bx_address branch_eip, bx_address new_eip);
+  void (*cnear_branch_not_taken)(unsigned cpu, bx_address branch_eip);
+  void (*ucnear_branch)(unsigned cpu, unsigned what, bx_address branch_eip, bx_address new_eip);
+  void (*far_branch)(unsigned cpu, unsigned what, Bit16u prev_cs, bx_address prev_eip, Bit16u new_cs, bx_address new_eip);
+
+  void (*opcode)(unsigned cpu, bxInstruction_c *i, const Bit8u *opcode, unsigned len, bool is32, bool is64);
+
+  void (*interrupt)(unsigned cpu, unsigned vector);
+  void (*exception)(unsigned cpu, unsigned vector, unsigned error_code);
+  void (*hwinterrupt)(unsigned cpu, unsigned vector, Bit16u cs, bx_address eip);
+
+  void (*tlb_cntrl)(unsigned cpu, unsigned what, bx_phy_address new_cr3);
+  void (*cache_cntrl)(unsigned cpu, unsigned what);
+  void (*prefetch_hint)(unsigned cpu, unsigned what, unsigned seg, bx_address offset);
+  void (*clflush)(unsigned cpu, bx_address laddr, bx_phy_address paddr);
+  void (*cpuid)(unsigned cpu);
+
+  void (*before_execution)(unsigned cpu, bxInstruction_c *i);
+  void (*after_execution)(unsigned cpu, bxInstruction_c *i);
+  void (*repeat_iteration)(unsigned cpu, bxInstruction_c *i);
+
+  void (*inp)(Bit16u addr, unsigned len);
+  void (*inp2)(Bit16u addr, unsigned len, unsigned val);
+  void (*outp)(Bit16u addr, unsigned len, unsigned val);
+
+  void (*lin_access)(unsigned cpu, bx_address lin, bx_address phy, unsigned len, unsigned memtype, unsigned rw);
+  void (*phy_access)(unsigned cpu, bx_address phy, unsigned len, unsigned memtype, unsigned rw);
+
+  void (*wrmsr)(unsigned cpu, unsigned addr, Bit64u value);
+
+  void (*vmexit)(unsigned cpu, Bit32u reason, Bit64u qualification);
+} bx_instr_module_t;
+
+typedef int (*bx_instr_module_init_t)(bx_instr_module_t *module,
+               const bx_instr_services_t *services, const char *options);
+
+#endif
@@ -0,0 +1,144 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+// Example runtime instrumentation module. It counts interrupts, exceptions
+// and conditional branches, and the executed instructions while the "exec"
+// option is given. Build it with "make example.so" in instrument/runtime
+// and attach it with
+//
+//   instrument: module=instrument/runtime/example.so, options="exec"
+//
+// or from the debugger with
+//
+//   instrument "attach instrument/runtime/example.so"
+//   instrument "example exec"     - start counting executed instructions
+//   instrument "example noexec"   - stop counting executed instructions
+//   instrument example            - print the statistics
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "bx_instr_module.h"
+
+static const bx_instr_services_t *bx;
+static bx_instr_module_t *self;
+
+struct cpu_stats_t {
+  Bit64u executed;
+  Bit64u taken, not_taken;
+  Bit64u interrupts, exceptions;
+};
+
+static cpu_stats_t *stats;
+
+#define BASE_EVENTS (BX_INSTR_EV_CNEAR_BRANCH_TAKEN | BX_INSTR_EV_CNEAR_BRANCH_NOT_TAKEN | \
+  BX_INSTR_EV_INTERRUPT | BX_INSTR_EV_HWINTERRUPT | BX_INSTR_EV_EXCEPTION)
+
+static void print_stats(void)
+{
+  char msg[256];
+
+  for (unsigned cpu=0; cpu < bx->num_cpus; cpu++) {
+    snprintf(msg, sizeof(msg), "CPU%u: executed %llu, branches %llu taken %llu not taken, "
+      "interrupts %llu, exceptions %llu", cpu,
+      (unsigned long long) stats[cpu].executed,
+      (unsigned long long) stats[cpu].taken,
+      (unsigned long long) stats[cpu].not_taken,
+      (unsigned long long) stats[cpu].interrupts,
+      (unsigned long long) stats[cpu].exceptions);
+    bx->log(msg);
+  }
+}
+
+static void example_exit_module(void)
+{
+  print_stats();
+  delete [] stats;
+}
+
+static void example_debug_cmd(const char *cmd)
+{
+  if (! strcmp(cmd, "example"))
+    print_stats();
+  else if (! strcmp(cmd, "example exec"))
+    bx->subscribe(self, BASE_EVENTS | BX_INSTR_EV_AFTER_EXECUTION);
+  else if (! strcmp(cmd, "example noexec"))
+    bx->subscribe(self, BASE_EVENTS);
+}
+
+static void example_after_execution(unsigned cpu, bxInstruction_c *i)
+{
+  stats[cpu].executed++;
+}
+
+static void example_cnear_branch_taken(unsigned cpu, bx_address branch_eip, bx_address new_eip)
+{
+  stats[cpu].taken++;
+}
+
+static void example_cnear_branch_not_taken(unsigned cpu, bx_address branch_eip)
+{
+  stats[cpu].not_taken++;
+}
+
+static void example_interrupt(unsigned cpu, unsigned vector)
+{
+  stats[cpu].interrupts++;
+}
+
+static void example_hwinterrupt(unsigned cpu, unsigned vector, Bit16u cs, bx_address eip)
+{
+  stats[cpu].interrupts++;
+}
+
+static void example_exception(unsigned cpu, unsigned vector, unsigned error_code)
+{
+  stats[cpu].exceptions++;
+}
+
+extern "C" int bx_instr_module_init(bx_instr_module_t *module,
+                 const bx_instr_services_t *services, const char *options)
+{
+  if (services->version != BX_INSTR_MODULE_VERSION)
+    return -1;
+
+  bx = services;
+  self = module;
+  stats = new cpu_stats_t[services->num_cpus];
+  memset(stats, 0, sizeof(cpu_stats_t) * services->num_cpus);
+
+  module->name = "example";
+  module->exit_module = example_exit_module;
+  module->debug_cmd = example_debug_cmd;
+  module->after_execution = example_after_execution;
+  module->cnear_branch_taken = example_cnear_branch_taken;
+  module->cnear_branch_not_taken = example_cnear_branch_not_taken;
+  module->interrupt = example_interrupt;
+  module->hwinterrupt = example_hwinterrupt;
+  module->exception = example_exception;
+
+  module->events = BASE_EVENTS;
+  if (! strcmp(options, "exec"))
+    module->events |= BX_INSTR_EV_AFTER_EXECUTION;
+
+  return 0;
+}
@@ -0,0 +1,546 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+
+
+#include "bochs.h"
+#include "cpu/cpu.h"
+#include "param_names.h"
+#include "gui/siminterface.h"
+#include "memory/memory-bochs.h"
+#include "bx_debug/debug.h"
+
+#if BX_INSTRUMENTATION
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#define LOG_THIS instrlog->
+
+#define BX_INSTR_MAX_MODULES 8
+
+static logfunctions *instrlog = NULL;
+
+typedef struct {
+  bx_instr_module_t module;
+  Bit32u events; // subscribed events the module has a callback for
+  char *path;
+#if defined(WIN32)
+  HMODULE handle;
+#else
+  void *handle;
+#endif
+} bx_instr_attached_t;
+
+static bx_instr_attached_t *modules[BX_INSTR_MAX_MODULES];
+static unsigned num_modules = 0;
+
+// number of CPUs initialized so far, modules attached later get the
+// initialize callback for them when they are attached
+static unsigned num_cpus = 0;
+
+static bool bochsrc_module_attached = false;
+
+Bit32u bx_instr_events = 0;
+
+#define BX_INSTR_FOREACH(event, callback, args) {                \
+  for (unsigned n=0; n < num_modules; n++) {                     \
+    if (modules[n]->events & (event))                            \
+      modules[n]->module.callback args;                          \
+  }                                                              \
+}
+
+static Bit32u callback_events(const bx_instr_module_t *m)
+{
+  Bit32u events = 0;
+
+  if (m->reset) events |= BX_INSTR_EV_RESET;
+  if (m->hlt) events |= BX_INSTR_EV_HLT;
+  if (m->mwait) events |= BX_INSTR_EV_MWAIT;
+  if (m->cnear_branch_taken) events |= BX_INSTR_EV_CNEAR_BRANCH_TAKEN;
+  if (m->cnear_branch_not_taken) events |= BX_INSTR_EV_CNEAR_BRANCH_NOT_TAKEN;
+  if (m->ucnear_branch) events |= BX_INSTR_EV_UCNEAR_BRANCH;
+  if (m->far_branch) events |= BX_INSTR_EV_FAR_BRANCH;
+  if (m->opcode) events |= BX_INSTR_EV_OPCODE;
+  if (m->interrupt) events |= BX_INSTR_EV_INTERRUPT;
+  if (m->exception) events |= BX_INSTR_EV_EXCEPTION;
+  if (m->hwinterrupt) events |= BX_INSTR_EV_HWINTERRUPT;
+  if (m->tlb_cntrl) events |= BX_INSTR_EV_TLB_CNTRL;
+  if (m->cache_cntrl) events |= BX_INSTR_EV_CACHE_CNTRL;
+  if (m->prefetch_hint) events |= BX_INSTR_EV_PREFETCH_HINT;
+  if (m->clflush) events |= BX_INSTR_EV_CLFLUSH;
+  if (m->cpuid) events |= BX_INSTR_EV_CPUID;
+  if (m->before_execution) events |= BX_INSTR_EV_BEFORE_EXECUTION;
+  if (m->after_execution) events |= BX_INSTR_EV_AFTER_EXECUTION;
+  if (m->repeat_iteration) events |= BX_INSTR_EV_REPEAT_ITERATION;
+  if (m->inp) events |= BX_INSTR_EV_INP;
+  if (m->inp2) events |= BX_INSTR_EV_INP2;
+  if (m->outp) events |= BX_INSTR_EV_OUTP;
+  if (m->lin_access) events |= BX_INSTR_EV_LIN_ACCESS;
+  if (m->phy_access) events |= BX_INSTR_EV_PHY_ACCESS;
+  if (m->wrmsr) events |= BX_INSTR_EV_WRMSR;
+  if (m->vmexit) events |= BX_INSTR_EV_VMEXIT;
+
+  return events;
+}
+
+static void update_events(void)
+{
+  Bit32u events = 0;
+
+  for (unsigned n=0; n < num_modules; n++) {
+    modules[n]->events = modules[n]->module.events & callback_events(&modules[n]->module);
+    events |= modules[n]->events;
+  }
+
+  Bit32u changed = events ^ bx_instr_events;
+  bx_instr_events = events;
+
+  // Leave the handlers chain, cpu_loop switches between chained traces and
+  // single instructions according to the execution events. Instructions
+  // in the icache were decoded without reporting them to the modules.
+  for (unsigned cpu=0; cpu < num_cpus; cpu++) {
+    if (changed & events & BX_INSTR_EV_OPCODE)
+      BX_CPU(cpu)->iCache.flushICacheEntries();
+    if (changed)
+      BX_CPU(cpu)->async_event |= BX_ASYNC_EVENT_STOP_TRACE;
+  }
+}
+
+// services provided to the modules
+
+static void bx_instr_subscribe(bx_instr_module_t *module, Bit32u events)
+{
+  module->events = events;
+  update_events();
+}
+
+static void bx_instr_log(const char *msg)
+{
+  BX_INFO(("%s", msg));
+}
+
+static Bit64u bx_instr_get_icount(unsigned cpu)
+{
+  return BX_CPU(cpu)->get_icount();
+}
+
+static bx_address bx_instr_get_rip(unsigned cpu)
+{
+  return BX_CPU(cpu)->get_instruction_pointer();
+}
+
+static Bit64u bx_instr_get_reg(unsigned cpu, unsigned reg)
+{
+  if (reg >= BX_GENERAL_REGISTERS) return 0;
+#if BX_SUPPORT_X86_64
+  return BX_CPU(cpu)->get_reg64(reg);
+#else
+  return BX_CPU(cpu)->get_reg32(reg);
+#endif
+}
+
+static bx_phy_address bx_instr_get_cr3(unsigned cpu)
+{
+  return BX_CPU(cpu)->cr3;
+}
+
+static unsigned bx_instr_get_cpl(unsigned cpu)
+{
+  return BX_CPU(cpu)->get_cpl();
+}
+
+static unsigned bx_instr_get_cpu_mode(unsigned cpu)
+{
+  return BX_CPU(cpu)->get_cpu_mode();
+}
+
+static bool bx_instr_read_linear(unsigned cpu, bx_address laddr, unsigned len, Bit8u *buf)
+{
+  while (len > 0) {
+    bx_phy_address paddr;
+    unsigned n = 0x1000 - PAGE_OFFSET(laddr);
+    if (n > len) n = len;
+    if (! BX_CPU(cpu)->dbg_xlate_linear2phy(laddr, &paddr))
+      return false;
+    if (! BX_MEM(0)->dbg_fetch_mem(BX_CPU(cpu), paddr, n, buf))
+      return false;
+    laddr += n;
+    buf += n;
+    len -= n;
+  }
+
+  return true;
+}
+
+static unsigned bx_instr_insn_length(const bxInstruction_c *i)
+{
+  return i->ilen();
+}
+
+static const char *bx_instr_insn_name(const bxInstruction_c *i)
+{
+  return i->getIaOpcodeNameShort();
+}
+
+static bx_instr_services_t services = {
+  BX_INSTR_MODULE_VERSION,
+  0, // set when the first module is attached
+  bx_instr_subscribe,
+  bx_instr_log,
+  bx_instr_get_icount,
+  bx_instr_get_rip,
+  bx_instr_get_reg,
+  bx_instr_get_cr3,
+  bx_instr_get_cpl,
+  bx_instr_get_cpu_mode,
+  bx_instr_read_linear,
+  bx_instr_insn_length,
+  bx_instr_insn_name
+};
+
+// loading and unloading of the modules
+
+#if defined(WIN32)
+#define BX_INSTR_DLOPEN(path)          LoadLibraryA(path)
+#define BX_INSTR_DLSYM(handle, symbol) ((void *) GetProcAddress(handle, symbol))
+#define BX_INSTR_DLCLOSE(handle)       FreeLibrary(handle)
+#define BX_INSTR_DLERROR()             "LoadLibrary() failed"
+#else
+#define BX_INSTR_DLOPEN(path)          dlopen(path, RTLD_NOW | RTLD_LOCAL)
+#define BX_INSTR_DLSYM(handle, symbol) dlsym(handle, symbol)
+#define BX_INSTR_DLCLOSE(handle)       dlclose(handle)
+#define BX_INSTR_DLERROR()             dlerror()
+#endif
+
+bool bx_instr_attach(const char *path, const char *options)
+{
+  if (num_modules == BX_INSTR_MAX_MODULES) {
+    BX_ERROR(("cannot attach '%s': too many instrumentation modules", path));
+    return false;
+  }
+
+  services.num_cpus = BX_SMP_PROCESSORS;
+
+  bx_instr_attached_t *m = new bx_instr_attached_t;
+  memset(&m->module, 0, sizeof(m->module));
+  m->events = 0;
+  m->handle = BX_INSTR_DLOPEN(path);
+  if (! m->handle) {
+    BX_ERROR(("cannot load instrumentation module '%s': %s", path, BX_INSTR_DLERROR()));
+    delete m;
+    return false;
+  }
+
+  bx_instr_module_init_t init = (bx_instr_module_init_t) BX_INSTR_DLSYM(m->handle, BX_INSTR_MODULE_INIT);
+  if (! init) {
+    BX_ERROR(("'%s' is not an instrumentation module", path));
+    BX_INSTR_DLCLOSE(m->handle);
+    delete m;
+    return false;
+  }
+
+  if (init(&m->module, &services, options ? options : "") < 0) {
+    BX_ERROR(("instrumentation module '%s' failed to initialize", path));
+    BX_INSTR_DLCLOSE(m->handle);
+    delete m;
+    return false;
+  }
+
+  m->path = strdup(path);
+  if (! m->module.name)
+    m->module.name = m->path;
+
+  modules[num_modules++] = m;
+  if (m->module.initialize) {
+    for (unsigned cpu=0; cpu < num_cpus; cpu++)
+      m->module.initialize(cpu);
+  }
+  update_events();
+
+  BX_INFO(("attached instrumentation module '%s' (%s), events 0x%08x",
+    m->module.name, path, m->events));
+  return true;
+}
+
+static void unload_module(unsigned n)
+{
+  bx_instr_attached_t *m = modules[n];
+
+  if (m->module.exit_module)
+    m->module.exit_module();
+
+  num_modules--;
+  for (unsigned k=n; k < num_modules; k++)
+    modules[k] = modules[k+1];
+  // no event may reach the module after it is unloaded
+  update_events();
+
+  BX_INFO(("detached instrumentation module '%s'", m->module.name));
+  BX_INSTR_DLCLOSE(m->handle);
+  free(m->path);
+  delete m;
+}
+
+bool bx_instr_detach(const char *name)
+{
+  bool found = false;
+
+  for (unsigned n=num_modules; n > 0; n--) {
+    if (! name || ! strcmp(modules[n-1]->module.name, name)) {
+      unload_module(n-1);
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+// the hooks
+
+void bx_instr_init_env(void)
+{
+  instrlog = new logfunctions();
+  instrlog->put("INSTR");
+}
+
+void bx_instr_exit_env(void)
+{
+  bx_instr_detach(NULL);
+}
+
+void bx_instr_initialize(unsigned cpu)
+{
+  // the module configured in bochsrc is attached once the options are known
+  if (! bochsrc_module_attached) {
+    bochsrc_module_attached = true;
+    bx_param_string_c *module = SIM->get_param_string(BXPN_INSTRUMENT_MODULE);
+    if (! module->isempty()) {
+      if (! bx_instr_attach(module->getptr(), SIM->get_param_string(BXPN_INSTRUMENT_OPTIONS)->getptr()))
+        BX_PANIC(("failed to attach the instrumentation module '%s'", module->getptr()));
+    }
+  }
+
+  for (unsigned n=0; n < num_modules; n++) {
+    if (modules[n]->module.initialize)
+      modules[n]->module.initialize(cpu);
+  }
+  if (cpu >= num_cpus) num_cpus = cpu + 1;
+}
+
+void bx_instr_exit(unsigned cpu)
+{
+  for (unsigned n=0; n < num_modules; n++) {
+    if (modules[n]->module.exit)
+      modules[n]->module.exit(cpu);
+  }
+  // the CPUs are going away
+  num_cpus = 0;
+}
+
+void bx_instr_reset(unsigned cpu, unsigned type)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_RESET, reset, (cpu, type));
+}
+
+void bx_instr_hlt(unsigned cpu)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_HLT, hlt, (cpu));
+}
+
+void bx_instr_mwait(unsigned cpu, bx_phy_address addr, unsigned len, Bit32u flags)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_MWAIT, mwait, (cpu, addr, len, flags));
+}
+
+void bx_instr_debug_promt()
+{
+  for (unsigned n=0; n < num_modules; n++) {
+    if (modules[n]->module.debug_promt)
+      modules[n]->module.debug_promt();
+  }
+}
+
+// "attach <path> [options]", "detach [name]" and "list" are handled here,
+// all other commands are passed to the attached modules
+void bx_instr_debug_cmd(const char *cmd)
+{
+#if BX_DEBUGGER
+  char *buf = strdup(cmd);
+  char *args = buf;
+
+  while (*args == ' ') args++;
+  char *verb = args;
+  while (*args && *args != ' ') args++;
+  if (*args) *args++ = 0;
+  while (*args == ' ') args++;
+
+  if (! strcmp(verb, "attach")) {
+    char *path = args;
+    while (*args && *args != ' ') args++;
+    if (*args) *args++ = 0;
+    while (*args == ' ') args++;
+    if (! *path)
+      dbg_printf("usage: instrument \"attach <module> [options]\"\n");
+    else if (bx_instr_attach(path, args))
+      dbg_printf("attached '%s'\n", modules[num_modules-1]->module.name);
+    else
+      dbg_printf("failed to attach '%s'\n", path);
+  }
+  else if (! strcmp(verb, "detach")) {
+    if (! bx_instr_detach(*args ? args : NULL))
+      dbg_printf("no instrumentation module '%s' attached\n", args);
+  }
+  else if (! strcmp(verb, "list")) {
+    for (unsigned n=0; n < num_modules; n++)
+      dbg_printf("%-16s events 0x%08x %s\n", modules[n]->module.name,
+        modules[n]->events, modules[n]->path);
+    if (! num_modules)
+      dbg_printf("no instrumentation modules attached\n");
+  }
+  else {
+    for (unsigned n=0; n < num_modules; n++) {
+      if (modules[n]->module.debug_cmd)
+        modules[n]->module.debug_cmd(cmd);
+    }
+  }
+
+  free(buf);
+#endif
+}
+
+void bx_instr_cnear_branch_taken(unsigned cpu, bx_address branch_eip, bx_address new_eip)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_CNEAR_BRANCH_TAKEN, cnear_branch_taken, (cpu, branch_eip, new_eip));
+}
+
+void bx_instr_cnear_branch_not_taken(unsigned cpu, bx_address branch_eip)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_CNEAR_BRANCH_NOT_TAKEN, cnear_branch_not_taken, (cpu, branch_eip));
+}
+
+void bx_instr_ucnear_branch(unsigned cpu, unsigned what, bx_address branch_eip, bx_address new_eip)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_UCNEAR_BRANCH, ucnear_branch, (cpu, what, branch_eip, new_eip));
+}
+
+void bx_instr_far_branch(unsigned cpu, unsigned what, Bit16u prev_cs, bx_address prev_eip, Bit16u new_cs, bx_address new_eip)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_FAR_BRANCH, far_branch, (cpu, what, prev_cs, prev_eip, new_cs, new_eip));
+}
+
+void bx_instr_opcode(unsigned cpu, bxInstruction_c *i, const Bit8u *opcode, unsigned len, bool is32, bool is64)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_OPCODE, opcode, (cpu, i, opcode, len, is32, is64));
+}
+
+void bx_instr_interrupt(unsigned cpu, unsigned vector)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_INTERRUPT, interrupt, (cpu, vector));
+}
+
+void bx_instr_exception(unsigned cpu, unsigned vector, unsigned error_code)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_EXCEPTION, exception, (cpu, vector, error_code));
+}
+
+void bx_instr_hwinterrupt(unsigned cpu, unsigned vector, Bit16u cs, bx_address eip)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_HWINTERRUPT, hwinterrupt, (cpu, vector, cs, eip));
+}
+
+void bx_instr_tlb_cntrl(unsigned cpu, unsigned what, bx_phy_address new_cr3)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_TLB_CNTRL, tlb_cntrl, (cpu, what, new_cr3));
+}
+
+void bx_instr_cache_cntrl(unsigned cpu, unsigned what)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_CACHE_CNTRL, cache_cntrl, (cpu, what));
+}
+
+void bx_instr_prefetch_hint(unsigned cpu, unsigned what, unsigned seg, bx_address offset)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_PREFETCH_HINT, prefetch_hint, (cpu, what, seg, offset));
+}
+
+void bx_instr_clflush(unsigned cpu, bx_address laddr, bx_phy_address paddr)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_CLFLUSH, clflush, (cpu, laddr, paddr));
+}
+
+void bx_instr_cpuid(unsigned cpu)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_CPUID, cpuid, (cpu));
+}
+
+void bx_instr_before_execution(unsigned cpu, bxInstruction_c *i)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_BEFORE_EXECUTION, before_execution, (cpu, i));
+}
+
+void bx_instr_after_execution(unsigned cpu, bxInstruction_c *i)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_AFTER_EXECUTION, after_execution, (cpu, i));
+}
+
+void bx_instr_repeat_iteration(unsigned cpu, bxInstruction_c *i)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_REPEAT_ITERATION, repeat_iteration, (cpu, i));
+}
+
+void bx_instr_inp(Bit16u addr, unsigned len)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_INP, inp, (addr, len));
+}
+
+void bx_instr_inp2(Bit16u addr, unsigned len, unsigned val)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_INP2, inp2, (addr, len, val));
+}
+
+void bx_instr_outp(Bit16u addr, unsigned len, unsigned val)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_OUTP, outp, (addr, len, val));
+}
+
+void bx_instr_lin_access(unsigned cpu, bx_address lin, bx_address phy, unsigned len, unsigned memtype, unsigned rw)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_LIN_ACCESS, lin_access, (cpu, lin, phy, len, memtype, rw));
+}
+
+void bx_instr_phy_access(unsigned cpu, bx_address phy, unsigned len, unsigned memtype, unsigned rw)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_PHY_ACCESS, phy_access, (cpu, phy, len, memtype, rw));
+}
+
+void bx_instr_wrmsr(unsigned cpu, unsigned addr, Bit64u value)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_WRMSR, wrmsr, (cpu, addr, value));
+}
+
+void bx_instr_vmexit(unsigned cpu, Bit32u reason, Bit64u qualification)
+{
+  BX_INSTR_FOREACH(BX_INSTR_EV_VMEXIT, vmexit, (cpu, reason, qualification));
+}
+
+#endif
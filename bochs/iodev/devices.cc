@@ -1470,7 +1470,8 @@ bool bx_devices_c::register_pci_handlers(bx_pci_device_c *dev,
 }
 
 bool bx_devices_c::pci_set_base_mem(void *this_ptr, memory_handler_t f1, memory_handler_t f2,
-                                       Bit32u *addr, Bit8u *pci_conf, unsigned size)
+                                       Bit32u *addr, Bit8u *pci_conf, unsigned size,
+                                       memory_direct_access_handler_t da)
 {
   Bit32u oldbase = *addr, newbase;
   Bit32u mask = ~(size - 1);
@@ -1489,7 +1490,7 @@ bool bx_devices_c::pci_set_base_mem(void *this_ptr, memory_handler_t f1, memory_
       DEV_unregister_memory_handlers(this_ptr, oldbase, oldbase + size - 1);
     }
     if (newbase > 0) {
-      DEV_register_memory_handlers(this_ptr, f1, f2, newbase, newbase + size - 1);
+      DEV_register_memory_handlers_da(this_ptr, f1, f2, da, newbase, newbase + size - 1);
     }
     *addr = newbase;
     return true;
@@ -1566,13 +1567,14 @@ void bx_pci_device_c::init_bar_io(Bit8u num, Bit16u size, bx_read_handler_t rh,
 }
 
 void bx_pci_device_c::init_bar_mem(Bit8u num, Bit32u size, memory_handler_t rh,
-                                   memory_handler_t wh)
+                                   memory_handler_t wh, memory_direct_access_handler_t da)
 {
   if (num < 6) {
     pci_bar[num].type = BX_PCI_BAR_TYPE_MEM;
     pci_bar[num].size = size;
     pci_bar[num].mem.rh = rh;
     pci_bar[num].mem.wh = wh;
+    pci_bar[num].mem.da = da;
   }
 }
 
@@ -1585,9 +1587,9 @@ void bx_pci_device_c::after_restore_pci_state(memory_handler_t mem_read_handler)
 {
   for (int i = 0; i < 6; i++) {
     if (pci_bar[i].type == BX_PCI_BAR_TYPE_MEM) {
-      if (DEV_pci_set_base_mem(this, pci_bar[i].mem.rh, pci_bar[i].mem.wh,
-                           &pci_bar[i].addr, &pci_conf[0x10 + i * 4],
-                           pci_bar[i].size)) {
+      if (DEV_pci_set_base_mem_da(this, pci_bar[i].mem.rh, pci_bar[i].mem.wh,
+                                  &pci_bar[i].addr, &pci_conf[0x10 + i * 4],
+                                  pci_bar[i].size, pci_bar[i].mem.da)) {
         BX_INFO(("BAR #%d: mem base address = 0x%08x", i, pci_bar[i].addr));
         pci_bar_change_notify();
       }
@@ -1705,9 +1707,9 @@ void bx_pci_device_c::pci_write_handler_common(Bit8u address, Bit32u value, unsi
             pci_bar_change_notify();
           }
         } else {
-          if (DEV_pci_set_base_mem(this, pci_bar[bnum].mem.rh, pci_bar[bnum].mem.wh,
-                                   &pci_bar[bnum].addr, &pci_conf[0x10 + bnum * 4],
-                                   pci_bar[bnum].size)) {
+          if (DEV_pci_set_base_mem_da(this, pci_bar[bnum].mem.rh, pci_bar[bnum].mem.wh,
+                                      &pci_bar[bnum].addr, &pci_conf[0x10 + bnum * 4],
+                                      pci_bar[bnum].size, pci_bar[bnum].mem.da)) {
             BX_INFO(("BAR #%d: mem base address = 0x%08x", bnum, pci_bar[bnum].addr));
             pci_bar_change_notify();
           }
@@ -65,10 +65,16 @@ PLUGIN_ENTRY_FOR_MODULE(vga)
 bx_vga_c::bx_vga_c() : bx_vgacore_c()
 {
   put("VGA");
+  lfb_write_track = -1;
+  lfb_dirty_pages = NULL;
 }
 
 bx_vga_c::~bx_vga_c()
 {
+  if (lfb_write_track >= 0) {
+    DEV_unregister_write_tracking(lfb_write_track);
+  }
+  delete [] lfb_dirty_pages;
   SIM->get_bochs_root()->remove("vga");
   BX_DEBUG(("Exit"));
 }
@@ -94,15 +100,17 @@ bool bx_vga_c::init_vga_extension(void)
       DEV_register_iowrite_handler(this, vbe_write_handler, addr, "vga video", 7);
     }
     BX_VGA_THIS s.memsize = atoi(SIM->get_param_enum(BXPN_VBE_MEMSIZE)->get_selected()) << 20;
-    if (!BX_VGA_THIS pci_enabled) {
-      BX_VGA_THIS vbe.base_address = VBE_DISPI_LFB_PHYSICAL_ADDRESS;
-      DEV_register_memory_handlers(theVga, mem_read_handler, mem_write_handler,
-                                   BX_VGA_THIS vbe.base_address,
-                                   BX_VGA_THIS vbe.base_address + BX_VGA_THIS s.memsize - 1);
-    }
     if (BX_VGA_THIS s.memory == NULL)
       BX_VGA_THIS s.memory = new Bit8u[BX_VGA_THIS s.memsize];
     memset(BX_VGA_THIS s.memory, 0, BX_VGA_THIS s.memsize);
+    BX_VGA_THIS lfb_dirty_pages = new Bit32u[((BX_VGA_THIS s.memsize >> 12) + 31) >> 5];
+    if (!BX_VGA_THIS pci_enabled) {
+      BX_VGA_THIS vbe.base_address = VBE_DISPI_LFB_PHYSICAL_ADDRESS;
+      DEV_register_memory_handlers_da(theVga, mem_read_handler, mem_write_handler,
+                                      mem_da_handler, BX_VGA_THIS vbe.base_address,
+                                      BX_VGA_THIS vbe.base_address + BX_VGA_THIS s.memsize - 1);
+      BX_VGA_THIS vbe_set_write_tracking();
+    }
     BX_VGA_THIS vbe.cur_dispi=VBE_DISPI_ID0;
     BX_VGA_THIS vbe.xres=640;
     BX_VGA_THIS vbe.yres=480;
@@ -144,7 +152,7 @@ bool bx_vga_c::init_vga_extension(void)
     if (BX_VGA_THIS vbe_present) {
       BX_VGA_THIS pci_conf[0x10] = 0x08;
       BX_VGA_THIS init_bar_mem(0, BX_VGA_THIS s.memsize,
-                               mem_read_handler, mem_write_handler);
+                               mem_read_handler, mem_write_handler, mem_da_handler);
     }
     BX_VGA_THIS pci_rom_address = 0;
     BX_VGA_THIS pci_rom_read_handler = mem_read_handler;
@@ -302,6 +310,10 @@ void bx_vga_c::update(void)
   unsigned iHeight, iWidth;
 
   if (BX_VGA_THIS vbe.enabled) {
+    /* pick up direct CPU writes to the linear framebuffer */
+    if (BX_VGA_THIS vbe.bpp != VBE_DISPI_BPP_4)
+      BX_VGA_THIS vbe_update_dirty_tiles();
+
     /* no screen update necessary */
     if ((BX_VGA_THIS s.vga_mem_updated==0) && BX_VGA_THIS s.graphics_ctrl.graphics_alpha)
       return;
@@ -691,6 +703,20 @@ bool bx_vga_c::mem_write_handler(bx_phy_address addr, unsigned len, void *data,
   return 1;
 }
 
+Bit8u *bx_vga_c::mem_da_handler(bx_phy_address addr, unsigned rw, void *param)
+{
+  // allow direct access to the LFB in VBE packed pixel modes only, CPU writes
+  // are collected from the dirty page bitmap in update()
+  if ((rw != BX_EXECUTE) && (BX_VGA_THIS lfb_write_track >= 0) &&
+      BX_VGA_THIS vbe.enabled && (BX_VGA_THIS vbe.bpp != VBE_DISPI_BPP_4) &&
+      (addr >= BX_VGA_THIS vbe.base_address)) {
+    Bit32u offset = (Bit32u)(addr - BX_VGA_THIS vbe.base_address) & ~0xfff;
+    if (offset < BX_VGA_THIS s.memsize)
+      return &BX_VGA_THIS s.memory[offset];
+  }
+  return NULL;
+}
+
 void bx_vga_c::mem_write(bx_phy_address addr, Bit8u value)
 {
   // if in a vbe enabled mode, write to the vbe_memory
@@ -744,9 +770,68 @@ void bx_vga_c::redraw_area(unsigned x0, unsigned y0, unsigned width, unsigned he
 void bx_vga_c::pci_bar_change_notify(void)
 {
   BX_VGA_THIS vbe.base_address = pci_bar[0].addr;
+  BX_VGA_THIS vbe_set_write_tracking();
 }
 #endif
 
+void bx_vga_c::vbe_set_write_tracking(void)
+{
+  if (BX_VGA_THIS lfb_write_track >= 0) {
+    DEV_unregister_write_tracking(BX_VGA_THIS lfb_write_track);
+    BX_VGA_THIS lfb_write_track = -1;
+  }
+  if (BX_VGA_THIS vbe.base_address != 0) {
+    BX_VGA_THIS lfb_write_track = DEV_register_write_tracking(BX_VGA_THIS vbe.base_address,
+      BX_VGA_THIS vbe.base_address + BX_VGA_THIS s.memsize - 1);
+  }
+  // drop host pointers to the old LFB location
+  bx_pc_system.MemoryMappingChanged();
+}
+
+void bx_vga_c::vbe_update_dirty_tiles(void)
+{
+  unsigned xti, yti, xt0, xt1, yt0, yt1;
+
+  if (BX_VGA_THIS lfb_write_track < 0)
+    return;
+  if (!DEV_get_dirty_pages(BX_VGA_THIS lfb_write_track, BX_VGA_THIS lfb_dirty_pages))
+    return;
+
+  Bit32u pitch = BX_VGA_THIS vbe.line_offset;
+  Bit32u num_pages = BX_VGA_THIS s.memsize >> 12;
+  if (pitch == 0)
+    return;
+
+  for (Bit32u page = 0; page < num_pages; page++) {
+    if (!(BX_VGA_THIS lfb_dirty_pages[page >> 5] & (1 << (page & 31))))
+      continue;
+    Bit32u start = page << 12, end = start + 0xfff;
+    // only update the UI when writing 'onscreen'
+    if ((end < BX_VGA_THIS vbe.virtual_start) ||
+        (start >= (BX_VGA_THIS vbe.virtual_start + BX_VGA_THIS vbe.visible_screen_size)))
+      continue;
+    start = (start > BX_VGA_THIS vbe.virtual_start) ? (start - BX_VGA_THIS vbe.virtual_start) : 0;
+    end -= BX_VGA_THIS vbe.virtual_start;
+    if (end >= BX_VGA_THIS vbe.visible_screen_size)
+      end = BX_VGA_THIS vbe.visible_screen_size - 1;
+    yt0 = (start / pitch) / Y_TILESIZE;
+    yt1 = (end / pitch) / Y_TILESIZE;
+    if ((start / pitch) == (end / pitch)) {
+      xt0 = ((start % pitch) / BX_VGA_THIS vbe.bpp_multiplier) / X_TILESIZE;
+      xt1 = ((end % pitch) / BX_VGA_THIS vbe.bpp_multiplier) / X_TILESIZE;
+    } else {
+      xt0 = 0;
+      xt1 = BX_VGA_THIS s.num_x_tiles - 1;
+    }
+    for (yti = yt0; yti <= yt1; yti++) {
+      for (xti = xt0; xti <= xt1; xti++) {
+        SET_TILE_UPDATED(BX_VGA_THIS, xti, yti, 1);
+      }
+    }
+    BX_VGA_THIS s.vga_mem_updated = 1;
+  }
+}
+
   Bit8u  BX_CPP_AttrRegparmN(1)
 bx_vga_c::vbe_mem_read(bx_phy_address addr)
 {
@@ -1145,6 +1230,10 @@ Bit32u bx_vga_c::vbe_write(Bit32u address, Bit32u value, unsigned io_len)
             BX_VGA_THIS s.ext_offset = 0;
             BX_VGA_THIS s.vgamem_mask = 0x3ffff;
           }
+          if (BX_VGA_THIS vbe.enabled != ((value & VBE_DISPI_ENABLED) != 0)) {
+            // LFB direct access depends on the VBE mode
+            bx_pc_system.MemoryMappingChanged();
+          }
           BX_VGA_THIS vbe.enabled = ((value & VBE_DISPI_ENABLED) != 0);
           BX_VGA_THIS vbe.get_capabilities = ((value & VBE_DISPI_GETCAPS) != 0);
           if (BX_VGA_THIS vbe.get_capabilities) {
@@ -95,6 +95,7 @@ public:
   virtual void   reset(unsigned type);
   BX_VGA_SMF bool mem_read_handler(bx_phy_address addr, unsigned len, void *data, void *param);
   BX_VGA_SMF bool mem_write_handler(bx_phy_address addr, unsigned len, void *data, void *param);
+  BX_VGA_SMF Bit8u *mem_da_handler(bx_phy_address addr, unsigned rw, void *param);
   virtual Bit8u  mem_read(bx_phy_address addr);
   virtual void   mem_write(bx_phy_address addr, Bit8u value);
   virtual void   register_state(void);
@@ -126,6 +127,9 @@ protected:
   BX_VGA_SMF Bit8u vbe_mem_read(bx_phy_address addr) BX_CPP_AttrRegparmN(1);
   BX_VGA_SMF void  vbe_mem_write(bx_phy_address addr, Bit8u value) BX_CPP_AttrRegparmN(2);
 
+  BX_VGA_SMF void  vbe_set_write_tracking(void);
+  BX_VGA_SMF void  vbe_update_dirty_tiles(void);
+
   static Bit32u vbe_read_handler(void *this_ptr, Bit32u address, unsigned io_len);
   static void   vbe_write_handler(void *this_ptr, Bit32u address, Bit32u value, unsigned io_len);
 
@@ -162,6 +166,10 @@ private:
     bool    ddc_enabled;
   } vbe;  // VBE state information
 
+  // write tracking of the linear framebuffer (direct access by the CPU)
+  int     lfb_write_track;
+  Bit32u *lfb_dirty_pages;
+
   bx_ddc_c ddc;
 };
 
@@ -3614,24 +3614,32 @@ bool bx_hard_drive_c::bmdma_read_sector(Bit8u channel, Bit8u *buffer, Bit32u *se
         case 0x28: // read (10)
         case 0xa8: // read (12)
         case 0xbe: // read cd
-          *sector_size = controller->buffer_size;
+          {
+          // read as many blocks as the current PRD can take in one go
+          Bit32u blocks = *sector_size / controller->buffer_size;
+          if ((int)blocks > BX_SELECTED_DRIVE(channel).cdrom.remaining_blocks)
+            blocks = BX_SELECTED_DRIVE(channel).cdrom.remaining_blocks;
+          if ((int)blocks < 1)
+            blocks = 1;
+          *sector_size = blocks * controller->buffer_size;
           if (!BX_SELECTED_DRIVE(channel).cdrom.ready) {
             BX_PANIC(("Read with CDROM not ready"));
             return 0;
           }
           /* set status bar conditions for device */
           bx_gui->statusbar_setitem(BX_SELECTED_DRIVE(channel).statusbar_id, 1);
-          if (!BX_SELECTED_DRIVE(channel).cdrom.cd->read_block(buffer, BX_SELECTED_DRIVE(channel).cdrom.next_lba,
-                                                               controller->buffer_size))
+          if (!BX_SELECTED_DRIVE(channel).cdrom.cd->read_blocks(buffer, BX_SELECTED_DRIVE(channel).cdrom.next_lba,
+                                                                blocks, controller->buffer_size))
           {
             BX_PANIC(("CDROM: read block %d failed", BX_SELECTED_DRIVE(channel).cdrom.next_lba));
             return 0;
           }
-          BX_SELECTED_DRIVE(channel).cdrom.next_lba++;
-          BX_SELECTED_DRIVE(channel).cdrom.remaining_blocks--;
+          BX_SELECTED_DRIVE(channel).cdrom.next_lba += blocks;
+          BX_SELECTED_DRIVE(channel).cdrom.remaining_blocks -= blocks;
           if (!BX_SELECTED_DRIVE(channel).cdrom.remaining_blocks) {
             BX_SELECTED_DRIVE(channel).cdrom.curr_lba = BX_SELECTED_DRIVE(channel).cdrom.next_lba;
           }
+          }
           break;
         default:
           BX_DEBUG_ATAPI(("ata%d-%d: bmdma_read_sector(): ATAPI cmd = 0x%02x, size = %d",
@@ -25,10 +25,15 @@
 #include "cdrom.h"
 
 #include <stdio.h>
+#if BX_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #define LOG_THIS /* no SMF tricks here, not needed */
 
 #define BX_CD_FRAMESIZE 2048
+// number of frames fetched ahead on sequential reads
+#define BX_CD_READAHEAD 32
 
 unsigned int bx_cdrom_count = 0;
 
@@ -46,12 +51,21 @@ cdrom_base_c::cdrom_base_c(const char *dev)
     path = strdup(dev);
   }
   using_file = 0;
+  image_map = NULL;
+  image_size = 0;
+  ra_buf = NULL;
+  ra_lba = 0;
+  ra_count = 0;
+  ra_next = 0;
 }
 
 cdrom_base_c::~cdrom_base_c(void)
 {
+  unmap_image();
   if (fd >= 0)
     close(fd);
+  if (ra_buf)
+    delete [] ra_buf;
   if (path)
     free(path);
   BX_DEBUG(("Exit"));
@@ -85,6 +99,7 @@ bool cdrom_base_c::insert_cdrom(const char *dev)
   if (S_ISREG(stat_buf.st_mode)) {
     using_file = 1;
     BX_INFO(("Opening image file as a cd."));
+    map_image(stat_buf.st_size);
   } else {
     using_file = 0;
     BX_INFO(("Using direct access for cdrom."));
@@ -99,6 +114,7 @@ void cdrom_base_c::eject_cdrom()
   // Logically eject the CD.  I suppose we could stick in
   // some ioctl() calls to really eject the CD as well.
 
+  unmap_image();
   if (fd >= 0) {
     close(fd);
     fd = -1;
@@ -252,6 +268,14 @@ bool BX_CPP_AttrRegparmN(3) cdrom_base_c::read_block(Bit8u* buf, Bit32u lba, int
   } else {
     buf1 = buf;
   }
+  if (image_map != NULL) {
+    return read_frames(buf1, lba, 1);
+  }
+  if ((lba == ra_next) || ((lba >= ra_lba) && (lba < (ra_lba + ra_count)))) {
+    if (read_frames(buf1, lba, 1))
+      return 1;
+  }
+  ra_next = lba + 1;
   do {
     pos = lseek(fd, (off_t) lba * BX_CD_FRAMESIZE, SEEK_SET);
     if (pos < 0) {
@@ -264,6 +288,67 @@ bool BX_CPP_AttrRegparmN(3) cdrom_base_c::read_block(Bit8u* buf, Bit32u lba, int
   return (n == BX_CD_FRAMESIZE);
 }
 
+bool cdrom_base_c::read_blocks(Bit8u* buf, Bit32u lba, Bit32u count, int blocksize)
+{
+  // Read consecutive blocks from the CD
+
+  if ((image_map != NULL) && (blocksize == BX_CD_FRAMESIZE)) {
+    return read_frames(buf, lba, count);
+  }
+  for (Bit32u i = 0; i < count; i++) {
+    if (!read_block(buf + i * blocksize, lba + i, blocksize))
+      return 0;
+  }
+  return 1;
+}
+
+// Read 2048 byte frames from the image mapping or through the read-ahead
+// cache. A cache miss fetches the next BX_CD_READAHEAD frames with a single
+// host read. Returns 0 if the frames are not available that way.
+bool cdrom_base_c::read_frames(Bit8u* buf, Bit32u lba, Bit32u count)
+{
+  Bit64u offset = (Bit64u) lba * BX_CD_FRAMESIZE;
+  Bit64u len = (Bit64u) count * BX_CD_FRAMESIZE;
+
+  if (image_map != NULL) {
+    if ((offset + len) > image_size)
+      return 0;
+    memcpy(buf, image_map + offset, (size_t) len);
+#if BX_HAVE_SYS_MMAN_H && defined(MADV_WILLNEED)
+    // let the host start reading the following frames in the background
+    if (lba == ra_next) {
+      Bit64u start = (offset + len) & ~BX_CONST64(0xfff);
+      if (start < image_size) {
+        Bit64u ahead = BX_CD_READAHEAD * BX_CD_FRAMESIZE;
+        if (ahead > (image_size - start))
+          ahead = image_size - start;
+        madvise(image_map + start, (size_t) ahead, MADV_WILLNEED);
+      }
+    }
+#endif
+    ra_next = lba + count;
+    return 1;
+  }
+  for (Bit32u i = 0; i < count; i++, lba++) {
+    if ((lba < ra_lba) || (lba >= (ra_lba + ra_count))) {
+      if (ra_buf == NULL)
+        ra_buf = new Bit8u[BX_CD_READAHEAD * BX_CD_FRAMESIZE];
+      ra_count = 0;
+      ssize_t n = -1;
+      if (lseek(fd, (off_t) lba * BX_CD_FRAMESIZE, SEEK_SET) >= 0) {
+        n = read(fd, (char*) ra_buf, BX_CD_READAHEAD * BX_CD_FRAMESIZE);
+      }
+      if (n < BX_CD_FRAMESIZE)
+        return 0;
+      ra_lba = lba;
+      ra_count = (Bit32u)(n / BX_CD_FRAMESIZE);
+    }
+    memcpy(buf + i * BX_CD_FRAMESIZE, ra_buf + (lba - ra_lba) * BX_CD_FRAMESIZE, BX_CD_FRAMESIZE);
+  }
+  ra_next = lba;
+  return 1;
+}
+
 Bit32u cdrom_base_c::capacity()
 {
   // Return CD-ROM capacity.  I believe you want to return
@@ -303,3 +388,38 @@ bool cdrom_base_c::seek(Bit32u lba)
 
   return read_block(buffer, lba, BX_CD_FRAMESIZE);
 }
+
+void cdrom_base_c::map_image(Bit64u size)
+{
+  // Map the image file into host memory, so that reads are plain copies
+  // and the host page cache does the read-ahead.
+
+#if BX_HAVE_SYS_MMAN_H
+  if ((size == 0) || (size != (Bit64u)(size_t) size))
+    return;
+  void *ptr = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    BX_DEBUG(("mmap of cd image failed: %s", strerror(errno)));
+    return;
+  }
+  image_map = (Bit8u*) ptr;
+  image_size = size;
+  BX_INFO(("cd image mapped into host memory"));
+#endif
+}
+
+void cdrom_base_c::unmap_image()
+{
+  // Release the image mapping and invalidate the read-ahead cache.
+
+#if BX_HAVE_SYS_MMAN_H
+  if (image_map != NULL) {
+    munmap(image_map, (size_t) image_size);
+  }
+#endif
+  image_map = NULL;
+  image_size = 0;
+  ra_lba = 0;
+  ra_count = 0;
+  ra_next = 0;
+}
@@ -45,6 +45,9 @@ public:
   // Read a single block from the CD. Returns 0 on failure.
   virtual bool read_block(Bit8u* buf, Bit32u lba, int blocksize) BX_CPP_AttrRegparmN(3);
 
+  // Read consecutive blocks from the CD. Returns 0 on failure.
+  virtual bool read_blocks(Bit8u* buf, Bit32u lba, Bit32u count, int blocksize);
+
   // Start (spin up) the CD.
   virtual bool start_cdrom();
 
@@ -52,7 +55,19 @@ public:
   virtual bool seek(Bit32u lba);
 
 protected:
+  bool read_frames(Bit8u* buf, Bit32u lba, Bit32u count);
+  void map_image(Bit64u size);
+  void unmap_image();
+
   int fd;
   char *path;
   bool using_file;
+  // image file mapped into host memory (if supported)
+  Bit8u *image_map;
+  Bit64u image_size;
+  // read-ahead cache for sequential access
+  Bit8u *ra_buf;
+  Bit32u ra_lba;
+  Bit32u ra_count;
+  Bit32u ra_next;
 };
@@ -131,6 +131,7 @@ void cdrom_misc_c::eject_cdrom()
   // Logically eject the CD.  I suppose we could stick in
   // some ioctl() calls to really eject the CD as well.
 
+  unmap_image();
   if (fd >= 0) {
     if (!using_file) {
 #if (defined(__OpenBSD__) || defined(__FreeBSD__) || defined(__FreeBSD_kernel__))
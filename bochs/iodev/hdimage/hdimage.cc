@@ -619,6 +619,135 @@ bool hdimage_copy_file(const char *src, const char *dst)
 #endif
 }
 
+/*** hdimage_block_cache_c function definitions ***/
+
+hdimage_block_cache_c::hdimage_block_cache_c()
+{
+  slot_data = NULL;
+  block_size = 0;
+  slots = 0;
+  writeback = NULL;
+  owner = NULL;
+  cleanup();
+}
+
+hdimage_block_cache_c::~hdimage_block_cache_c()
+{
+  cleanup();
+}
+
+bool hdimage_block_cache_c::init(Bit32u _block_size, unsigned _slots, hdimage_writeback_t _writeback, void *this_ptr)
+{
+  cleanup();
+  if (_slots == 0) {
+    _slots = HDIMAGE_BLOCK_CACHE_SIZE / _block_size;
+  }
+  if (_slots < 2) {
+    _slots = 2;
+  } else if (_slots > HDIMAGE_BLOCK_CACHE_MAX_SLOTS) {
+    _slots = HDIMAGE_BLOCK_CACHE_MAX_SLOTS;
+  }
+  slot_data = new Bit8u[(size_t)_block_size * _slots];
+  if (slot_data == NULL) {
+    return 0;
+  }
+  block_size = _block_size;
+  slots = _slots;
+  writeback = _writeback;
+  owner = this_ptr;
+  return 1;
+}
+
+void hdimage_block_cache_c::cleanup()
+{
+  if (slot_data != NULL) {
+    delete [] slot_data;
+    slot_data = NULL;
+  }
+  for (unsigned i = 0; i < HDIMAGE_BLOCK_CACHE_MAX_SLOTS; i++) {
+    entry[i].valid = 0;
+    entry[i].dirty = 0;
+    entry[i].stamp = 0;
+  }
+  slots = 0;
+  last_slot = -1;
+  clock = 0;
+  last_miss = (Bit64u)-2;
+}
+
+int hdimage_block_cache_c::find(Bit64u index)
+{
+  if ((last_slot >= 0) && (entry[last_slot].index == index)) {
+    entry[last_slot].stamp = ++clock;
+    return last_slot;
+  }
+  for (unsigned i = 0; i < slots; i++) {
+    if (entry[i].valid && (entry[i].index == index)) {
+      entry[i].stamp = ++clock;
+      last_slot = i;
+      return i;
+    }
+  }
+  return -1;
+}
+
+int hdimage_block_cache_c::alloc(Bit64u index, Bit64s offset)
+{
+  int slot = 0;
+
+  for (unsigned i = 0; i < slots; i++) {
+    if (!entry[i].valid) {
+      slot = i;
+      break;
+    }
+    if (entry[i].stamp < entry[slot].stamp) {
+      slot = i;
+    }
+  }
+  if (!writeback_slot(slot)) {
+    return -1;
+  }
+  entry[slot].index = index;
+  entry[slot].offset = offset;
+  entry[slot].stamp = ++clock;
+  entry[slot].valid = 1;
+  last_slot = slot;
+  return slot;
+}
+
+bool hdimage_block_cache_c::writeback_slot(int slot)
+{
+  if (entry[slot].valid && entry[slot].dirty) {
+    if (!writeback(owner, entry[slot].index, &entry[slot].offset, data(slot))) {
+      return 0;
+    }
+    entry[slot].dirty = 0;
+  }
+  return 1;
+}
+
+bool hdimage_block_cache_c::flush()
+{
+  bool ret = 1;
+
+  while (1) {
+    int slot = -1;
+    for (unsigned i = 0; i < slots; i++) {
+      if (entry[i].valid && entry[i].dirty &&
+          ((slot < 0) || (entry[i].index < entry[slot].index))) {
+        slot = i;
+      }
+    }
+    if (slot < 0) break;
+    if (!writeback_slot(slot)) {
+      // drop the block to avoid retrying forever
+      entry[slot].dirty = 0;
+      ret = 0;
+    }
+  }
+  return ret;
+}
+
 /*** base class device_image_t ***/
 
 device_image_t::device_image_t()
@@ -702,7 +831,35 @@ int flat_image_t::check_format(int fd, Bit64u imgsize)
   }
 }
 
-#ifndef BXIMAGE
+#ifdef BXIMAGE
+int flat_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  off_t curpos = ::lseek(fd, 0, SEEK_CUR);
+  off_t data = ::lseek(fd, (off_t)offset, SEEK_DATA);
+  int status = 1;
+
+  if (data < 0) {
+    // ENXIO: no more data after 'offset'
+    status = (errno == ENXIO) ? 0 : 1;
+  } else if ((Bit64u)data > offset) {
+    status = 0;
+    if (((Bit64u)data - offset) < *count) {
+      *count = (Bit64u)data - offset;
+    }
+  } else {
+    off_t hole = ::lseek(fd, (off_t)offset, SEEK_HOLE);
+    if ((hole > (off_t)offset) && (((Bit64u)hole - offset) < *count)) {
+      *count = (Bit64u)hole - offset;
+    }
+  }
+  ::lseek(fd, curpos, SEEK_SET);
+  return status;
+#else
+  return 1;
+#endif
+}
+#else
 bool flat_image_t::save_state(const char *backup_fname)
 {
   return hdimage_backup_file(fd, backup_fname);
@@ -1457,6 +1614,26 @@ int sparse_image_t::check_format(int fd, Bit64u imgsize)
 }
 
 #ifdef BXIMAGE
+int sparse_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  Bit32u numpages = dtoh32(header.numpages);
+  Bit32u page = (Bit32u)(offset >> pagesize_shift);
+  Bit64u len = ((Bit64u)(page + 1) << pagesize_shift) - offset;
+
+  // unallocated pages of a child image are read from the parent
+  if ((parent_image != NULL) || (page >= numpages))
+    return 1;
+  int status = (dtoh32(pagetable[page]) != SPARSE_PAGE_NOT_ALLOCATED);
+  while ((len < *count) && (++page < numpages) &&
+         ((dtoh32(pagetable[page]) != SPARSE_PAGE_NOT_ALLOCATED) == status)) {
+    len += pagesize;
+  }
+  if (len < *count) {
+    *count = len;
+  }
+  return status;
+}
+
 int sparse_image_t::create_image(const char *pathname, Bit64u size)
 {
   Bit64u numpages;
@@ -1653,9 +1830,13 @@ redolog_t::redolog_t()
   pathname = NULL;
   catalog = NULL;
   bitmap = NULL;
-  extent_index = (Bit32u)0;
-  extent_offset = (Bit32u)0;
+  for (int i = 0; i < REDOLOG_BITMAP_SLOTS; i++) {
+    bitmap_extent[i] = REDOLOG_PAGE_NOT_ALLOCATED;
+    bitmap_dirty[i] = 0;
+  }
+  bitmap_write_back = 0;
   extent_next = (Bit32u)0;
+  imagepos = 0;
 }
 
 void redolog_t::print_header()
@@ -1717,10 +1898,14 @@ int redolog_t::make_header(const char* type, Bit64u size)
   header.specific.timestamp = 0;
   header.specific.disk = htod64(size);
 
+  // Only the volatile redolog is discarded on exit, so the bitmap updates of
+  // the other types are written at the end of each write request.
+  bitmap_write_back = !strcmp(type, REDOLOG_SUBTYPE_VOLATILE);
+
   print_header();
 
   catalog = new Bit32u[dtoh32(header.specific.catalog)];
-  bitmap =  new Bit8u[dtoh32(header.specific.bitmap)];
+  bitmap =  new Bit8u[dtoh32(header.specific.bitmap) * REDOLOG_BITMAP_SLOTS];
 
   if ((catalog == NULL) || (bitmap==NULL))
     BX_PANIC(("redolog : could not malloc catalog or bitmap"));
@@ -1840,6 +2025,7 @@ int redolog_t::open(const char* filename, const char *type, int flags)
   if (!strcmp(type, REDOLOG_SUBTYPE_GROWING)) {
     set_timestamp(fat_datetime(mtime, 1) | (fat_datetime(mtime, 0) << 16));
   }
+  bitmap_write_back = !strcmp(type, REDOLOG_SUBTYPE_VOLATILE);
 
   catalog = new Bit32u[dtoh32(header.specific.catalog)];
 
@@ -1864,8 +2050,12 @@ int redolog_t::open(const char* filename, const char *type, int flags)
   }
   BX_INFO(("redolog : next extent will be at index %d",extent_next));
 
-  // memory used for storing bitmaps
-  bitmap = new Bit8u[dtoh32(header.specific.bitmap)];
+  // memory used for caching bitmaps
+  bitmap = new Bit8u[dtoh32(header.specific.bitmap) * REDOLOG_BITMAP_SLOTS];
+  for (int i = 0; i < REDOLOG_BITMAP_SLOTS; i++) {
+    bitmap_extent[i] = REDOLOG_PAGE_NOT_ALLOCATED;
+    bitmap_dirty[i] = 0;
+  }
 
   bitmap_blocks = 1 + (dtoh32(header.specific.bitmap) - 1) / 512;
   extent_blocks = 1 + (dtoh32(header.specific.extent) - 1) / 512;
@@ -1874,24 +2064,32 @@ int redolog_t::open(const char* filename, const char *type, int flags)
   BX_DEBUG(("redolog : each extent is %d blocks", extent_blocks));
 
   imagepos = 0;
-  bitmap_update = 1;
 
   return 0;
 }
 
 void redolog_t::close()
 {
-  if (fd >= 0)
+  if (fd >= 0) {
+    flush_bitmaps();
     bx_close_image(fd, pathname);
+    fd = -1;
+  }
 
-  if (pathname != NULL)
+  if (pathname != NULL) {
     delete [] pathname;
+    pathname = NULL;
+  }
 
-  if (catalog != NULL)
+  if (catalog != NULL) {
     delete [] catalog;
+    catalog = NULL;
+  }
 
-  if (bitmap != NULL)
+  if (bitmap != NULL) {
     delete [] bitmap;
+    bitmap = NULL;
+  }
 }
 
 Bit64u redolog_t::get_size()
@@ -1931,148 +2129,250 @@ Bit64s redolog_t::lseek(Bit64s offset, int whence)
     return -1;
   }
 
-  Bit32u old_extent_index = extent_index;
-  extent_index = (Bit32u)(imagepos / dtoh32(header.specific.extent));
-  if (extent_index != old_extent_index) {
-    bitmap_update = 1;
-  }
-  extent_offset = (Bit32u)((imagepos % dtoh32(header.specific.extent)) / 512);
-
-  BX_DEBUG(("redolog : lseeking extent index %d, offset %d",extent_index, extent_offset));
+  BX_DEBUG(("redolog : lseeking extent index %d, offset %d",
+            (Bit32u)(imagepos / dtoh32(header.specific.extent)),
+            (Bit32u)((imagepos % dtoh32(header.specific.extent)) / 512)));
 
   return imagepos;
 }
 
-ssize_t redolog_t::read(void* buf, size_t count)
+Bit64s redolog_t::get_bitmap_offset(Bit32u extent)
 {
-  Bit64s block_offset, bitmap_offset;
-  ssize_t ret;
+  Bit64s bitmap_offset;
 
-  if (count != 512) {
-    BX_PANIC(("redolog : read() with count not 512"));
-    return -1;
-  }
+  bitmap_offset  = (Bit64s)STANDARD_HEADER_SIZE + (dtoh32(header.specific.catalog) * sizeof(Bit32u));
+  bitmap_offset += (Bit64s)512 * dtoh32(catalog[extent]) * (extent_blocks + bitmap_blocks);
+  return bitmap_offset;
+}
 
-  BX_DEBUG(("redolog : reading index %d, mapping to %d", extent_index, dtoh32(catalog[extent_index])));
+// Returns the cached bitmap of an allocated extent. The bitmap of a newly
+// allocated extent is not read from disk.
+Bit8u* redolog_t::get_bitmap(Bit32u extent, bool is_new)
+{
+  Bit32u slot = extent % REDOLOG_BITMAP_SLOTS;
+  Bit32u bitmap_size = dtoh32(header.specific.bitmap);
+  Bit8u *slot_bitmap = bitmap + slot * bitmap_size;
 
-  if (dtoh32(catalog[extent_index]) == REDOLOG_PAGE_NOT_ALLOCATED) {
-    // page not allocated
-    return 0;
+  if (bitmap_extent[slot] != extent) {
+    flush_bitmap(slot);
+    bitmap_extent[slot] = REDOLOG_PAGE_NOT_ALLOCATED;
+    if (is_new) {
+      memset(slot_bitmap, 0, bitmap_size);
+    } else if (bx_read_image(fd, (off_t)get_bitmap_offset(extent), slot_bitmap, bitmap_size) != (ssize_t)bitmap_size) {
+      BX_PANIC(("redolog : failed to read bitmap for extent %d", extent));
+      return NULL;
+    }
+    bitmap_extent[slot] = extent;
   }
+  return slot_bitmap;
+}
 
-  bitmap_offset  = (Bit64s)STANDARD_HEADER_SIZE + (dtoh32(header.specific.catalog) * sizeof(Bit32u));
-  bitmap_offset += (Bit64s)512 * dtoh32(catalog[extent_index]) * (extent_blocks + bitmap_blocks);
-  block_offset    = bitmap_offset + ((Bit64s)512 * (bitmap_blocks + extent_offset));
-
-  BX_DEBUG(("redolog : bitmap offset is %x", (Bit32u)bitmap_offset));
-  BX_DEBUG(("redolog : block offset is %x", (Bit32u)block_offset));
+void redolog_t::flush_bitmap(Bit32u slot)
+{
+  Bit32u bitmap_size = dtoh32(header.specific.bitmap);
 
-  if (bitmap_update) {
-    if (bx_read_image(fd, (off_t)bitmap_offset, bitmap,  dtoh32(header.specific.bitmap)) != (ssize_t)dtoh32(header.specific.bitmap)) {
-      BX_PANIC(("redolog : failed to read bitmap for extent %d", extent_index));
-      return -1;
+  if (bitmap_dirty[slot]) {
+    if (bx_write_image(fd, (off_t)get_bitmap_offset(bitmap_extent[slot]),
+                       bitmap + slot * bitmap_size, bitmap_size) != (ssize_t)bitmap_size) {
+      BX_ERROR(("redolog : failed to write bitmap for extent %d", bitmap_extent[slot]));
     }
-    bitmap_update = 0;
+    bitmap_dirty[slot] = 0;
   }
+}
 
-  if (((bitmap[extent_offset/8] >> (extent_offset%8)) & 0x01) == 0x00) {
-    BX_DEBUG(("read not in redolog"));
+void redolog_t::flush_bitmaps()
+{
+  if (bitmap == NULL) return;
+  for (Bit32u i = 0; i < REDOLOG_BITMAP_SLOTS; i++) {
+    flush_bitmap(i);
+  }
+}
 
-    // bitmap says block not in redolog
+bool redolog_t::allocate_extent(Bit32u extent)
+{
+  Bit64s catalog_offset;
+  Bit32u size;
+
+  if (extent_next >= dtoh32(header.specific.catalog)) {
+    BX_PANIC(("redolog : can't allocate new extent... catalog is full"));
     return 0;
   }
 
-  ret = bx_read_image(fd, (off_t)block_offset, buf, count);
-  if (ret >= 0) lseek(512, SEEK_CUR);
+  BX_DEBUG(("redolog : allocating new extent at %d", extent_next));
 
-  return ret;
+  catalog[extent] = htod32(extent_next);
+  extent_next += 1;
+
+  // Write bitmap and extent with a single request
+  size = 512 * (bitmap_blocks + extent_blocks);
+  Bit8u *zerobuffer = new Bit8u[size];
+  memset(zerobuffer, 0, size);
+  if (bx_write_image(fd, (off_t)get_bitmap_offset(extent), zerobuffer, size) != (ssize_t)size) {
+    BX_ERROR(("redolog : failed to write new extent %d", extent));
+  }
+  delete [] zerobuffer;
+  get_bitmap(extent, 1);
+
+  // Write catalog
+  // FIXME if mmap
+  catalog_offset  = (Bit64s)STANDARD_HEADER_SIZE + (extent * sizeof(Bit32u));
+
+  BX_DEBUG(("redolog : writing catalog at offset %x", (Bit32u)catalog_offset));
+
+  bx_write_image(fd, (off_t)catalog_offset, &catalog[extent], sizeof(Bit32u));
+  return 1;
 }
 
-ssize_t redolog_t::write(const void* buf, size_t count)
+ssize_t redolog_t::read(void* buf, size_t count)
 {
-  Bit32u i;
-  Bit64s block_offset, bitmap_offset, catalog_offset;
-  ssize_t written;
-  bool update_catalog = 0;
+  Bit32u extent, offset;
+  Bit8u *extent_bitmap;
 
   if (count != 512) {
-    BX_PANIC(("redolog : write() with count not 512"));
+    BX_PANIC(("redolog : read() with count not 512"));
     return -1;
   }
 
-  BX_DEBUG(("redolog : writing index %d, mapping to %d", extent_index, dtoh32(catalog[extent_index])));
+  extent = (Bit32u)(imagepos / dtoh32(header.specific.extent));
+  offset = (Bit32u)((imagepos % dtoh32(header.specific.extent)) / 512);
 
-  if (dtoh32(catalog[extent_index]) == REDOLOG_PAGE_NOT_ALLOCATED) {
-    if (extent_next >= dtoh32(header.specific.catalog)) {
-      BX_PANIC(("redolog : can't allocate new extent... catalog is full"));
-      return -1;
-    }
+  BX_DEBUG(("redolog : reading index %d, mapping to %d", extent, dtoh32(catalog[extent])));
+
+  if (dtoh32(catalog[extent]) == REDOLOG_PAGE_NOT_ALLOCATED) {
+    // page not allocated
+    return 0;
+  }
+
+  extent_bitmap = get_bitmap(extent, 0);
+  if (extent_bitmap == NULL) {
+    return -1;
+  }
+  if (((extent_bitmap[offset/8] >> (offset%8)) & 0x01) == 0x00) {
+    BX_DEBUG(("read not in redolog"));
 
-    BX_DEBUG(("redolog : allocating new extent at %d", extent_next));
+    // bitmap says block not in redolog
+    return 0;
+  }
 
-    // Extent not allocated, allocate new
-    catalog[extent_index] = htod32(extent_next);
+  return read_sectors(buf, count, NULL);
+}
 
-    extent_next += 1;
+// Contiguous blocks with the same state within an extent are handled with a
+// single read request.
+ssize_t redolog_t::read_sectors(void* buf, size_t count, device_image_t *base_image)
+{
+  Bit8u *cbuf = (Bit8u*)buf;
+  Bit8u *extent_bitmap;
+  Bit32u extent, offset, n, run, len;
+  Bit32u nblocks = (Bit32u)(count / 512);
+  bool present;
 
-    char *zerobuffer = new char[512];
-    memset(zerobuffer, 0, 512);
+  if ((count % 512) != 0) {
+    BX_PANIC(("redolog : read() with count not multiple of 512"));
+    return -1;
+  }
 
-    // Write bitmap
-    bitmap_offset  = (Bit64s)STANDARD_HEADER_SIZE + (dtoh32(header.specific.catalog) * sizeof(Bit32u));
-    bitmap_offset += (Bit64s)512 * dtoh32(catalog[extent_index]) * (extent_blocks + bitmap_blocks);
-    ::lseek(fd, (off_t)bitmap_offset, SEEK_SET);
-    for (i=0; i<bitmap_blocks; i++) {
-      ::write(fd, zerobuffer, 512);
+  while (nblocks > 0) {
+    extent = (Bit32u)(imagepos / dtoh32(header.specific.extent));
+    offset = (Bit32u)((imagepos % dtoh32(header.specific.extent)) / 512);
+    n = extent_blocks - offset;
+    if (n > nblocks) n = nblocks;
+    extent_bitmap = NULL;
+    if (dtoh32(catalog[extent]) != REDOLOG_PAGE_NOT_ALLOCATED) {
+      extent_bitmap = get_bitmap(extent, 0);
+      if (extent_bitmap == NULL) {
+        return -1;
+      }
     }
-    // Write extent
-    for (i=0; i<extent_blocks; i++) {
-      ::write(fd, zerobuffer, 512);
+    while (n > 0) {
+      present = (extent_bitmap != NULL) &&
+                ((extent_bitmap[offset/8] >> (offset%8)) & 0x01);
+      run = 1;
+      while ((run < n) && (((extent_bitmap != NULL) &&
+             ((extent_bitmap[(offset+run)/8] >> ((offset+run)%8)) & 0x01)) == present)) {
+        run++;
+      }
+      len = run * 512;
+      if (present) {
+        if (bx_read_image(fd, (off_t)(get_bitmap_offset(extent) + (Bit64s)512 * (bitmap_blocks + offset)),
+                          cbuf, len) != (ssize_t)len) {
+          return -1;
+        }
+      } else if (base_image != NULL) {
+        if (base_image->lseek(imagepos, SEEK_SET) < 0) {
+          return -1;
+        }
+        if (base_image->read(cbuf, len) < 0) {
+          return -1;
+        }
+      } else {
+        memset(cbuf, 0, len);
+      }
+      cbuf += len;
+      imagepos += len;
+      offset += run;
+      n -= run;
+      nblocks -= run;
     }
+  }
+  return count;
+}
 
-    delete [] zerobuffer;
+// Contiguous blocks within an extent are written with a single request. The
+// bitmap is updated in the cache and written once per request (or on eviction
+// for volatile redologs).
+ssize_t redolog_t::write(const void* buf, size_t count)
+{
+  Bit8u *cbuf = (Bit8u*)buf;
+  Bit8u *extent_bitmap;
+  Bit32u extent, offset, n, i, len;
+  Bit32u nblocks = (Bit32u)(count / 512);
 
-    update_catalog = 1;
+  if ((count % 512) != 0) {
+    BX_PANIC(("redolog : write() with count not multiple of 512"));
+    return -1;
   }
 
-  bitmap_offset  = (Bit64s)STANDARD_HEADER_SIZE + (dtoh32(header.specific.catalog) * sizeof(Bit32u));
-  bitmap_offset += (Bit64s)512 * dtoh32(catalog[extent_index]) * (extent_blocks + bitmap_blocks);
-  block_offset    = bitmap_offset + ((Bit64s)512 * (bitmap_blocks + extent_offset));
+  while (nblocks > 0) {
+    extent = (Bit32u)(imagepos / dtoh32(header.specific.extent));
+    offset = (Bit32u)((imagepos % dtoh32(header.specific.extent)) / 512);
+    n = extent_blocks - offset;
+    if (n > nblocks) n = nblocks;
 
-  BX_DEBUG(("redolog : bitmap offset is %x", (Bit32u)bitmap_offset));
-  BX_DEBUG(("redolog : block offset is %x", (Bit32u)block_offset));
+    BX_DEBUG(("redolog : writing index %d, mapping to %d", extent, dtoh32(catalog[extent])));
 
-  // Write block
-  written = bx_write_image(fd, (off_t)block_offset, (void*)buf, count);
+    if (dtoh32(catalog[extent]) == REDOLOG_PAGE_NOT_ALLOCATED) {
+      if (!allocate_extent(extent)) {
+        return -1;
+      }
+    }
+    extent_bitmap = get_bitmap(extent, 0);
+    if (extent_bitmap == NULL) {
+      return -1;
+    }
 
-  // Write bitmap
-  if (bitmap_update) {
-    if (bx_read_image(fd, (off_t)bitmap_offset, bitmap,  dtoh32(header.specific.bitmap)) != (ssize_t)dtoh32(header.specific.bitmap)) {
-      BX_PANIC(("redolog : failed to read bitmap for extent %d", extent_index));
-      return 0;
+    // Write blocks
+    len = n * 512;
+    if (bx_write_image(fd, (off_t)(get_bitmap_offset(extent) + (Bit64s)512 * (bitmap_blocks + offset)),
+                       cbuf, len) != (ssize_t)len) {
+      return -1;
     }
-    bitmap_update = 0;
-  }
 
-  // If bloc does not belong to extent yet
-  if (((bitmap[extent_offset/8] >> (extent_offset%8)) & 0x01) == 0x00) {
-    bitmap[extent_offset/8] |= 1 << (extent_offset%8);
-    bx_write_image(fd, (off_t)bitmap_offset, bitmap,  dtoh32(header.specific.bitmap));
+    // Update bitmap
+    for (i = offset; i < (offset + n); i++) {
+      if (((extent_bitmap[i/8] >> (i%8)) & 0x01) == 0x00) {
+        extent_bitmap[i/8] |= 1 << (i%8);
+        bitmap_dirty[extent % REDOLOG_BITMAP_SLOTS] = 1;
+      }
+    }
+    cbuf += len;
+    imagepos += len;
+    nblocks -= n;
   }
-
-  // Write catalog
-  if (update_catalog) {
-    // FIXME if mmap
-    catalog_offset  = (Bit64s)STANDARD_HEADER_SIZE + (extent_index * sizeof(Bit32u));
-
-    BX_DEBUG(("redolog : writing catalog at offset %x", (Bit32u)catalog_offset));
-
-    bx_write_image(fd, (off_t)catalog_offset, &catalog[extent_index], sizeof(Bit32u));
+  if (!bitmap_write_back) {
+    flush_bitmaps();
   }
-
-  if (written >= 0) lseek(512, SEEK_CUR);
-
-  return written;
+  return count;
 }
 
 int redolog_t::check_format(int fd, const char *subtype)
@@ -2106,66 +2406,77 @@ int redolog_t::check_format(int fd, const char *subtype)
 int redolog_t::commit(device_image_t *base_image)
 {
   int ret = 0;
-  Bit32u i;
-  Bit8u buffer[512];
+  Bit32u i, j, run;
+  Bit32u extent_size = dtoh32(header.specific.extent);
+  Bit32u blocks = dtoh32(header.specific.bitmap) * 8;
+  Bit8u *buffer = new Bit8u[extent_size];
 
   printf("\nCommitting changes to base image file: [  0%%]");
 
-  for (i = 0; i < dtoh32(header.specific.catalog); i++) {
+  for (i = 0; (i < dtoh32(header.specific.catalog)) && (ret == 0); i++) {
     printf("\x8\x8\x8\x8\x8%3d%%]", (i+1)*100/dtoh32(header.specific.catalog));
     fflush(stdout);
 
-    if (dtoh32(catalog[i]) != REDOLOG_PAGE_NOT_ALLOCATED) {
-      Bit64s bitmap_offset;
-      Bit32u bitmap_size, j;
+    if (dtoh32(catalog[i]) == REDOLOG_PAGE_NOT_ALLOCATED)
+      continue;
 
-      bitmap_offset  = (Bit64s)STANDARD_HEADER_SIZE + (dtoh32(header.specific.catalog) * sizeof(Bit32u));
-      bitmap_offset += (Bit64s)512 * dtoh32(catalog[i]) * (extent_blocks + bitmap_blocks);
+    Bit64s bitmap_offset = get_bitmap_offset(i);
+    Bit8u *extent_bitmap = get_bitmap(i, 0);
+    if (extent_bitmap == NULL) {
+      ret = -1;
+      break;
+    }
+    // copy each run of present blocks with one read and one write
+    for (j = 0; j < blocks; j += run) {
+      run = 0;
+      while (((j + run) < blocks) && ((extent_bitmap[(j + run) >> 3] & (1 << ((j + run) & 7))) != 0)) {
+        run++;
+      }
+      if (run == 0) {
+        run = 1;
+        continue;
+      }
+      Bit64s block_offset = bitmap_offset + ((Bit64s)512 * (bitmap_blocks + j));
+      Bit64s base_offset = (Bit64s)i * extent_size + (Bit64s)512 * j;
+      int len = run * 512;
 
-      // Read bitmap
-      bitmap_size = dtoh32(header.specific.bitmap);
-      if ((Bit32u)bx_read_image(fd, (off_t)bitmap_offset, bitmap, bitmap_size) != bitmap_size) {
+      if ((bx_read_image(fd, (off_t)block_offset, buffer, len) != len) ||
+          (base_image->lseek(base_offset, SEEK_SET) < 0) ||
+          (base_image->write(buffer, len) != len)) {
         ret = -1;
         break;
       }
-
-      for (j = 0; j < dtoh32(header.specific.bitmap); j++) {
-        Bit32u bit;
-
-        for (bit = 0; bit < 8; bit++) {
-          if ( (bitmap[j] & (1 << bit)) != 0) {
-            Bit64s base_offset, block_offset;
-
-            block_offset = bitmap_offset + ((Bit64s)512 * (bitmap_blocks + ((j * 8) + bit)));
-
-            if (bx_read_image(fd, (off_t)block_offset, buffer, 512) != 512) {
-              ret = -1;
-              break;
-            }
-
-            base_offset  = (Bit64s)i * (dtoh32(header.specific.extent));
-            base_offset += (Bit64s)512 * ((j * 8) + bit);
-
-            if (base_image->lseek(base_offset, SEEK_SET) < 0) {
-              ret = -1;
-              break;
-            }
-            if (base_image->write(buffer, 512) < 0) {
-              ret = -1;
-              break;
-            }
-          }
-        }
-      }
     }
   }
+  delete [] buffer;
   return ret;
 }
+
+int redolog_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  Bit32u extent_size = dtoh32(header.specific.extent);
+  Bit32u extents = dtoh32(header.specific.catalog);
+  Bit32u extent = (Bit32u)(offset / extent_size);
+  Bit64u len = (Bit64u)(extent + 1) * extent_size - offset;
+
+  if (extent >= extents)
+    return 1;
+  int status = (dtoh32(catalog[extent]) != REDOLOG_PAGE_NOT_ALLOCATED);
+  while ((len < *count) && (++extent < extents) &&
+         ((dtoh32(catalog[extent]) != REDOLOG_PAGE_NOT_ALLOCATED) == status)) {
+    len += extent_size;
+  }
+  if (len < *count) {
+    *count = len;
+  }
+  return status;
+}
 #endif
 
 #ifndef BXIMAGE
 bool redolog_t::save_state(const char *backup_fname)
 {
+  flush_bitmaps();
   return hdimage_backup_file(fd, backup_fname);
 }
 #endif
@@ -2203,33 +2514,12 @@ Bit64s growing_image_t::lseek(Bit64s offset, int whence)
 
 ssize_t growing_image_t::read(void* buf, size_t count)
 {
-  char *cbuf = (char*)buf;
-  size_t n = 0;
-  ssize_t ret = 0;
-
-  memset(buf, 0, count);
-  while (n < count) {
-    ret = redolog->read(cbuf, 512);
-    if (ret < 0) break;
-    cbuf += 512;
-    n += 512;
-  }
-  return (ret < 0) ? ret : count;
+  return redolog->read_sectors(buf, count, NULL);
 }
 
 ssize_t growing_image_t::write(const void* buf, size_t count)
 {
-  char *cbuf = (char*)buf;
-  size_t n = 0;
-  ssize_t ret = 0;
-
-  while (n < count) {
-    ret = redolog->write(cbuf, 512);
-    if (ret < 0) break;
-    cbuf += 512;
-    n += 512;
-  }
-  return (ret < 0) ? ret : count;
+  return redolog->write(buf, count);
 }
 
 Bit32u growing_image_t::get_timestamp()
@@ -2243,6 +2533,11 @@ int growing_image_t::check_format(int fd, Bit64u imgsize)
 }
 
 #ifdef BXIMAGE
+int growing_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  return redolog->get_alloc_status(offset, count);
+}
+
 int growing_image_t::create_image(const char *pathname, Bit64u size)
 {
   redolog = new redolog_t;
@@ -2403,34 +2698,12 @@ Bit64s undoable_image_t::lseek(Bit64s offset, int whence)
 
 ssize_t undoable_image_t::read(void* buf, size_t count)
 {
-  char *cbuf = (char*)buf;
-  size_t n = 0;
-  ssize_t ret = 0;
-
-  while (n < count) {
-    if ((size_t)redolog->read(cbuf, 512) != 512) {
-      ret = ro_disk->read(cbuf, 512);
-      if (ret < 0) break;
-    }
-    cbuf += 512;
-    n += 512;
-  }
-  return (ret < 0) ? ret : count;
+  return redolog->read_sectors(buf, count, ro_disk);
 }
 
 ssize_t undoable_image_t::write(const void* buf, size_t count)
 {
-  char *cbuf = (char*)buf;
-  size_t n = 0;
-  ssize_t ret = 0;
-
-  while (n < count) {
-    ret = redolog->write(cbuf, 512);
-    if (ret < 0) break;
-    cbuf += 512;
-    n += 512;
-  }
-  return (ret < 0) ? ret : count;
+  return redolog->write(buf, count);
 }
 
 #ifndef BXIMAGE
@@ -2577,34 +2850,12 @@ Bit64s volatile_image_t::lseek(Bit64s offset, int whence)
 
 ssize_t volatile_image_t::read(void* buf, size_t count)
 {
-  char *cbuf = (char*)buf;
-  size_t n = 0;
-  ssize_t ret = 0;
-
-  while (n < count) {
-    if ((size_t)redolog->read(cbuf, 512) != 512) {
-      ret = ro_disk->read(cbuf, 512);
-      if (ret < 0) break;
-    }
-    cbuf += 512;
-    n += 512;
-  }
-  return (ret < 0) ? ret : count;
+  return redolog->read_sectors(buf, count, ro_disk);
 }
 
 ssize_t volatile_image_t::write(const void* buf, size_t count)
 {
-  char *cbuf = (char*)buf;
-  size_t n = 0;
-  ssize_t ret = 0;
-
-  while (n < count) {
-    ret = redolog->write(cbuf, 512);
-    if (ret < 0) break;
-    cbuf += 512;
-    n += 512;
-  }
-  return (ret < 0) ? ret : count;
+  return redolog->write(buf, count);
 }
 
 #ifndef BXIMAGE
@@ -80,6 +80,14 @@
 
 #define REDOLOG_PAGE_NOT_ALLOCATED (0xffffffff)
 
+// number of extent bitmaps cached in memory (direct mapped)
+#define REDOLOG_BITMAP_SLOTS 64
+
+// memory budget and slot limit of the block caches used by the sparse
+// image formats (vmware4 grains, vbox blocks)
+#define HDIMAGE_BLOCK_CACHE_SIZE      (4 << 20)
+#define HDIMAGE_BLOCK_CACHE_MAX_SLOTS 64
+
 #define UNDOABLE_REDOLOG_EXTENSION ".redolog"
 #define UNDOABLE_REDOLOG_EXTENSION_LENGTH (strlen(UNDOABLE_REDOLOG_EXTENSION))
 #define VOLATILE_REDOLOG_EXTENSION ".XXXXXX"
@@ -204,6 +212,11 @@ class BOCHSAPI_MSVCONLY device_image_t
 #ifdef BXIMAGE
       // Create new image file
       virtual int create_image(const char *pathname, Bit64u size) {return 0;}
+
+      // Returns 1 if the range starting at 'offset' may contain data or 0 if
+      // it is known to read as zeros. On input 'count' is the maximum length
+      // to check, on return the length of the range with the same status.
+      virtual int get_alloc_status(Bit64u offset, Bit64u *count) {return 1;}
 #else
       // Save/restore support
       virtual void register_state(bx_list_c *parent);
@@ -249,7 +262,10 @@ class flat_image_t : public device_image_t
       // Check image format
       static int check_format(int fd, Bit64u imgsize);
 
-#ifndef BXIMAGE
+#ifdef BXIMAGE
+      // Allocation status from the holes of the host file
+      int get_alloc_status(Bit64u offset, Bit64u *count);
+#else
       // Save/restore support
       bool save_state(const char *backup_fname);
       void restore_state(const char *backup_fname);
@@ -351,6 +367,7 @@ class sparse_image_t : public device_image_t
 #ifdef BXIMAGE
     // Create new image file
     int create_image(const char *pathname, Bit64u size);
+    int get_alloc_status(Bit64u offset, Bit64u *count);
 #else
     // Save/restore support
     bool save_state(const char *backup_fname);
@@ -431,6 +448,60 @@ class dll_image_t : public device_image_t
 };
 #endif
 
+// LRU cache for fixed size blocks of an image file. Each cached block has
+// a virtual index and an owner specific file offset. Dirty blocks are
+// written back using the owner's callback when they are evicted or flushed.
+// The callback may update the file offset (e.g. after allocating the block).
+typedef bool (*hdimage_writeback_t)(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data);
+
+class BOCHSAPI_MSVCONLY hdimage_block_cache_c
+{
+  public:
+      hdimage_block_cache_c();
+      ~hdimage_block_cache_c();
+
+      // 'slots' == 0 selects the number of slots from HDIMAGE_BLOCK_CACHE_SIZE
+      bool init(Bit32u block_size, unsigned slots, hdimage_writeback_t writeback, void *this_ptr);
+      void cleanup();
+
+      // Returns the slot holding block 'index' or -1 if not cached.
+      int find(Bit64u index);
+      // Returns a slot for block 'index', evicting the least recently used
+      // block first. Returns -1 if the write back of the evicted block failed.
+      int alloc(Bit64u index, Bit64s offset);
+      // Writes back all dirty blocks in ascending index order.
+      bool flush();
+      // Returns true if a miss on 'index' follows the last recorded miss.
+      bool sequential(Bit64u index) const { return (index == (last_miss + 1)); }
+      void set_last_miss(Bit64u index) { last_miss = index; }
+
+      Bit8u *data(int slot) const { return slot_data + (size_t)slot * block_size; }
+      Bit64s get_offset(int slot) const { return entry[slot].offset; }
+      void set_offset(int slot, Bit64s offset) { entry[slot].offset = offset; }
+      void set_dirty(int slot) { entry[slot].dirty = 1; }
+      void drop(int slot) { entry[slot].valid = 0; entry[slot].dirty = 0; last_slot = -1; }
+      unsigned get_slots() const { return slots; }
+
+  private:
+      bool writeback_slot(int slot);
+
+      struct {
+        Bit64u index;
+        Bit64s offset;
+        Bit32u stamp;
+        bool   valid;
+        bool   dirty;
+      } entry[HDIMAGE_BLOCK_CACHE_MAX_SLOTS];
+      Bit8u   *slot_data;
+      Bit32u   block_size;
+      unsigned slots;
+      int      last_slot;
+      Bit32u   clock;
+      Bit64u   last_miss;
+      hdimage_writeback_t writeback;
+      void    *owner;
+};
+
 // REDOLOG class
 class BOCHSAPI_MSVCONLY redolog_t
 {
@@ -447,27 +518,37 @@ class BOCHSAPI_MSVCONLY redolog_t
       bool set_timestamp(Bit32u timestamp);
 
       Bit64s lseek(Bit64s offset, int whence);
+      // Read one block. Returns 0 if the block is not present in the redolog.
       ssize_t read(void* buf, size_t count);
+      // Read count bytes. Blocks not present in the redolog are read from the
+      // base image (or zero-filled if base_image is NULL).
+      ssize_t read_sectors(void* buf, size_t count, device_image_t *base_image);
       ssize_t write(const void* buf, size_t count);
 
       static int check_format(int fd, const char *subtype);
 
 #ifdef BXIMAGE
       int commit(device_image_t *base_image);
+      int get_alloc_status(Bit64u offset, Bit64u *count);
 #else
       bool save_state(const char *backup_fname);
 #endif
 
   private:
       void             print_header();
+      Bit64s           get_bitmap_offset(Bit32u extent);
+      Bit8u           *get_bitmap(Bit32u extent, bool is_new);
+      void             flush_bitmap(Bit32u slot);
+      void             flush_bitmaps();
+      bool             allocate_extent(Bit32u extent);
       char            *pathname;
       int              fd;
       redolog_header_t header;     // Header is kept in x86 (little) endianness
       Bit32u          *catalog;
-      Bit8u           *bitmap;
-      bool             bitmap_update;
-      Bit32u           extent_index;
-      Bit32u           extent_offset;
+      Bit8u           *bitmap;     // bitmap cache (write-back)
+      Bit32u           bitmap_extent[REDOLOG_BITMAP_SLOTS];
+      bool             bitmap_dirty[REDOLOG_BITMAP_SLOTS];
+      bool             bitmap_write_back;
       Bit32u           extent_next;
 
       Bit32u           bitmap_blocks;
@@ -511,6 +592,7 @@ class growing_image_t : public device_image_t
 #ifdef BXIMAGE
       // Create new image file
       int create_image(const char *pathname, Bit64u size);
+      int get_alloc_status(Bit64u offset, Bit64u *count);
 #else
       // Save/restore support
       bool save_state(const char *backup_fname);
@@ -0,0 +1,1044 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  QEMU copy-on-write (qcow2) disk image support
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+/////////////////////////////////////////////////////////////////////////
+
+// Supported: qcow2 version 2 and 3 images with 16-bit refcounts, backing
+// files (any image mode detected by Bochs), zlib compressed clusters (read
+// only) and zero clusters. Encrypted images, external data files, extended
+// L2 entries and non-zlib compression are rejected. Images with internal
+// snapshots can only be opened read-only.
+//
+// New clusters (data, L2 tables and refcount blocks) are always appended
+// to the image file and freed clusters are never reused. The references of
+// rewritten compressed clusters are dropped, preallocated zero clusters are
+// leaked when they are rewritten.
+
+// Define BX_PLUGGABLE in files that can be compiled into plugins.  For
+// platforms that require a special tag on exported symbols, BX_PLUGGABLE
+// is used to know when we are exporting symbols and when we are importing.
+#define BX_PLUGGABLE
+
+#ifdef BXIMAGE
+#include "config.h"
+#include "misc/bxcompat.h"
+#include "osdep.h"
+#include "misc/bswap.h"
+#else
+#include "bochs.h"
+#include "plugin.h"
+#endif
+#include "hdimage.h"
+#include "qcow2.h"
+
+#if BX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define LOG_THIS bx_hdimage_ctl.
+
+#ifndef BXIMAGE
+
+// disk image plugin entry point
+
+PLUGIN_ENTRY_FOR_IMG_MODULE(qcow2)
+{
+  if (mode == PLUGIN_PROBE) {
+    return (int)PLUGTYPE_IMG;
+  }
+  return 0; // Success
+}
+
+#endif
+
+//
+// Define the static class that registers the derived device image class,
+// and allocates one on request.
+//
+class bx_qcow2_locator_c : public hdimage_locator_c {
+public:
+  bx_qcow2_locator_c(void) : hdimage_locator_c("qcow2") {}
+protected:
+  device_image_t *allocate(Bit64u disk_size, const char *journal) {
+    return (new qcow2_image_t());
+  }
+  int check_format(int fd, Bit64u disk_size) {
+    return (qcow2_image_t::check_format(fd, disk_size));
+  }
+} bx_qcow2_match;
+
+// nesting level of backing files currently being opened
+static int qcow2_backing_depth = 0;
+
+qcow2_image_t::qcow2_image_t()
+  : fd(-1),
+  read_only(0),
+  cluster_size(512),
+  l1_table(NULL),
+  refcount_table(NULL),
+  refcount_table_size(0),
+  refcount_block(NULL),
+  refcount_block_offset(0),
+  refcount_dirty_first(-1),
+  refcount_dirty_last(-1),
+  cluster_buf(NULL),
+  zbuf(NULL),
+  zcache(NULL),
+  zcache_entry(0),
+  end_offset(0),
+  cur_offset(0),
+  backing(NULL),
+  backing_path(NULL),
+  pathname(NULL)
+{
+#ifdef BXIMAGE
+  backing_file = NULL;
+  zwrite_offset = 0;
+  zwrite_end = 0;
+#endif
+}
+
+qcow2_image_t::~qcow2_image_t()
+{
+  close();
+}
+
+int qcow2_image_t::check_format(int fd, Bit64u imgsize)
+{
+  Bit32u buf[2];
+
+  if (bx_read_image(fd, 0, buf, 8) != 8)
+    return HDIMAGE_READ_ERROR;
+  if (QCOW2_BE32(buf[0]) != QCOW2_MAGIC)
+    return HDIMAGE_NO_SIGNATURE;
+  if ((QCOW2_BE32(buf[1]) != 2) && (QCOW2_BE32(buf[1]) != 3))
+    return HDIMAGE_VERSION_ERROR;
+
+  return HDIMAGE_FORMAT_OK;
+}
+
+int qcow2_image_t::open(const char* _pathname, int flags)
+{
+  Bit64u imgsize = 0;
+  Bit32u i;
+
+  close();
+  pathname = _pathname;
+  read_only = ((flags & (O_WRONLY | O_RDWR)) == 0);
+  if ((fd = hdimage_open_file(pathname, flags, &imgsize, &mtime)) < 0) {
+    BX_ERROR(("qcow2: cannot open image file '%s'", pathname));
+    return -1;
+  }
+  if (!read_header()) {
+    close();
+    return -1;
+  }
+  cluster_size = 1 << header.cluster_bits;
+  l2_bits = header.cluster_bits - 3;
+
+  l1_table = new Bit64u[header.l1_size + 1];
+  if (bx_read_image(fd, header.l1_table_offset, l1_table, header.l1_size * 8) != (int)(header.l1_size * 8)) {
+    BX_ERROR(("qcow2: cannot read L1 table"));
+    close();
+    return -1;
+  }
+  for (i = 0; i < header.l1_size; i++) {
+    l1_table[i] = QCOW2_BE64(l1_table[i]);
+  }
+  if (!read_only) {
+    refcount_table_size = (Bit64u)header.refcount_table_clusters * cluster_size / 8;
+    refcount_table = new Bit64u[refcount_table_size];
+    if (bx_read_image(fd, header.refcount_table_offset, refcount_table,
+                      (int)(refcount_table_size * 8)) != (int)(refcount_table_size * 8)) {
+      BX_ERROR(("qcow2: cannot read refcount table"));
+      close();
+      return -1;
+    }
+    for (i = 0; i < refcount_table_size; i++) {
+      refcount_table[i] = QCOW2_BE64(refcount_table[i]);
+    }
+    refcount_block = new Bit8u[cluster_size];
+    refcount_block_offset = 0;
+    refcount_dirty_first = -1;
+    refcount_dirty_last = -1;
+    cluster_buf = new Bit8u[cluster_size];
+  }
+  if (!l2_cache.init(cluster_size, 0, l2_writeback, this)) {
+    BX_ERROR(("qcow2: cannot allocate the L2 table cache"));
+    close();
+    return -1;
+  }
+  zcache_entry = 0;
+  end_offset = (imgsize + cluster_size - 1) & ~(Bit64u)(cluster_size - 1);
+  cur_offset = 0;
+#ifdef BXIMAGE
+  zwrite_offset = 0;
+  zwrite_end = 0;
+#endif
+
+  if (header.backing_file_offset != 0) {
+    if (!open_backing_file()) {
+      close();
+      return -1;
+    }
+  }
+
+  // the image is modified: the features in the autoclear bits are invalid now
+  if (!read_only && (header.autoclear_features != 0)) {
+    Bit64u zero = 0;
+    header.autoclear_features = 0;
+    bx_write_image(fd, 88, &zero, 8);
+  }
+
+  hd_size = header.size;
+  sect_size = 512;
+
+  BX_INFO(("'qcow2' disk image opened: path is '%s'", pathname));
+
+  return 0;
+}
+
+bool qcow2_image_t::read_header()
+{
+  Bit8u buf[QCOW2_V3_HEADER_SIZE];
+
+  memset(buf, 0, sizeof(buf));
+  if (bx_read_image(fd, 0, buf, QCOW2_V3_HEADER_SIZE) < QCOW2_V2_HEADER_SIZE) {
+    BX_ERROR(("qcow2: cannot read image header"));
+    return 0;
+  }
+  memcpy(&header, buf, sizeof(header));
+  header.magic = QCOW2_BE32(header.magic);
+  header.version = QCOW2_BE32(header.version);
+  header.backing_file_offset = QCOW2_BE64(header.backing_file_offset);
+  header.backing_file_size = QCOW2_BE32(header.backing_file_size);
+  header.cluster_bits = QCOW2_BE32(header.cluster_bits);
+  header.size = QCOW2_BE64(header.size);
+  header.crypt_method = QCOW2_BE32(header.crypt_method);
+  header.l1_size = QCOW2_BE32(header.l1_size);
+  header.l1_table_offset = QCOW2_BE64(header.l1_table_offset);
+  header.refcount_table_offset = QCOW2_BE64(header.refcount_table_offset);
+  header.refcount_table_clusters = QCOW2_BE32(header.refcount_table_clusters);
+  header.nb_snapshots = QCOW2_BE32(header.nb_snapshots);
+  header.snapshots_offset = QCOW2_BE64(header.snapshots_offset);
+  if (header.version >= 3) {
+    header.incompatible_features = QCOW2_BE64(header.incompatible_features);
+    header.compatible_features = QCOW2_BE64(header.compatible_features);
+    header.autoclear_features = QCOW2_BE64(header.autoclear_features);
+    header.refcount_order = QCOW2_BE32(header.refcount_order);
+    header.header_length = QCOW2_BE32(header.header_length);
+  } else {
+    header.incompatible_features = 0;
+    header.compatible_features = 0;
+    header.autoclear_features = 0;
+    header.refcount_order = 4;
+    header.header_length = QCOW2_V2_HEADER_SIZE;
+  }
+
+  if ((header.magic != QCOW2_MAGIC) || ((header.version != 2) && (header.version != 3))) {
+    BX_ERROR(("qcow2: '%s' is not a qcow2 version 2 or 3 image", pathname));
+    return 0;
+  }
+  if ((header.cluster_bits < QCOW2_MIN_CLUSTER_BITS) ||
+      (header.cluster_bits > QCOW2_MAX_CLUSTER_BITS)) {
+    BX_ERROR(("qcow2: unsupported cluster size (%d bits)", header.cluster_bits));
+    return 0;
+  }
+  if (header.crypt_method != 0) {
+    BX_ERROR(("qcow2: encrypted images are not supported"));
+    return 0;
+  }
+  if (header.incompatible_features != 0) {
+    BX_ERROR(("qcow2: unsupported incompatible features 0x" FMT_LL "x", header.incompatible_features));
+    return 0;
+  }
+  Bit64u l2_coverage = (Bit64u)1 << (2 * header.cluster_bits - 3);
+  if ((Bit64u)header.l1_size < ((header.size + l2_coverage - 1) / l2_coverage)) {
+    BX_ERROR(("qcow2: L1 table too small for the disk size"));
+    return 0;
+  }
+  if (!read_only) {
+    if (header.refcount_order != 4) {
+      BX_ERROR(("qcow2: %d-bit refcounts are only supported read-only", 1 << header.refcount_order));
+      return 0;
+    }
+    if (header.nb_snapshots != 0) {
+      BX_ERROR(("qcow2: images with internal snapshots are only supported read-only"));
+      return 0;
+    }
+  }
+  return 1;
+}
+
+bool qcow2_image_t::open_backing_file()
+{
+  char name[BX_PATHNAME_LEN];
+  const char *image_mode = NULL;
+  Bit32u len = header.backing_file_size;
+
+  if ((len == 0) || (len >= BX_PATHNAME_LEN) ||
+      (bx_read_image(fd, header.backing_file_offset, name, len) != (int)len)) {
+    BX_ERROR(("qcow2: cannot read backing file name"));
+    return 0;
+  }
+  name[len] = 0;
+  backing_path = new char[BX_PATHNAME_LEN];
+  // relative names are relative to the directory of the image
+  const char *sep = strrchr(pathname, '/');
+  const char *sep2 = strrchr(pathname, '\\');
+  if ((sep2 != NULL) && ((sep == NULL) || (sep2 > sep))) sep = sep2;
+  if ((name[0] != '/') && (name[0] != '\\') && (strchr(name, ':') == NULL) && (sep != NULL) &&
+      ((size_t)(sep - pathname + 1 + len) < BX_PATHNAME_LEN)) {
+    memcpy(backing_path, pathname, sep - pathname + 1);
+    strcpy(backing_path + (sep - pathname + 1), name);
+  } else {
+    strcpy(backing_path, name);
+  }
+
+  if (qcow2_backing_depth >= QCOW2_MAX_BACKING_DEPTH) {
+    BX_ERROR(("qcow2: backing file chain too long"));
+    return 0;
+  }
+  if (!hdimage_detect_image_mode(backing_path, &image_mode)) {
+    BX_ERROR(("qcow2: backing file '%s' not found or mode not detected", backing_path));
+    return 0;
+  }
+  backing = DEV_hdimage_init_image(image_mode, 0, NULL);
+  if (backing == NULL) {
+    return 0;
+  }
+  qcow2_backing_depth++;
+  int ret = backing->open(backing_path, O_RDONLY);
+  qcow2_backing_depth--;
+  if (ret < 0) {
+    BX_ERROR(("qcow2: cannot open backing file '%s'", backing_path));
+    delete backing;
+    backing = NULL;
+    return 0;
+  }
+  backing_size = backing->hd_size;
+  BX_INFO(("qcow2: backing file '%s' (mode '%s')", backing_path, image_mode));
+  return 1;
+}
+
+void qcow2_image_t::close()
+{
+  if (fd > -1) {
+    if (!read_only) {
+      flush();
+    }
+    l2_cache.cleanup();
+    bx_close_image(fd, pathname);
+    fd = -1;
+  }
+  delete [] l1_table; l1_table = NULL;
+  delete [] refcount_table; refcount_table = NULL;
+  delete [] refcount_block; refcount_block = NULL;
+  delete [] cluster_buf; cluster_buf = NULL;
+  delete [] zbuf; zbuf = NULL;
+  delete [] zcache; zcache = NULL;
+  if (backing != NULL) {
+    backing->close();
+    delete backing;
+    backing = NULL;
+  }
+  delete [] backing_path; backing_path = NULL;
+}
+
+void qcow2_image_t::flush()
+{
+  if (!flush_refcount_block() || !l2_cache.flush()) {
+    BX_ERROR(("qcow2: failed to write back image metadata"));
+  }
+}
+
+Bit64s qcow2_image_t::lseek(Bit64s offset, int whence)
+{
+  switch (whence) {
+    case SEEK_SET:
+      cur_offset = (Bit64u)offset;
+      break;
+    case SEEK_CUR:
+      cur_offset += offset;
+      break;
+    case SEEK_END:
+      cur_offset = header.size + offset;
+      break;
+    default:
+      BX_ERROR(("qcow2: unknown 'whence' value (%d)", whence));
+      return -1;
+  }
+  if (cur_offset > header.size)
+    return -1;
+  return (Bit64s)cur_offset;
+}
+
+bool qcow2_image_t::is_data_cluster(Bit64u entry) const
+{
+  return (!(entry & (QCOW2_OFLAG_COMPRESSED | QCOW2_OFLAG_ZERO)) &&
+          ((entry & QCOW2_OFFSET_MASK) != 0));
+}
+
+//
+// Returns the cache slot of the L2 table for 'l1_index', -1 if it is not
+// allocated (and 'alloc' is not set) or -2 on error.
+//
+int qcow2_image_t::get_l2_table(Bit32u l1_index, bool alloc)
+{
+  int slot = l2_cache.find(l1_index);
+  if (slot >= 0)
+    return slot;
+
+  Bit64u l2_offset = l1_table[l1_index] & QCOW2_OFFSET_MASK;
+  if (l2_offset == 0) {
+    if (!alloc)
+      return -1;
+    Bit64s new_offset = alloc_clusters(1);
+    if (new_offset < 0)
+      return -2;
+    slot = l2_cache.alloc(l1_index, new_offset);
+    if (slot < 0)
+      return -2;
+    memset(l2_cache.data(slot), 0, cluster_size);
+    if (bx_write_image(fd, new_offset, l2_cache.data(slot), cluster_size) != (int)cluster_size) {
+      l2_cache.drop(slot);
+      return -2;
+    }
+    l1_table[l1_index] = (Bit64u)new_offset | QCOW2_OFLAG_COPIED;
+    Bit64u entry = QCOW2_BE64(l1_table[l1_index]);
+    if (bx_write_image(fd, header.l1_table_offset + (Bit64u)l1_index * 8, &entry, 8) != 8) {
+      return -2;
+    }
+    return slot;
+  }
+  if (alloc && !(l1_table[l1_index] & QCOW2_OFLAG_COPIED)) {
+    BX_ERROR(("qcow2: shared L2 tables are not supported for writing"));
+    return -2;
+  }
+  slot = l2_cache.alloc(l1_index, l2_offset);
+  if (slot < 0)
+    return -2;
+  if (bx_read_image(fd, l2_offset, l2_cache.data(slot), cluster_size) != (int)cluster_size) {
+    BX_ERROR(("qcow2: cannot read L2 table"));
+    l2_cache.drop(slot);
+    return -2;
+  }
+  return slot;
+}
+
+bool qcow2_image_t::get_cluster_entry(Bit64u offset, Bit64u *entry)
+{
+  Bit64u l1_index = offset >> (header.cluster_bits + l2_bits);
+
+  *entry = 0;
+  if (l1_index >= header.l1_size)
+    return 1;
+  int slot = get_l2_table((Bit32u)l1_index, 0);
+  if (slot == -1)
+    return 1;
+  if (slot < 0)
+    return 0;
+  Bit32u l2_index = (Bit32u)((offset >> header.cluster_bits) & ((1 << l2_bits) - 1));
+  *entry = QCOW2_BE64(((Bit64u*)l2_cache.data(slot))[l2_index]);
+  return 1;
+}
+
+bool qcow2_image_t::l2_writeback(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data)
+{
+  qcow2_image_t *class_ptr = (qcow2_image_t*)this_ptr;
+
+  return (bx_write_image(class_ptr->fd, *offset, data, class_ptr->cluster_size) == (int)class_ptr->cluster_size);
+}
+
+bool qcow2_image_t::read_backing(Bit64u offset, Bit8u *buf, size_t count)
+{
+  if ((backing != NULL) && (offset < backing_size)) {
+    size_t n = count;
+    if ((offset + n) > backing_size) {
+      n = (size_t)(backing_size - offset);
+    }
+    if ((backing->lseek(offset, SEEK_SET) < 0) || (backing->read(buf, n) != (ssize_t)n)) {
+      BX_ERROR(("qcow2: cannot read from backing file '%s'", backing_path));
+      return 0;
+    }
+    buf += n;
+    count -= n;
+  }
+  if (count > 0) {
+    memset(buf, 0, count);
+  }
+  return 1;
+}
+
+//
+// Decompresses the cluster described by 'entry' into 'zcache'. The last
+// decompressed cluster is kept since the guest usually reads it with
+// several requests.
+//
+bool qcow2_image_t::read_compressed(Bit64u entry)
+{
+  if ((zcache != NULL) && (zcache_entry == entry))
+    return 1;
+
+#if BX_HAVE_ZLIB
+  int csize_shift = 62 - (header.cluster_bits - 8);
+  Bit64u coffset = entry & ((BX_CONST64(1) << csize_shift) - 1);
+  Bit64u nb_csectors = ((entry >> csize_shift) & ((BX_CONST64(1) << (header.cluster_bits - 8)) - 1)) + 1;
+  int csize = (int)(nb_csectors * 512 - (coffset & 511));
+  z_stream strm;
+
+  if (zcache == NULL) {
+    zbuf = new Bit8u[cluster_size * 2];
+    zcache = new Bit8u[cluster_size];
+  }
+  zcache_entry = 0;
+  if (csize > (int)(cluster_size * 2)) {
+    csize = cluster_size * 2;
+  }
+  // the last compressed cluster may end before the sector boundary
+  csize = bx_read_image(fd, coffset, zbuf, csize);
+  if (csize <= 0) {
+    BX_ERROR(("qcow2: cannot read compressed cluster"));
+    return 0;
+  }
+  memset(&strm, 0, sizeof(strm));
+  if (inflateInit2(&strm, -12) != Z_OK)
+    return 0;
+  strm.next_in = zbuf;
+  strm.avail_in = csize;
+  strm.next_out = zcache;
+  strm.avail_out = cluster_size;
+  int ret = inflate(&strm, Z_FINISH);
+  inflateEnd(&strm);
+  if (((ret != Z_STREAM_END) && (ret != Z_BUF_ERROR)) || (strm.avail_out != 0)) {
+    BX_ERROR(("qcow2: cannot decompress cluster"));
+    return 0;
+  }
+  zcache_entry = entry;
+  return 1;
+#else
+  BX_ERROR(("qcow2: compressed clusters are not supported (Bochs compiled without zlib)"));
+  return 0;
+#endif
+}
+
+//
+// Reads the full cluster at the guest 'offset' described by 'entry'.
+//
+bool qcow2_image_t::read_cluster(Bit64u offset, Bit64u entry, Bit8u *buf)
+{
+  if (entry & QCOW2_OFLAG_COMPRESSED) {
+    if (!read_compressed(entry))
+      return 0;
+    memcpy(buf, zcache, cluster_size);
+  } else if (entry & QCOW2_OFLAG_ZERO) {
+    memset(buf, 0, cluster_size);
+  } else if ((entry & QCOW2_OFFSET_MASK) != 0) {
+    if (bx_read_image(fd, entry & QCOW2_OFFSET_MASK, buf, cluster_size) != (int)cluster_size)
+      return 0;
+  } else {
+    return read_backing(offset, buf, cluster_size);
+  }
+  return 1;
+}
+
+ssize_t qcow2_image_t::read(void* buf, size_t count)
+{
+  Bit8u *cbuf = (Bit8u*)buf;
+  size_t total = 0;
+  Bit64u entry, next;
+
+  while ((total < count) && (cur_offset < header.size)) {
+    Bit32u in_cluster = (Bit32u)(cur_offset & (cluster_size - 1));
+    size_t n = cluster_size - in_cluster;
+    if (n > (count - total)) {
+      n = count - total;
+    }
+    if ((cur_offset + n) > header.size) {
+      n = (size_t)(header.size - cur_offset);
+    }
+    if (!get_cluster_entry(cur_offset, &entry))
+      return -1;
+    if (is_data_cluster(entry)) {
+      // extend the request over clusters stored contiguously in the image
+      Bit64u host = (entry & QCOW2_OFFSET_MASK) + in_cluster;
+      while (((total + n) < count) && ((cur_offset + n) < header.size)) {
+        if (!get_cluster_entry(cur_offset + n, &next))
+          return -1;
+        if (!is_data_cluster(next) || ((next & QCOW2_OFFSET_MASK) != (host + n)))
+          break;
+        size_t left = count - total - n;
+        n += (left > cluster_size) ? cluster_size : left;
+      }
+      if (bx_read_image(fd, host, cbuf, (int)n) != (int)n)
+        return -1;
+    } else if (entry & QCOW2_OFLAG_COMPRESSED) {
+      if (!read_compressed(entry))
+        return -1;
+      memcpy(cbuf, zcache + in_cluster, n);
+    } else if (entry & QCOW2_OFLAG_ZERO) {
+      memset(cbuf, 0, n);
+    } else if (!read_backing(cur_offset, cbuf, n)) {
+      return -1;
+    }
+    cur_offset += n;
+    total += n;
+    cbuf += n;
+  }
+  return (ssize_t)total;
+}
+
+ssize_t qcow2_image_t::write(const void* buf, size_t count)
+{
+  Bit8u *cbuf = (Bit8u*)buf;
+  size_t total = 0;
+  Bit32u l2_entries = 1 << l2_bits;
+
+  if (read_only) {
+    BX_ERROR(("qcow2: image '%s' opened read-only", pathname));
+    return -1;
+  }
+  while ((total < count) && (cur_offset < header.size)) {
+    Bit32u in_cluster = (Bit32u)(cur_offset & (cluster_size - 1));
+    size_t n = cluster_size - in_cluster;
+    if (n > (count - total)) {
+      n = count - total;
+    }
+    if ((cur_offset + n) > header.size) {
+      n = (size_t)(header.size - cur_offset);
+    }
+    Bit32u l1_index = (Bit32u)(cur_offset >> (header.cluster_bits + l2_bits));
+    Bit32u l2_index = (Bit32u)((cur_offset >> header.cluster_bits) & (l2_entries - 1));
+    int slot = get_l2_table(l1_index, 1);
+    if (slot < 0)
+      return -1;
+    Bit64u *l2_table = (Bit64u*)l2_cache.data(slot);
+    Bit64u entry = QCOW2_BE64(l2_table[l2_index]);
+
+    if (is_data_cluster(entry) && (entry & QCOW2_OFLAG_COPIED)) {
+      // the cluster is only used by this image
+      if (bx_write_image(fd, (entry & QCOW2_OFFSET_MASK) + in_cluster, cbuf, (int)n) != (int)n)
+        return -1;
+    } else if (n == cluster_size) {
+      // new full clusters: allocate them in one run and write them at once
+      unsigned run = 1;
+      while (((total + (run + 1) * cluster_size) <= count) &&
+             ((l2_index + run) < l2_entries) &&
+             ((cur_offset + (Bit64u)(run + 1) * cluster_size) <= header.size)) {
+        Bit64u next = QCOW2_BE64(l2_table[l2_index + run]);
+        if (is_data_cluster(next) && (next & QCOW2_OFLAG_COPIED))
+          break;
+        run++;
+      }
+      Bit64s host = alloc_clusters(run);
+      if (host < 0)
+        return -1;
+      n = (size_t)run * cluster_size;
+      if (bx_write_image(fd, host, cbuf, (int)n) != (int)n)
+        return -1;
+      for (unsigned i = 0; i < run; i++) {
+        Bit64u old = QCOW2_BE64(l2_table[l2_index + i]);
+        l2_table[l2_index + i] = QCOW2_BE64(((Bit64u)host + (Bit64u)i * cluster_size) | QCOW2_OFLAG_COPIED);
+        if ((old & QCOW2_OFLAG_COMPRESSED) && !free_compressed(old))
+          return -1;
+      }
+      l2_cache.set_dirty(slot);
+    } else {
+      // copy on write: merge the new data with the old cluster contents
+      if (!read_cluster(cur_offset - in_cluster, entry, cluster_buf))
+        return -1;
+      memcpy(cluster_buf + in_cluster, cbuf, n);
+      Bit64s host = alloc_clusters(1);
+      if (host < 0)
+        return -1;
+      if (bx_write_image(fd, host, cluster_buf, cluster_size) != (int)cluster_size)
+        return -1;
+      l2_table[l2_index] = QCOW2_BE64((Bit64u)host | QCOW2_OFLAG_COPIED);
+      l2_cache.set_dirty(slot);
+      if ((entry & QCOW2_OFLAG_COMPRESSED) && !free_compressed(entry))
+        return -1;
+    }
+    cur_offset += n;
+    total += n;
+    cbuf += n;
+  }
+  return (ssize_t)total;
+}
+
+//
+// Allocates 'count' contiguous clusters at the end of the image file and
+// returns the offset of the first one (or -1 on error).
+//
+Bit64s qcow2_image_t::alloc_clusters(unsigned count)
+{
+  Bit64u offset = end_offset;
+
+  end_offset += (Bit64u)count * cluster_size;
+  for (unsigned i = 0; i < count; i++) {
+    if (!update_refcount((offset >> header.cluster_bits) + i, 1))
+      return -1;
+  }
+  // the refcounts must be on disk before the clusters are referenced
+  if (!flush_refcount_block())
+    return -1;
+  return (Bit64s)offset;
+}
+
+//
+// Drops the references of a rewritten compressed cluster to the (up to two)
+// clusters holding its data.
+//
+bool qcow2_image_t::free_compressed(Bit64u entry)
+{
+  int csize_shift = 62 - (header.cluster_bits - 8);
+  Bit64u coffset = entry & ((BX_CONST64(1) << csize_shift) - 1);
+  Bit64u nb_csectors = ((entry >> csize_shift) & ((BX_CONST64(1) << (header.cluster_bits - 8)) - 1)) + 1;
+  Bit64u last = ((coffset & ~(Bit64u)511) + nb_csectors * 512 - 1) >> header.cluster_bits;
+
+  for (Bit64u cluster = coffset >> header.cluster_bits; cluster <= last; cluster++) {
+    if (!update_refcount(cluster, -1))
+      return 0;
+  }
+  return 1;
+}
+
+bool qcow2_image_t::update_refcount(Bit64u cluster, int addend)
+{
+  Bit32u rb_bits = header.cluster_bits - 1; // 16-bit refcounts
+  Bit64u rt_index = cluster >> rb_bits;
+  int rb_index = (int)(cluster & ((1 << rb_bits) - 1));
+
+  if (rt_index >= refcount_table_size) {
+    if (!grow_refcount_table(rt_index + 1))
+      return 0;
+  }
+  Bit64u rb_offset = refcount_table[rt_index] & QCOW2_OFFSET_MASK;
+  if (rb_offset == 0) {
+    // allocate a new refcount block
+    if (!flush_refcount_block())
+      return 0;
+    rb_offset = end_offset;
+    end_offset += cluster_size;
+    memset(refcount_block, 0, cluster_size);
+    refcount_block_offset = rb_offset;
+    if (bx_write_image(fd, rb_offset, refcount_block, cluster_size) != (int)cluster_size)
+      return 0;
+    refcount_table[rt_index] = rb_offset;
+    Bit64u entry = QCOW2_BE64(rb_offset);
+    if (bx_write_image(fd, header.refcount_table_offset + rt_index * 8, &entry, 8) != 8)
+      return 0;
+    if (!update_refcount(rb_offset >> header.cluster_bits, 1))
+      return 0;
+  }
+  if (refcount_block_offset != rb_offset) {
+    if (!flush_refcount_block())
+      return 0;
+    if (bx_read_image(fd, rb_offset, refcount_block, cluster_size) != (int)cluster_size) {
+      refcount_block_offset = 0;
+      return 0;
+    }
+    refcount_block_offset = rb_offset;
+  }
+  Bit16u *refcount = (Bit16u*)refcount_block;
+  int value = QCOW2_BE16(refcount[rb_index]) + addend;
+  if ((value < 0) || (value > 0xffff)) {
+    BX_ERROR(("qcow2: refcount of cluster " FMT_LL "u out of range", cluster));
+    return 0;
+  }
+  refcount[rb_index] = QCOW2_BE16((Bit16u)value);
+  if ((refcount_dirty_first < 0) || (rb_index < refcount_dirty_first)) {
+    refcount_dirty_first = rb_index;
+  }
+  if (rb_index > refcount_dirty_last) {
+    refcount_dirty_last = rb_index;
+  }
+  return 1;
+}
+
+bool qcow2_image_t::flush_refcount_block()
+{
+  if (refcount_dirty_first < 0)
+    return 1;
+
+  int start = refcount_dirty_first * 2;
+  int len = (refcount_dirty_last - refcount_dirty_first + 1) * 2;
+  refcount_dirty_first = -1;
+  refcount_dirty_last = -1;
+  return (bx_write_image(fd, refcount_block_offset + start, refcount_block + start, len) == len);
+}
+
+//
+// Moves the refcount table to a larger area at the end of the image file.
+//
+bool qcow2_image_t::grow_refcount_table(Bit64u min_entries)
+{
+  Bit64u old_offset = header.refcount_table_offset;
+  Bit32u old_clusters = header.refcount_table_clusters;
+  Bit32u new_clusters = (old_clusters > 0) ? old_clusters : 1;
+  Bit64u entries_per_cluster = cluster_size / 8;
+  int block_shift = 2 * header.cluster_bits - 1;
+  Bit64u i;
+
+  // the new table must also cover itself and the new refcount blocks
+  while ((((Bit64u)new_clusters * entries_per_cluster) < min_entries) ||
+         (((Bit64u)new_clusters * entries_per_cluster) <
+          (((end_offset + (Bit64u)new_clusters * cluster_size) >> block_shift) + 2))) {
+    new_clusters *= 2;
+  }
+  Bit64u new_size = (Bit64u)new_clusters * entries_per_cluster;
+  Bit64u *new_table = new Bit64u[new_size];
+  memset(new_table, 0, new_size * 8);
+  for (i = 0; i < refcount_table_size; i++) {
+    new_table[i] = QCOW2_BE64(refcount_table[i]);
+  }
+  Bit64u new_offset = end_offset;
+  end_offset += (Bit64u)new_clusters * cluster_size;
+  if (bx_write_image(fd, new_offset, new_table, (int)(new_size * 8)) != (int)(new_size * 8)) {
+    delete [] new_table;
+    return 0;
+  }
+  for (i = 0; i < refcount_table_size; i++) {
+    new_table[i] = refcount_table[i];
+  }
+  // switch the header to the new table
+  Bit8u buf[12];
+  Bit64u be_offset = QCOW2_BE64(new_offset);
+  Bit32u be_clusters = QCOW2_BE32(new_clusters);
+  memcpy(buf, &be_offset, 8);
+  memcpy(buf + 8, &be_clusters, 4);
+  if (bx_write_image(fd, 48, buf, 12) != 12) {
+    delete [] new_table;
+    return 0;
+  }
+  delete [] refcount_table;
+  refcount_table = new_table;
+  refcount_table_size = new_size;
+  header.refcount_table_offset = new_offset;
+  header.refcount_table_clusters = new_clusters;
+
+  for (i = 0; i < new_clusters; i++) {
+    if (!update_refcount((new_offset >> header.cluster_bits) + i, 1))
+      return 0;
+  }
+  for (i = 0; i < old_clusters; i++) {
+    if (!update_refcount((old_offset >> header.cluster_bits) + i, -1))
+      return 0;
+  }
+  return 1;
+}
+
+#ifdef BXIMAGE
+int qcow2_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  Bit32u l2_shift = header.cluster_bits + l2_bits;
+  Bit64u entry, len = 0;
+  int status = -1;
+
+  while ((len < *count) && ((offset + len) < header.size)) {
+    Bit64u pos = offset + len;
+    Bit64u next = ((pos >> header.cluster_bits) + 1) << header.cluster_bits;
+    Bit64u l1_index = pos >> l2_shift;
+    int allocated;
+
+    if (((l1_index >= header.l1_size) || ((l1_table[l1_index] & QCOW2_OFFSET_MASK) == 0)) &&
+        ((backing == NULL) || (pos >= backing_size))) {
+      // no L2 table: skip the whole range covered by it
+      allocated = 0;
+      next = (l1_index + 1) << l2_shift;
+    } else {
+      if (!get_cluster_entry(pos, &entry))
+        return 1;
+      if (entry & QCOW2_OFLAG_COMPRESSED) {
+        allocated = 1;
+      } else if (entry & QCOW2_OFLAG_ZERO) {
+        allocated = 0;
+      } else if ((entry & QCOW2_OFFSET_MASK) != 0) {
+        allocated = 1;
+      } else if ((backing != NULL) && (pos < backing_size)) {
+        Bit64u n = next - pos;
+        allocated = backing->get_alloc_status(pos, &n);
+        if ((n > 0) && (n < (next - pos))) {
+          next = pos + n;
+        }
+      } else {
+        allocated = 0;
+      }
+    }
+    if (status < 0) {
+      status = allocated;
+    } else if (allocated != status) {
+      break;
+    }
+    len = next - offset;
+  }
+  if ((status >= 0) && (len < *count)) {
+    *count = len;
+  }
+  return (status != 0);
+}
+
+//
+// Stores the compressed data of the cluster at the guest 'offset' if it is
+// not allocated yet. Compressed clusters are packed into the clusters
+// allocated for them at the end of the image file. Returns 0 if the data
+// must be written uncompressed.
+//
+bool qcow2_image_t::write_compressed(Bit64u offset, const Bit8u *zdata, Bit32u zlen)
+{
+  Bit32u l1_index = (Bit32u)(offset >> (header.cluster_bits + l2_bits));
+  Bit32u l2_index = (Bit32u)((offset >> header.cluster_bits) & ((1 << l2_bits) - 1));
+  int csize_shift = 62 - (header.cluster_bits - 8);
+
+  if (read_only || (zlen == 0) || (zlen >= cluster_size) || ((offset & (cluster_size - 1)) != 0) ||
+      ((offset + cluster_size) > header.size))
+    return 0;
+  int slot = get_l2_table(l1_index, 1);
+  if (slot < 0)
+    return 0;
+  Bit64u *l2_table = (Bit64u*)l2_cache.data(slot);
+  if (l2_table[l2_index] != 0)
+    return 0;
+
+  // continue in the last cluster if it is still at the end of the file
+  if ((zwrite_end == 0) || (zwrite_end != end_offset)) {
+    zwrite_offset = end_offset;
+    zwrite_end = end_offset;
+  }
+  // a partially used cluster gets an additional reference, new ones get
+  // their first one from alloc_clusters()
+  if ((zwrite_offset < zwrite_end) && !update_refcount(zwrite_offset >> header.cluster_bits, 1))
+    return 0;
+  if ((zwrite_offset + zlen) > zwrite_end) {
+    unsigned n = (unsigned)((zwrite_offset + zlen - zwrite_end + cluster_size - 1) >> header.cluster_bits);
+    if (alloc_clusters(n) < 0)
+      return 0;
+    zwrite_end += (Bit64u)n * cluster_size;
+  }
+  if (bx_write_image(fd, zwrite_offset, (void*)zdata, zlen) != (int)zlen)
+    return 0;
+  Bit64u nb_csectors = ((zwrite_offset + zlen - 1) >> 9) - (zwrite_offset >> 9) + 1;
+  l2_table[l2_index] = QCOW2_BE64(QCOW2_OFLAG_COMPRESSED | ((nb_csectors - 1) << csize_shift) | zwrite_offset);
+  l2_cache.set_dirty(slot);
+  zwrite_offset += zlen;
+  return 1;
+}
+
+int qcow2_image_t::create_image(const char *pathname, Bit64u size)
+{
+  Bit32u cluster_bits = QCOW2_DEFAULT_CLUSTER_BITS;
+  Bit32u cluster_size = 1 << cluster_bits;
+  Bit64u l2_coverage = (Bit64u)1 << (2 * cluster_bits - 3);
+  Bit32u l1_size = (Bit32u)((size + l2_coverage - 1) / l2_coverage);
+  Bit32u l1_clusters = (l1_size * 8 + cluster_size - 1) / cluster_size;
+  Bit32u i;
+
+  if (l1_clusters == 0) {
+    l1_clusters = 1;
+  }
+  int fd = bx_create_image_file(pathname);
+  if (fd < 0) {
+    BX_FATAL(("ERROR: failed to create qcow2 image file"));
+  }
+  Bit8u *buf = new Bit8u[cluster_size];
+
+  // cluster 0: header, end of header extensions marker and backing file name
+  memset(buf, 0, cluster_size);
+  qcow2_header_t *hdr = (qcow2_header_t*)buf;
+  hdr->magic = QCOW2_BE32(QCOW2_MAGIC);
+  hdr->version = QCOW2_BE32(3);
+  hdr->cluster_bits = QCOW2_BE32(cluster_bits);
+  hdr->size = QCOW2_BE64(size);
+  hdr->l1_size = QCOW2_BE32(l1_size);
+  hdr->l1_table_offset = QCOW2_BE64((Bit64u)3 * cluster_size);
+  hdr->refcount_table_offset = QCOW2_BE64((Bit64u)cluster_size);
+  hdr->refcount_table_clusters = QCOW2_BE32(1);
+  hdr->refcount_order = QCOW2_BE32(4);
+  hdr->header_length = QCOW2_BE32(QCOW2_V3_HEADER_SIZE);
+  if ((backing_file != NULL) && (strlen(backing_file) > 0)) {
+    Bit32u len = (Bit32u)strlen(backing_file);
+    if ((QCOW2_V3_HEADER_SIZE + 8 + len) > cluster_size) {
+      BX_FATAL(("ERROR: backing file name too long"));
+    }
+    memcpy(buf + QCOW2_V3_HEADER_SIZE + 8, backing_file, len);
+    hdr->backing_file_offset = QCOW2_BE64(QCOW2_V3_HEADER_SIZE + 8);
+    hdr->backing_file_size = QCOW2_BE32(len);
+  }
+  if (bx_write_image(fd, 0, buf, cluster_size) != (int)cluster_size) {
+    BX_FATAL(("ERROR: The disk image is not complete - could not write header!"));
+  }
+  // cluster 1: refcount table
+  memset(buf, 0, cluster_size);
+  ((Bit64u*)buf)[0] = QCOW2_BE64((Bit64u)2 * cluster_size);
+  if (bx_write_image(fd, cluster_size, buf, cluster_size) != (int)cluster_size) {
+    BX_FATAL(("ERROR: The disk image is not complete - could not write refcount table!"));
+  }
+  // cluster 2: refcount block for the metadata clusters
+  memset(buf, 0, cluster_size);
+  for (i = 0; i < (3 + l1_clusters); i++) {
+    ((Bit16u*)buf)[i] = QCOW2_BE16(1);
+  }
+  if (bx_write_image(fd, (Bit64u)2 * cluster_size, buf, cluster_size) != (int)cluster_size) {
+    BX_FATAL(("ERROR: The disk image is not complete - could not write refcount block!"));
+  }
+  // cluster 3...: empty L1 table
+  memset(buf, 0, cluster_size);
+  for (i = 0; i < l1_clusters; i++) {
+    if (bx_write_image(fd, (Bit64u)(3 + i) * cluster_size, buf, cluster_size) != (int)cluster_size) {
+      BX_FATAL(("ERROR: The disk image is not complete - could not write L1 table!"));
+    }
+  }
+  delete [] buf;
+  ::close(fd);
+  return 0;
+}
+#else
+bool qcow2_image_t::save_state(const char *backup_fname)
+{
+  if (!read_only) {
+    flush();
+  }
+  return hdimage_backup_file(fd, backup_fname);
+}
+
+void qcow2_image_t::restore_state(const char *backup_fname)
+{
+  int temp_fd;
+  Bit64u imgsize;
+
+  if ((temp_fd = hdimage_open_file(backup_fname, O_RDONLY, &imgsize, NULL)) < 0) {
+    BX_PANIC(("Cannot open qcow2 image backup '%s'", backup_fname));
+    return;
+  }
+
+  if (check_format(temp_fd, imgsize) < HDIMAGE_FORMAT_OK) {
+    ::close(temp_fd);
+    BX_PANIC(("Cannot detect qcow2 image header"));
+    return;
+  }
+  ::close(temp_fd);
+  close();
+  if (!hdimage_copy_file(backup_fname, pathname)) {
+    BX_PANIC(("Failed to restore qcow2 image '%s'", pathname));
+    return;
+  }
+  device_image_t::open(pathname);
+}
+#endif
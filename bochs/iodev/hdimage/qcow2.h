@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  QEMU copy-on-write (qcow2) disk image support
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+/////////////////////////////////////////////////////////////////////////
+
+#ifndef BX_QCOW2IMG_H
+#define BX_QCOW2IMG_H
+
+#define QCOW2_MAGIC 0x514649fb  // "QFI\xfb"
+
+#define QCOW2_DEFAULT_CLUSTER_BITS 16
+#define QCOW2_MIN_CLUSTER_BITS     9
+#define QCOW2_MAX_CLUSTER_BITS     21
+#define QCOW2_MAX_BACKING_DEPTH    16
+
+// L1 / L2 table entry flags
+#define QCOW2_OFLAG_COPIED     BX_CONST64(0x8000000000000000)
+#define QCOW2_OFLAG_COMPRESSED BX_CONST64(0x4000000000000000)
+#define QCOW2_OFLAG_ZERO       BX_CONST64(0x0000000000000001)
+#define QCOW2_OFFSET_MASK      BX_CONST64(0x00fffffffffffe00)
+
+// QCOW2_BE*: convert disk (big endian) to host endianness and vice versa
+#if defined (BX_LITTLE_ENDIAN)
+#define QCOW2_BE16(val) bx_bswap16(val)
+#define QCOW2_BE32(val) bx_bswap32(val)
+#define QCOW2_BE64(val) bx_bswap64(val)
+#else
+#define QCOW2_BE16(val) (val)
+#define QCOW2_BE32(val) (val)
+#define QCOW2_BE64(val) (val)
+#endif
+
+#if defined(_MSC_VER)
+#pragma pack(push, 1)
+#elif defined(__MWERKS__) && defined(macintosh)
+#pragma options align=packed
+#endif
+
+// always big-endian on disk
+typedef struct
+{
+  Bit32u magic;
+  Bit32u version;
+  Bit64u backing_file_offset;
+  Bit32u backing_file_size;
+  Bit32u cluster_bits;
+  Bit64u size;
+  Bit32u crypt_method;
+  Bit32u l1_size;
+  Bit64u l1_table_offset;
+  Bit64u refcount_table_offset;
+  Bit32u refcount_table_clusters;
+  Bit32u nb_snapshots;
+  Bit64u snapshots_offset;
+  // version 3 only
+  Bit64u incompatible_features;
+  Bit64u compatible_features;
+  Bit64u autoclear_features;
+  Bit32u refcount_order;
+  Bit32u header_length;
+}
+#if !defined(_MSC_VER)
+GCC_ATTRIBUTE((packed))
+#endif
+qcow2_header_t;
+
+#if defined(_MSC_VER)
+#pragma pack(pop)
+#elif defined(__MWERKS__) && defined(macintosh)
+#pragma options align=reset
+#endif
+
+#define QCOW2_V2_HEADER_SIZE 72
+#define QCOW2_V3_HEADER_SIZE 104
+
+class qcow2_image_t : public device_image_t
+{
+  public:
+    qcow2_image_t();
+    virtual ~qcow2_image_t();
+
+    int open(const char* pathname, int flags);
+    void close();
+    Bit64s lseek(Bit64s offset, int whence);
+    ssize_t read(void* buf, size_t count);
+    ssize_t write(const void* buf, size_t count);
+
+    static int check_format(int fd, Bit64u imgsize);
+
+#ifdef BXIMAGE
+    // must be called before create_image() to create a thin clone
+    void set_backing_file(const char *filename) { backing_file = filename; }
+    int create_image(const char *pathname, Bit64u size);
+    int get_alloc_status(Bit64u offset, Bit64u *count);
+    // stores a deflate (windowBits -12) compressed cluster
+    bool write_compressed(Bit64u offset, const Bit8u *zdata, Bit32u zlen);
+    Bit32u get_cluster_size() const { return cluster_size; }
+#else
+    bool save_state(const char *backup_fname);
+    void restore_state(const char *backup_fname);
+#endif
+
+  private:
+    bool read_header();
+    bool open_backing_file();
+    int  get_l2_table(Bit32u l1_index, bool alloc);
+    bool get_cluster_entry(Bit64u offset, Bit64u *entry);
+    bool read_cluster(Bit64u offset, Bit64u entry, Bit8u *buf);
+    bool read_compressed(Bit64u entry);
+    bool read_backing(Bit64u offset, Bit8u *buf, size_t count);
+    bool is_data_cluster(Bit64u entry) const;
+    Bit64s alloc_clusters(unsigned count);
+    bool free_compressed(Bit64u entry);
+    bool update_refcount(Bit64u cluster, int addend);
+    bool flush_refcount_block();
+    bool grow_refcount_table(Bit64u min_entries);
+    void flush();
+    static bool l2_writeback(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data);
+
+    int fd;
+    qcow2_header_t header;  // host byte order
+    bool read_only;
+    Bit32u cluster_size;
+    Bit32u l2_bits;
+    Bit64u *l1_table;       // host byte order
+    Bit64u *refcount_table; // host byte order
+    Bit64u refcount_table_size;
+    Bit8u  *refcount_block; // disk byte order, write-back of the changed range
+    Bit64u refcount_block_offset;
+    int    refcount_dirty_first;
+    int    refcount_dirty_last;
+    hdimage_block_cache_c l2_cache;  // disk byte order
+    Bit8u  *cluster_buf;    // copy-on-write buffer
+    Bit8u  *zbuf;           // compressed cluster data
+    Bit8u  *zcache;         // last decompressed cluster
+    Bit64u zcache_entry;
+    Bit64u end_offset;
+    Bit64u cur_offset;
+    device_image_t *backing;
+    char   *backing_path;
+    Bit64u backing_size;
+    const char *pathname;
+#ifdef BXIMAGE
+    const char *backing_file;
+    Bit64u zwrite_offset;   // next free byte for compressed clusters
+    Bit64u zwrite_end;      // end of the clusters allocated for them
+#endif
+};
+
+#endif
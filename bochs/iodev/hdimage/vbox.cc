@@ -90,9 +90,9 @@ vbox_image_t::vbox_image_t()
   : file_descriptor(-1),
   mtlb(0),
   block_data(0),
+  block_slot(-1),
   current_offset(INVALID_OFFSET),
   mtlb_sector(0),
-  is_dirty(0),
   mtlb_dirty(0),
   header_dirty(0)
 {
@@ -123,12 +123,12 @@ int vbox_image_t::open(const char* _pathname, int flags)
     return -1;
   }
 
-  // allocate one block of memory
-  block_data = new Bit8u[(unsigned) header.block_size];
-  if (block_data == 0) {
+  // allocate the block cache
+  if (!block_cache.init(header.block_size, 0, block_writeback, this)) {
     BX_PANIC(("unable to allocate %d bytes for vbox block size", header.block_size));
   }
-  is_dirty = 0;
+  block_data = 0;
+  block_slot = -1;
   mtlb_dirty = 0;
   header_dirty = 0;
 
@@ -147,9 +147,6 @@ int vbox_image_t::open(const char* _pathname, int flags)
       BX_PANIC(("did not read in map table"));
   }
 
-  // read in the first index so that we have something in memory
-  read_block(0);
-
   mtlb_sector = 0;
   current_offset = 0;
 
@@ -182,23 +179,10 @@ void vbox_image_t::close()
 
   flush();
 
-  // write the map back to the disk
-  if (mtlb_dirty) {
-    if (bx_write_image(file_descriptor, header.offset_blocks, mtlb, (unsigned) header.blocks_in_hdd * sizeof(Bit32u))
-        != (ssize_t)(header.blocks_in_hdd * sizeof(Bit32u))) {
-        BX_PANIC(("did not write map table"));
-    }
-  }
-
-  // write header back to image
-  if (header_dirty) {
-    if (bx_write_image(file_descriptor, 0, &header, sizeof(VBOX_VDI_Header)) != sizeof(VBOX_VDI_Header)) {
-      BX_PANIC(("did not write header"));
-    }
-  }
-
   delete [] mtlb; mtlb = 0;
-  delete [] block_data; block_data = 0;
+  block_cache.cleanup();
+  block_data = 0;
+  block_slot = -1;
 
   bx_close_image(file_descriptor, pathname);
   file_descriptor = -1;
@@ -260,12 +244,12 @@ ssize_t vbox_image_t::write(const void *buf, size_t count)
     off_t writesize = ((off_t)count > writable) ? writable : count;
     off_t offset = current_offset & (header.block_size - 1);
     memcpy(block_data + offset, cbuf, (size_t) writesize);
+    block_cache.set_dirty(block_slot);
 
     current_offset += writesize;
     total += (long) writesize;
     cbuf += writesize;
     count -= (size_t) writesize;
-    is_dirty = 1;
   }
   return total;
 }
@@ -345,31 +329,52 @@ off_t vbox_image_t::perform_seek()
 
   Bit32u index = (Bit32u) (current_offset / header.block_size);
 
-  if (mtlb_sector == index) {
-    return header.block_size - (current_offset & (header.block_size - 1));
-  } else {
-    flush();
-
-    read_block(index);
+  if ((block_slot < 0) || (mtlb_sector != index)) {
+    int slot = block_cache.find(index);
+    if (slot < 0) {
+      slot = block_cache.alloc(index, 0);
+      if (slot < 0) {
+        BX_ERROR(("vbox image: failed to write back cached block"));
+        return INVALID_OFFSET;
+      }
+      read_block(index, block_cache.data(slot));
+    }
+    block_slot = slot;
+    block_data = block_cache.data(slot);
     mtlb_sector = index;
-
-    return header.block_size;
   }
+
+  return header.block_size - (current_offset & (header.block_size - 1));
 }
 
 void vbox_image_t::flush()
 {
-  if (!is_dirty)
-    return;
-
   //
-  // Write dirty sectors to disk.
+  // Write dirty blocks to disk.
   //
-  write_block(mtlb_sector);
-  is_dirty = 0;
+  if (!block_cache.flush()) {
+    BX_ERROR(("vbox image: failed to write back cached blocks"));
+  }
+
+  // write the map back to the disk
+  if (mtlb_dirty) {
+    if (bx_write_image(file_descriptor, header.offset_blocks, mtlb, (unsigned) header.blocks_in_hdd * sizeof(Bit32u))
+        != (ssize_t)(header.blocks_in_hdd * sizeof(Bit32u))) {
+        BX_PANIC(("did not write map table"));
+    }
+    mtlb_dirty = 0;
+  }
+
+  // write header back to image
+  if (header_dirty) {
+    if (bx_write_image(file_descriptor, 0, &header, sizeof(VBOX_VDI_Header)) != sizeof(VBOX_VDI_Header)) {
+      BX_PANIC(("did not write header"));
+    }
+    header_dirty = 0;
+  }
 }
 
-void vbox_image_t::read_block(const Bit32u index)
+void vbox_image_t::read_block(const Bit32u index, Bit8u *data)
 {
   off_t offset;
 
@@ -379,7 +384,7 @@ void vbox_image_t::read_block(const Bit32u index)
     if (header.image_type == 2) {
       BX_PANIC(("Found non-existing block in Static type image"));
     }
-    memset(block_data, 0, header.block_size);
+    memset(data, 0, header.block_size);
 
     BX_DEBUG(("reading empty block index %d", index));
   } else {
@@ -387,13 +392,18 @@ void vbox_image_t::read_block(const Bit32u index)
       BX_PANIC(("Trying to read past end of image (index out of range)"));
     }
     offset = dtoh32(mtlb[index]) * header.block_size;
-    bx_read_image(file_descriptor, header.offset_data + offset, block_data, header.block_size);
+    bx_read_image(file_descriptor, header.offset_data + offset, data, header.block_size);
 
     BX_DEBUG(("reading block index %d (%d) " FMT_LL "d", index, dtoh32(mtlb[index]), offset));
   }
 }
 
-void vbox_image_t::write_block(const Bit32u index)
+bool vbox_image_t::block_writeback(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data)
+{
+  return ((vbox_image_t*)this_ptr)->write_block((Bit32u)index, data);
+}
+
+bool vbox_image_t::write_block(const Bit32u index, Bit8u *data)
 {
   off_t offset;
 
@@ -417,7 +427,8 @@ void vbox_image_t::write_block(const Bit32u index)
 
   BX_DEBUG(("writing block index %d (%d) " FMT_LL "d", index, dtoh32(mtlb[index]), offset));
 
-  bx_write_image(file_descriptor, header.offset_data + offset, block_data, header.block_size);
+  return (bx_write_image(file_descriptor, header.offset_data + offset, data, header.block_size)
+          == (int) header.block_size);
 }
 
 Bit32u vbox_image_t::get_capabilities(void)
@@ -425,9 +436,29 @@ Bit32u vbox_image_t::get_capabilities(void)
   return HDIMAGE_HAS_GEOMETRY;
 }
 
-#ifndef BXIMAGE
+#ifdef BXIMAGE
+int vbox_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  Bit32u index = (Bit32u)(offset / header.block_size);
+  Bit64u len = (Bit64u)(index + 1) * header.block_size - offset;
+
+  // free (-1) and zero (-2) blocks are not stored in the image
+  if ((index >= header.blocks_in_hdd) || (block_cache.find(index) >= 0))
+    return 1;
+  int status = (dtoh32(mtlb[index]) >= 0);
+  while ((len < *count) && (++index < header.blocks_in_hdd) &&
+         (block_cache.find(index) < 0) && ((dtoh32(mtlb[index]) >= 0) == status)) {
+    len += header.block_size;
+  }
+  if (len < *count) {
+    *count = len;
+  }
+  return status;
+}
+#else
 bool vbox_image_t::save_state(const char *backup_fname)
 {
+  flush();
   return hdimage_backup_file(file_descriptor, backup_fname);
 }
 
@@ -89,7 +89,9 @@ class vbox_image_t : public device_image_t
         Bit32u get_capabilities();
         static int check_format(int fd, Bit64u imgsize);
 
-#ifndef BXIMAGE
+#ifdef BXIMAGE
+        int get_alloc_status(Bit64u offset, Bit64u *count);
+#else
         bool save_state(const char *backup_fname);
         void restore_state(const char *backup_fname);
 #endif
@@ -103,16 +105,18 @@ class vbox_image_t : public device_image_t
         bool read_header();
         off_t perform_seek();
         void flush();
-        void read_block(const Bit32u index);
-        void write_block(const Bit32u index);
+        void read_block(const Bit32u index, Bit8u *data);
+        bool write_block(const Bit32u index, Bit8u *data);
+        static bool block_writeback(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data);
 
         int file_descriptor;
         VBOX_VDI_Header header;
         Bit32s *mtlb;
+        hdimage_block_cache_c block_cache;
         Bit8u  *block_data;
+        int block_slot;
         off_t current_offset;
         Bit32u mtlb_sector;
-        bool is_dirty;
         bool mtlb_dirty;
         bool header_dirty;
         const char *pathname;
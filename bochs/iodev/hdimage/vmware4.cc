@@ -55,6 +55,11 @@
 const off_t vmware4_image_t::INVALID_OFFSET = (off_t)-1;
 const int vmware4_image_t::SECTOR_SIZE = 512;
 
+// number of grains read at once on sequential access
+#define VMWARE4_READAHEAD_GRAINS 4
+// number of cached grain tables
+#define VMWARE4_TABLE_SLOTS 16
+
 #ifndef BXIMAGE
 
 // disk image plugin entry point
@@ -88,9 +93,12 @@ protected:
 vmware4_image_t::vmware4_image_t()
   : file_descriptor(-1),
   tlb(0),
+  tlb_slot(-1),
   tlb_offset(INVALID_OFFSET),
   current_offset(INVALID_OFFSET),
-  is_dirty(0)
+  next_grain_offset(0),
+  readahead_buf(0),
+  readahead_grains(1)
 {
   if (sizeof(_VM4_Header) != 77) {
     BX_FATAL(("system error: invalid header structure size"));
@@ -119,13 +127,23 @@ int vmware4_image_t::open(const char* _pathname, int flags)
     return -1;
   }
 
-  tlb = new Bit8u[(unsigned)header.tlb_size_sectors * SECTOR_SIZE];
-  if (tlb == 0)
-    BX_PANIC(("unable to allocate " FMT_LL "d bytes for vmware4 image's tlb", header.tlb_size_sectors * SECTOR_SIZE));
+  Bit32u grain_size = (Bit32u)header.tlb_size_sectors * SECTOR_SIZE;
+  if (!grain_cache.init(grain_size, 0, grain_writeback, this) ||
+      !table_cache.init(header.slb_count * sizeof(Bit32u), VMWARE4_TABLE_SLOTS, NULL, this)) {
+    BX_PANIC(("unable to allocate the vmware4 image's grain cache"));
+    return -1;
+  }
+  readahead_grains = grain_cache.get_slots() - 1;
+  if (readahead_grains > VMWARE4_READAHEAD_GRAINS)
+    readahead_grains = VMWARE4_READAHEAD_GRAINS;
+  readahead_buf = new Bit8u[(size_t)grain_size * readahead_grains];
 
+  tlb = 0;
+  tlb_slot = -1;
   tlb_offset = INVALID_OFFSET;
   current_offset = 0;
-  is_dirty = 0;
+  // new grains are appended to the image file
+  next_grain_offset = ((imgsize + SECTOR_SIZE - 1) / SECTOR_SIZE) * SECTOR_SIZE;
 
   sect_size = SECTOR_SIZE;
   hd_size = header.total_sectors * sect_size;
@@ -149,7 +167,10 @@ void vmware4_image_t::close()
     return;
 
   flush();
-  delete [] tlb; tlb = 0;
+  grain_cache.cleanup();
+  table_cache.cleanup();
+  tlb = 0; tlb_slot = -1;
+  delete [] readahead_buf; readahead_buf = 0;
 
   bx_close_image(file_descriptor, pathname);
   file_descriptor = -1;
@@ -208,12 +229,12 @@ ssize_t vmware4_image_t::write(const void * buf, size_t count)
 
     off_t writesize = ((off_t)count > writable) ? writable : count;
     memcpy(tlb + current_offset - tlb_offset, cbuf, (size_t)writesize);
+    grain_cache.set_dirty(tlb_slot);
 
     current_offset += writesize;
     total += (long)writesize;
     cbuf += writesize;
     count -= (size_t)writesize;
-    is_dirty = 1;
   }
   return total;
 }
@@ -303,68 +324,157 @@ off_t vmware4_image_t::perform_seek()
     return INVALID_OFFSET;
   }
 
+  off_t grain_size = (off_t)header.tlb_size_sectors * SECTOR_SIZE;
+  Bit64u index = current_offset / grain_size;
+
   //
   // The currently loaded tlb can service the request.
   //
-  if (tlb_offset / (header.tlb_size_sectors * SECTOR_SIZE) == current_offset / (header.tlb_size_sectors * SECTOR_SIZE))
-    return (header.tlb_size_sectors * SECTOR_SIZE) - (current_offset - tlb_offset);
+  if ((tlb_slot < 0) || ((Bit64u)(tlb_offset / grain_size) != index)) {
+    int slot = grain_cache.find(index);
+    if (slot < 0) {
+      slot = load_grain(index);
+      if (slot < 0)
+        return INVALID_OFFSET;
+    }
+    tlb_slot = slot;
+    tlb = grain_cache.data(slot);
+    tlb_offset = index * grain_size;
+  }
 
-  flush();
+  return grain_size - (current_offset - tlb_offset);
+}
 
-  Bit64u index = current_offset / (header.tlb_size_sectors * SECTOR_SIZE);
-  Bit32u slb_index = (Bit32u)(index % header.slb_count);
-  Bit32u flb_index = (Bit32u)(index / header.slb_count);
+void vmware4_image_t::flush()
+{
+  if (!grain_cache.flush()) {
+    BX_ERROR(("vmware4 image: failed to write back cached grains"));
+  }
+}
+
+//
+// Returns the cache slot holding the grain table for the grain directory
+// entry 'flb_index'. The cached tables are updated with the image file.
+//
+int vmware4_image_t::load_grain_table(Bit32u flb_index)
+{
+  int slot = table_cache.find(flb_index);
+  if (slot >= 0)
+    return slot;
 
   Bit32u slb_sector = read_block_index(header.flb_offset_sectors, flb_index);
   Bit32u slb_copy_sector = read_block_index(header.flb_copy_offset_sectors, flb_index);
 
   if (slb_sector == 0 && slb_copy_sector == 0) {
     BX_DEBUG(("loaded vmware4 disk image requires un-implemented feature"));
-    return INVALID_OFFSET;
+    return -1;
   }
   if (slb_sector == 0)
     slb_sector = slb_copy_sector;
 
-  Bit32u tlb_sector = read_block_index(slb_sector, slb_index);
-  tlb_offset = index * header.tlb_size_sectors * SECTOR_SIZE;
-  if (tlb_sector == 0) {
-    //
-    // Allocate a new tlb
-    //
-    memset(tlb, 0, (size_t)header.tlb_size_sectors * SECTOR_SIZE);
+  int size = header.slb_count * sizeof(Bit32u);
+  slot = table_cache.alloc(flb_index, (Bit64s)slb_sector * SECTOR_SIZE);
+  if (bx_read_image(file_descriptor, (Bit64s)slb_sector * SECTOR_SIZE,
+                    table_cache.data(slot), size) != size) {
+    BX_ERROR(("vmware4 image: failed to read grain table"));
+    table_cache.drop(slot);
+    return -1;
+  }
+  return slot;
+}
 
-    //
-    // Instead of doing a write to increase the file size, we could use
-    // ftruncate but it is not portable.
-    //
-    off_t eof = ((::lseek(file_descriptor, 0, SEEK_END) + SECTOR_SIZE - 1) / SECTOR_SIZE) * SECTOR_SIZE;
-    ::write(file_descriptor, tlb, (unsigned)header.tlb_size_sectors * SECTOR_SIZE);
-    tlb_sector = (Bit32u)(eof / SECTOR_SIZE);
+//
+// Loads the grain 'index' into the grain cache and returns its slot. Grains
+// not present in the image are zero-filled and allocated on write back. On
+// sequential access the following grains are read with the same request
+// if they are stored contiguously in the image file.
+//
+int vmware4_image_t::load_grain(Bit64u index)
+{
+  Bit32u slb_index = (Bit32u)(index % header.slb_count);
+  Bit32u flb_index = (Bit32u)(index / header.slb_count);
+  Bit32u grain_size = (Bit32u)header.tlb_size_sectors * SECTOR_SIZE;
+  Bit64u grains = (header.total_sectors + header.tlb_size_sectors - 1) / header.tlb_size_sectors;
+  unsigned count = 1;
 
-    write_block_index(slb_sector, slb_index, tlb_sector);
-    write_block_index(slb_copy_sector, slb_index, tlb_sector);
+  int table = load_grain_table(flb_index);
+  if (table < 0)
+    return -1;
+  Bit32u *slb = (Bit32u*)table_cache.data(table);
+  Bit32u tlb_sector = dtoh32(slb[slb_index]);
+
+  if ((tlb_sector != 0) && grain_cache.sequential(index)) {
+    while ((count < readahead_grains) && ((slb_index + count) < header.slb_count) &&
+           ((index + count) < grains) &&
+           (dtoh32(slb[slb_index + count]) == (tlb_sector + count * header.tlb_size_sectors)) &&
+           (grain_cache.find(index + count) < 0)) {
+      count++;
+    }
+  }
+  grain_cache.set_last_miss(index + count - 1);
 
-    ::lseek(file_descriptor, eof, SEEK_SET);
-  } else {
-    ::lseek(file_descriptor, (off_t)tlb_sector * SECTOR_SIZE, SEEK_SET);
-    ::read(file_descriptor, tlb, (unsigned)header.tlb_size_sectors * SECTOR_SIZE);
-    ::lseek(file_descriptor, (off_t)tlb_sector * SECTOR_SIZE, SEEK_SET);
+  int slot = grain_cache.alloc(index, (Bit64s)tlb_sector * SECTOR_SIZE);
+  if (slot < 0)
+    return -1;
+  if (tlb_sector == 0) {
+    memset(grain_cache.data(slot), 0, grain_size);
+    return slot;
   }
 
-  return (header.tlb_size_sectors * SECTOR_SIZE) - (current_offset - tlb_offset);
+  Bit8u *buf = (count > 1) ? readahead_buf : grain_cache.data(slot);
+  int size = count * grain_size;
+  if (bx_read_image(file_descriptor, (Bit64s)tlb_sector * SECTOR_SIZE, buf, size) != size) {
+    BX_ERROR(("vmware4 image: failed to read grain " FMT_LL "d", index));
+    grain_cache.drop(slot);
+    return -1;
+  }
+  if (count > 1) {
+    memcpy(grain_cache.data(slot), buf, grain_size);
+    for (unsigned i = 1; i < count; i++) {
+      int next = grain_cache.alloc(index + i, (Bit64s)(tlb_sector + i * header.tlb_size_sectors) * SECTOR_SIZE);
+      if (next < 0)
+        break;
+      memcpy(grain_cache.data(next), buf + i * grain_size, grain_size);
+    }
+    // keep the requested grain as the most recently used one
+    slot = grain_cache.find(index);
+  }
+  return slot;
 }
 
-void vmware4_image_t::flush()
+bool vmware4_image_t::grain_writeback(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data)
 {
-  if (!is_dirty)
-    return;
+  return ((vmware4_image_t*)this_ptr)->write_grain(index, offset, data);
+}
 
-  //
-  // Write dirty sectors to disk first. Assume that the file is already at the
-  // position for the current tlb.
-  //
-  ::write(file_descriptor, tlb, (unsigned)header.tlb_size_sectors * SECTOR_SIZE);
-  is_dirty = 0;
+bool vmware4_image_t::write_grain(Bit64u index, Bit64s *offset, Bit8u *data)
+{
+  int grain_size = (int)header.tlb_size_sectors * SECTOR_SIZE;
+
+  if (*offset == 0) {
+    //
+    // Allocate a new grain at the end of the image file
+    //
+    Bit32u slb_index = (Bit32u)(index % header.slb_count);
+    Bit32u flb_index = (Bit32u)(index / header.slb_count);
+    int table = load_grain_table(flb_index);
+    if (table < 0)
+      return 0;
+    if (bx_write_image(file_descriptor, next_grain_offset, data, grain_size) != grain_size)
+      return 0;
+    *offset = next_grain_offset;
+    next_grain_offset += grain_size;
+
+    Bit32u tlb_sector = (Bit32u)(*offset / SECTOR_SIZE);
+    Bit32u slb_sector = (Bit32u)(table_cache.get_offset(table) / SECTOR_SIZE);
+    Bit32u slb_copy_sector = read_block_index(header.flb_copy_offset_sectors, flb_index);
+    ((Bit32u*)table_cache.data(table))[slb_index] = htod32(tlb_sector);
+    write_block_index(slb_sector, slb_index, tlb_sector);
+    if ((slb_copy_sector != 0) && (slb_copy_sector != slb_sector))
+      write_block_index(slb_copy_sector, slb_index, tlb_sector);
+    return 1;
+  }
+  return (bx_write_image(file_descriptor, *offset, data, grain_size) == grain_size);
 }
 
 Bit32u vmware4_image_t::read_block_index(Bit64u sector, Bit32u index)
@@ -391,6 +501,36 @@ Bit32u vmware4_image_t::get_capabilities(void)
 }
 
 #ifdef BXIMAGE
+int vmware4_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  Bit32u grain_size = (Bit32u)header.tlb_size_sectors * SECTOR_SIZE;
+  Bit64u grains = (header.total_sectors + header.tlb_size_sectors - 1) / header.tlb_size_sectors;
+  Bit64u index = offset / grain_size;
+  Bit64u len = 0;
+  int status = -1;
+
+  while ((len < *count) && (index < grains)) {
+    int allocated = 1;
+    if (grain_cache.find(index) < 0) {
+      int table = load_grain_table((Bit32u)(index / header.slb_count));
+      if (table >= 0) {
+        Bit32u *slb = (Bit32u*)table_cache.data(table);
+        allocated = (dtoh32(slb[index % header.slb_count]) != 0);
+      }
+    }
+    if (status < 0) {
+      status = allocated;
+    } else if (allocated != status) {
+      break;
+    }
+    len = ++index * grain_size - offset;
+  }
+  if ((status >= 0) && (len < *count)) {
+    *count = len;
+  }
+  return (status != 0);
+}
+
 int vmware4_image_t::create_image(const char *pathname, Bit64u size)
 {
   const int SECTOR_SIZE = 512;
@@ -503,6 +643,7 @@ int vmware4_image_t::create_image(const char *pathname, Bit64u size)
 #else
 bool vmware4_image_t::save_state(const char *backup_fname)
 {
+  flush();
   return hdimage_backup_file(file_descriptor, backup_fname);
 }
 
@@ -79,6 +79,7 @@ class vmware4_image_t : public device_image_t
 
 #ifdef BXIMAGE
         int create_image(const char *pathname, Bit64u size);
+        int get_alloc_status(Bit64u offset, Bit64u *count);
 #else
         bool save_state(const char *backup_fname);
         void restore_state(const char *backup_fname);
@@ -93,15 +94,24 @@ class vmware4_image_t : public device_image_t
         bool read_header();
         off_t perform_seek();
         void flush();
+        int load_grain_table(Bit32u flb_index);
+        int load_grain(Bit64u index);
+        bool write_grain(Bit64u index, Bit64s *offset, Bit8u *data);
+        static bool grain_writeback(void *this_ptr, Bit64u index, Bit64s *offset, Bit8u *data);
         Bit32u read_block_index(Bit64u sector, Bit32u index);
         void write_block_index(Bit64u sector, Bit32u index, Bit32u block_sector);
 
         int file_descriptor;
         VM4_Header header;
+        hdimage_block_cache_c grain_cache;  // data grains
+        hdimage_block_cache_c table_cache;  // grain tables (write-through)
         Bit8u* tlb;
+        int tlb_slot;
         off_t tlb_offset;
         off_t current_offset;
-        bool is_dirty;
+        Bit64s next_grain_offset;
+        Bit8u* readahead_buf;
+        unsigned readahead_grains;
         const char *pathname;
 };
 
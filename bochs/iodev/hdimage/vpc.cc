@@ -127,6 +127,8 @@ int vpc_image_t::open(const char* _pathname, int flags)
   int disk_type;
 
   pathname = _pathname;
+  pagetable = NULL;
+  bitmap_valid = NULL;
   if ((fd = hdimage_open_file(pathname, flags, &imgsize, &mtime)) < 0) {
     BX_ERROR(("VPC: cannot open hdimage file '%s'", pathname));
     return -1;
@@ -246,7 +248,8 @@ int vpc_image_t::open(const char* _pathname, int flags)
       }
     }
 
-    last_bitmap_offset = (Bit64s) -1;
+    bitmap_valid = new Bit8u[max_table_entries];
+    memset(bitmap_valid, 0, max_table_entries);
   }
   cur_sector = 0;
 
@@ -259,7 +262,11 @@ void vpc_image_t::close(void)
 {
   if (fd > -1) {
     delete [] pagetable;
+    pagetable = NULL;
+    delete [] bitmap_valid;
+    bitmap_valid = NULL;
     bx_close_image(fd, pathname);
+    fd = -1;
   }
 }
 
@@ -300,10 +307,10 @@ ssize_t vpc_image_t::read(void* buf, size_t count)
     }
 
     if (offset == -1) {
-      memset(buf, 0, 512);
+      memset(cbuf, 0, (size_t)sectors * 512);
     } else {
       ret = bx_read_image(fd, offset, cbuf, (int)sectors * 512);
-      if (ret != 512) {
+      if (ret != sectors * 512) {
         return -1;
       }
     }
@@ -359,6 +366,26 @@ Bit32u vpc_image_t::get_capabilities(void)
 }
 
 #ifdef BXIMAGE
+int vpc_image_t::get_alloc_status(Bit64u offset, Bit64u *count)
+{
+  if (pagetable == NULL)
+    return 1; // fixed size image
+  Bit32u index = (Bit32u)(offset / block_size);
+  Bit64u len = (Bit64u)(index + 1) * block_size - offset;
+
+  if (index >= (Bit32u)max_table_entries)
+    return 1;
+  int status = (pagetable[index] != 0xffffffff);
+  while ((len < *count) && (++index < (Bit32u)max_table_entries) &&
+         ((pagetable[index] != 0xffffffff) == status)) {
+    len += block_size;
+  }
+  if (len < *count) {
+    *count = len;
+  }
+  return status;
+}
+
 int vpc_image_t::create_image(const char *pathname, Bit64u size)
 {
   Bit8u buf[1024];
@@ -501,11 +528,11 @@ Bit64s vpc_image_t::get_sector_offset(Bit64s sector_num, int write)
   // unused in the bitmap. We get away with setting all bits in the block
   // bitmap each time we write to a new block. This might cause Virtual PC to
   // miss sparse read optimization, but it's not a problem in terms of
-  // correctness.
-  if (write && (last_bitmap_offset != bitmap_offset)) {
+  // correctness. Each bitmap is written only once per session.
+  if (write && !bitmap_valid[pagetable_index]) {
     Bit8u *bitmap = new Bit8u[bitmap_size];
 
-    last_bitmap_offset = bitmap_offset;
+    bitmap_valid[pagetable_index] = 1;
     memset(bitmap, 0xff, bitmap_size);
     bx_write_image(fd, bitmap_offset, bitmap, bitmap_size);
     delete [] bitmap;
@@ -565,6 +592,7 @@ Bit64s vpc_image_t::alloc_block(Bit64s sector_num)
   if (ret < 0) {
     return ret;
   }
+  bitmap_valid[index] = 1;
 
   // Write new footer (the old one will be overwritten)
   old_fdbo = free_data_block_offset;
@@ -167,6 +167,7 @@ class vpc_image_t : public device_image_t
 
 #ifdef BXIMAGE
     int create_image(const char *pathname, Bit64u size);
+    int get_alloc_status(Bit64u offset, Bit64u *count);
 #else
     bool save_state(const char *backup_fname);
     void restore_state(const char *backup_fname);
@@ -184,8 +185,8 @@ class vpc_image_t : public device_image_t
     Bit64u free_data_block_offset;
     int max_table_entries;
     Bit64u bat_offset;
-    Bit64u last_bitmap_offset;
     Bit32u *pagetable;
+    Bit8u *bitmap_valid;  // block bitmap already marks all sectors as used
 
     Bit32u block_size;
     Bit32u bitmap_size;
@@ -144,7 +144,7 @@ typedef struct {
     struct {
       memory_handler_t rh;
       memory_handler_t wh;
-      const Bit8u *dummy;
+      memory_direct_access_handler_t da;
     } mem;
     struct {
       bx_read_handler_t rh;
@@ -172,7 +172,8 @@ public:
                      Bit8u headt, Bit8u intpin);
   void init_bar_io(Bit8u num, Bit16u size, bx_read_handler_t rh,
                    bx_write_handler_t wh, const Bit8u *mask);
-  void init_bar_mem(Bit8u num, Bit32u size, memory_handler_t rh, memory_handler_t wh);
+  void init_bar_mem(Bit8u num, Bit32u size, memory_handler_t rh, memory_handler_t wh,
+                    memory_direct_access_handler_t da = NULL);
   void register_pci_state(bx_list_c *list);
   void after_restore_pci_state(memory_handler_t mem_read_handler);
   void load_pci_rom(const char *path);
@@ -450,7 +451,8 @@ public:
   bool register_pci_handlers(bx_pci_device_c *device, Bit8u *devfunc,
                              const char *name, const char *descr, Bit8u bus = 0);
   bool pci_set_base_mem(void *this_ptr, memory_handler_t f1, memory_handler_t f2,
-                        Bit32u *addr, Bit8u *pci_conf, unsigned size);
+                        Bit32u *addr, Bit8u *pci_conf, unsigned size,
+                        memory_direct_access_handler_t da = NULL);
   bool pci_set_base_io(void *this_ptr, bx_read_handler_t f1, bx_write_handler_t f2,
                        Bit32u *addr, Bit8u *pci_conf, unsigned size,
                        const Bit8u *iomask, const char *name);
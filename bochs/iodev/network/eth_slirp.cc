@@ -31,6 +31,7 @@
 #include "plugin.h"
 #include "pc_system.h"
 #include "netmod.h"
+#include "bxthread.h"
 
 #if BX_NETWORKING && BX_NETMOD_SLIRP
 
@@ -66,8 +67,31 @@ typedef ssize_t slirp_ssize_t;
 #endif
 #include <signal.h>
 
+// on Linux the slirp sockets stay registered in an epoll set, so that only
+// changes of the requested events cost a system call
+#if defined(__linux__)
+#define BX_SLIRP_EPOLL 1
+#include <sys/epoll.h>
+#else
+#define BX_SLIRP_EPOLL 0
+#endif
+
 static unsigned int bx_slirp_instances = 0;
 
+// Each slirp instance runs on its own network thread, but the slirp code
+// keeps some state in globals (the clock, the DNS cache timestamps). All
+// calls into slirp are serialized with this lock, it is released while the
+// network threads wait for socket events.
+static BX_MUTEX(slirp_lock);
+static bool slirp_lock_initialized = 0;
+
+struct timer {
+    SlirpTimerId id;
+    void *cb_opaque;
+    int64_t expire;
+    struct timer *next;
+};
+
 // network driver plugin entry point
 
 PLUGIN_ENTRY_FOR_NET_MODULE(slirp)
@@ -84,9 +108,8 @@ PLUGIN_ENTRY_FOR_NET_MODULE(slirp)
 
 #define MAX_HOSTFWD 5
 
-static int rx_timer_index = BX_NULL_TIMER_HANDLE;
-fd_set rfds, wfds, xfds;
-int nfds;
+// maximum time the network thread waits for socket events (msec)
+#define SLIRP_POLL_TIMEOUT 10
 
 class bx_slirp_pktmover_c : public eth_pktmover_c {
 public:
@@ -97,6 +120,18 @@ public:
   void sendpkt(void *buf, unsigned io_len);
   slirp_ssize_t receive(void *pkt, unsigned pkt_len);
   void slirp_msg(bool error, const char *msg);
+  int64_t get_clock_ns() const {return vclock_ns;}
+  void net_thread_main(void);
+  int select_add(int fd, int events);
+  int select_get_revents(int fd);
+#if BX_SLIRP_EPOLL
+  int epoll_add(int fd, int events);
+  int epoll_get_revents(int fd);
+  void epoll_remove(int fd);
+#endif
+  // state of the slirp callbacks, used with slirp_lock held
+  struct timer *timer_queue;
+  int npoll;
 private:
   Slirp *slirp;
   unsigned netdev_speed;
@@ -115,6 +150,50 @@ private:
 
   logfunctions *slirplog;
 
+  // slirp runs on a network thread, frames are exchanged with the
+  // simulation thread through lock-free queues
+  bx_packet_queue_c txq;  // guest to host
+  bx_packet_queue_c rxq;  // host to guest
+  BX_THREAD_VAR(net_thread);
+  bool net_thread_started;
+  volatile bool net_thread_stop;
+  volatile bool net_thread_waiting;
+#ifdef WIN32
+  bx_thread_sem_t wakeup_sem;
+#else
+  int wakeup_fd[2];
+#endif
+  volatile int64_t vclock_ns; // simulation time, updated by the rx timer
+  int rx_timer_index;
+
+  fd_set rfds, wfds, xfds;
+  int nfds;
+
+  void wakeup(void);
+  void select_cycle(Bit32u timeout);
+  void deliver_packets(void);
+
+#if BX_SLIRP_EPOLL
+  typedef struct {
+    Bit32u events;  // events registered in the epoll set (0 = not registered)
+    Bit32u revents; // events reported by epoll_wait()
+    Bit32u tick;    // last poll cycle that requested the fd
+    Bit32u rtick;   // poll cycle of the 'revents' value
+    int list_idx;   // index in 'epoll_list'
+  } slirp_pollfd_t;
+
+  int epoll_fd;
+  Bit32u poll_tick;
+  slirp_pollfd_t *pollfds;
+  int pollfds_size;
+  int *epoll_list;  // registered fds
+  int epoll_count;
+  int epoll_list_size;
+  struct epoll_event *epoll_events;
+
+  void epoll_cycle(Bit32u timeout);
+#endif
+
   bool parse_slirp_conf(const char *conf);
   static void rx_timer_handler(void *);
   void rx_timer(void);
@@ -156,18 +235,9 @@ static void guest_error(const char *msg, void *opaque)
 
 static int64_t clock_get_ns(void *opaque)
 {
-  return bx_pc_system.time_usec() * 1000;
+  return ((bx_slirp_pktmover_c*)opaque)->get_clock_ns();
 }
 
-struct timer {
-    SlirpTimerId id;
-    void *cb_opaque;
-    int64_t expire;
-    struct timer *next;
-};
-
-static struct timer *timer_queue;
-
 static void *timer_new_opaque(SlirpTimerId id, void *cb_opaque, void *opaque)
 {
   ((bx_slirp_pktmover_c*)opaque)->slirp_msg(false, "timer_new_opaque()");
@@ -178,33 +248,40 @@ static void *timer_new_opaque(SlirpTimerId id, void *cb_opaque, void *opaque)
   return new_timer;
 }
 
-static void timer_free(void *_timer, void *opaque)
+static void timer_unlink(struct timer **queue, struct timer *timer1)
 {
-  ((bx_slirp_pktmover_c*)opaque)->slirp_msg(false, "timer_free()");
-  struct timer *timer1 = (timer*)_timer;
-  struct timer **t;
-
-  for (t = &timer_queue; *t != NULL; *t = (*t)->next) {
+  for (struct timer **t = queue; *t != NULL; t = &(*t)->next) {
     if (*t == timer1) {
       /* Not expired yet, drop it */
       *t = timer1->next;
       break;
     }
   }
+}
+
+static void timer_free(void *_timer, void *opaque)
+{
+  bx_slirp_pktmover_c *class_ptr = (bx_slirp_pktmover_c*)opaque;
+  class_ptr->slirp_msg(false, "timer_free()");
+  struct timer *timer1 = (timer*)_timer;
 
-  delete [] timer1;
+  timer_unlink(&class_ptr->timer_queue, timer1);
+  delete timer1;
 }
 
 static void timer_mod(void *_timer, int64_t expire_time, void *opaque)
 {
-  ((bx_slirp_pktmover_c*)opaque)->slirp_msg(false, "timer_mod()");
+  bx_slirp_pktmover_c *class_ptr = (bx_slirp_pktmover_c*)opaque;
+  class_ptr->slirp_msg(false, "timer_mod()");
   struct timer *timer1 = (timer*)_timer;
   struct timer **t;
 
+  // a timer may be modified while it is queued
+  timer_unlink(&class_ptr->timer_queue, timer1);
   timer1->expire = expire_time * 1000 * 1000;
 
-  for (t = &timer_queue; *t != NULL; *t = (*t)->next) {
-    if (expire_time < (*t)->expire)
+  for (t = &class_ptr->timer_queue; *t != NULL; t = &(*t)->next) {
+    if (timer1->expire < (*t)->expire)
       break;
   }
 
@@ -212,16 +289,18 @@ static void timer_mod(void *_timer, int64_t expire_time, void *opaque)
   *t = timer1;
 }
 
-static int npoll;
-
 static void register_poll_fd(int fd, void *opaque)
 {
-  npoll++;
+  ((bx_slirp_pktmover_c*)opaque)->npoll++;
 }
 
 static void unregister_poll_fd(int fd, void *opaque)
 {
-  npoll--;
+  ((bx_slirp_pktmover_c*)opaque)->npoll--;
+#if BX_SLIRP_EPOLL
+  // the fd is closed after this call and its number may be reused
+  ((bx_slirp_pktmover_c*)opaque)->epoll_remove(fd);
+#endif
 }
 
 static void notify(void *opaque)
@@ -245,6 +324,12 @@ static struct SlirpCb callbacks = {
 static struct SlirpCb callbacks;
 #endif
 
+static BX_THREAD_FUNC(slirp_net_thread, indata)
+{
+  ((bx_slirp_pktmover_c*)indata)->net_thread_main();
+  BX_THREAD_EXIT;
+}
+
 bx_slirp_pktmover_c::bx_slirp_pktmover_c(const char *netif,
                                          const char *macaddr,
                                          eth_rx_handler_t rxh,
@@ -257,6 +342,30 @@ bx_slirp_pktmover_c::bx_slirp_pktmover_c(const char *netif,
   slirp = NULL;
   pktlog_fn = NULL;
   n_hostfwd = 0;
+  net_thread_started = 0;
+  net_thread_stop = 0;
+  net_thread_waiting = 0;
+  vclock_ns = bx_pc_system.time_usec() * 1000;
+  timer_queue = NULL;
+  npoll = 0;
+  if (!slirp_lock_initialized) {
+    BX_INIT_MUTEX(slirp_lock);
+    slirp_lock_initialized = 1;
+  }
+#if BX_SLIRP_EPOLL
+  poll_tick = 0;
+  pollfds = NULL;
+  pollfds_size = 0;
+  epoll_list = NULL;
+  epoll_count = 0;
+  epoll_list_size = 0;
+  // one more entry for the wakeup pipe of the network thread
+  epoll_events = (struct epoll_event*)malloc(sizeof(struct epoll_event));
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    BX_ERROR(("slirp: epoll_create1() failed, using select()"));
+  }
+#endif
 #if CPP_STD < 201703
   callbacks.send_packet = send_packet,
   callbacks.guest_error = guest_error,
@@ -305,14 +414,14 @@ bx_slirp_pktmover_c::bx_slirp_pktmover_c(const char *netif,
   Bit32u status = this->rxstat(this->netdev) & BX_NETDEV_SPEED;
   this->netdev_speed = (status == BX_NETDEV_1GBIT) ? 1000 :
                        (status == BX_NETDEV_100MBIT) ? 100 : 10;
-  if (bx_slirp_instances == 0) {
-    rx_timer_index =
-      DEV_register_timer(this, this->rx_timer_handler, 1000, 1, 1,
-                         "eth_slirp");
+  rx_timer_index =
+    DEV_register_timer(this, this->rx_timer_handler, 1000, 1, 1,
+                       "eth_slirp");
 #ifndef WIN32
+  if (bx_slirp_instances == 0) {
     signal(SIGPIPE, SIG_IGN);
-#endif
   }
+#endif
 
   if ((strlen(script) > 0) && (strcmp(script, "none"))) {
     if (!parse_slirp_conf(script)) {
@@ -330,6 +439,8 @@ bx_slirp_pktmover_c::bx_slirp_pktmover_c(const char *netif,
   slirplog = new logfunctions();
   sprintf(prefix, "SLIRP%d", bx_slirp_instances);
   slirplog->put(prefix);
+  // other instances may already be running on their network threads
+  BX_LOCK(slirp_lock);
   slirp = slirp_new(&config, &callbacks, this);
 #if !BX_HAVE_LIBSLIRP
   if (debug_switches != 0) {
@@ -350,6 +461,7 @@ bx_slirp_pktmover_c::bx_slirp_pktmover_c(const char *netif,
     }
   }
 #endif
+  BX_UNLOCK(slirp_lock);
   if (pktlog_fn != NULL) {
     pktlog_txt = fopen(pktlog_fn, "wb");
     slirp_logging = (pktlog_txt != NULL);
@@ -372,11 +484,46 @@ bx_slirp_pktmover_c::bx_slirp_pktmover_c(const char *netif,
     slirp_logging = 0;
   }
   bx_slirp_instances++;
+  if (slirp != NULL) {
+#ifdef WIN32
+    bx_create_sem(&wakeup_sem);
+#else
+    if (pipe(wakeup_fd) < 0) {
+      BX_PANIC(("slirp: failed to create wakeup pipe"));
+    }
+    fcntl(wakeup_fd[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeup_fd[1], F_SETFL, O_NONBLOCK);
+#if BX_SLIRP_EPOLL
+    if (epoll_fd >= 0) {
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.fd = wakeup_fd[0];
+      epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd[0], &ev);
+    }
+#endif
+#endif
+    BX_THREAD_CREATE(slirp_net_thread, this, net_thread);
+    net_thread_started = 1;
+  }
 }
 
 bx_slirp_pktmover_c::~bx_slirp_pktmover_c()
 {
+  bx_pc_system.deactivate_timer(rx_timer_index);
+  if (net_thread_started) {
+    net_thread_stop = 1;
+    wakeup();
+    BX_THREAD_JOIN(net_thread);
+#ifdef WIN32
+    bx_destroy_sem(&wakeup_sem);
+#else
+    close(wakeup_fd[0]);
+    close(wakeup_fd[1]);
+#endif
+  }
   if (slirp != NULL) {
+    BX_LOCK(slirp_lock);
     slirp_cleanup(slirp);
 #ifndef WIN32
     if ((smb_export != NULL) && (smb_tmpdir != NULL)) {
@@ -385,6 +532,7 @@ bx_slirp_pktmover_c::~bx_slirp_pktmover_c()
       free(smb_export);
     }
 #endif
+    BX_UNLOCK(slirp_lock);
     if (config.bootfile != NULL) free((void*)config.bootfile);
     if (config.vhostname != NULL) free((void*)config.vhostname);
     if (config.tftp_server_name != NULL) free((void*)config.tftp_server_name);
@@ -398,16 +546,25 @@ bx_slirp_pktmover_c::~bx_slirp_pktmover_c()
     while (n_hostfwd > 0) {
       free(hostfwd[--n_hostfwd]);
     }
-    if (--bx_slirp_instances == 0) {
-      bx_pc_system.deactivate_timer(rx_timer_index);
 #ifndef WIN32
+    if (--bx_slirp_instances == 0) {
       signal(SIGPIPE, SIG_DFL);
-#endif
     }
+#else
+    --bx_slirp_instances;
+#endif
     if (slirp_logging) {
       fclose(pktlog_txt);
     }
   }
+#if BX_SLIRP_EPOLL
+  if (epoll_fd >= 0) {
+    close(epoll_fd);
+  }
+  free(pollfds);
+  free(epoll_list);
+  free(epoll_events);
+#endif
 }
 
 #if defined(WIN32)
@@ -595,7 +752,16 @@ void bx_slirp_pktmover_c::sendpkt(void *buf, unsigned io_len)
   if (slirp_logging) {
     write_pktlog_txt(pktlog_txt, (const Bit8u*)buf, io_len, 0);
   }
-  slirp_input(slirp, (Bit8u*)buf, io_len);
+  if (!txq.put(buf, io_len)) {
+    BX_ERROR(("slirp: tx queue full, packet dropped"));
+    return;
+  }
+  BX_MEMORY_BARRIER();
+  if (net_thread_waiting) {
+    net_thread_waiting = 0;
+    wakeup();
+  }
+  deliver_packets();
 }
 
 void bx_slirp_pktmover_c::rx_timer_handler(void *this_ptr)
@@ -604,63 +770,278 @@ void bx_slirp_pktmover_c::rx_timer_handler(void *this_ptr)
 }
 
 
-static int add_poll_cb(int fd, int events, void *opaque)
+void bx_slirp_pktmover_c::rx_timer(void)
+{
+  vclock_ns = bx_pc_system.time_usec() * 1000;
+  deliver_packets();
+}
+
+// called by the simulation thread: pass the frames queued by the network
+// thread to the device as long as it accepts them
+void bx_slirp_pktmover_c::deliver_packets(void)
+{
+  const Bit8u *pkt;
+  unsigned pkt_len;
+
+  while (!rxq.empty() && (this->rxstat(this->netdev) & BX_NETDEV_RXREADY)) {
+    pkt = rxq.peek(&pkt_len);
+    if (slirp_logging) {
+      write_pktlog_txt(pktlog_txt, pkt, pkt_len, 1);
+    }
+    this->rxh(this->netdev, pkt, pkt_len);
+    rxq.remove();
+  }
+}
+
+void bx_slirp_pktmover_c::wakeup(void)
 {
-    if (events & SLIRP_POLL_IN)
-        FD_SET(fd, &rfds);
-    if (events & SLIRP_POLL_OUT)
-        FD_SET(fd, &wfds);
-    if (events & SLIRP_POLL_PRI)
-        FD_SET(fd, &xfds);
-    if (nfds < fd)
-        nfds = fd;
-    return fd;
+#ifdef WIN32
+  bx_set_sem(&wakeup_sem);
+#else
+  char c = 0;
+  if (write(wakeup_fd[1], &c, 1) < 0) {
+    // pipe full: a wakeup is already pending
+  }
+#endif
 }
 
-static int get_revents_cb(int idx, void *opaque)
+void bx_slirp_pktmover_c::net_thread_main(void)
 {
-    int event = 0;
-    if (FD_ISSET(idx, &rfds))
-        event |= SLIRP_POLL_IN;
-    if (FD_ISSET(idx, &wfds))
-        event |= SLIRP_POLL_OUT;
-    if (FD_ISSET(idx, &xfds))
-        event |= SLIRP_POLL_PRI;
-    return event;
+  const Bit8u *pkt;
+  unsigned pkt_len;
+  Bit32u timeout;
+
+  while (!net_thread_stop) {
+    BX_LOCK(slirp_lock);
+    while ((pkt = txq.peek(&pkt_len)) != NULL) {
+      slirp_input(slirp, pkt, pkt_len);
+      txq.remove();
+    }
+    BX_UNLOCK(slirp_lock);
+    net_thread_waiting = 1;
+    BX_MEMORY_BARRIER();
+    timeout = txq.empty() ? SLIRP_POLL_TIMEOUT : 0;
+#if BX_SLIRP_EPOLL
+    if (epoll_fd >= 0) {
+      epoll_cycle(timeout);
+    } else
+#endif
+    select_cycle(timeout);
+    net_thread_waiting = 0;
+  }
 }
 
-void bx_slirp_pktmover_c::rx_timer(void)
+static int select_add_cb(int fd, int events, void *opaque)
+{
+  return ((bx_slirp_pktmover_c*)opaque)->select_add(fd, events);
+}
+
+static int select_revents_cb(int idx, void *opaque)
+{
+  return ((bx_slirp_pktmover_c*)opaque)->select_get_revents(idx);
+}
+
+int bx_slirp_pktmover_c::select_add(int fd, int events)
+{
+  if (events & SLIRP_POLL_IN)
+    FD_SET(fd, &rfds);
+  if (events & SLIRP_POLL_OUT)
+    FD_SET(fd, &wfds);
+  if (events & SLIRP_POLL_PRI)
+    FD_SET(fd, &xfds);
+  if (nfds < fd)
+    nfds = fd;
+  return fd;
+}
+
+int bx_slirp_pktmover_c::select_get_revents(int fd)
+{
+  int event = 0;
+  if (FD_ISSET(fd, &rfds))
+    event |= SLIRP_POLL_IN;
+  if (FD_ISSET(fd, &wfds))
+    event |= SLIRP_POLL_OUT;
+  if (FD_ISSET(fd, &xfds))
+    event |= SLIRP_POLL_PRI;
+  return event;
+}
+
+void bx_slirp_pktmover_c::select_cycle(Bit32u timeout)
 {
-  Bit32u timeout = 0;
   int ret;
 #ifdef WIN32
   TIMEVAL tv;
 #else
   struct timeval tv;
+  char buf[64];
 #endif
 
   nfds = -1;
   FD_ZERO(&rfds);
   FD_ZERO(&wfds);
   FD_ZERO(&xfds);
-  slirp_pollfds_fill(slirp, &timeout, add_poll_cb, this);
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
+  BX_LOCK(slirp_lock);
+  slirp_pollfds_fill(slirp, &timeout, select_add_cb, this);
+  BX_UNLOCK(slirp_lock);
+#ifdef WIN32
+  // winsock can't wait for the semaphore, so poll the sockets at 1 msec
+  if (nfds < 0) {
+    if (timeout > 0) {
+      bx_wait_sem_timeout(&wakeup_sem, timeout);
+    }
+    ret = 0;
+  } else {
+    if (timeout > 1) timeout = 1;
+    tv.tv_sec = 0;
+    tv.tv_usec = timeout * 1000;
+    ret = select(nfds + 1, &rfds, &wfds, &xfds, &tv);
+  }
+#else
+  FD_SET(wakeup_fd[0], &rfds);
+  if (nfds < wakeup_fd[0])
+    nfds = wakeup_fd[0];
+  tv.tv_sec = timeout / 1000;
+  tv.tv_usec = (timeout % 1000) * 1000;
   ret = select(nfds + 1, &rfds, &wfds, &xfds, &tv);
-  slirp_pollfds_poll(slirp, (ret < 0), get_revents_cb, this);
+  if ((ret > 0) && FD_ISSET(wakeup_fd[0], &rfds)) {
+    while (read(wakeup_fd[0], buf, sizeof(buf)) > 0);
+    FD_CLR(wakeup_fd[0], &rfds);
+  }
+#endif
+  BX_LOCK(slirp_lock);
+  slirp_pollfds_poll(slirp, (ret < 0), select_revents_cb, this);
+  BX_UNLOCK(slirp_lock);
 }
 
-slirp_ssize_t bx_slirp_pktmover_c::receive(void *pkt, unsigned pkt_len)
+#if BX_SLIRP_EPOLL
+static int epoll_add_cb(int fd, int events, void *opaque)
 {
-  if (this->rxstat(this->netdev) & BX_NETDEV_RXREADY) {
-    if (pkt_len < MIN_RX_PACKET_LEN) pkt_len = MIN_RX_PACKET_LEN;
-    if (slirp_logging) {
-      write_pktlog_txt(pktlog_txt, (const Bit8u*)pkt, pkt_len, 1);
+  return ((bx_slirp_pktmover_c*)opaque)->epoll_add(fd, events);
+}
+
+static int epoll_revents_cb(int idx, void *opaque)
+{
+  return ((bx_slirp_pktmover_c*)opaque)->epoll_get_revents(idx);
+}
+
+int bx_slirp_pktmover_c::epoll_add(int fd, int events)
+{
+  struct epoll_event ev;
+  Bit32u mask = EPOLLERR | EPOLLHUP;
+
+  if (fd >= pollfds_size) {
+    int new_size = (fd + 64) & ~63;
+    pollfds = (slirp_pollfd_t*)realloc(pollfds, new_size * sizeof(slirp_pollfd_t));
+    memset(&pollfds[pollfds_size], 0, (new_size - pollfds_size) * sizeof(slirp_pollfd_t));
+    pollfds_size = new_size;
+  }
+  if (events & SLIRP_POLL_IN)
+    mask |= EPOLLIN;
+  if (events & SLIRP_POLL_OUT)
+    mask |= EPOLLOUT;
+  if (events & SLIRP_POLL_PRI)
+    mask |= EPOLLPRI;
+  slirp_pollfd_t *pfd = &pollfds[fd];
+  pfd->tick = poll_tick;
+  if (pfd->events != mask) {
+    memset(&ev, 0, sizeof(ev));
+    ev.events = mask;
+    ev.data.fd = fd;
+    if (pfd->events != 0) {
+      if ((epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0) && (errno == ENOENT)) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+      }
+    } else {
+      if ((epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) && (errno == EEXIST)) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+      }
+      if (epoll_count == epoll_list_size) {
+        epoll_list_size += 64;
+        epoll_list = (int*)realloc(epoll_list, epoll_list_size * sizeof(int));
+        epoll_events = (struct epoll_event*)realloc(epoll_events,
+                         (epoll_list_size + 1) * sizeof(struct epoll_event));
+      }
+      pfd->list_idx = epoll_count;
+      epoll_list[epoll_count++] = fd;
     }
-    this->rxh(this->netdev, pkt, pkt_len);
+    pfd->events = mask;
+  }
+  return fd;
+}
+
+int bx_slirp_pktmover_c::epoll_get_revents(int fd)
+{
+  int event = 0;
+
+  if ((fd < pollfds_size) && (pollfds[fd].rtick == poll_tick)) {
+    Bit32u revents = pollfds[fd].revents;
+    if (revents & EPOLLIN)
+      event |= SLIRP_POLL_IN;
+    if (revents & EPOLLOUT)
+      event |= SLIRP_POLL_OUT;
+    if (revents & EPOLLPRI)
+      event |= SLIRP_POLL_PRI;
+    if (revents & EPOLLERR)
+      event |= SLIRP_POLL_ERR;
+    if (revents & EPOLLHUP)
+      event |= SLIRP_POLL_HUP;
+  }
+  return event;
+}
+
+void bx_slirp_pktmover_c::epoll_remove(int fd)
+{
+  if ((epoll_fd < 0) || (fd < 0) || (fd >= pollfds_size) || (pollfds[fd].events == 0))
+    return;
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+  int idx = pollfds[fd].list_idx;
+  epoll_list[idx] = epoll_list[--epoll_count];
+  pollfds[epoll_list[idx]].list_idx = idx;
+  pollfds[fd].events = 0;
+  pollfds[fd].rtick = poll_tick - 1;
+}
+
+void bx_slirp_pktmover_c::epoll_cycle(Bit32u timeout)
+{
+  int i, ret;
+  char buf[64];
+
+  poll_tick++;
+  BX_LOCK(slirp_lock);
+  slirp_pollfds_fill(slirp, &timeout, epoll_add_cb, this);
+  BX_UNLOCK(slirp_lock);
+  // drop the fds slirp is no longer interested in
+  for (i = epoll_count - 1; i >= 0; i--) {
+    if (pollfds[epoll_list[i]].tick != poll_tick) {
+      epoll_remove(epoll_list[i]);
+    }
+  }
+  // the wakeup pipe is registered as well, but not listed in 'epoll_list'
+  ret = epoll_wait(epoll_fd, epoll_events, epoll_count + 1, timeout);
+  for (i = 0; i < ret; i++) {
+    int fd = epoll_events[i].data.fd;
+    if (fd == wakeup_fd[0]) {
+      while (read(wakeup_fd[0], buf, sizeof(buf)) > 0);
+      continue;
+    }
+    slirp_pollfd_t *pfd = &pollfds[fd];
+    pfd->revents = epoll_events[i].events;
+    pfd->rtick = poll_tick;
+  }
+  BX_LOCK(slirp_lock);
+  slirp_pollfds_poll(slirp, (ret < 0), epoll_revents_cb, this);
+  BX_UNLOCK(slirp_lock);
+}
+#endif
+
+// called by the network thread, the frame is passed to the device
+// by the simulation thread
+slirp_ssize_t bx_slirp_pktmover_c::receive(void *pkt, unsigned pkt_len)
+{
+  if (rxq.put(pkt, pkt_len)) {
     return pkt_len;
   } else {
-    BX_ERROR(("device not ready to receive data"));
+    BX_ERROR(("slirp: rx queue full, packet dropped"));
     return -1;
   }
 }
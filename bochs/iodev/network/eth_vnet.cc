@@ -43,6 +43,7 @@
 #include "pc_system.h"
 #include "netmod.h"
 #include "netutil.h"
+#include "bxthread.h"
 
 #if BX_NETWORKING
 
@@ -79,9 +80,6 @@ static const Bit8u default_ftp_ipv4addr[4] = {192,168,10,3};
 static const Bit8u dhcp_base_ipv4addr[4] = {192,168,10,15};
 static const char default_bootfile[] = "pxelinux.0";
 
-static Bit8u    packet_buffer[BX_PACKET_BUFSIZE];
-static unsigned packet_len;
-
 class bx_vnet_pktmover_c : public eth_pktmover_c {
 public:
   bx_vnet_pktmover_c(const char *netif, const char *macaddr,
@@ -89,13 +87,24 @@ public:
                      logfunctions *netdev, const char *script);
   virtual ~bx_vnet_pktmover_c();
   void sendpkt(void *buf, unsigned io_len);
+  void vnet_thread_main(void);
 private:
   bool parse_vnet_conf(const char *conf);
-  void guest_to_host(const Bit8u *buf, unsigned io_len);
-  void host_to_guest(void);
+  void log_rx_packet(const Bit8u *buf, unsigned len);
 
   vnet_server_c vnet_server;
 
+  // the server (including TFTP / FTP file access) runs on a separate
+  // thread, frames are exchanged through lock-free queues
+  bx_packet_queue_c txq;  // guest to server
+  bx_packet_queue_c rxq;  // server to guest
+  Bit8u packet_buffer[BX_PACKET_BUFSIZE];
+  BX_THREAD_VAR(vnet_thread);
+  bx_thread_sem_t tx_sem;
+  volatile bool thread_stop;
+  Bit32u tx_count;         // frames sent by the guest
+  volatile Bit32u tx_done; // frames handled by the server thread
+
   dhcp_cfg_t dhcp;
   char *hostname;
 
@@ -261,6 +270,12 @@ bool bx_vnet_pktmover_c::parse_vnet_conf(const char *conf)
   return 1;
 }
 
+static BX_THREAD_FUNC(vnet_server_thread, indata)
+{
+  ((bx_vnet_pktmover_c*)indata)->vnet_thread_main();
+  BX_THREAD_EXIT;
+}
+
 bx_vnet_pktmover_c::bx_vnet_pktmover_c(const char *netif,
                                        const char *macaddr,
                                        eth_rx_handler_t rxh,
@@ -300,6 +315,12 @@ bx_vnet_pktmover_c::bx_vnet_pktmover_c(const char *netif,
   this->rx_timer_index =
     DEV_register_timer(this, this->rx_timer_handler, 1000, 0, 0, "eth_vnet");
   rx_timer_pending = 0;
+  tx_count = 0;
+  tx_done = 0;
+  thread_stop = 0;
+  tftp_set_time((unsigned)(bx_pc_system.time_usec() / 1000000));
+  bx_create_sem(&tx_sem);
+  BX_THREAD_CREATE(vnet_server_thread, this, vnet_thread);
 
   BX_INFO(("'vnet' network driver initialized"));
   bx_vnet_instances++;
@@ -332,6 +353,11 @@ bx_vnet_pktmover_c::bx_vnet_pktmover_c(const char *netif,
 
 bx_vnet_pktmover_c::~bx_vnet_pktmover_c()
 {
+  thread_stop = 1;
+  bx_set_sem(&tx_sem);
+  BX_THREAD_JOIN(vnet_thread);
+  bx_destroy_sem(&tx_sem);
+  bx_pc_system.deactivate_timer(rx_timer_index);
   if (vnet_logging) {
     fclose(pktlog_txt);
   }
@@ -339,14 +365,9 @@ bx_vnet_pktmover_c::~bx_vnet_pktmover_c()
 }
 
 void bx_vnet_pktmover_c::sendpkt(void *buf, unsigned io_len)
-{
-  guest_to_host((const Bit8u *)buf,io_len);
-}
-
-void bx_vnet_pktmover_c::guest_to_host(const Bit8u *buf, unsigned io_len)
 {
   if (vnet_logging) {
-    write_pktlog_txt(pktlog_txt, buf, io_len, 0);
+    write_pktlog_txt(pktlog_txt, (const Bit8u *)buf, io_len, 0);
   }
 #if BX_ETH_VNET_PCAP_LOGGING
   if (pktlog_pcap && !ferror((FILE *)pktlog_pcap)) {
@@ -355,27 +376,72 @@ void bx_vnet_pktmover_c::guest_to_host(const Bit8u *buf, unsigned io_len)
     pcaphdr.ts.tv_sec = time / 1000000;
     pcaphdr.caplen = io_len;
     pcaphdr.len = io_len;
-    pcap_dump((u_char *)pktlog_pcap, &pcaphdr, buf);
+    pcap_dump((u_char *)pktlog_pcap, &pcaphdr, (const u_char *)buf);
     fflush((FILE *)pktlog_pcap);
   }
 #endif
 
-  this->tx_time = (64 + 96 + 4 * 8 + io_len * 8) / this->netdev_speed;
-  vnet_server.handle_packet(buf, io_len);
+  // the server thread uses the simulation time of the last frame
+  tftp_set_time((unsigned)(bx_pc_system.time_usec() / 1000000));
+  if (!txq.put(buf, io_len)) {
+    BX_ERROR(("vnet: tx queue full, packet dropped"));
+    return;
+  }
+  tx_count++;
+  bx_set_sem(&tx_sem);
+  if (!rx_timer_pending) {
+    this->tx_time = (64 + 96 + 4 * 8 + io_len * 8) / this->netdev_speed;
+    bx_pc_system.activate_timer(this->rx_timer_index, this->tx_time + 100, 0);
+    rx_timer_pending = 1;
+  }
+}
 
-  host_to_guest();
+void bx_vnet_pktmover_c::vnet_thread_main(void)
+{
+  const Bit8u *buf;
+  unsigned len;
+  Bit32u handled = 0;
+  bool rx_blocked = 0;
+
+  while (!thread_stop) {
+    // while the rx queue is full, check again after 1 msec
+    bx_wait_sem_timeout(&tx_sem, rx_blocked ? 1 : 100);
+    do {
+      // pass the server replies to the guest before handling the next frame
+      while (!rxq.full() && ((len = vnet_server.get_packet(packet_buffer)) > 0)) {
+        rxq.put(packet_buffer, len);
+      }
+      rx_blocked = rxq.full();
+      if (rx_blocked)
+        break;
+      // all replies are queued now
+      BX_MEMORY_BARRIER();
+      tx_done = handled;
+      if ((buf = txq.peek(&len)) == NULL)
+        break;
+      vnet_server.handle_packet(buf, len);
+      txq.remove();
+      handled++;
+    } while (!thread_stop);
+  }
 }
 
-void bx_vnet_pktmover_c::host_to_guest(void)
+void bx_vnet_pktmover_c::log_rx_packet(const Bit8u *buf, unsigned len)
 {
-  if (!rx_timer_pending) {
-    packet_len = vnet_server.get_packet(packet_buffer);
-    if (packet_len > 0) {
-      unsigned rx_time = (64 + 96 + 4 * 8 + packet_len * 8) / this->netdev_speed;
-      bx_pc_system.activate_timer(this->rx_timer_index, this->tx_time + rx_time + 100, 0);
-      rx_timer_pending = 1;
-    }
+  if (vnet_logging) {
+    write_pktlog_txt(pktlog_txt, buf, len, 1);
   }
+#if BX_ETH_VNET_PCAP_LOGGING
+  if (pktlog_pcap && !ferror((FILE *)pktlog_pcap)) {
+    Bit64u time = bx_pc_system.time_usec();
+    pcaphdr.ts.tv_usec = time % 1000000;
+    pcaphdr.ts.tv_sec = time / 1000000;
+    pcaphdr.caplen = len;
+    pcaphdr.len = len;
+    pcap_dump((u_char *)pktlog_pcap, &pcaphdr, buf);
+    fflush((FILE *)pktlog_pcap);
+  }
+#endif
 }
 
 // The receive poll process
@@ -388,27 +454,32 @@ void bx_vnet_pktmover_c::rx_timer_handler(void *this_ptr)
 
 void bx_vnet_pktmover_c::rx_timer(void)
 {
-  if (this->rxstat(this->netdev) & BX_NETDEV_RXREADY) {
-    this->rxh(this->netdev, (void *)packet_buffer, packet_len);
-    if (vnet_logging) {
-      write_pktlog_txt(pktlog_txt, packet_buffer, packet_len, 1);
-    }
-#if BX_ETH_VNET_PCAP_LOGGING
-    if (pktlog_pcap && !ferror((FILE *)pktlog_pcap)) {
-      Bit64u time = bx_pc_system.time_usec();
-      pcaphdr.ts.tv_usec = time % 1000000;
-      pcaphdr.ts.tv_sec = time / 1000000;
-      pcaphdr.caplen = packet_len;
-      pcaphdr.len = packet_len;
-      pcap_dump((u_char *)pktlog_pcap, &pcaphdr, packet_buffer);
-      fflush((FILE *)pktlog_pcap);
+  const Bit8u *buf;
+  unsigned len, delay = 0;
+
+  rx_timer_pending = 0;
+  tftp_set_time((unsigned)(bx_pc_system.time_usec() / 1000000));
+  if ((buf = rxq.peek(&len)) != NULL) {
+    if (this->rxstat(this->netdev) & BX_NETDEV_RXREADY) {
+      this->rxh(this->netdev, (void *)buf, len);
+      log_rx_packet(buf, len);
+      rxq.remove();
+      // check for another pending packet
+      if ((buf = rxq.peek(&len)) != NULL) {
+        delay = (64 + 96 + 4 * 8 + len * 8) / this->netdev_speed;
+      }
+    } else {
+      BX_DEBUG(("device not ready to receive data"));
+      delay = 1000;
     }
-#endif
-    rx_timer_pending = 0;
-    // check for another pending packet
-    host_to_guest();
-  } else {
-    BX_ERROR(("device not ready to receive data"));
+  }
+  if ((delay == 0) && (tx_done != tx_count)) {
+    // the server thread is still busy
+    delay = 100;
+  }
+  if (delay > 0) {
+    bx_pc_system.activate_timer(this->rx_timer_index, delay, 0);
+    rx_timer_pending = 1;
   }
 }
 
@@ -31,6 +31,7 @@
 #if BX_NETWORKING
 
 #include "netmod.h"
+#include "bxthread.h"
 
 #define LOG_THIS bx_netmod_ctl.
 
@@ -288,6 +289,51 @@ void write_pktlog_txt(FILE *pktlog_txt, const Bit8u *buf, unsigned len, bool hos
   fflush(pktlog_txt);
 }
 
+bx_packet_queue_c::bx_packet_queue_c()
+{
+  data = new Bit8u[BX_PACKET_QUEUE_SIZE * BX_PACKET_BUFSIZE];
+  rpos = 0;
+  wpos = 0;
+}
+
+bx_packet_queue_c::~bx_packet_queue_c()
+{
+  delete [] data;
+}
+
+bool bx_packet_queue_c::put(const void *buf, unsigned buflen)
+{
+  if ((buflen > BX_PACKET_BUFSIZE) || full())
+    return 0;
+  unsigned idx = wpos % BX_PACKET_QUEUE_SIZE;
+  Bit8u *dst = &data[idx * BX_PACKET_BUFSIZE];
+  memcpy(dst, buf, buflen);
+  if (buflen < MIN_RX_PACKET_LEN) {
+    memset(dst + buflen, 0, MIN_RX_PACKET_LEN - buflen);
+    buflen = MIN_RX_PACKET_LEN;
+  }
+  len[idx] = buflen;
+  BX_MEMORY_BARRIER();
+  wpos++;
+  return 1;
+}
+
+const Bit8u *bx_packet_queue_c::peek(unsigned *buflen)
+{
+  if (empty())
+    return NULL;
+  BX_MEMORY_BARRIER();
+  unsigned idx = rpos % BX_PACKET_QUEUE_SIZE;
+  *buflen = len[idx];
+  return &data[idx * BX_PACKET_BUFSIZE];
+}
+
+void bx_packet_queue_c::remove()
+{
+  BX_MEMORY_BARRIER();
+  rpos++;
+}
+
 size_t strip_whitespace(char *s)
 {
   size_t ptr = 0;
@@ -110,6 +110,31 @@ protected:
   eth_rx_status_t  rxstat; // receive status callback
 };
 
+// Single producer / single consumer queue of ethernet frames (no locking)
+// for passing frames between the simulation thread and a network thread.
+// Frames shorter than MIN_RX_PACKET_LEN are padded with zeros.
+
+#define BX_PACKET_QUEUE_SIZE 256
+
+class BOCHSAPI_MSVCONLY bx_packet_queue_c {
+public:
+  bx_packet_queue_c();
+  ~bx_packet_queue_c();
+
+  // producer side
+  bool put(const void *buf, unsigned len);
+  // consumer side: the frame returned by peek() is valid until remove()
+  const Bit8u *peek(unsigned *len);
+  void remove();
+
+  bool empty() const {return rpos == wpos;}
+  bool full() const {return (wpos - rpos) == BX_PACKET_QUEUE_SIZE;}
+private:
+  Bit8u *data;
+  unsigned len[BX_PACKET_QUEUE_SIZE];
+  volatile Bit32u rpos, wpos;
+};
+
 
 //
 //  The eth_locator class is used by pktmover classes to register
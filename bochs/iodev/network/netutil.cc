@@ -2282,10 +2282,21 @@ void tftp_remove_session(tftp_session_t *s)
   delete s;
 }
 
+#ifndef BXHUB
+// simulation time in seconds, published by the simulation thread since the
+// TFTP server runs on the vnet thread
+static volatile unsigned tftp_time_sec = 0;
+
+void tftp_set_time(unsigned sec)
+{
+  tftp_time_sec = sec;
+}
+#endif
+
 void tftp_update_timestamp(tftp_session_t *s)
 {
 #ifndef BXHUB
-  s->timestamp = (unsigned)(bx_pc_system.time_usec() / 1000000);
+  s->timestamp = tftp_time_sec;
 #else
   s->timestamp = (unsigned)time(NULL);
 #endif
@@ -2294,7 +2305,7 @@ void tftp_update_timestamp(tftp_session_t *s)
 void tftp_timeout_check()
 {
 #ifndef BXHUB
-  unsigned curtime = (unsigned)(bx_pc_system.time_usec() / 1000000);
+  unsigned curtime = tftp_time_sec;
 #else
   unsigned curtime = (unsigned)time(NULL);
 #endif
@@ -187,6 +187,10 @@ typedef struct tftp_session {
   struct tftp_session *next;
 } tftp_session_t;
 
+#ifndef BXHUB
+void tftp_set_time(unsigned sec);
+#endif
+
 // VNET server
 
 #define VNET_MAX_CLIENTS 6
@@ -122,9 +122,13 @@ diddit:
     }
 
     /*
-     * This prevents us from malloc()ing too many mbufs
+     * This prevents us from malloc()ing too many mbufs. While the sockets
+     * are polled the packets are only queued and sent by one if_start()
+     * call at the end.
      */
-    if_start(ifm->slirp);
+    if (!slirp->if_start_deferred) {
+        if_start(slirp);
+    }
 }
 
 void if_start(Slirp *slirp)
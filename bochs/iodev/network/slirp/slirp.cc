@@ -932,6 +932,7 @@ void slirp_pollfds_poll(Slirp *slirp, int select_error,
     int ret;
 
     curtime = slirp->cb->clock_get_ns(slirp->opaque) / SCALE_MS;
+    slirp->if_start_deferred = true;
 
     /*
      * See if anything has timed out
@@ -1103,6 +1104,7 @@ void slirp_pollfds_poll(Slirp *slirp, int select_error,
         }
     }
 
+    slirp->if_start_deferred = false;
     if_start(slirp);
 }
 
@@ -190,6 +190,7 @@ struct Slirp {
     struct slirp_quehead if_fastq; /* fast queue (for interactive data) */
     struct slirp_quehead if_batchq; /* queue for non-interactive data */
     bool if_start_busy;     /* avoid if_start recursion */
+    bool if_start_deferred; /* queue output until the end of the poll */
 
     /* ip states */
     struct ipq ipq;         /* ip reass. queue */
@@ -205,12 +206,14 @@ struct Slirp {
     /* tcp states */
     struct socket tcb;
     struct socket *tcp_last_so;
+    struct socket *tcp_hash[SO_HASH_SIZE];
     tcp_seq tcp_iss;        /* tcp initial send seq # */
     uint32_t tcp_now;       /* for RFC 1323 timestamps */
 
     /* udp states */
     struct socket udb;
     struct socket *udp_last_so;
+    struct socket *udp_hash[SO_HASH_SIZE];
 
     /* icmp states */
     struct socket icmp;
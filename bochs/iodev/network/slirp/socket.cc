@@ -18,11 +18,73 @@
 static void sofcantrcvmore(struct socket *so);
 static void sofcantsendmore(struct socket *so);
 
+static uint32_t sohash_addr(uint32_t h, const struct sockaddr_storage *addr)
+{
+    switch (addr->ss_family) {
+    case AF_INET: {
+        const struct sockaddr_in *a4 = (const struct sockaddr_in *)addr;
+        h = (h ^ a4->sin_addr.s_addr) * 0x9e3779b1;
+        h = (h ^ a4->sin_port) * 0x9e3779b1;
+        break;
+    }
+    case AF_INET6: {
+        const struct sockaddr_in6 *a6 = (const struct sockaddr_in6 *)addr;
+        uint32_t w;
+        for (int i = 0; i < 16; i += 4) {
+            memcpy(&w, &a6->sin6_addr.s6_addr[i], 4);
+            h = (h ^ w) * 0x9e3779b1;
+        }
+        h = (h ^ a6->sin6_port) * 0x9e3779b1;
+        break;
+    }
+    default:
+        h = (h ^ addr->ss_family) * 0x9e3779b1;
+    }
+    return h;
+}
+
+static unsigned sohash(const struct sockaddr_storage *lhost,
+                       const struct sockaddr_storage *fhost)
+{
+    uint32_t h = sohash_addr(0, lhost);
+
+    if (fhost) {
+        h = sohash_addr(h, fhost);
+    }
+    return h >> (32 - SO_HASH_BITS);
+}
+
+static void sohash_remove(struct socket *so)
+{
+    struct socket **p;
+
+    if (so->so_hash_head == NULL) {
+        return;
+    }
+    for (p = so->so_hash_head; *p != NULL; p = &(*p)->so_hash_next) {
+        if (*p == so) {
+            *p = so->so_hash_next;
+            break;
+        }
+    }
+    so->so_hash_head = NULL;
+    so->so_hash_next = NULL;
+}
+
+/*
+ * Sockets get their addresses only after they have been queued, so they are
+ * entered into the hash table when the list walk finds them first. A socket
+ * whose addresses changed afterwards is found by the list walk again and
+ * moved to the right chain. The UDP table is keyed by the local address
+ * only, like its lookups.
+ */
 struct socket *solookup(struct socket **last, struct socket *head,
+                        struct socket **hashtab,
                         struct sockaddr_storage *lhost,
                         struct sockaddr_storage *fhost)
 {
     struct socket *so = *last;
+    unsigned h;
 
     /* Optimisation */
     if (so != head && sockaddr_equal(&(so->lhost.ss), lhost) &&
@@ -30,9 +92,22 @@ struct socket *solookup(struct socket **last, struct socket *head,
         return so;
     }
 
+    h = sohash(lhost, fhost);
+    for (so = hashtab[h]; so != NULL; so = so->so_hash_next) {
+        if (sockaddr_equal(&(so->lhost.ss), lhost) &&
+            (!fhost || sockaddr_equal(&so->fhost.ss, fhost))) {
+            *last = so;
+            return so;
+        }
+    }
+
     for (so = head->so_next; so != head; so = so->so_next) {
         if (sockaddr_equal(&(so->lhost.ss), lhost) &&
             (!fhost || sockaddr_equal(&so->fhost.ss, fhost))) {
+            sohash_remove(so);
+            so->so_hash_head = &hashtab[h];
+            so->so_hash_next = hashtab[h];
+            hashtab[h] = so;
             *last = so;
             return so;
         }
@@ -102,6 +177,7 @@ void sofree(struct socket *so)
     } else if (so == slirp->icmp_last_so) {
         slirp->icmp_last_so = &slirp->icmp;
     }
+    sohash_remove(so);
     m_free(so->so_m);
 
     if(so->so_next && so->so_prev)
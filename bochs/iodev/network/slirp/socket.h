@@ -18,6 +18,10 @@
 #define SO_EXPIRE 240000
 #define SO_EXPIREFAST 10000
 
+/* Size of the socket lookup hash tables (power of 2) */
+#define SO_HASH_BITS 9
+#define SO_HASH_SIZE (1 << SO_HASH_BITS)
+
 /* Helps unify some in/in6 routines. */
 union in4or6_addr {
     struct in_addr addr4;
@@ -38,6 +42,8 @@ union slirp_sockaddr {
 
 struct socket {
     struct socket *so_next, *so_prev; /* For a linked list of sockets */
+    struct socket *so_hash_next; /* Next socket in the lookup hash chain */
+    struct socket **so_hash_head; /* Hash chain the socket is on, or NULL */
 
     int s; /* The actual socket */
     int s_aux; /* An auxiliary socket for miscellaneous use. Currently used to
@@ -182,6 +188,7 @@ static inline void sockaddr_copy(struct sockaddr *dst, socklen_t dstlen, const s
 
 /* Find the socket corresponding to lhost & fhost, trying last as a guess */
 struct socket *solookup(struct socket **last, struct socket *head,
+                        struct socket **hashtab,
                         struct sockaddr_storage *lhost, struct sockaddr_storage *fhost);
 /* Create a new socket */
 struct socket *socreate(Slirp *, int);
@@ -365,7 +365,7 @@ findso:
         slirplog_error("Unknown protocol");
     }
 
-    so = solookup(&slirp->tcp_last_so, &slirp->tcb, &lhost, &fhost);
+    so = solookup(&slirp->tcp_last_so, &slirp->tcb, slirp->tcp_hash, &lhost, &fhost);
 
     /*
      * If the state is CLOSED (i.e., TCB does not exist) then
@@ -172,7 +172,7 @@ void udp_input(struct mbuf *m, int iphlen)
     /*
      * Locate pcb for datagram.
      */
-    so = solookup(&slirp->udp_last_so, &slirp->udb, &lhost, NULL);
+    so = solookup(&slirp->udp_last_so, &slirp->udb, slirp->udp_hash, &lhost, NULL);
 
     if (so == NULL) {
       /*
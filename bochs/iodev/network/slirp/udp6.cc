@@ -92,7 +92,7 @@ void udp6_input(struct mbuf *m)
         goto bad;
     }
 
-    so = solookup(&slirp->udp_last_so, &slirp->udb,
+    so = solookup(&slirp->udp_last_so, &slirp->udb, slirp->udp_hash,
                   (struct sockaddr_storage *)&lhost, NULL);
 
     if (so == NULL) {
@@ -37,6 +37,7 @@
 #include <math.h>
 #include <stdlib.h> // rand()
 #include "iodev.h"
+#include "bxthread.h"
 #define OPL_SOURCE
 #include "opl.h"
 
@@ -44,6 +45,25 @@
 
 Bit16u opl_index;
 
+// Register writes from the simulation thread are queued with the emulated
+// time and applied by the audio thread at the corresponding sample position.
+// The queue is single producer / single consumer. The consumer side is only
+// accessed with the mutex held, so the producer can take it to flush the
+// queue if it is full or to reset it.
+typedef struct {
+  Bit64u usec;
+  Bit16u idx;
+  Bit8u  val;
+} opl_write_t;
+
+static opl_write_t opl_wqueue[OPL_WQUEUE_SIZE];
+static volatile Bit32u opl_wq_head = 0, opl_wq_tail = 0;
+static Bit8u opl3_mode = 0;         // OPL3 mode as seen by the simulation thread
+static fltype render_usec = 0;      // emulated time of the next rendered sample
+static bool render_usec_valid = 0;
+static bool opl_mutex_init = 0;
+BX_MUTEX(opl_mutex);
+
 static fltype recipsamp;            // inverse of sampling rate
 static Bit16s wavtable[WAVEPREC*3]; // wave form table
 
@@ -231,9 +251,7 @@ void operator_off(op_type* /*op_pt*/)
 void operator_sustain(op_type* op_pt)
 {
   Bit32u num_steps_add = op_pt->generator_pos/FIXEDPT;  // number of (standardized) samples
-  for (Bit32u ct=0; ct<num_steps_add; ct++) {
-    op_pt->cur_env_step++;
-  }
+  op_pt->cur_env_step += num_steps_add;
   op_pt->generator_pos -= num_steps_add*FIXEDPT;
 }
 
@@ -960,7 +978,7 @@ void adlib_write_index(Bitu port, Bit8u val)
 #if defined(OPLTYPE_IS_OPL3)
   if ((port&3)!=0) {
     // possibly second set
-    if (((adlibreg[0x105]&1)!=0) || (opl_index==5)) opl_index |= ARC_SECONDSET;
+    if ((opl3_mode!=0) || (opl_index==5)) opl_index |= ARC_SECONDSET;
   }
 #endif
 }
@@ -1005,7 +1023,8 @@ static void OPL_INLINE clipit16(Bit32s ival, Bit16s* outval, Bit8u vol)
   opl_active = 1;
 #endif
 
-bool adlib_getsample(Bit16u rate, Bit16s* sndptr, Bits numsamples, Bit16u volume)
+// render 'numsamples' stereo samples with the current register settings
+static bool adlib_render(Bit16s* sndptr, Bits numsamples, Bit8u lvol, Bit8u rvol)
 {
   Bits i, endsamples;
   op_type* cptr;
@@ -1022,14 +1041,8 @@ bool adlib_getsample(Bit16u rate, Bit16s* sndptr, Bits numsamples, Bit16u volume
   Bit32s vib_lut[BLOCKBUF_SIZE];
   Bit32s trem_lut[BLOCKBUF_SIZE];
 
-  Bit8u lvol = (Bit8u)(volume & 0xff);
-  Bit8u rvol = (Bit8u)(volume >> 8);
   Bits samples_to_process = numsamples;
 
-  if (rate != (Bit16u)int_samplerate) {
-    adlib_init(rate);
-  }
-
   for (Bits cursmp=0; cursmp<samples_to_process; cursmp+=endsamples) {
     endsamples = samples_to_process-cursmp;
     if (endsamples>BLOCKBUF_SIZE) endsamples = BLOCKBUF_SIZE;
@@ -1526,68 +1539,198 @@ bool adlib_getsample(Bit16u rate, Bit16s* sndptr, Bits numsamples, Bit16u volume
   return opl_active;
 }
 
+// apply all pending register writes immediately (mutex must be held)
+static void adlib_flush_writes()
+{
+  while (opl_wq_tail != opl_wq_head) {
+    BX_MEMORY_BARRIER();
+    opl_write_t *wr = &opl_wqueue[opl_wq_tail % OPL_WQUEUE_SIZE];
+    adlib_write(wr->idx, wr->val);
+    opl_wq_tail++;
+  }
+}
+
+// Called by the audio thread. The block of samples is split at the positions
+// of the queued register writes. If the emulated time of a register write is
+// too far away from the current render position (e.g. the simulation is not
+// running in real time), the render position is adjusted.
+bool adlib_getsample(Bit16u rate, Bit16s* sndptr, Bits numsamples, Bit16u volume)
+{
+  Bit8u lvol = (Bit8u)(volume & 0xff);
+  Bit8u rvol = (Bit8u)(volume >> 8);
+  bool opl_active = 0;
+  Bits cursmp = 0, endsmp;
+  fltype usec_per_sample, wpos;
+
+  BX_LOCK(opl_mutex);
+  if (rate != (Bit16u)int_samplerate) {
+    adlib_init(rate);
+  }
+  usec_per_sample = 1000000.0 / (fltype)int_samplerate;
+  while (cursmp < numsamples) {
+    endsmp = numsamples;
+    if (opl_wq_tail != opl_wq_head) {
+      BX_MEMORY_BARRIER();
+      opl_write_t *wr = &opl_wqueue[opl_wq_tail % OPL_WQUEUE_SIZE];
+      wpos = ((fltype)wr->usec - render_usec) / usec_per_sample;
+      if (!render_usec_valid || (wpos < (fltype)(cursmp - OPL_MAX_LAG)) ||
+          (wpos > (fltype)(numsamples + OPL_MAX_LAG))) {
+        render_usec = (fltype)wr->usec - (fltype)cursmp * usec_per_sample;
+        render_usec_valid = 1;
+        wpos = (fltype)cursmp;
+      }
+      if (wpos <= (fltype)cursmp) {
+        adlib_write(wr->idx, wr->val);
+        opl_wq_tail++;
+        continue;
+      }
+      if (wpos < (fltype)numsamples) {
+        endsmp = (Bits)wpos;
+        if (endsmp == cursmp) endsmp++;
+      }
+    }
+    opl_active |= adlib_render(sndptr + cursmp * 2, endsmp - cursmp, lvol, rvol);
+    cursmp = endsmp;
+  }
+  render_usec += (fltype)numsamples * usec_per_sample;
+  BX_UNLOCK(opl_mutex);
+  return opl_active;
+}
+
+// Called by the simulation thread for writes to the OPL data ports.
+void adlib_queue_write(Bitu idx, Bit8u val, Bit64u usec)
+{
+  if (idx == 0x105) {
+    opl3_mode = val & 1;
+  }
+  if ((opl_wq_head - opl_wq_tail) == OPL_WQUEUE_SIZE) {
+    // audio thread not running or too slow
+    BX_LOCK(opl_mutex);
+    adlib_flush_writes();
+    BX_UNLOCK(opl_mutex);
+  }
+  opl_write_t *wr = &opl_wqueue[opl_wq_head % OPL_WQUEUE_SIZE];
+  wr->usec = usec;
+  wr->idx = (Bit16u)idx;
+  wr->val = val;
+  BX_MEMORY_BARRIER();
+  opl_wq_head++;
+}
+
+void adlib_reset(Bit32u samplerate)
+{
+  if (!opl_mutex_init) {
+    BX_INIT_MUTEX(opl_mutex);
+    opl_mutex_init = 1;
+  }
+  BX_LOCK(opl_mutex);
+  opl_wq_head = opl_wq_tail = 0;
+  opl3_mode = 0;
+  render_usec_valid = 0;
+  adlib_init(samplerate);
+  BX_UNLOCK(opl_mutex);
+}
+
+// The audio thread changes the chip state with opl_mutex held. The save
+// handler of the first parameter applies the queued register writes and
+// copies the state here before it is written; adlib_after_restore_state()
+// copies it back.
+static struct {
+  Bit8u regs[sizeof(adlibreg)];
+  Bit8u wsel[sizeof(wave_sel)];
+  Bit32u vibtab_pos;
+  Bit32u tremtab_pos;
+  op_type op[MAXOPERATORS];
+} opl_saved;
+
+static Bit64s adlib_param_save_handler(void *devptr, bx_param_c *param)
+{
+  BX_LOCK(opl_mutex);
+  adlib_flush_writes();
+  memcpy(opl_saved.regs, adlibreg, sizeof(adlibreg));
+  memcpy(opl_saved.wsel, wave_sel, sizeof(wave_sel));
+  opl_saved.vibtab_pos = vibtab_pos;
+  opl_saved.tremtab_pos = tremtab_pos;
+  memcpy(opl_saved.op, op, sizeof(op));
+  BX_UNLOCK(opl_mutex);
+  return 0;
+}
+
 void adlib_register_state(bx_list_c *parent)
 {
   bx_list_c *adlib = new bx_list_c(parent, "adlib");
+  bx_param_num_c *sync = new bx_param_num_c(adlib, "sync", "", "", 0, 1, 0);
+  sync->set_sr_handlers(NULL, adlib_param_save_handler, NULL);
   new bx_shadow_num_c(adlib, "opl_index", &opl_index, BASE_HEX);
 #if defined(OPLTYPE_IS_OPL3)
-  new bx_shadow_data_c(adlib, "regs", adlibreg, 512);
-  new bx_shadow_data_c(adlib, "wave_sel", wave_sel, 44, 1);
+  new bx_shadow_data_c(adlib, "regs", opl_saved.regs, 512);
+  new bx_shadow_data_c(adlib, "wave_sel", opl_saved.wsel, 44, 1);
 #endif
-  new bx_shadow_num_c(adlib, "vibtab_pos", &vibtab_pos);
-  new bx_shadow_num_c(adlib, "tremtab_pos", &tremtab_pos);
+  new bx_shadow_num_c(adlib, "vibtab_pos", &opl_saved.vibtab_pos);
+  new bx_shadow_num_c(adlib, "tremtab_pos", &opl_saved.tremtab_pos);
   bx_list_c *ops = new bx_list_c(adlib, "op");
   for (int i = 0; i < MAXOPERATORS; i++) {
     char numstr[8];
     sprintf(numstr, "%d", i);
     bx_list_c *opX = new bx_list_c(ops, numstr);
-    new bx_shadow_num_c(opX, "cval", &op[i].cval);
-    new bx_shadow_num_c(opX, "lastcval", &op[i].lastcval);
-    new bx_shadow_num_c(opX, "tcount", &op[i].tcount);
-    new bx_shadow_num_c(opX, "wfpos", &op[i].wfpos);
-    new bx_shadow_num_c(opX, "tinc", &op[i].tinc);
-    new bx_shadow_num_c(opX, "amp", &op[i].amp);
-    new bx_shadow_num_c(opX, "step_amp", &op[i].step_amp);
-    new bx_shadow_num_c(opX, "vol", &op[i].vol);
-    new bx_shadow_num_c(opX, "sustain_level", &op[i].sustain_level);
-    new bx_shadow_num_c(opX, "mfbi", &op[i].mfbi);
-    new bx_shadow_num_c(opX, "a0", &op[i].a0);
-    new bx_shadow_num_c(opX, "a1", &op[i].a1);
-    new bx_shadow_num_c(opX, "a2", &op[i].a2);
-    new bx_shadow_num_c(opX, "a3", &op[i].a3);
-    new bx_shadow_num_c(opX, "decaymul", &op[i].decaymul);
-    new bx_shadow_num_c(opX, "releasemul", &op[i].releasemul);
-    new bx_shadow_num_c(opX, "op_state", &op[i].op_state);
-    new bx_shadow_num_c(opX, "toff", &op[i].toff);
-    new bx_shadow_num_c(opX, "freq_high", &op[i].freq_high);
-    new bx_shadow_num_c(opX, "cur_wvsel", &op[i].cur_wvsel);
-    new bx_shadow_num_c(opX, "act_state", &op[i].act_state);
-    BXRS_PARAM_BOOL(opX, sys_keep, op[i].sus_keep);
-    BXRS_PARAM_BOOL(opX, vibrato, op[i].vibrato);
-    BXRS_PARAM_BOOL(opX, tremolo, op[i].tremolo);
-    new bx_shadow_num_c(opX, "generator_pos", &op[i].generator_pos);
-    new bx_shadow_num_c(opX, "cur_env_step", &op[i].cur_env_step);
-    new bx_shadow_num_c(opX, "env_step_a", &op[i].env_step_a);
-    new bx_shadow_num_c(opX, "env_step_d", &op[i].env_step_d);
-    new bx_shadow_num_c(opX, "env_step_r", &op[i].env_step_r);
-    new bx_shadow_num_c(opX, "step_skip_pos_a", &op[i].step_skip_pos_a);
-    new bx_shadow_num_c(opX, "env_step_skip_a", &op[i].env_step_skip_a);
+    op_type *op = &opl_saved.op[i];
+    new bx_shadow_num_c(opX, "cval", &op->cval);
+    new bx_shadow_num_c(opX, "lastcval", &op->lastcval);
+    new bx_shadow_num_c(opX, "tcount", &op->tcount);
+    new bx_shadow_num_c(opX, "wfpos", &op->wfpos);
+    new bx_shadow_num_c(opX, "tinc", &op->tinc);
+    new bx_shadow_num_c(opX, "amp", &op->amp);
+    new bx_shadow_num_c(opX, "step_amp", &op->step_amp);
+    new bx_shadow_num_c(opX, "vol", &op->vol);
+    new bx_shadow_num_c(opX, "sustain_level", &op->sustain_level);
+    new bx_shadow_num_c(opX, "mfbi", &op->mfbi);
+    new bx_shadow_num_c(opX, "a0", &op->a0);
+    new bx_shadow_num_c(opX, "a1", &op->a1);
+    new bx_shadow_num_c(opX, "a2", &op->a2);
+    new bx_shadow_num_c(opX, "a3", &op->a3);
+    new bx_shadow_num_c(opX, "decaymul", &op->decaymul);
+    new bx_shadow_num_c(opX, "releasemul", &op->releasemul);
+    new bx_shadow_num_c(opX, "op_state", &op->op_state);
+    new bx_shadow_num_c(opX, "toff", &op->toff);
+    new bx_shadow_num_c(opX, "freq_high", &op->freq_high);
+    new bx_shadow_num_c(opX, "cur_wvsel", &op->cur_wvsel);
+    new bx_shadow_num_c(opX, "act_state", &op->act_state);
+    BXRS_PARAM_BOOL(opX, sys_keep, op->sus_keep);
+    BXRS_PARAM_BOOL(opX, vibrato, op->vibrato);
+    BXRS_PARAM_BOOL(opX, tremolo, op->tremolo);
+    new bx_shadow_num_c(opX, "generator_pos", &op->generator_pos);
+    new bx_shadow_num_c(opX, "cur_env_step", &op->cur_env_step);
+    new bx_shadow_num_c(opX, "env_step_a", &op->env_step_a);
+    new bx_shadow_num_c(opX, "env_step_d", &op->env_step_d);
+    new bx_shadow_num_c(opX, "env_step_r", &op->env_step_r);
+    new bx_shadow_num_c(opX, "step_skip_pos_a", &op->step_skip_pos_a);
+    new bx_shadow_num_c(opX, "env_step_skip_a", &op->env_step_skip_a);
 #if defined(OPLTYPE_IS_OPL3)
-    BXRS_PARAM_BOOL(opX, is_4op, op[i].is_4op);
-    BXRS_PARAM_BOOL(opX, is_4op_attached, op[i].is_4op_attached);
-    new bx_shadow_num_c(opX, "left_pan", &op[i].left_pan);
-    new bx_shadow_num_c(opX, "right_pan", &op[i].right_pan);
+    BXRS_PARAM_BOOL(opX, is_4op, op->is_4op);
+    BXRS_PARAM_BOOL(opX, is_4op_attached, op->is_4op_attached);
+    new bx_shadow_num_c(opX, "left_pan", &op->left_pan);
+    new bx_shadow_num_c(opX, "right_pan", &op->right_pan);
 #endif
   }
 }
 
 void adlib_after_restore_state()
 {
+  BX_LOCK(opl_mutex);
+  memcpy(adlibreg, opl_saved.regs, sizeof(adlibreg));
+  memcpy(wave_sel, opl_saved.wsel, sizeof(wave_sel));
+  vibtab_pos = opl_saved.vibtab_pos;
+  tremtab_pos = opl_saved.tremtab_pos;
+  memcpy(op, opl_saved.op, sizeof(op));
+  opl_wq_head = opl_wq_tail = 0;
+  opl3_mode = adlibreg[0x105] & 1;
+  render_usec_valid = 0;
   for (int i = 0; i < MAXOPERATORS; i++) {
     Bit8u wvsel = op[i].cur_wvsel;
     op[i].cur_wmask = wavemask[wvsel];
     op[i].cur_wform = &wavtable[waveform[wvsel]];
   }
+  BX_UNLOCK(opl_mutex);
 }
 
 #endif
@@ -99,6 +99,12 @@ enum {
 
 #define BLOCKBUF_SIZE   512
 
+// register write queue
+#define OPL_WQUEUE_SIZE 1024
+// maximum distance (in samples) between a queued register write and the
+// render position before the position is adjusted
+#define OPL_MAX_LAG     8192
+
 
 // vibrato constants
 #define VIBTAB_SIZE      8
@@ -195,7 +201,9 @@ static Bit32u generator_add; // should be a chip parameter
 
 // general functions
 void adlib_init(Bit32u samplerate);
+void adlib_reset(Bit32u samplerate);
 void adlib_write(Bitu idx, Bit8u val);
+void adlib_queue_write(Bitu idx, Bit8u val, Bit64u usec);
 bool adlib_getsample(Bit16u rate, Bit16s* sndptr, Bits numsamples, Bit16u volume);
 
 Bitu adlib_reg_read(Bitu port);
@@ -383,7 +383,7 @@ void bx_sb16_c::init(void)
     OPL.timer[i] = 0;
     OPL.timerinit[i] = 0;
   }
-  adlib_init(44100);
+  adlib_reset(44100);
 
   // csp
   memset(&BX_SB16_THIS csp_reg[0], 0, sizeof(BX_SB16_THIS csp_reg));
@@ -2789,7 +2789,7 @@ void bx_sb16_c::write(Bit32u address, Bit32u value, unsigned io_len)
     case BX_SB16_IO + 0x09:
     case BX_SB16_IOADLIB + 0x01:
       opl_data(value, 0);
-      adlib_write(opl_index, value);
+      adlib_queue_write(opl_index, value, bx_pc_system.time_usec());
       return;
 
     // 2x2: Advanced FM Music Register Port
@@ -2807,7 +2807,7 @@ void bx_sb16_c::write(Bit32u address, Bit32u value, unsigned io_len)
     case BX_SB16_IO + 0x03:
     case BX_SB16_IOADLIB + 0x03:
       opl_data(value, 1);
-      adlib_write(opl_index, value);
+      adlib_queue_write(opl_index, value, bx_pc_system.time_usec());
       return;
 
     // 2x4: Mixer Register Port
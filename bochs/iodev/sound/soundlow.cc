@@ -35,14 +35,17 @@
 bx_audio_buffer_c::bx_audio_buffer_c(Bit8u _format)
 {
   format = _format;
-  root = NULL;
+  root = new audio_buffer_t;
+  memset(root, 0, sizeof(audio_buffer_t));
+  last = root;
 }
 
 bx_audio_buffer_c::~bx_audio_buffer_c()
 {
-  while (root != NULL) {
+  while (root->next != NULL) {
     delete_buffer();
   }
+  delete root;
 }
 
 audio_buffer_t* bx_audio_buffer_c::new_buffer(Bit32u size)
@@ -56,98 +59,147 @@ audio_buffer_t* bx_audio_buffer_c::new_buffer(Bit32u size)
   newbuffer->size = size;
   newbuffer->pos = 0;
   newbuffer->next = NULL;
-
-  if (root == NULL) {
-    root = newbuffer;
-  } else {
-    audio_buffer_t *temp = root;
-
-    while (temp->next)
-      temp = temp->next;
-
-    temp->next = newbuffer;
-  }
   return newbuffer;
 }
 
+void bx_audio_buffer_c::add_buffer(audio_buffer_t *buffer)
+{
+  buffer->next = NULL;
+  // the buffer contents must be visible before the buffer is linked
+  BX_MEMORY_BARRIER();
+  last->next = buffer;
+  last = buffer;
+}
+
 audio_buffer_t* bx_audio_buffer_c::get_buffer()
 {
-  return root;
+  audio_buffer_t *buffer = root->next;
+  BX_MEMORY_BARRIER();
+  return buffer;
 }
 
 void bx_audio_buffer_c::delete_buffer()
 {
   audio_buffer_t *tmpbuffer = root;
+  // the consumed buffer becomes the new root entry
   root = tmpbuffer->next;
-  if (tmpbuffer->size > 0) {
+  free_buffer(root);
+  delete tmpbuffer;
+}
+
+void bx_audio_buffer_c::free_buffer(audio_buffer_t *buffer)
+{
+  if (buffer->size > 0) {
     if (format == BUFTYPE_FLOAT) {
-      delete [] tmpbuffer->fdata;
+      delete [] buffer->fdata;
     } else {
-      delete [] tmpbuffer->data;
+      delete [] buffer->data;
     }
+    buffer->size = 0;
   }
-  delete tmpbuffer;
 }
 
-void bx_audio_buffer_c::flush()
+// ring buffer support
+
+bx_audio_ringbuffer_c::bx_audio_ringbuffer_c(Bit32u _size)
 {
-  while (root != NULL) {
-    BX_MSLEEP(1);
+  size = _size;
+  data = new Bit8u[size];
+  rpos = 0;
+  wpos = 0;
+}
+
+bx_audio_ringbuffer_c::~bx_audio_ringbuffer_c()
+{
+  delete [] data;
+}
+
+Bit32u bx_audio_ringbuffer_c::write(const Bit8u *src, Bit32u len)
+{
+  Bit32u pos = wpos;
+  Bit32u space = size - (pos - rpos);
+  Bit32u offset, len1;
+
+  if (len > space) len = space;
+  if (len == 0) return 0;
+  offset = pos % size;
+  len1 = size - offset;
+  if (len1 > len) len1 = len;
+  memcpy(data + offset, src, len1);
+  if (len > len1) {
+    memcpy(data, src + len1, len - len1);
   }
+  BX_MEMORY_BARRIER();
+  wpos = pos + len;
+  return len;
+}
+
+Bit32u bx_audio_ringbuffer_c::read(Bit8u *dst, Bit32u len)
+{
+  Bit32u pos = rpos;
+  Bit32u avail = wpos - pos;
+  Bit32u offset, len1;
+
+  if (len > avail) len = avail;
+  if (len == 0) return 0;
+  BX_MEMORY_BARRIER();
+  offset = pos % size;
+  len1 = size - offset;
+  if (len1 > len) len1 = len;
+  memcpy(dst, data + offset, len1);
+  if (len > len1) {
+    memcpy(dst + len1, data, len - len1);
+  }
+  BX_MEMORY_BARRIER();
+  rpos = pos + len;
+  return len;
 }
 
 // convert to float format for resampler
+// The loops are kept simple to let the compiler vectorize them.
 
 static void convert_to_float(Bit8u *src, unsigned srcsize, audio_buffer_t *audiobuf)
 {
-  unsigned i, j;
+  unsigned i, count;
   bx_pcm_param_t *param = &audiobuf->param;
   bool issigned = (param->format & 1);
-  bool setvol = (param->volume != BX_MAX_BIT16U);
-  Bit16s val16s;
-  Bit16u val16u;
   float volume[2];
 
   float *dst = audiobuf->fdata;
-  if (setvol) {
-    volume[0] = ((float)(param->volume & 0xff)) / 255.0F;
-    volume[1] = ((float)(param->volume >> 8)) / 255.0F;
-  }
   if (param->bits == 8) {
+    count = srcsize;
     if (issigned) {
-      for (i = 0; i < srcsize; i++) {
-        dst[i] = ((float)src[i]) / 128.0F;
-        if (setvol) {
-          dst[i] *= volume[i & 1];
-        }
+      for (i = 0; i < count; i++) {
+        dst[i] = ((float)(Bit8s)src[i]) * (1.0F / 128.0F);
       }
     } else {
-      for (i = 0; i < srcsize; i++) {
-        dst[i] = (((float)src[i]) - 128.0F) / 128.0F;
-        if (setvol) {
-          dst[i] *= volume[i & 1];
-        }
+      for (i = 0; i < count; i++) {
+        dst[i] = (((float)src[i]) - 128.0F) * (1.0F / 128.0F);
       }
     }
   } else {
-    j = 0;
+    count = srcsize >> 1;
     if (issigned) {
-      for (i = 0; i < srcsize; i += 2) {
-        val16s = (Bit16s)(src[i] | (src[i+1] << 8));
-        dst[j] = ((float)val16s) / 32768.0F;
-        if (setvol) {
-          dst[j] *= volume[i & 1];
-        }
-        j++;
+      for (i = 0; i < count; i++) {
+        dst[i] = ((float)(Bit16s)(src[i*2] | (src[i*2+1] << 8))) * (1.0F / 32768.0F);
       }
     } else {
-      for (i = 0; i < srcsize; i += 2) {
-        val16u = (Bit16u)(src[i] | (src[i+1] << 8));
-        dst[j] = (((float)val16u) - 32768.0F) / 32768.0F;
-        if (setvol) {
-          dst[j] *= volume[i & 1];
-        }
-        j++;
+      for (i = 0; i < count; i++) {
+        dst[i] = (((float)(src[i*2] | (src[i*2+1] << 8))) - 32768.0F) * (1.0F / 32768.0F);
+      }
+    }
+  }
+  if (param->volume != BX_MAX_BIT16U) {
+    volume[0] = ((float)(param->volume & 0xff)) / 255.0F;
+    volume[1] = ((float)(param->volume >> 8)) / 255.0F;
+    if (param->channels == 2) {
+      for (i = 0; i < (count & ~1); i += 2) {
+        dst[i] *= volume[0];
+        dst[i+1] *= volume[1];
+      }
+    } else {
+      for (i = 0; i < count; i++) {
+        dst[i] *= volume[0];
       }
     }
   }
@@ -157,13 +209,17 @@ static void convert_to_float(Bit8u *src, unsigned srcsize, audio_buffer_t *audio
 
 void convert_float_to_s16le(float *src, unsigned srcsize, Bit8u *dst)
 {
+  float val;
   Bit16s val16s;
-  unsigned i, j = 0;
+  unsigned i;
 
   for (i = 0; i < srcsize; i++) {
-    val16s = (Bit16s)(src[i] * 32768.0F);
-    dst[j++] =(Bit8u)(val16s & 0xff);
-    dst[j++] = (Bit8u)(val16s >> 8);
+    val = src[i] * 32768.0F;
+    val = (val > 32767.0F) ? 32767.0F : val;
+    val = (val < -32768.0F) ? -32768.0F : val;
+    val16s = (Bit16s)val;
+    dst[i*2] = (Bit8u)(val16s & 0xff);
+    dst[i*2+1] = (Bit8u)(val16s >> 8);
   }
 }
 
@@ -171,34 +227,18 @@ void convert_float_to_s16le(float *src, unsigned srcsize, Bit8u *dst)
 
 Bit32u pcm_callback(void *dev, Bit16u rate, Bit8u *buffer, Bit32u len)
 {
-  Bit32u copied = 0;
   UNUSED(rate);
   bx_soundlow_waveout_c *waveout = (bx_soundlow_waveout_c*)dev;
 
-  while (len > 0) {
-    audio_buffer_t *curbuffer = waveout->get_audio_buffer(1)->get_buffer();
-    if (curbuffer == NULL)
-      break;
-    Bit32u tmplen = curbuffer->size - curbuffer->pos;
-    if (tmplen > len) {
-      tmplen = len;
-    }
-    if (tmplen > 0) {
-      memcpy(buffer+copied, curbuffer->data+curbuffer->pos, tmplen);
-      curbuffer->pos += tmplen;
-      copied += tmplen;
-      len -= tmplen;
-    }
-    if (curbuffer->pos >= curbuffer->size) {
-      waveout->get_audio_buffer(1)->delete_buffer();
-    }
-  }
-  return copied;
+  return waveout->read_output(buffer, len);
 }
 
 // resampler & mixer thread support
+// The simulation thread wakes up the resampler thread after queueing data
+// and the resampler thread wakes up the mixer thread after converting it.
+// The mixer thread still polls the other wave callbacks (e.g. OPL, PC
+// speaker) if no data is present.
 
-BX_MUTEX(resampler_mutex);
 BX_MUTEX(mixer_mutex);
 int mixer_mutex_usage = 0;
 
@@ -206,16 +246,12 @@ BX_THREAD_FUNC(resampler_thread, indata)
 {
   bx_soundlow_waveout_c *waveout = (bx_soundlow_waveout_c*)indata;
   while (waveout->resampler_running()) {
-    BX_LOCK(resampler_mutex);
-    audio_buffer_t *curbuffer = waveout->get_audio_buffer(0)->get_buffer();
-    BX_UNLOCK(resampler_mutex);
+    audio_buffer_t *curbuffer = waveout->get_audio_buffer()->get_buffer();
     if (curbuffer != NULL) {
       waveout->resampler(curbuffer, NULL);
-      BX_LOCK(resampler_mutex);
-      waveout->get_audio_buffer(0)->delete_buffer();
-      BX_UNLOCK(resampler_mutex);
+      waveout->get_audio_buffer()->delete_buffer();
     } else {
-      BX_MSLEEP(20);
+      waveout->resampler_wait();
     }
   }
   BX_THREAD_EXIT;
@@ -233,7 +269,7 @@ BX_THREAD_FUNC(mixer_thread, indata)
     if (waveout->mixer_common(mixbuffer, len)) {
       waveout->output(len, mixbuffer);
     } else {
-      BX_MSLEEP(25);
+      waveout->mixer_wait(25);
     }
   }
   delete [] mixbuffer;
@@ -247,8 +283,12 @@ BX_THREAD_FUNC(mixer_thread, indata)
 bx_soundlow_waveout_c::bx_soundlow_waveout_c()
 {
   put("waveout", "WAVOUT");
-  audio_buffers[0] = new bx_audio_buffer_c(BUFTYPE_FLOAT);
-  audio_buffers[1] = new bx_audio_buffer_c(BUFTYPE_UCHAR);
+  audio_buffer = new bx_audio_buffer_c(BUFTYPE_FLOAT);
+  audio_ring = new bx_audio_ringbuffer_c(BX_SOUNDLOW_RINGBUFSIZE);
+  ring_full = 0;
+  bx_create_sem(&res_sem);
+  bx_create_sem(&mix_sem);
+  bx_create_sem(&ring_sem);
   real_pcm_param = default_pcm_param;
   cb_count = 0;
   pcm_callback_id = -1;
@@ -269,22 +309,27 @@ bx_soundlow_waveout_c::~bx_soundlow_waveout_c()
     unregister_wave_callback(pcm_callback_id);
     if (res_thread_start) {
       res_thread_start = 0;
-      BX_MSLEEP(20);
-      BX_FINI_MUTEX(resampler_mutex);
+      bx_set_sem(&res_sem);
+      bx_set_sem(&ring_sem);
+      BX_THREAD_JOIN(res_thread_var);
     }
     if (mix_thread_start) {
       mix_thread_start = 0;
-      BX_MSLEEP(30);
+      bx_set_sem(&mix_sem);
+      BX_THREAD_JOIN(mix_thread_var);
       if (mixer_mutex_usage > 0) {
         if (--mixer_mutex_usage == 0) {
           BX_FINI_MUTEX(mixer_mutex);
         }
       }
     }
-    if (audio_buffers[0] != NULL) {
-      delete audio_buffers[0];
-      delete audio_buffers[1];
-      audio_buffers[0] = NULL;
+    bx_destroy_sem(&res_sem);
+    bx_destroy_sem(&mix_sem);
+    bx_destroy_sem(&ring_sem);
+    if (audio_buffer != NULL) {
+      delete audio_buffer;
+      delete audio_ring;
+      audio_buffer = NULL;
     }
   }
 }
@@ -307,11 +352,13 @@ int bx_soundlow_waveout_c::sendwavepacket(int length, Bit8u data[], bx_pcm_param
 
   if (src_param->bits == 16) len1 >>= 1;
   if (pcm_callback_id >= 0) {
-    BX_LOCK(resampler_mutex);
-    audio_buffer_t *inbuffer = audio_buffers[0]->new_buffer(len1);
+    audio_buffer_t *inbuffer = audio_buffer->new_buffer(len1);
     memcpy(&inbuffer->param, src_param, sizeof(bx_pcm_param_t));
     convert_to_float(data, length, inbuffer);
-    BX_UNLOCK(resampler_mutex);
+    audio_buffer->add_buffer(inbuffer);
+    if (res_thread_start) {
+      bx_set_sem(&res_sem);
+    }
   } else {
     audio_buffer_t *inbuffer = new audio_buffer_t;
     inbuffer->fdata = new float[len1];
@@ -367,35 +414,24 @@ void bx_soundlow_waveout_c::unregister_wave_callback(int callback_id)
 
 bool bx_soundlow_waveout_c::mixer_common(Bit8u *buffer, int len)
 {
-  Bit32u count, len2 = 0, len3 = 0;
-  Bit16s src1, src2, dst_val;
+  Bit32u i, count, len2 = 0, len3 = 0;
   Bit32s tmp_val;
-  Bit8u *src, *dst;
 
   Bit8u *tmpbuffer = new Bit8u[len];
+  count = len / 2;
   BX_LOCK(mixer_mutex);
-  for (int i = 0; i < cb_count; i++) {
-    if (get_wave[i].cb != NULL) {
+  for (int n = 0; n < cb_count; n++) {
+    if (get_wave[n].cb != NULL) {
       memset(tmpbuffer, 0, len);
-      len2 = get_wave[i].cb(get_wave[i].device, real_pcm_param.samplerate, tmpbuffer, len);
+      len2 = get_wave[n].cb(get_wave[n].device, real_pcm_param.samplerate, tmpbuffer, len);
       if (len2 > 0) {
-        src = tmpbuffer;
-        dst = buffer;
-        count = len / 2;
-        while (count--) {
-          src1 = (src[0] | (src[1] << 8));
-          src2 = (dst[0] | (dst[1] << 8));
-          tmp_val = (Bit32s)src1 + (Bit32s)src2;
-          if (tmp_val > BX_MAX_BIT16S) {
-            tmp_val = BX_MAX_BIT16S;
-          } else if (tmp_val < BX_MIN_BIT16S) {
-            tmp_val = BX_MIN_BIT16S;
-          }
-          dst_val = (Bit16s)tmp_val;
-          dst[0] = dst_val & 0xff;
-          dst[1] = (Bit8u)(dst_val >> 8);
-          src += 2;
-          dst += 2;
+        for (i = 0; i < count; i++) {
+          tmp_val = (Bit32s)(Bit16s)(tmpbuffer[i*2] | (tmpbuffer[i*2+1] << 8)) +
+                    (Bit32s)(Bit16s)(buffer[i*2] | (buffer[i*2+1] << 8));
+          tmp_val = (tmp_val > BX_MAX_BIT16S) ? BX_MAX_BIT16S : tmp_val;
+          tmp_val = (tmp_val < BX_MIN_BIT16S) ? BX_MIN_BIT16S : tmp_val;
+          buffer[i*2] = (Bit8u)(tmp_val & 0xff);
+          buffer[i*2+1] = (Bit8u)(tmp_val >> 8);
         }
         if (len3 < len2) len3 = len2;
       }
@@ -413,10 +449,10 @@ void bx_soundlow_waveout_c::resampler(audio_buffer_t *inbuffer, audio_buffer_t *
 
   fcount = resampler_common(inbuffer, &fbuffer);
   if (outbuffer == NULL) {
-    BX_LOCK(mixer_mutex);
-    audio_buffer_t *newbuffer = audio_buffers[1]->new_buffer(fcount << 1);
-    convert_float_to_s16le(fbuffer, fcount, newbuffer->data);
-    BX_UNLOCK(mixer_mutex);
+    Bit8u *tmpbuffer = new Bit8u[fcount << 1];
+    convert_float_to_s16le(fbuffer, fcount, tmpbuffer);
+    write_output(tmpbuffer, fcount << 1);
+    delete [] tmpbuffer;
   } else {
     outbuffer->data = new Bit8u[fcount << 1];
     outbuffer->size = (fcount << 1);
@@ -427,18 +463,61 @@ void bx_soundlow_waveout_c::resampler(audio_buffer_t *inbuffer, audio_buffer_t *
   }
 }
 
+// Called by the resampler thread. If the ring buffer is full, wait until
+// the mixer has consumed some data.
+void bx_soundlow_waveout_c::write_output(Bit8u *data, Bit32u len)
+{
+  Bit32u written;
+
+  while ((len > 0) && res_thread_start) {
+    written = audio_ring->write(data, len);
+    data += written;
+    len -= written;
+    if (written > 0) {
+      bx_set_sem(&mix_sem);
+    }
+    if (len > 0) {
+      ring_full = 1;
+      BX_MEMORY_BARRIER();
+      if (audio_ring->used() == BX_SOUNDLOW_RINGBUFSIZE) {
+        bx_wait_sem_timeout(&ring_sem, 100);
+      }
+      ring_full = 0;
+    }
+  }
+}
+
+// Called by the mixer to get the converted PCM data
+Bit32u bx_soundlow_waveout_c::read_output(Bit8u *buffer, Bit32u len)
+{
+  Bit32u copied = audio_ring->read(buffer, len);
+
+  BX_MEMORY_BARRIER();
+  if ((copied > 0) && ring_full) {
+    bx_set_sem(&ring_sem);
+  }
+  return copied;
+}
+
+// Wait until all converted data has been played
+void bx_soundlow_waveout_c::flush_output()
+{
+  while ((audio_ring->used() > 0) && mix_thread_start) {
+    BX_MSLEEP(1);
+  }
+}
+
 Bit32u bx_soundlow_waveout_c::resampler_common(audio_buffer_t *inbuffer, float **fbuffer)
 {
-  unsigned i, j, fcount = 0;
+  unsigned i, fcount = 0;
   bx_pcm_param_t param = inbuffer->param;
 
   if (param.channels != real_pcm_param.channels) {
     if (param.channels == 1) {
       float *temp = new float[inbuffer->size * 2];
-      j = 0;
       for (i = 0; i < inbuffer->size; i++) {
-        temp[j++] = inbuffer->fdata[i];
-        temp[j++] = inbuffer->fdata[i];
+        temp[i*2] = inbuffer->fdata[i];
+        temp[i*2+1] = inbuffer->fdata[i];
       }
       delete [] inbuffer->fdata;
       inbuffer->fdata = temp;
@@ -476,7 +555,7 @@ Bit32u bx_soundlow_waveout_c::resampler_common(audio_buffer_t *inbuffer, float *
 #else
   if (param.samplerate != real_pcm_param.samplerate) {
     real_pcm_param.samplerate = param.samplerate;
-    audio_buffers[1]->flush();
+    flush_output();
     set_pcm_params(&real_pcm_param);
   }
   *fbuffer = new float[inbuffer->size];
@@ -488,7 +567,6 @@ Bit32u bx_soundlow_waveout_c::resampler_common(audio_buffer_t *inbuffer, float *
 
 void bx_soundlow_waveout_c::start_resampler_thread()
 {
-  BX_INIT_MUTEX(resampler_mutex);
   res_thread_start = 1;
   BX_THREAD_CREATE(resampler_thread, this, res_thread_var);
 }
@@ -67,24 +67,49 @@ typedef struct _audio_buffer_t
   struct _audio_buffer_t *next;
 } audio_buffer_t;
 
+// Single producer / single consumer queue of audio buffers (no locking).
+// The producer fills a buffer returned by new_buffer() and appends it with
+// add_buffer(). The consumer processes the buffer returned by get_buffer()
+// and then removes it with delete_buffer().
+
 class bx_audio_buffer_c {
 public:
   bx_audio_buffer_c(Bit8u format);
   ~bx_audio_buffer_c();
 
   audio_buffer_t *new_buffer(Bit32u size);
+  void add_buffer(audio_buffer_t *buffer);
   audio_buffer_t *get_buffer();
   void delete_buffer();
-  void flush();
 private:
+  void free_buffer(audio_buffer_t *buffer);
+
   Bit8u format;
-  audio_buffer_t *root;
+  audio_buffer_t *root; // already consumed entry, owned by the consumer
+  audio_buffer_t *last; // owned by the producer
+};
+
+// Single producer / single consumer ring buffer for the output data
+
+#define BX_SOUNDLOW_RINGBUFSIZE  131072
+
+class bx_audio_ringbuffer_c {
+public:
+  bx_audio_ringbuffer_c(Bit32u size);
+  ~bx_audio_ringbuffer_c();
+
+  Bit32u write(const Bit8u *src, Bit32u len);
+  Bit32u read(Bit8u *dst, Bit32u len);
+  Bit32u used() {return wpos - rpos;}
+private:
+  Bit8u *data;
+  Bit32u size;
+  volatile Bit32u rpos, wpos;
 };
 
 void convert_float_to_s16le(float *src, unsigned srcsize, Bit8u *dst);
 BOCHSAPI_MSVCONLY Bit32u pcm_callback(void *dev, Bit16u rate, Bit8u *buffer, Bit32u len);
 
-extern BX_MUTEX(resampler_mutex);
 #ifndef __ANDROID__
 extern BX_MUTEX(mixer_mutex);
 #endif
@@ -113,12 +138,17 @@ public:
   bool resampler_running() {return res_thread_start;}
   bool mixer_running() {return mix_thread_start;}
 
-  bx_audio_buffer_c *get_audio_buffer(int n) {return audio_buffers[n];}
+  bx_audio_buffer_c *get_audio_buffer() {return audio_buffer;}
+  void resampler_wait() {bx_wait_sem(&res_sem);}
+  void mixer_wait(unsigned msec) {bx_wait_sem_timeout(&mix_sem, msec);}
+  Bit32u read_output(Bit8u *buffer, Bit32u len);
 
 protected:
   void start_resampler_thread(void);
   void start_mixer_thread(void);
   Bit32u resampler_common(audio_buffer_t *inbuffer, float **fbuffer);
+  void write_output(Bit8u *data, Bit32u len);
+  void flush_output(void);
 
   bx_pcm_param_t real_pcm_param;
   bool res_thread_start;
@@ -128,7 +158,12 @@ protected:
 #if BX_HAVE_LIBSAMPLERATE || BX_HAVE_SOXR_LSR
   SRC_STATE *src_state;
 #endif
-  bx_audio_buffer_c *audio_buffers[2];
+  bx_audio_buffer_c *audio_buffer;
+  bx_audio_ringbuffer_c *audio_ring;
+  bx_thread_sem_t res_sem;
+  bx_thread_sem_t mix_sem;
+  bx_thread_sem_t ring_sem;
+  volatile bool ring_full;
 
   int cb_count;
   struct {
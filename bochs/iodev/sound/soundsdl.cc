@@ -141,12 +141,12 @@ void bx_soundlow_waveout_sdl_c::resampler(audio_buffer_t *inbuffer, audio_buffer
 
   UNUSED(outbuffer);
   fcount = resampler_common(inbuffer, &fbuffer);
-  SDL_LockAudio();
   if (WaveOutOpen) {
-    audio_buffer_t *newbuffer = audio_buffers[1]->new_buffer(fcount << 1);
-    convert_float_to_s16le(fbuffer, fcount, newbuffer->data);
+    Bit8u *tmpbuffer = new Bit8u[fcount << 1];
+    convert_float_to_s16le(fbuffer, fcount, tmpbuffer);
+    write_output(tmpbuffer, fcount << 1);
+    delete [] tmpbuffer;
   }
-  SDL_UnlockAudio();
   if (fbuffer != NULL) {
     delete [] fbuffer;
   }
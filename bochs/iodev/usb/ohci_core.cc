@@ -152,6 +152,9 @@ void bx_ohci_core_c::reset_hc()
 {
   // reset locals
   hub.ohci_done_count = 7;
+  hub.idle_frames = 0;
+  hub.timer_idle = 0;
+  bx_pc_system.activate_timer(hub.timer_index, 1000, 1);
 
   // HcRevision
   hub.op_regs.HcRevision         = 0x0110;
@@ -356,6 +359,8 @@ void bx_ohci_core_c::ohci_register_state(bx_list_c *parent)
   BXRS_PARAM_BOOL(hub1, use_control_head, hub.use_control_head);
   BXRS_PARAM_BOOL(hub1, use_bulk_head, hub.use_bulk_head);
   BXRS_DEC_PARAM_FIELD(hub1, sof_time, hub.sof_time);
+  BXRS_DEC_PARAM_FIELD(hub1, idle_frames, hub.idle_frames);
+  BXRS_PARAM_BOOL(hub1, timer_idle, hub.timer_idle);
   // TODO: handle async packets
   register_pci_state(hub1);
 }
@@ -487,6 +492,10 @@ bool bx_ohci_core_c::mem_read(bx_phy_address addr, unsigned len, void *data)
 
     case 0x3C: // HcFmNumber
       val = hub.op_regs.HcFmNumber;
+      if (hub.op_regs.HcControl.hcfs == OHCI_USB_OPERATIONAL) {
+        // add the frames skipped by the idle frame timer
+        val = (val + (Bit32u) ((bx_pc_system.time_usec() - hub.sof_time) / 1000)) & 0xffff;
+      }
       break;
 
     case 0x40: // HcPeriodicStart
@@ -598,6 +607,8 @@ bool bx_ohci_core_c::mem_write(bx_phy_address addr, unsigned len, void *data)
     return 1;
   }
 
+  ohci_timer_wakeup();
+
   switch (offset) {
     case 0x00: // HcRevision
       BX_ERROR(("Write to HcRevision ignored"));
@@ -618,8 +629,10 @@ bool bx_ohci_core_c::mem_write(bx_phy_address addr, unsigned len, void *data)
       hub.op_regs.HcControl.cbsr     = (value & (3<< 0)) >>  0;
       if (hub.op_regs.HcControl.hcfs == OHCI_USB_OPERATIONAL) {
         hub.op_regs.HcFmRemainingToggle = 0;
-        if (org_state != OHCI_USB_OPERATIONAL)
+        if (org_state != OHCI_USB_OPERATIONAL) {
           hub.use_control_head = hub.use_bulk_head = 1;
+          hub.sof_time = bx_pc_system.time_usec();
+        }
       }
       break;
 
@@ -631,6 +644,9 @@ bool bx_ohci_core_c::mem_write(bx_phy_address addr, unsigned len, void *data)
       if (value & (1<< 3)) hub.op_regs.HcCommandStatus.ocr = 1;
       if (value & (1<< 2)) hub.op_regs.HcCommandStatus.blf = 1;
       if (value & (1<< 1)) hub.op_regs.HcCommandStatus.clf = 1;
+      // control / bulk list filled: don't wait for the next frame
+      if ((value & (3<< 1)) && (hub.op_regs.HcControl.hcfs == OHCI_USB_OPERATIONAL))
+        process_lists();
       if (value & (1<< 0)) {
         hub.op_regs.HcCommandStatus.hcr = 1;
         reset_hc();
@@ -893,8 +909,12 @@ bool bx_ohci_core_c::mem_write(bx_phy_address addr, unsigned len, void *data)
 Bit32u bx_ohci_core_c::get_frame_remaining(void)
 {
   Bit16u bit_time, fr;
+  Bit64u elapsed = bx_pc_system.time_usec() - hub.sof_time;
 
-  bit_time = (Bit16u)((bx_pc_system.time_usec() - hub.sof_time) * 12);
+  if (hub.timer_idle) {
+    elapsed %= 1000;
+  }
+  bit_time = (Bit16u)(elapsed * 12);
   if ((hub.op_regs.HcControl.hcfs != OHCI_USB_OPERATIONAL) ||
       (bit_time > hub.op_regs.HcFmInterval.fi)) {
     fr = 0;
@@ -914,24 +934,30 @@ void bx_ohci_core_c::ohci_timer_handler(void *this_ptr)
 void bx_ohci_core_c::ohci_timer(void)
 {
   struct OHCI_ED cur_ed;
-  Bit32u address, ed_address;
+  Bit32u address, ed_address, done_head;
   Bit16u zero = 0;
 
   if (hub.op_regs.HcControl.hcfs == OHCI_USB_OPERATIONAL) {
 #if BX_USB_DEBUGGER
     SIM->usb_debug_trigger(USB_DEBUG_OHCI, USB_DEBUG_FRAME, 0, 0, 0);
 #endif
+    // frames skipped by the idle frame timer are added to the frame number
+    Bit64u now = bx_pc_system.time_usec();
+    Bit32u frames = (Bit32u) ((now - hub.sof_time) / 1000);
+    if (frames == 0) frames = 1;
+
     // set remaining to the interval amount.
     hub.op_regs.HcFmRemainingToggle = hub.op_regs.HcFmInterval.fit;
-    hub.sof_time = bx_pc_system.time_usec();
+    hub.sof_time = now;
 
     // The Frame Number Register is incremented
     //  every time bit 15 is changed (at 0x8000 or 0x0000), fno is fired.
-    hub.op_regs.HcFmNumber++;
+    Bit32u old_frame = hub.op_regs.HcFmNumber;
+    hub.op_regs.HcFmNumber += frames;
     hub.op_regs.HcFmNumber &= 0xffff;
     DEV_MEM_WRITE_PHYSICAL(hub.op_regs.HcHCCA + 0x80, 2, (Bit8u *) &hub.op_regs.HcFmNumber);
     DEV_MEM_WRITE_PHYSICAL(hub.op_regs.HcHCCA + 0x82, 2, (Bit8u *) &zero);
-    if ((hub.op_regs.HcFmNumber == 0x8000) || (hub.op_regs.HcFmNumber == 0x0000)) {
+    if ((old_frame ^ hub.op_regs.HcFmNumber) & 0x8000) {
       set_interrupt(OHCI_INTR_FNO);
     }
 
@@ -956,6 +982,7 @@ void bx_ohci_core_c::ohci_timer(void)
     if ((hub.ohci_done_count != 7) && (hub.ohci_done_count > 0))
       hub.ohci_done_count--;
 
+    done_head = hub.op_regs.HcDoneHead;
     process_lists();
 
     // do the ED's in the interrupt table
@@ -972,9 +999,51 @@ void bx_ohci_core_c::ohci_timer(void)
       }
     }
 
+    ohci_update_timer((hub.op_regs.HcDoneHead != done_head) ||
+                      (hub.ohci_done_count != 7) ||
+                      hub.op_regs.HcCommandStatus.clf || hub.op_regs.HcCommandStatus.blf ||
+                      (hub.op_regs.HcControlCurrentED != 0) || (hub.op_regs.HcBulkCurrentED != 0) ||
+                      ((hub.op_regs.HcInterruptEnable & OHCI_INTR_SF) != 0));
+  } else {
+    ohci_update_timer(0);
   }  // end run schedule
 }
 
+// The frame timer is stopped while the controller is not operational.
+// After OHCI_IDLE_FRAMES frames without a retired TD, pending list or
+// SOF interrupt request it only fires every OHCI_IDLE_INTERVAL frames
+// until a register write or a device event wakes it up again.
+void bx_ohci_core_c::ohci_update_timer(bool active)
+{
+  if (hub.op_regs.HcControl.hcfs != OHCI_USB_OPERATIONAL) {
+    if (!hub.timer_idle) {
+      bx_pc_system.deactivate_timer(hub.timer_index);
+      hub.timer_idle = 1;
+    }
+  } else if (active) {
+    hub.idle_frames = 0;
+    if (hub.timer_idle) {
+      hub.timer_idle = 0;
+      bx_pc_system.activate_timer(hub.timer_index, 1000, 1);
+    }
+  } else if ((hub.idle_frames < OHCI_IDLE_FRAMES) &&
+             (++hub.idle_frames == OHCI_IDLE_FRAMES)) {
+    BX_DEBUG(("schedule idle, frame timer slowed down"));
+    hub.timer_idle = 1;
+    bx_pc_system.activate_timer(hub.timer_index, OHCI_IDLE_INTERVAL * 1000, 1);
+  }
+}
+
+void bx_ohci_core_c::ohci_timer_wakeup(void)
+{
+  hub.idle_frames = 0;
+  if (hub.timer_idle) {
+    // the skipped frames are accounted for by the next timer event
+    hub.timer_idle = 0;
+    bx_pc_system.activate_timer(hub.timer_index, 1000, 1);
+  }
+}
+
 void bx_ohci_core_c::process_lists(void)
 {
   struct OHCI_ED cur_ed;
@@ -1109,8 +1178,13 @@ int bx_ohci_core_c::event_handler(int event, void *ptr, int port)
       p = container_of_usb_packet(ptr);
       p->done = 1;
       process_lists();
+      ohci_timer_wakeup();
+      break;
+    case USB_EVENT_DATA_READY:
+      ohci_timer_wakeup();
       break;
     case USB_EVENT_WAKEUP:
+      ohci_timer_wakeup();
       if (hub.usb_port[port].HcRhPortStatus.pss) {
         hub.usb_port[port].HcRhPortStatus.pss = 0;
         hub.usb_port[port].HcRhPortStatus.pssc = 1;
@@ -1371,6 +1445,7 @@ bool bx_ohci_core_c::set_connect_status(Bit8u port, bool connected)
 
   usb_device_c *device = hub.usb_port[port].device;
   if (device != NULL) {
+    ohci_timer_wakeup();
     if (connected) {
       switch (device->get_speed()) {
         case USB_SPEED_LOW:
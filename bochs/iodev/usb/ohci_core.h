@@ -24,6 +24,12 @@
 
 #define USB_OHCI_PORTS 2
 
+// after this number of frames without a retired TD the frame timer only
+// runs every OHCI_IDLE_INTERVAL frames (the frame number still counts
+// every frame)
+#define OHCI_IDLE_FRAMES    32
+#define OHCI_IDLE_INTERVAL  8
+
 // HCFS values
 #define  OHCI_USB_RESET       0x00
 #define  OHCI_USB_RESUME      0x01
@@ -135,6 +141,8 @@ struct OHCI_ISO_TD {
 
 typedef struct {
   int   timer_index;
+  int   idle_frames;  // frames without a retired TD
+  bool  timer_idle;   // frame timer slowed down or stopped
 
   struct OHCI_OP_REGS {
     Bit16u HcRevision;
@@ -262,6 +270,8 @@ protected:
 
   static void ohci_timer_handler(void *);
   void ohci_timer(void);
+  void ohci_update_timer(bool active);
+  void ohci_timer_wakeup(void);
 
   Bit32u get_frame_remaining(void);
 
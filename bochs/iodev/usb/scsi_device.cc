@@ -1792,10 +1792,7 @@ void scsi_device_t::seek_complete(SCSIRequest *r)
       n = SCSI_DMA_BUF_SIZE / block_size;
     r->buf_len = n * block_size;
     if (type == SCSIDEV_TYPE_CDROM) {
-      i = 0;
-      do {
-        ret = (int) cdrom->read_block(r->dma_buf + (i * 2048), (Bit32u) (r->sector + i), 2048);
-      } while ((++i < n) && (ret == 1));
+      ret = (int) cdrom->read_blocks(r->dma_buf, (Bit32u) r->sector, n, 2048);
       if (ret == 0) {
         scsi_command_complete(r, STATUS_CHECK_CONDITION, SENSE_MEDIUM_ERROR, 0, 0);
         return;
@@ -132,6 +132,10 @@ void bx_uhci_core_c::reset_uhci(unsigned type)
 
   // reset locals
   global_reset = 0;
+  hub.idle_frames = 0;
+  hub.timer_idle = 0;
+  hub.frame_time = bx_pc_system.time_usec();
+  bx_pc_system.activate_timer(hub.timer_index, 1000, 1);
 
   // Put the USB registers into their RESET state
   hub.usb_command.max_packet_size = 0;
@@ -212,6 +216,9 @@ void bx_uhci_core_c::uhci_register_state(bx_list_c *parent)
   BXRS_HEX_PARAM_FIELD(hub1, frame_num, hub.usb_frame_num.frame_num);
   BXRS_HEX_PARAM_FIELD(hub1, frame_base, hub.usb_frame_base.frame_base);
   BXRS_HEX_PARAM_FIELD(hub1, sof_timing, hub.usb_sof.sof_timing);
+  BXRS_DEC_PARAM_FIELD(hub1, idle_frames, hub.idle_frames);
+  BXRS_PARAM_BOOL(hub1, timer_idle, hub.timer_idle);
+  BXRS_DEC_PARAM_FIELD(hub1, frame_time, hub.frame_time);
   for (j=0; j<USB_UHCI_PORTS; j++) {
     sprintf(portnum, "port%d", j+1);
     port = new bx_list_c(hub1, portnum);
@@ -313,6 +320,10 @@ Bit32u bx_uhci_core_c::read(Bit32u address, unsigned io_len)
 
     case 0x06: // frame number register (16-bit)
       val = hub.usb_frame_num.frame_num;
+      if (hub.timer_idle && hub.usb_command.schedule) {
+        // add the frames skipped by the idle frame timer
+        val = (val + (Bit32u) ((bx_pc_system.time_usec() - hub.frame_time) / 1000)) & 0x7FF;
+      }
       break;
 
     case 0x08: // frame base register (32-bit)
@@ -385,6 +396,8 @@ void bx_uhci_core_c::write(Bit32u address, Bit32u value, unsigned io_len)
 
   BX_DEBUG(("register write to  address 0x%04X:  0x%08X (%2i bits)", (unsigned) address, (unsigned) value, io_len * 8));
 
+  uhci_timer_wakeup();
+
   switch (offset) {
     case 0x00: // command register (16-bit) (R/W)
       if (value & 0xFF00)
@@ -661,6 +674,7 @@ void bx_uhci_core_c::uhci_timer(void)
       hub.usb_port[i].over_current_change = 0;
       hub.usb_port[i].suspend = 0;
     }
+    uhci_update_timer(0);
     return;
   }
 
@@ -672,9 +686,21 @@ void bx_uhci_core_c::uhci_timer(void)
     int  count = USB_UHCI_LOOP_COUNT;
     int  bytes_processed = 0; // The UHCI (USB 1.1) allows up to 1280 bytes to be processed per frame.
     bool interrupt = 0, shortpacket = 0, stalled = 0;
+    bool active = 0;
     Bit32u item, queue_addr = 0;
     struct QUEUE queue;
     struct TD td;
+    Bit64u now = bx_pc_system.time_usec();
+
+    if (hub.timer_idle) {
+      // account for the frames skipped since the last timer event
+      Bit32u frames = (Bit32u) ((now - hub.frame_time) / 1000);
+      if (frames > 1) {
+        hub.usb_frame_num.frame_num = (hub.usb_frame_num.frame_num + frames - 1) & 0x7FF;
+      }
+    }
+    hub.frame_time = now;
+
     Bit32u address = hub.usb_frame_base.frame_base +
                    ((hub.usb_frame_num.frame_num & 0x3FF) * sizeof(Bit32u));
 
@@ -764,6 +790,8 @@ void bx_uhci_core_c::uhci_timer(void)
             }
           }
           if (td.dword1 & (1<<22)) stalled = was_stall = 1;
+          // a NAK'ed TD stays active
+          if (!(td.dword1 & (1<<23))) active = 1;
 
           // write back the status to the TD
           DEV_MEM_WRITE_PHYSICAL(address + sizeof(Bit32u), sizeof(Bit32u), (Bit8u *) &td.dword1);
@@ -836,13 +864,17 @@ void bx_uhci_core_c::uhci_timer(void)
 
     // if we needed to fire an interrupt now, lets do it *after* we increment the frame_num register
     update_irq();
+
+    uhci_update_timer(active);
   }  // end run schedule
 
   // if host turned off the schedule, set the halted bit in the status register
   // Note: Can not use an else from the if() above since the host can changed this bit
   //  while we are processing a frame.
-  if (hub.usb_command.schedule == 0)
+  if (hub.usb_command.schedule == 0) {
     hub.usb_status.host_halted = 1;
+    uhci_update_timer(0);
+  }
 
   // TODO ?:
   //  If in Global_Suspend mode and any of usb_port[i] bits 6,3, or 1 are set,
@@ -850,6 +882,49 @@ void bx_uhci_core_c::uhci_timer(void)
   //    However, since we don't do anything, let's not.
 }
 
+// The frame timer is stopped while the schedule is not running. After
+// USB_UHCI_IDLE_FRAMES frames without a completed transfer (e.g. only NAK'ed
+// interrupt TDs) it only fires every USB_UHCI_IDLE_INTERVAL frames until a
+// register write or a device event wakes it up again.
+void bx_uhci_core_c::uhci_update_timer(bool active)
+{
+  if (!hub.usb_command.schedule || global_reset) {
+    if (!hub.timer_idle) {
+      bx_pc_system.deactivate_timer(hub.timer_index);
+      hub.timer_idle = 1;
+    }
+  } else if (active) {
+    hub.idle_frames = 0;
+    if (hub.timer_idle) {
+      hub.timer_idle = 0;
+      bx_pc_system.activate_timer(hub.timer_index, 1000, 1);
+    }
+  } else if ((hub.idle_frames < USB_UHCI_IDLE_FRAMES) &&
+             (++hub.idle_frames == USB_UHCI_IDLE_FRAMES)) {
+    BX_DEBUG(("schedule idle, frame timer slowed down"));
+    hub.timer_idle = 1;
+    bx_pc_system.activate_timer(hub.timer_index, USB_UHCI_IDLE_INTERVAL * 1000, 1);
+  }
+}
+
+void bx_uhci_core_c::uhci_timer_wakeup(void)
+{
+  hub.idle_frames = 0;
+  if (hub.timer_idle) {
+    Bit64u now = bx_pc_system.time_usec();
+    if (hub.usb_command.schedule && !global_reset) {
+      // catch up with the frames skipped so far
+      Bit32u frames = (Bit32u) ((now - hub.frame_time) / 1000);
+      hub.usb_frame_num.frame_num = (hub.usb_frame_num.frame_num + frames) & 0x7FF;
+      hub.frame_time += (Bit64u) frames * 1000;
+    } else {
+      hub.frame_time = now;
+    }
+    hub.timer_idle = 0;
+    bx_pc_system.activate_timer(hub.timer_index, 1000, 1);
+  }
+}
+
 int uhci_event_handler(int event, void *ptr, void *dev, int port)
 {
   if (dev != NULL) {
@@ -869,8 +944,13 @@ int bx_uhci_core_c::event_handler(int event, void *ptr, int port)
       BX_DEBUG(("Async packet completion"));
       p = container_of_usb_packet(ptr);
       p->done = 1;
+      uhci_timer_wakeup();
+      break;
+    case USB_EVENT_DATA_READY:
+      uhci_timer_wakeup();
       break;
     case USB_EVENT_WAKEUP:
+      uhci_timer_wakeup();
       if (hub.usb_port[port].suspend && !hub.usb_port[port].resume) {
         hub.usb_port[port].resume = 1;
       }
@@ -1096,6 +1176,7 @@ bool bx_uhci_core_c::set_connect_status(Bit8u port, bool connected)
 {
   usb_device_c *device = hub.usb_port[port].device;
   if (device != NULL) {
+    uhci_timer_wakeup();
     if (connected) {
       BX_DEBUG(("port #%d: speed = %s", port+1, usb_speed[device->get_speed()]));
       switch (device->get_speed()) {
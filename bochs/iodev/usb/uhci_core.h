@@ -36,6 +36,12 @@
 // the standard max bandwidth (bytes per frame) for the UHCI is 1280 bytes
 #define USB_UHCI_STD_MAX_BANDWIDTH  1280
 
+// after this number of frames without a completed transfer the frame timer
+// only runs every USB_UHCI_IDLE_INTERVAL frames (the frame number still
+// counts every frame)
+#define USB_UHCI_IDLE_FRAMES    32
+#define USB_UHCI_IDLE_INTERVAL  8
+
 struct USB_UHCI_QUEUE_STACK {
   int    queue_cnt;
   Bit32u queue_stack[USB_UHCI_QUEUE_STACK_SIZE];
@@ -43,6 +49,9 @@ struct USB_UHCI_QUEUE_STACK {
 
 typedef struct {
   int    timer_index;
+  int    idle_frames;    // frames without a completed transfer
+  bool   timer_idle;     // frame timer slowed down or stopped
+  Bit64u frame_time;     // time of the last processed frame (usec)
 
   // Registers
   // Base + 0x00  Command register
@@ -214,6 +223,8 @@ protected:
   bool uhci_add_queue(struct USB_UHCI_QUEUE_STACK *stack, const Bit32u addr);
   static void uhci_timer_handler(void *);
   void uhci_timer(void);
+  void uhci_update_timer(bool active);
+  void uhci_timer_wakeup(void);
   bool DoTransfer(Bit32u address, struct TD *);
   void set_status(struct TD *td, bool active, bool stalled, bool data_buffer_error, bool babble,
     bool nak, bool crc_time_out, bool bitstuff_error, Bit16u act_len);
@@ -148,6 +148,9 @@ typedef struct USBPacket USBPacket;
 // packet events
 #define USB_EVENT_WAKEUP        0
 #define USB_EVENT_ASYNC         1
+// a device that NAKs an interrupt IN endpoint must send this event when it
+// has new data, since idle host controllers may stop polling it
+#define USB_EVENT_DATA_READY    2
 // controller events
 #define USB_EVENT_DEFAULT_SPEED  10
 #define USB_EVENT_CHECK_SPEED    11
@@ -442,6 +442,7 @@ void bx_usb_ehci_c::register_state(void)
   BXRS_DEC_PARAM_FIELD(hub, astate, BX_EHCI_THIS hub.astate);
   BXRS_DEC_PARAM_FIELD(hub, last_run_usec, BX_EHCI_THIS hub.last_run_usec);
   BXRS_DEC_PARAM_FIELD(hub, async_stepdown, BX_EHCI_THIS hub.async_stepdown);
+  BXRS_PARAM_BOOL(hub, frame_timer_idle, BX_EHCI_THIS hub.frame_timer_idle);
   op_regs = new bx_list_c(hub, "op_regs");
   reg = new bx_list_c(op_regs, "UsbCmd");
   BXRS_HEX_PARAM_FIELD(reg, itc, BX_EHCI_THIS hub.op_regs.UsbCmd.itc);
@@ -560,6 +561,10 @@ void bx_usb_ehci_c::reset_hc()
   BX_EHCI_THIS queues_rip_all(0);
   BX_EHCI_THIS queues_rip_all(1);
   BX_EHCI_THIS update_irq();
+
+  BX_EHCI_THIS hub.async_stepdown = 0;
+  BX_EHCI_THIS hub.frame_timer_idle = 0;
+  bx_pc_system.activate_timer(BX_EHCI_THIS hub.frame_timer_index, FRAME_TIMER_USEC, 1);
 }
 
 void bx_usb_ehci_c::reset_port(int p)
@@ -625,6 +630,7 @@ bool bx_usb_ehci_c::set_connect_status(Bit8u port, bool connected)
 
   usb_device_c *device = BX_EHCI_THIS hub.usb_port[port].device;
   if (device != NULL) {
+    BX_EHCI_THIS ehci_timer_wakeup();
     if (connected) {
       if (BX_EHCI_THIS hub.usb_port[port].portsc.po) {
         if (get_port_routing(port, &n_cc, &n_pcc)) {
@@ -857,6 +863,11 @@ bool bx_usb_ehci_c::read_handler(bx_phy_address addr, unsigned len, void *data,
           break;
         case 0x0c:
           val = BX_EHCI_THIS hub.op_regs.FrIndex;
+          if (BX_EHCI_THIS hub.frame_timer_idle && BX_EHCI_THIS hub.op_regs.UsbCmd.rs) {
+            // add the frames not yet accounted for by the slowed down frame timer
+            val += (Bit32u) ((bx_pc_system.time_usec() - BX_EHCI_THIS hub.last_run_usec) / FRAME_TIMER_USEC) * 8;
+            val &= 0x3fff;
+          }
           break;
         case 0x10:
           val = BX_EHCI_THIS hub.op_regs.CtrlDsSegment;
@@ -954,6 +965,7 @@ bool bx_usb_ehci_c::write_handler(bx_phy_address addr, unsigned len, void *data,
 #endif
 
   if (offset >= OPS_REGS_OFFSET) {
+    BX_EHCI_THIS ehci_timer_wakeup();
     // Specs say that we should write dwords only
     if (len == 4) {
       switch (offset - OPS_REGS_OFFSET) {
@@ -973,6 +985,10 @@ bool bx_usb_ehci_c::write_handler(bx_phy_address addr, unsigned len, void *data,
             BX_EHCI_THIS hub.op_regs.UsbCmd.hcreset = 0;
           }
           if (BX_EHCI_THIS hub.op_regs.UsbCmd.rs) {
+            if (BX_EHCI_THIS hub.op_regs.UsbSts.hchalted) {
+              // the frame timer may have been stopped while halted
+              BX_EHCI_THIS hub.last_run_usec = bx_pc_system.time_usec();
+            }
             BX_EHCI_THIS hub.op_regs.UsbSts.hchalted = 0;
           } else {
             BX_EHCI_THIS hub.op_regs.UsbSts.hchalted = 1;
@@ -1476,12 +1492,17 @@ int bx_usb_ehci_c::event_handler(int event, void *ptr, int port)
       if (p->queue->async) {
         BX_EHCI_THIS advance_async_state();
       }
+      BX_EHCI_THIS ehci_timer_wakeup();
+      break;
+    case USB_EVENT_DATA_READY:
+      BX_EHCI_THIS ehci_timer_wakeup();
       break;
     case USB_EVENT_WAKEUP:
       if (BX_EHCI_THIS hub.usb_port[port].portsc.sus) {
         BX_EHCI_THIS hub.usb_port[port].portsc.fpr = 1;
         raise_irq(USBSTS_PCD);
       }
+      BX_EHCI_THIS ehci_timer_wakeup();
       break;
 
     // host controller events start here
@@ -2436,8 +2457,30 @@ void bx_usb_ehci_c::ehci_frame_timer(void)
     need_timer++;
     BX_EHCI_THIS hub.async_stepdown = 0;
   }
-  if (need_timer) {
-    // TODO: modify timer not implemented
+  if (need_timer && (BX_EHCI_THIS hub.async_stepdown == 0)) {
+    if (BX_EHCI_THIS hub.frame_timer_idle) {
+      BX_EHCI_THIS hub.frame_timer_idle = 0;
+      bx_pc_system.activate_timer(BX_EHCI_THIS hub.frame_timer_index, FRAME_TIMER_USEC, 1);
+    }
+  } else if (BX_EHCI_THIS hub.op_regs.UsbSts.hchalted) {
+    // nothing to do until the guest sets the run bit
+    bx_pc_system.deactivate_timer(BX_EHCI_THIS hub.frame_timer_index);
+    BX_EHCI_THIS hub.frame_timer_idle = 1;
+  } else {
+    // step down the frame rate while the schedules are idle
+    bx_pc_system.activate_timer(BX_EHCI_THIS hub.frame_timer_index,
+                                FRAME_TIMER_USEC * (BX_EHCI_THIS hub.async_stepdown + 1), 1);
+    BX_EHCI_THIS hub.frame_timer_idle = 1;
+  }
+}
+
+// called on register writes and device events
+void bx_usb_ehci_c::ehci_timer_wakeup(void)
+{
+  BX_EHCI_THIS hub.async_stepdown = 0;
+  if (BX_EHCI_THIS hub.frame_timer_idle) {
+    BX_EHCI_THIS hub.frame_timer_idle = 0;
+    bx_pc_system.activate_timer(BX_EHCI_THIS hub.frame_timer_index, FRAME_TIMER_USEC, 1);
   }
 }
 
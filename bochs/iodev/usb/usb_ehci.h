@@ -242,6 +242,7 @@ typedef struct {
 
   Bit64u last_run_usec;
   Bit32u async_stepdown;
+  bool   frame_timer_idle;  // frame timer slowed down or stopped
 
   struct {
     Bit8u  CapLength;
@@ -429,6 +430,7 @@ private:
   // EHCI frame timer
   static void ehci_frame_handler(void *);
   void ehci_frame_timer(void);
+  void ehci_timer_wakeup(void);
 
 #if BX_USE_USB_EHCI_SMF
   static bool read_handler(bx_phy_address addr, unsigned len, void *data, void *param);
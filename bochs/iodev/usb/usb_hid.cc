@@ -1878,6 +1878,9 @@ void usb_hid_device_c::mouse_enq(int delta_x, int delta_y, int delta_z, unsigned
       s.has_events = 1;
     }
   }
+  if (s.has_events) {
+    hc_event(USB_EVENT_DATA_READY, this);
+  }
 }
 
 int usb_hid_device_c::keyboard_poll(Bit8u *buf, bool force)
@@ -1984,6 +1987,9 @@ bool usb_hid_device_c::gen_scancode(Bit32u key)
       s.has_events = 1;
     }
   }
+  if (s.has_events) {
+    hc_event(USB_EVENT_DATA_READY, this);
+  }
   return 1;
 }
 
@@ -2021,6 +2027,7 @@ void usb_hid_device_c::hid_timer_handler(void *this_ptr)
 void usb_hid_device_c::hid_idle_timer()
 {
   s.has_events = 1;
+  hc_event(USB_EVENT_DATA_READY, this);
 }
 
 #endif // BX_SUPPORT_PCI && BX_SUPPORT_PCIUSB
@@ -489,6 +489,7 @@ int usb_hub_device_c::handle_control(int request, int value, int index, int leng
             /* set enable bit */
             hub.usb_port[n].PortStatus |= PORT_STAT_ENABLE;
             hub.usb_port[n].PortStatus &= ~PORT_STAT_SUSPEND;
+            hc_event(USB_EVENT_DATA_READY, this);
           }
           break;
         case PORT_POWER:
@@ -760,6 +761,12 @@ int usb_hub_device_c::event_handler(int event, void *ptr, int port)
         d.event.cb(USB_EVENT_WAKEUP, NULL, d.event.dev, d.event.port);
       }
       break;
+    case USB_EVENT_DATA_READY:
+      // forward to the host controller
+      if (d.event.dev != NULL) {
+        d.event.cb(USB_EVENT_DATA_READY, ptr, d.event.dev, d.event.port);
+      }
+      break;
 
     // "host controller" events start here
     case USB_EVENT_DEFAULT_SPEED:
@@ -934,6 +941,7 @@ Bit64s usb_hub_device_c::hub_param_oc_handler(bx_param_c *param, bool set, Bit64
 #endif
       hub->hub.usb_port[portnum].PortStatus |= PORT_STAT_OVERCURRENT;
       hub->hub.usb_port[portnum].PortChange |= PORT_STAT_C_OVERCURRENT;
+      hub->hc_event(USB_EVENT_DATA_READY, hub);
       BX_DEBUG(("Over-current signaled on port #%d.", portnum + 1));
     }
   }
@@ -688,6 +688,9 @@ void bx_usb_xhci_c::reset_hc()
     usb_cancel_packet(&BX_XHCI_THIS packets->packet);
     remove_async_packet(&BX_XHCI_THIS packets, BX_XHCI_THIS packets);
   }
+
+  BX_XHCI_THIS hub.timer_idle = 0;
+  bx_pc_system.activate_timer(BX_XHCI_THIS xhci_timer_index, 1024, 1);
 }
 
 void bx_usb_xhci_c::reset_port(int p)
@@ -893,6 +896,7 @@ void bx_usb_xhci_c::register_state(void)
 
   bx_list_c *list = new bx_list_c(SIM->get_bochs_root(), "usb_xhci", "USB xHCI State");
   hub = new bx_list_c(list, "hub");
+  BXRS_PARAM_BOOL(hub, timer_idle, BX_XHCI_THIS hub.timer_idle);
   reg_grp = new bx_list_c(hub, "op_regs");
   reg = new bx_list_c(reg_grp, "HcCommand");
 #if ((VERSION_MAJOR == 1) && (VERSION_MINOR >= 0x10))
@@ -1067,6 +1071,8 @@ void bx_usb_xhci_c::register_state(void)
       BXRS_PARAM_BOOL(entry, rcs, BX_XHCI_THIS hub.slots[i].ep_context[j].rcs);
       BXRS_PARAM_BOOL(entry, retry, BX_XHCI_THIS hub.slots[i].ep_context[j].retry);
       BXRS_DEC_PARAM_FIELD(entry, retry_counter, BX_XHCI_THIS hub.slots[i].ep_context[j].retry_counter);
+      BXRS_DEC_PARAM_FIELD(entry, nak_count, BX_XHCI_THIS hub.slots[i].ep_context[j].nak_count);
+      BXRS_PARAM_BOOL(entry, parked, BX_XHCI_THIS hub.slots[i].ep_context[j].parked);
       for (k = 0; k < MAX_PSA_SIZE_NUM; k++) {
         sprintf(tmpname, "%d", k);
         entry1 = new bx_list_c(entry, tmpname);
@@ -1543,6 +1549,9 @@ bool bx_usb_xhci_c::write_handler(bx_phy_address addr, unsigned len, void *data,
     BX_DEBUG(("Ben: In 32-bit mode, len > 4! (len=%d)", len));
 #endif
 
+  // the timer is stopped while there is nothing to poll
+  BX_XHCI_THIS xhci_timer_wakeup(0);
+
   // Even though the controller allows reads other than 32-bits & on odd boundaries,
   //  we are going to ASSUME dword reads and writes unless specified below
 
@@ -2174,8 +2183,13 @@ int bx_usb_xhci_c::event_handler(int event, void *ptr, int port)
           BX_XHCI_THIS process_transfer_ring(slot, ep, BX_XHCI_THIS hub.slots[slot].ep_context[ep].enqueue_pointer,
                                                       &BX_XHCI_THIS hub.slots[slot].ep_context[ep].rcs, 0);
       }
+      BX_XHCI_THIS xhci_timer_wakeup(0);
+      break;
+    case USB_EVENT_DATA_READY:
+      BX_XHCI_THIS xhci_timer_wakeup(1);
       break;
     case USB_EVENT_WAKEUP:
+      BX_XHCI_THIS xhci_timer_wakeup(1);
       if (BX_XHCI_THIS hub.usb_port[port].portsc.pls != PLS_U3_SUSPENDED) {
         break;
       }
@@ -2247,6 +2261,7 @@ Bit64u bx_usb_xhci_c::process_transfer_ring(int slot, int ep, Bit64u ring_addr,
   int trb_count = 0;
   BX_XHCI_THIS hub.slots[slot].ep_context[ep].edtla = 0;
   BX_XHCI_THIS hub.slots[slot].ep_context[ep].retry = 0;
+  BX_XHCI_THIS hub.slots[slot].ep_context[ep].parked = 0;
 
   // if the ep is disabled, return an error event trb.
   if ((BX_XHCI_THIS hub.slots[slot].slot_context.slot_state == SLOT_STATE_DISABLED_ENABLED)
@@ -3626,8 +3641,13 @@ Bit8u bx_usb_xhci_c::get_psceg(int port)
 
 void bx_usb_xhci_c::xhci_timer(void)
 {
-  if (BX_XHCI_THIS hub.op_regs.HcStatus.hch)
+  bool active = 0;
+
+  if (BX_XHCI_THIS hub.op_regs.HcStatus.hch) {
+    bx_pc_system.deactivate_timer(BX_XHCI_THIS xhci_timer_index);
+    BX_XHCI_THIS hub.timer_idle = 1;
     return;
+  }
 
 #if BX_USB_DEBUGGER
   SIM->usb_debug_trigger(USB_DEBUG_XHCI, USB_DEBUG_FRAME, 0, 0, 0);
@@ -3651,6 +3671,7 @@ void bx_usb_xhci_c::xhci_timer(void)
     if ((BX_XHCI_THIS hub.usb_port[port].psceg == 0) && (new_psceg != 0)) {
       BX_DEBUG(("Port #%d Status Change Event: (%2Xh)", port + 1, new_psceg));
       write_event_TRB(0, ((port + 1) << 24), TRB_SET_COMP_CODE(1), TRB_SET_TYPE(PORT_STATUS_CHANGE), 1);
+      active = 1;
     }
     BX_XHCI_THIS hub.usb_port[port].psceg |= new_psceg;
   }
@@ -3658,7 +3679,8 @@ void bx_usb_xhci_c::xhci_timer(void)
   for (int slot=1; slot<MAX_SLOTS; slot++) {
     if (BX_XHCI_THIS hub.slots[slot].enabled) {
       for (int ep=1; ep<32; ep++) {
-        if (BX_XHCI_THIS hub.slots[slot].ep_context[ep].retry) {
+        if (BX_XHCI_THIS hub.slots[slot].ep_context[ep].retry &&
+            !BX_XHCI_THIS hub.slots[slot].ep_context[ep].parked) {
           if (--BX_XHCI_THIS hub.slots[slot].ep_context[ep].retry_counter <= 0) {
             if (BX_XHCI_THIS hub.slots[slot].ep_context[ep].ep_context.max_pstreams > 0) {   // specifying streams
               //
@@ -3670,12 +3692,50 @@ void bx_usb_xhci_c::xhci_timer(void)
               BX_XHCI_THIS hub.slots[slot].ep_context[ep].enqueue_pointer =
                 BX_XHCI_THIS process_transfer_ring(slot, ep, BX_XHCI_THIS hub.slots[slot].ep_context[ep].enqueue_pointer,
                                                             &BX_XHCI_THIS hub.slots[slot].ep_context[ep].rcs, 0);
+              // an endpoint that keeps NAKing is parked until the device
+              // reports new data (USB_EVENT_DATA_READY)
+              if (!BX_XHCI_THIS hub.slots[slot].ep_context[ep].retry) {
+                BX_XHCI_THIS hub.slots[slot].ep_context[ep].nak_count = 0;
+              } else if (++BX_XHCI_THIS hub.slots[slot].ep_context[ep].nak_count >= XHCI_MAX_NAK_RETRIES) {
+                BX_XHCI_THIS hub.slots[slot].ep_context[ep].parked = 1;
+              }
             }
           }
+          if (!BX_XHCI_THIS hub.slots[slot].ep_context[ep].parked) {
+            active = 1;
+          }
+        }
+      }
+    }
+  }
+
+  // nothing left to poll: stop the timer until the next register write or
+  // device event
+  if (!active) {
+    bx_pc_system.deactivate_timer(BX_XHCI_THIS xhci_timer_index);
+    BX_XHCI_THIS hub.timer_idle = 1;
+  }
+}
+
+void bx_usb_xhci_c::xhci_timer_wakeup(bool unpark)
+{
+  if (unpark) {
+    for (int slot=1; slot<MAX_SLOTS; slot++) {
+      if (BX_XHCI_THIS hub.slots[slot].enabled) {
+        for (int ep=1; ep<32; ep++) {
+          if (BX_XHCI_THIS hub.slots[slot].ep_context[ep].parked) {
+            BX_XHCI_THIS hub.slots[slot].ep_context[ep].parked = 0;
+            BX_XHCI_THIS hub.slots[slot].ep_context[ep].nak_count = 0;
+            BX_XHCI_THIS hub.slots[slot].ep_context[ep].retry_counter = 1;
+          }
         }
       }
     }
   }
+  if (BX_XHCI_THIS hub.timer_idle) {
+    BX_XHCI_THIS hub.timer_idle = 0;
+    bx_pc_system.activate_timer(BX_XHCI_THIS xhci_timer_index, 1024, 1);
+  }
 }
 
 void bx_usb_xhci_c::runtime_config_handler(void *this_ptr)
@@ -3752,6 +3812,7 @@ bool bx_usb_xhci_c::set_connect_status(Bit8u port, bool connected)
 
   usb_device_c *device = BX_XHCI_THIS hub.usb_port[port].device;
   if (device != NULL) {
+    BX_XHCI_THIS xhci_timer_wakeup(0);
     if (connected) {
       // make sure the user has not tried to put a device on a paired port number
       // (this is invalid in all but external USB3 hubs)
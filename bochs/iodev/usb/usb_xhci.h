@@ -71,6 +71,10 @@
   #error "USB_XHCI_PORTS must be at least 2 and no more than USB_XHCI_PORTS_MAX and must be an even number."
 #endif
 
+// Consecutive NAKs after which the timer stops retrying an endpoint until
+//  the device signals USB_EVENT_DATA_READY
+#define XHCI_MAX_NAK_RETRIES 8
+
 // HCSPARAMS2
 #define ISO_SECH_THRESHOLD   1
 #define MAX_SEG_TBL_SZ_EXP   1
@@ -261,6 +265,8 @@ struct HC_SLOT_CONTEXT {
     bool    rcs;
     bool    retry;
     int     retry_counter;
+    int     nak_count;    // consecutive NAKed retries
+    bool    parked;       // retries suspended until the device has data
     struct STREAM_CONTEXT stream[MAX_PSA_SIZE_NUM]; // first one is reserved
   } ep_context[32];  // first one is ignored by controller.
 };
@@ -373,6 +379,7 @@ enum {
 typedef struct {
   Bit32u HostController;
   unsigned int n_ports;
+  bool   timer_idle;  // xhci_timer stopped
 
   struct XHCI_CAP_REGS {
     Bit32u HcCapLength;
@@ -633,6 +640,7 @@ private:
   static Bit8u get_psceg(int port);
   static void xhci_timer_handler(void *);
   void xhci_timer(void);
+  static void xhci_timer_wakeup(bool unpark);
 
   static Bit64u process_transfer_ring(int slot, int ep, Bit64u ring_addr, bool *rcs, int primary_sid);
   static void process_command_ring(void);
@@ -1348,6 +1348,7 @@ void bx_init_hardware()
 #endif
 
   DEV_init_devices();
+  bx_profiler_init();
   // unload optional plugins which are unused and marked for removal
   SIM->opt_plugin_ctrl("*", 0);
   bx_pc_system.register_state();
@@ -1427,6 +1428,8 @@ int bx_atexit(void)
   // so that the user can see any messages left behind on the console.
   SIM->set_display_mode(DISP_MODE_CONFIG);
 
+  bx_profiler_exit();
+
   for (int cpu=0; cpu<BX_SMP_PROCESSORS; cpu++)
     if (BX_CPU(cpu)) BX_CPU(cpu)->atexit();
 
@@ -48,6 +48,8 @@ protected:
   Bit32u  block_size;      // individual block size, must be power of 2
   Bit8u   *actual_vector;
   Bit8u   *vector;   // aligned correctly
+  Bit64u  mapped_len; // length of the mmap()ed vector, 0 if allocated with new
+  bool    direct_map; // all guest blocks are mapped 1:1 into the vector
   Bit8u  **blocks;
   Bit8u   *rom;      // 512k BIOS rom space + 128k expansion rom space
   Bit8u   *bogus;    // 4k for unexisting memory
@@ -65,7 +67,7 @@ public:
   BX_MEMORY_STUB_C();
   virtual ~BX_MEMORY_STUB_C();
 
-  BX_MEM_SMF void    init_memory(Bit64u guest, Bit64u host, Bit32u block_size);
+  BX_MEM_SMF void    init_memory(Bit64u guest, Bit64u host, Bit32u block_size, const char *ram_file = NULL);
   BX_MEM_SMF void    cleanup_memory(void);
   BX_MEM_SMF Bit8u*  get_vector(bx_phy_address addr);
 
@@ -86,6 +88,9 @@ public:
   BX_MEM_SMF Bit64u get_memory_len(void);
   BX_MEM_SMF void allocate_block(Bit32u index);
   BX_MEM_SMF Bit8u* alloc_vector_aligned(Bit64u bytes, Bit64u alignment);
+  BX_MEM_SMF Bit8u* map_vector(Bit64u bytes, int fd);
+  BX_MEM_SMF void   free_vector(void);
+  BX_MEM_SMF bool   map_ram_image(FILE *fp);
 
 #if BX_SUPPORT_MONITOR_MWAIT
   BX_MEM_SMF bool is_monitor(bx_phy_address begin_addr, unsigned len);
@@ -149,6 +154,9 @@ private:
   Bit8u   flash_status;
   Bit8u   flash_wsm_state;
   bool    flash_modified;
+#if !BX_LARGE_RAMFILE
+  Bit32s  *restore_map; // block mapping of a restored state, if not 1:1
+#endif
 
   BX_MEM_SMF Bit8u flash_read(Bit32u addr);
   BX_MEM_SMF void  flash_write(Bit32u addr, Bit8u data);
@@ -201,13 +209,21 @@ public:
   }
   BX_MEM_SMF bool unregisterMemoryHandlers(void *param, bx_phy_address begin_addr, bx_phy_address end_addr);
 
+  // track CPU writes to device memory exposed with a direct access handler
+  BX_MEM_SMF int  registerWriteTracking(bx_phy_address begin_addr, bx_phy_address end_addr);
+  BX_MEM_SMF void unregisterWriteTracking(int handle);
+  BX_MEM_SMF bool getDirtyPages(int handle, Bit32u *bitmap);
+
   void register_state(void);
 
 #if BX_LARGE_RAMFILE
   friend void ramfile_save_handler(void *devptr, FILE *fp);
 #endif
+  friend void ram_save_handler(void *devptr, FILE *fp);
+  friend void ram_restore_handler(void *devptr, FILE *fp);
   friend Bit64s memory_param_save_handler(void *devptr, bx_param_c *param);
   friend void memory_param_restore_handler(void *devptr, bx_param_c *param, Bit64s val);
+  friend void memory_mapping_restore_handler(void *devptr, bx_list_c *list);
 };
 
 BOCHSAPI extern BX_MEM_C bx_mem;
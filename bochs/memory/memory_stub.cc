@@ -25,6 +25,11 @@
 #include "param_names.h"
 #include "cpu/cpu.h"
 #include "memory/memory-bochs.h"
+
+#if BX_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #define LOG_THIS BX_MEM(0)->
 
 // block size must be power of two
@@ -36,6 +41,21 @@ BX_CPP_INLINE bool is_power_of_2(Bit64u x)
 // alignment of memory vector, must be a power of 2
 #define BX_MEM_VECTOR_ALIGN 4096
 
+#if BX_HAVE_SYS_MMAN_H && (defined(MAP_ANONYMOUS) || defined(MAP_ANON))
+#define BX_MEM_USE_MMAP 1
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+// the mapped vector is aligned to the x86 huge page size, so that the host
+// can back guest RAM with transparent huge pages
+#define BX_MEM_HUGEPAGE_SIZE (2*1024*1024)
+#else
+#define BX_MEM_USE_MMAP 0
+#endif
+
 #if BX_LARGE_RAMFILE
 Bit8u* const BX_MEMORY_STUB_C::swapped_out = ((Bit8u*)NULL - sizeof(Bit8u));
 #endif
@@ -49,6 +69,8 @@ BX_MEMORY_STUB_C::BX_MEMORY_STUB_C()
 
   vector = NULL;
   actual_vector = NULL;
+  mapped_len = 0;
+  direct_map = false;
   blocks = NULL;
   rom    = NULL;
   bogus  = NULL;
@@ -80,7 +102,7 @@ Bit64u BX_MEMORY_STUB_C::get_memory_len(void)
 Bit8u* BX_MEMORY_STUB_C::alloc_vector_aligned(Bit64u bytes, Bit64u alignment)
 {
   Bit64u test_mask = alignment - 1;
-  BX_MEM_THIS actual_vector = new Bit8u [(Bit32u)(bytes + test_mask)];
+  BX_MEM_THIS actual_vector = new Bit8u [(size_t)(bytes + test_mask)];
   if (BX_MEM_THIS actual_vector == 0) {
     BX_PANIC(("alloc_vector_aligned: unable to allocate host RAM !"));
     return 0;
@@ -96,7 +118,100 @@ Bit8u* BX_MEMORY_STUB_C::alloc_vector_aligned(Bit64u bytes, Bit64u alignment)
   return vector;
 }
 
-void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
+// Map the memory vector with mmap(). Host memory is only used for the pages
+// the guest actually touches (they are zero-filled on first access). With
+// fd >= 0 the vector is a shared mapping of that file and the kernel page
+// cache takes care of writing guest RAM back to it. Returns NULL on failure.
+Bit8u* BX_MEMORY_STUB_C::map_vector(Bit64u bytes, int fd)
+{
+#if BX_MEM_USE_MMAP
+  const Bit64u len = (bytes + BX_MEM_HUGEPAGE_SIZE - 1) & ~(Bit64u)(BX_MEM_HUGEPAGE_SIZE - 1);
+  Bit8u *ptr;
+
+  if ((Bit64u)(size_t) len != len) return NULL;
+
+  if (fd >= 0) {
+    // hugetlbfs files require the length to be a multiple of the huge page size
+    if (ftruncate(fd, (off_t) len) < 0) {
+      BX_ERROR(("map_vector: cannot resize RAM file: %s", strerror(errno)));
+      return NULL;
+    }
+    ptr = (Bit8u*) mmap(NULL, (size_t) len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == (Bit8u*) MAP_FAILED) {
+      BX_ERROR(("map_vector: cannot map RAM file: %s", strerror(errno)));
+      return NULL;
+    }
+    BX_MEM_THIS actual_vector = ptr;
+    BX_MEM_THIS mapped_len = len;
+  } else {
+    // reserve one more huge page and unmap the unaligned head and tail
+    const size_t map_len = (size_t)(len + BX_MEM_HUGEPAGE_SIZE);
+    ptr = (Bit8u*) mmap(NULL, map_len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == (Bit8u*) MAP_FAILED) {
+      BX_ERROR(("map_vector: mmap failed: %s", strerror(errno)));
+      return NULL;
+    }
+    Bit8u *aligned = (Bit8u*)(((bx_ptr_equiv_t) ptr + BX_MEM_HUGEPAGE_SIZE - 1) &
+                              ~(bx_ptr_equiv_t)(BX_MEM_HUGEPAGE_SIZE - 1));
+    if (aligned > ptr)
+      munmap(ptr, aligned - ptr);
+    if (aligned + len < ptr + map_len)
+      munmap(aligned + len, (ptr + map_len) - (aligned + len));
+    ptr = aligned;
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, (size_t) len, MADV_HUGEPAGE);
+#endif
+    BX_MEM_THIS actual_vector = ptr;
+    BX_MEM_THIS mapped_len = len;
+  }
+  return ptr;
+#else
+  return NULL;
+#endif
+}
+
+// Replace the directly mapped guest RAM with a private (copy-on-write)
+// mapping of a saved RAM image. The vector address does not change, so the
+// block pointers and host page addresses cached in the TLBs stay valid.
+// Unmodified pages are shared with all other processes mapping the image.
+// The image must not be truncated or written in place while it is mapped,
+// so saving a state replaces the file instead (see save_sr_param()).
+bool BX_MEMORY_STUB_C::map_ram_image(FILE *fp)
+{
+#if BX_MEM_USE_MMAP
+  struct stat st;
+  int fd = fileno(fp);
+
+  if (!BX_MEM_THIS direct_map || (fstat(fd, &st) < 0) || ((Bit64u) st.st_size < BX_MEM_THIS len))
+    return false;
+  void *ptr = mmap(BX_MEM_THIS vector, (size_t) BX_MEM_THIS len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_FIXED, fd, 0);
+  if (ptr == MAP_FAILED) {
+    BX_ERROR(("map_ram_image: mmap failed: %s", strerror(errno)));
+    return false;
+  }
+  BX_INFO(("guest RAM mapped copy-on-write from saved image"));
+  return true;
+#else
+  return false;
+#endif
+}
+
+void BX_MEMORY_STUB_C::free_vector(void)
+{
+#if BX_MEM_USE_MMAP
+  if (BX_MEM_THIS mapped_len > 0) {
+    munmap(BX_MEM_THIS actual_vector, (size_t) BX_MEM_THIS mapped_len);
+    BX_MEM_THIS mapped_len = 0;
+  } else
+#endif
+  delete [] BX_MEM_THIS actual_vector;
+  BX_MEM_THIS actual_vector = NULL;
+  BX_MEM_THIS vector = NULL;
+}
+
+void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size, const char *ram_file)
 {
   // accept only memory size which is multiply of 1M
   BX_ASSERT((host & 0xfffff) == 0);
@@ -108,11 +223,41 @@ void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
 
   if (BX_MEM_THIS actual_vector != NULL) {
     BX_INFO(("freeing existing memory vector"));
-    delete [] BX_MEM_THIS actual_vector;
-    BX_MEM_THIS actual_vector = NULL;
-    BX_MEM_THIS vector = NULL;
+    free_vector();
     BX_MEM_THIS blocks = NULL;
   }
+#if BX_MEM_USE_MMAP
+  int fd = -1;
+  if (ram_file != NULL) {
+    // e.g. a file on a hugetlbfs mount
+    fd = open(ram_file, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+      BX_PANIC(("cannot open RAM file '%s': %s", ram_file, strerror(errno)));
+    }
+  }
+#if BX_LARGE_RAMFILE
+  else if (host < guest) {
+    // map all guest RAM from an unlinked temporary file instead of swapping
+    // blocks to the overflow file
+    FILE *tmp = tmpfile64();
+    if (tmp != NULL) {
+      fd = dup(fileno(tmp));
+      fclose(tmp);
+    }
+  }
+#endif
+  if (fd >= 0) {
+    BX_MEM_THIS vector = map_vector(guest + BIOSROMSZ + EXROMSIZE + 4096, fd);
+    close(fd);
+    if (BX_MEM_THIS vector != NULL) {
+      BX_INFO(("guest RAM mapped from %s", (ram_file != NULL) ? ram_file : "temporary file"));
+      host = guest;
+    }
+  } else {
+    BX_MEM_THIS vector = map_vector(host + BIOSROMSZ + EXROMSIZE + 4096, -1);
+  }
+  if (BX_MEM_THIS vector == NULL)
+#endif
   BX_MEM_THIS vector = alloc_vector_aligned(host + BIOSROMSZ + EXROMSIZE + 4096, BX_MEM_VECTOR_ALIGN);
   BX_INFO(("allocated memory at %p. after alignment, vector=%p, block_size = %dK",
         BX_MEM_THIS actual_vector, BX_MEM_THIS vector, block_size/1024));
@@ -131,10 +276,11 @@ void BX_MEMORY_STUB_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
   BX_INFO(("%.2fMB", (float)(BX_MEM_THIS len / (1024.0*1024.0))));
   BX_INFO(("mem block size = 0x%08x, blocks=%u", BX_MEM_THIS block_size, num_blocks));
   BX_MEM_THIS blocks = new Bit8u* [num_blocks];
-  if (0) {
-    // all guest memory is allocated, just map it
+  BX_MEM_THIS direct_map = (BX_MEM_THIS mapped_len > 0) && (BX_MEM_THIS allocated >= BX_MEM_THIS len);
+  if (BX_MEM_THIS direct_map) {
+    // all guest memory is mapped and costs nothing until used, just map it
     for (unsigned idx = 0; idx < num_blocks; idx++) {
-      BX_MEM_THIS blocks[idx] = BX_MEM_THIS vector + (idx * BX_MEM_THIS block_size);
+      BX_MEM_THIS blocks[idx] = BX_MEM_THIS vector + ((Bit64u) idx * BX_MEM_THIS block_size);
     }
     BX_MEM_THIS used_blocks = num_blocks;
   }
@@ -246,9 +392,7 @@ void BX_MEMORY_STUB_C::allocate_block(Bit32u block)
 void BX_MEMORY_STUB_C::cleanup_memory()
 {
   if (BX_MEM_THIS vector != NULL) {
-    delete [] BX_MEM_THIS actual_vector;
-    BX_MEM_THIS actual_vector = NULL;
-    BX_MEM_THIS vector = NULL;
+    free_vector();
     BX_MEM_THIS rom = NULL;
     BX_MEM_THIS bogus = NULL;
     delete [] BX_MEM_THIS blocks;
@@ -42,6 +42,9 @@
 BX_MEM_C::BX_MEM_C() : BX_MEMORY_STUB_C()
 {
   memory_handlers = NULL;
+#if !BX_LARGE_RAMFILE
+  restore_map = NULL;
+#endif
 }
 
 BX_MEM_C::~BX_MEM_C()
@@ -53,7 +56,9 @@ void BX_MEM_C::init_memory(Bit64u guest, Bit64u host, Bit32u block_size)
 {
   unsigned idx, i;
 
-  BX_MEMORY_STUB_C::init_memory(guest, host, block_size);
+  bx_param_string_c *ram_file = SIM->get_param_string(BXPN_MEM_FILE);
+  BX_MEMORY_STUB_C::init_memory(guest, host, block_size,
+                                ram_file->isempty() ? NULL : ram_file->getptr());
 
   BX_MEM_THIS smram_available = false;
   BX_MEM_THIS smram_enable = false;
@@ -98,6 +103,23 @@ void ramfile_save_handler(void *devptr, FILE *fp)
 }
 #endif
 
+// Directly mapped RAM is saved as a flat image without backing store. On
+// restore the image is mapped, so that instances restored from the same
+// state share the pages the guest has not modified yet.
+void ram_save_handler(void *devptr, FILE *fp)
+{
+  if (fwrite(BX_MEM(0)->vector, 1, (size_t) BX_MEM(0)->len, fp) != BX_MEM(0)->len)
+    BX_PANIC(("FATAL ERROR: Could not write guest RAM to save file!"));
+}
+
+void ram_restore_handler(void *devptr, FILE *fp)
+{
+  if (BX_MEM(0)->map_ram_image(fp))
+    return;
+  if ((fread(BX_MEM(0)->vector, 1, (size_t) BX_MEM(0)->len, fp) != BX_MEM(0)->len) && !feof(fp))
+    BX_PANIC(("FATAL ERROR: Could not read guest RAM from save file!"));
+}
+
 // Note: This must be called before the memory file save handler is called.
 Bit64s memory_param_save_handler(void *devptr, bx_param_c *param)
 {
@@ -144,6 +166,36 @@ void memory_param_restore_handler(void *devptr, bx_param_c *param, Bit64s val)
 
   if (! strncmp(pname, "blk", 3)) {
     Bit32u blk_index = atoi(pname + 3);
+    if (BX_MEM_THIS direct_map) {
+      // The mapping stays 1:1. With BX_LARGE_RAMFILE the saved RAM image is
+      // laid out by guest address already, otherwise it is a copy of the
+      // vector and the blocks are moved into place after the whole mapping
+      // is known (see memory_mapping_restore_handler).
+#if !BX_LARGE_RAMFILE
+      if ((Bit32s) val != (Bit32s) blk_index) {
+        Bit32u num_blocks = (Bit32u)(BX_MEM_THIS len / BX_MEM_THIS block_size);
+        if (BX_MEM_THIS restore_map == NULL) {
+          BX_MEM_THIS restore_map = new Bit32s[num_blocks];
+          for (Bit32u blk = 0; blk < num_blocks; blk++)
+            BX_MEM_THIS restore_map[blk] = blk;
+        }
+        BX_MEM_THIS restore_map[blk_index] = (Bit32s) val;
+      }
+#endif
+      return;
+    }
+    const Bit32u max_blocks = (Bit32u)(BX_MEM_THIS allocated / BX_MEM_THIS block_size);
+    if (((Bit32s) val >= 0) && ((Bit32u) val >= max_blocks)) {
+      // saved with more host memory (e.g. directly mapped) than available now
+#if BX_LARGE_RAMFILE
+      // the block is in the restored overflow file, all host blocks are in use
+      BX_MEM(0)->blocks[blk_index] = BX_MEM(0)->swapped_out;
+      BX_MEM_THIS used_blocks = max_blocks;
+#else
+      BX_PANIC(("cannot restore memory block %d: saved state needs more host memory", blk_index));
+#endif
+      return;
+    }
 #if BX_LARGE_RAMFILE
     if ((Bit32s) val == -2) {
       BX_MEM(0)->blocks[blk_index] = BX_MEM(0)->swapped_out;
@@ -173,21 +225,65 @@ void memory_param_restore_handler(void *devptr, bx_param_c *param, Bit64s val)
   }
 }
 
+// Move the blocks of a RAM image saved without direct mapping to their
+// guest addresses.
+void memory_mapping_restore_handler(void *devptr, bx_list_c *list)
+{
+#if !BX_LARGE_RAMFILE
+  if (BX_MEM_THIS restore_map == NULL)
+    return;
+
+  Bit32u num_blocks = (Bit32u)(BX_MEM_THIS len / BX_MEM_THIS block_size);
+  Bit32u max_index = 0;
+  for (Bit32u blk = 0; blk < num_blocks; blk++) {
+    if (BX_MEM_THIS restore_map[blk] >= (Bit32s) max_index)
+      max_index = BX_MEM_THIS restore_map[blk] + 1;
+  }
+  Bit64u image_len = (Bit64u) max_index * BX_MEM_THIS block_size;
+  Bit8u *image = new Bit8u[(size_t) image_len];
+  memcpy(image, BX_MEM_THIS vector, (size_t) image_len);
+  for (Bit32u blk = 0; blk < num_blocks; blk++) {
+    Bit8u *dst = BX_MEM_THIS vector + (Bit64u) blk * BX_MEM_THIS block_size;
+    if (BX_MEM_THIS restore_map[blk] >= 0) {
+      memcpy(dst, image + (Bit64u) BX_MEM_THIS restore_map[blk] * BX_MEM_THIS block_size,
+             BX_MEM_THIS block_size);
+    } else {
+      memset(dst, 0, BX_MEM_THIS block_size);
+    }
+  }
+  delete [] image;
+  delete [] BX_MEM_THIS restore_map;
+  BX_MEM_THIS restore_map = NULL;
+#endif
+  // all guest blocks are in use when directly mapped
+  if (BX_MEM_THIS direct_map)
+    BX_MEM_THIS used_blocks = (Bit32u)(BX_MEM_THIS len / BX_MEM_THIS block_size);
+}
+
 void BX_MEM_C::register_state()
 {
   char param_name[15];
 
   bx_list_c *list = new bx_list_c(SIM->get_bochs_root(), "memory", "Memory State");
   Bit32u num_blocks = (Bit32u)(BX_MEM_THIS len / BX_MEM_THIS block_size);
+  if (BX_MEM_THIS direct_map) {
+    bx_shadow_filedata_c *ramfile = new bx_shadow_filedata_c(list, "ram", NULL);
+    ramfile->set_sr_handlers(this, ram_save_handler, ram_restore_handler);
+  } else {
 #if BX_LARGE_RAMFILE
-  bx_shadow_filedata_c *ramfile = new bx_shadow_filedata_c(list, "ram", &(BX_MEM_THIS overflow_file));
-  ramfile->set_sr_handlers(this, ramfile_save_handler, (filedata_restore_handler)NULL);
-  BXRS_DEC_PARAM_FIELD(list, next_swapout_idx, BX_MEM_THIS next_swapout_idx);
+    bx_shadow_filedata_c *ramfile = new bx_shadow_filedata_c(list, "ram", &(BX_MEM_THIS overflow_file));
+    ramfile->set_sr_handlers(this, ramfile_save_handler, (filedata_restore_handler)NULL);
 #else
-  new bx_shadow_data_c(list, "ram", BX_MEM_THIS vector, BX_MEM_THIS allocated);
+    new bx_shadow_data_c(list, "ram", BX_MEM_THIS vector, BX_MEM_THIS allocated);
+#endif
+  }
+#if BX_LARGE_RAMFILE
+  BXRS_DEC_PARAM_FIELD(list, next_swapout_idx, BX_MEM_THIS next_swapout_idx);
 #endif
   BXRS_DEC_PARAM_FIELD(list, used_blocks, BX_MEM_THIS used_blocks);
 
+  // The block mapping is 1:1 if all guest RAM is mapped. It is saved anyway,
+  // so that states can be exchanged with configurations using the other mode.
   bx_list_c *mapping = new bx_list_c(list, "mapping");
   for (Bit32u blk=0; blk < num_blocks; blk++) {
     sprintf(param_name, "blk%d", blk);
@@ -195,6 +291,7 @@ void BX_MEM_C::register_state()
     param->set_base(BASE_DEC);
     param->set_sr_handlers(this, memory_param_save_handler, memory_param_restore_handler);
   }
+  mapping->set_restore_handler(this, memory_mapping_restore_handler);
   bx_list_c *memtype = new bx_list_c(list, "memtype");
   for (int i = 0; i <= BX_MEM_AREA_F0000; i++) {
     sprintf(param_name, "%d_r", i);
@@ -864,6 +961,29 @@ bool BX_MEM_C::unregisterMemoryHandlers(void *param, bx_phy_address begin_addr,
   return ret;
 }
 
+int BX_MEM_C::registerWriteTracking(bx_phy_address begin_addr, bx_phy_address end_addr)
+{
+  if (end_addr < begin_addr)
+    return -1;
+  int handle = pageWriteStampTable.registerWriteTracking(begin_addr, (Bit32u)(end_addr - begin_addr + 1));
+  if (handle < 0) {
+    BX_ERROR(("Register write tracking failed: 0x" FMT_PHY_ADDRX " - 0x" FMT_PHY_ADDRX, begin_addr, end_addr));
+  } else {
+    BX_INFO(("Register write tracking: 0x" FMT_PHY_ADDRX " - 0x" FMT_PHY_ADDRX, begin_addr, end_addr));
+  }
+  return handle;
+}
+
+void BX_MEM_C::unregisterWriteTracking(int handle)
+{
+  pageWriteStampTable.unregisterWriteTracking(handle);
+}
+
+bool BX_MEM_C::getDirtyPages(int handle, Bit32u *bitmap)
+{
+  return pageWriteStampTable.getDirtyPages(handle, bitmap);
+}
+
 void BX_MEM_C::enable_smram(bool enable, bool restricted)
 {
   BX_MEM_THIS smram_available = true;
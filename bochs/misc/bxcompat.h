@@ -59,6 +59,8 @@
 #endif
 #define BX_ASSERT(x)
 
+#define BX_PATHNAME_LEN 512
+
 #ifdef BXIMAGE
 extern int bx_interactive;
 
@@ -71,8 +73,6 @@ device_image_t* init_image(const char *image_mode);
 
 #else
 
-#define BX_PATHNAME_LEN 512
-
 extern int bx_loglev;
 
 #endif
@@ -36,6 +36,9 @@
 #  include <winioctl.h>
 #endif
 #include <ctype.h>
+#ifndef WIN32
+#include <sys/time.h>
+#endif
 
 #include "osdep.h"
 #include "bswap.h"
@@ -45,6 +48,12 @@
 #include "iodev/hdimage/vmware4.h"
 #include "iodev/hdimage/vpc.h"
 #include "iodev/hdimage/vbox.h"
+#include "iodev/hdimage/qcow2.h"
+#include "bxthread.h"
+
+#if BX_HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #define BXIMAGE_FUNC_NULL            0
 #define BXIMAGE_FUNC_CREATE_IMAGE    1
@@ -57,6 +66,12 @@
 
 #define SECTOR_SIZE 512
 
+// image conversion: size of the blocks passed between the threads, number
+// of blocks in flight and maximum number of compression threads
+#define CONVERT_CHUNK_SIZE  (1 << 20)
+#define CONVERT_QUEUE_SIZE  16
+#define CONVERT_MAX_WORKERS 8
+
 const int bx_max_hd_megs = (int)(((1 << BX_MAX_CYL_BITS) - 1) * 16.0 * 63.0 / 2048.0);
 
 int  bximage_func;
@@ -66,11 +81,13 @@ int  bx_min_hd_megs = 10;
 int  bx_hdsize;
 int  bx_imagemode;
 int  bx_backup;
+int  bx_compress;
 int  bx_interactive;
 int  bx_sectsize_idx;
 Bit16u bx_sectsize_val;
 char bx_filename_1[512];
 char bx_filename_2[522];
+char bx_backing_file[512];
 
 const char *EOF_ERR = "ERROR: End of input";
 const char *svnid = "$Id$";
@@ -99,9 +116,9 @@ const unsigned fdsize_sectors[] = { 320, 360, 640, 720, 1440, 2400, 2880, 3360,
 int fdsize_n_choices = 10;
 
 // menu data for choosing disk mode
-const char *hdmode_menu = "\nWhat kind of image should I create?\nPlease type flat, sparse, growing, vpc or vmware4. ";
-const char *hdmode_choices[] = {"flat", "sparse", "growing", "vpc", "vmware4" };
-int hdmode_n_choices = 5;
+const char *hdmode_menu = "\nWhat kind of image should I create?\nPlease type flat, sparse, growing, vpc, vmware4 or qcow2. ";
+const char *hdmode_choices[] = {"flat", "sparse", "growing", "vpc", "vmware4", "qcow2" };
+int hdmode_n_choices = 6;
 
 // menu data for choosing hard disk sector size
 const char *sectsize_menu = "\nChoose the size of hard disk sectors.\nPlease type 512, 1024 or 4096. ";
@@ -338,6 +355,8 @@ device_image_t* init_image(const char *imgmode)
     hdimage = new vpc_image_t();
   } else if (!strcmp(imgmode, "vbox")) {
     hdimage = new vbox_image_t();
+  } else if (!strcmp(imgmode, "qcow2")) {
+    hdimage = new qcow2_image_t();
   } else {
     fatal("unsupported disk image mode");
   }
@@ -403,6 +422,35 @@ void create_flat_image_win32(const char *filename, Bit64u size)
 }
 #endif
 
+// the qcow2 code resolves a relative backing file name from the image directory
+int get_backing_image_size(const char *filename, const char *backing, int *megs)
+{
+  char path[BX_PATHNAME_LEN];
+  const char *imgmode = NULL;
+
+  const char *sep = strrchr(filename, '/');
+  const char *sep2 = strrchr(filename, '\\');
+  if ((sep2 != NULL) && ((sep == NULL) || (sep2 > sep))) sep = sep2;
+  if ((backing[0] != '/') && (backing[0] != '\\') && (strchr(backing, ':') == NULL) &&
+      (sep != NULL) && ((size_t)(sep - filename + 1 + strlen(backing)) < BX_PATHNAME_LEN)) {
+    memcpy(path, filename, sep - filename + 1);
+    strcpy(path + (sep - filename + 1), backing);
+  } else {
+    strcpy(path, backing);
+  }
+  if (!hdimage_detect_image_mode(path, &imgmode))
+    return 0;
+  device_image_t *hdimage = init_image(imgmode);
+  if (hdimage->open(path, O_RDONLY) < 0) {
+    delete hdimage;
+    return 0;
+  }
+  *megs = (int)((hdimage->hd_size + (1 << 20) - 1) >> 20);
+  hdimage->close();
+  delete hdimage;
+  return 1;
+}
+
 device_image_t* create_hard_disk_image(const char *filename, const char *imgmode, Bit64u size)
 {
   device_image_t *hdimage = init_image(imgmode);
@@ -420,22 +468,238 @@ device_image_t* create_hard_disk_image(const char *filename, const char *imgmode
     hdimage->create_image(filename, size);
   } else if(!strcmp(imgmode, "vmware4")) {
     hdimage->create_image(filename, size);
+  } else if(!strcmp(imgmode, "qcow2")) {
+    ((qcow2_image_t*)hdimage)->set_backing_file(bx_backing_file);
+    hdimage->create_image(filename, size);
   } else {
     fatal("image mode not implemented yet");
   }
   return hdimage;
 }
 
+// conversion pipeline: a reader thread skips unallocated ranges and reads
+// the source image in large chunks, optional worker threads compress them
+// and the main thread writes the non-zero data to the destination image.
+
+enum {
+  CHUNK_FREE,
+  CHUNK_READ,   // waiting for compression
+  CHUNK_BUSY,   // being compressed
+  CHUNK_READY   // ready for writing
+};
+
+typedef struct {
+  int    state;
+  Bit64u offset;
+  Bit32u len;
+  bool   eof;       // end of the source image, no data
+  bool   error;     // read error, no data
+  Bit8u  *data;
+  Bit8u  *zdata;    // compressed clusters (same layout as data)
+  Bit32u *zlen;     // compressed size per cluster, 0 = not compressed
+} convert_chunk_t;
+
+typedef struct {
+  device_image_t *src;
+  Bit64u size;
+  Bit32u cluster_size;  // compression cluster size, 0 = no compression
+  convert_chunk_t chunk[CONVERT_QUEUE_SIZE];
+  unsigned compress_seq;
+  bool   compress_done;
+  bool   abort;
+  BX_MUTEX(lock);
+  bx_thread_sem_t reader_sem;
+  bx_thread_sem_t worker_sem;
+  bx_thread_sem_t writer_sem;
+} convert_ctx_t;
+
+Bit64u get_time_usec()
+{
+#ifdef WIN32
+  return (Bit64u)GetTickCount() * 1000;
+#else
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (Bit64u)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+int get_cpu_count()
+{
+#ifdef WIN32
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  return (int)si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? n : 1;
+#else
+  return 1;
+#endif
+}
+
+bool is_zero_block(const Bit8u *buf, Bit32u len)
+{
+  const Bit64u *p = (const Bit64u*)buf;
+
+  for (Bit32u i = 0; i < (len >> 3); i++) {
+    if (p[i] != 0) return 0;
+  }
+  return 1;
+}
+
+BX_THREAD_FUNC(convert_reader_thread, indata)
+{
+  convert_ctx_t *ctx = (convert_ctx_t*)indata;
+  Bit64u offset = 0;
+  unsigned seq = 0;
+  bool done = 0;
+
+  while (!done) {
+    // skip whole chunks that read as zeros
+    while (offset < ctx->size) {
+      Bit64u count = ctx->size - offset;
+      if (ctx->src->get_alloc_status(offset, &count) || (count < CONVERT_CHUNK_SIZE))
+        break;
+      offset += count & ~(Bit64u)(CONVERT_CHUNK_SIZE - 1);
+    }
+    convert_chunk_t *chunk = &ctx->chunk[seq % CONVERT_QUEUE_SIZE];
+    BX_LOCK(ctx->lock);
+    while ((chunk->state != CHUNK_FREE) && !ctx->abort) {
+      BX_UNLOCK(ctx->lock);
+      bx_wait_sem(&ctx->reader_sem);
+      BX_LOCK(ctx->lock);
+    }
+    done = ctx->abort;
+    BX_UNLOCK(ctx->lock);
+    if (done)
+      break;
+
+    chunk->offset = offset;
+    chunk->len = 0;
+    chunk->eof = (offset >= ctx->size);
+    chunk->error = 0;
+    if (!chunk->eof) {
+      chunk->len = CONVERT_CHUNK_SIZE;
+      if ((offset + chunk->len) > ctx->size) {
+        chunk->len = (Bit32u)(ctx->size - offset);
+      }
+      chunk->error = (ctx->src->lseek(offset, SEEK_SET) < 0) ||
+                     (ctx->src->read(chunk->data, chunk->len) != (ssize_t)chunk->len);
+    }
+    done = chunk->eof || chunk->error;
+    BX_LOCK(ctx->lock);
+    chunk->state = (ctx->cluster_size > 0) ? CHUNK_READ : CHUNK_READY;
+    BX_UNLOCK(ctx->lock);
+    if (ctx->cluster_size > 0) {
+      bx_set_sem(&ctx->worker_sem);
+    } else {
+      bx_set_sem(&ctx->writer_sem);
+    }
+    offset += chunk->len;
+    seq++;
+  }
+  BX_THREAD_EXIT;
+}
+
+#if BX_HAVE_ZLIB
+BX_THREAD_FUNC(convert_worker_thread, indata)
+{
+  convert_ctx_t *ctx = (convert_ctx_t*)indata;
+  Bit32u cs = ctx->cluster_size;
+  z_stream strm;
+
+  memset(&strm, 0, sizeof(strm));
+  if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -12, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+    memset(&strm, 0, sizeof(strm));
+    strm.state = NULL;
+  }
+  while (1) {
+    convert_chunk_t *chunk = NULL;
+    BX_LOCK(ctx->lock);
+    while (!ctx->compress_done && !ctx->abort) {
+      chunk = &ctx->chunk[ctx->compress_seq % CONVERT_QUEUE_SIZE];
+      if (chunk->state == CHUNK_READ) {
+        chunk->state = CHUNK_BUSY;
+        ctx->compress_seq++;
+        if (chunk->eof || chunk->error) {
+          ctx->compress_done = 1;
+        }
+        break;
+      }
+      chunk = NULL;
+      BX_UNLOCK(ctx->lock);
+      bx_wait_sem(&ctx->worker_sem);
+      BX_LOCK(ctx->lock);
+    }
+    BX_UNLOCK(ctx->lock);
+    if (chunk == NULL) {
+      // wake up the next worker (the semaphore may not count on all hosts)
+      bx_set_sem(&ctx->worker_sem);
+      break;
+    }
+    for (Bit32u i = 0; i < (chunk->len / cs); i++) {
+      Bit8u *data = chunk->data + i * cs;
+      chunk->zlen[i] = 0;
+      if ((strm.state == NULL) || is_zero_block(data, cs))
+        continue;
+      deflateReset(&strm);
+      strm.next_in = data;
+      strm.avail_in = cs;
+      strm.next_out = chunk->zdata + i * cs;
+      strm.avail_out = cs - 1;
+      if (deflate(&strm, Z_FINISH) == Z_STREAM_END) {
+        chunk->zlen[i] = (cs - 1) - strm.avail_out;
+      }
+    }
+    BX_LOCK(ctx->lock);
+    chunk->state = CHUNK_READY;
+    BX_UNLOCK(ctx->lock);
+    bx_set_sem(&ctx->writer_sem);
+  }
+  if (strm.state != NULL) {
+    deflateEnd(&strm);
+  }
+  BX_THREAD_EXIT;
+}
+#endif
+
+// writes the non-zero sectors of 'buf' with one request per run
+bool write_data(device_image_t *image, Bit64u offset, const Bit8u *buf, Bit32u len, Bit64u *written)
+{
+  Bit32u i = 0, start;
+
+  while (i < len) {
+    while ((i < len) && is_zero_block(buf + i, SECTOR_SIZE)) {
+      i += SECTOR_SIZE;
+    }
+    start = i;
+    while ((i < len) && !is_zero_block(buf + i, SECTOR_SIZE)) {
+      i += SECTOR_SIZE;
+    }
+    if (i > start) {
+      if ((image->lseek(offset + start, SEEK_SET) < 0) ||
+          (image->write(buf + start, i - start) != (ssize_t)(i - start)))
+        return 0;
+      *written += i - start;
+    }
+  }
+  return 1;
+}
+
 void convert_image(const char *newimgmode, Bit64u newsize)
 {
   device_image_t *source_image, *dest_image;
-  Bit64u i, sc, s;
-  char buffer[512], null_sector[512];
   const char *imgmode = NULL;
   bool error = false;
+  convert_ctx_t *ctx;
+  BX_THREAD_VAR(reader_thread);
+  BX_THREAD_VAR(worker_thread[CONVERT_MAX_WORKERS]);
+  int i, workers = 0, last_percent = -1;
+  unsigned seq = 0;
+  Bit64u written = 0;
 
   printf("\n");
-  memset(null_sector, 0, 512);
   if (newsize == 0) {
     if (!strncmp(bx_filename_1, "concat:", 7)) {
       imgmode = "concat";
@@ -471,40 +735,121 @@ void convert_image(const char *newimgmode, Bit64u newsize)
   if (dest_image->open(bx_filename_2) < 0)
     fatal("cannot open destination disk image");
 
+  ctx = new convert_ctx_t;
+  memset(ctx, 0, sizeof(convert_ctx_t));
+  ctx->src = source_image;
+  ctx->size = source_image->hd_size;
+#if BX_HAVE_ZLIB
+  if (bx_compress && !strcmp(newimgmode, "qcow2")) {
+    ctx->cluster_size = ((qcow2_image_t*)dest_image)->get_cluster_size();
+    workers = get_cpu_count();
+    if (workers > CONVERT_MAX_WORKERS) workers = CONVERT_MAX_WORKERS;
+  }
+#endif
+  for (i = 0; i < CONVERT_QUEUE_SIZE; i++) {
+    ctx->chunk[i].state = CHUNK_FREE;
+    ctx->chunk[i].data = new Bit8u[CONVERT_CHUNK_SIZE];
+    if (ctx->cluster_size > 0) {
+      ctx->chunk[i].zdata = new Bit8u[CONVERT_CHUNK_SIZE];
+      ctx->chunk[i].zlen = new Bit32u[CONVERT_CHUNK_SIZE / ctx->cluster_size];
+    }
+  }
+  BX_INIT_MUTEX(ctx->lock);
+  bx_create_sem(&ctx->reader_sem);
+  bx_create_sem(&ctx->worker_sem);
+  bx_create_sem(&ctx->writer_sem);
+
   printf("\nConverting image file: [  0%%]");
+  fflush(stdout);
+  Bit64u start_time = get_time_usec();
 
-  sc = source_image->hd_size / 512;
-  s = 0;
-  for (i = 0; i < source_image->hd_size; i+=512) {
-    printf("\x8\x8\x8\x8\x8%3d%%]", (int)((s+1)*100/sc));
-    fflush(stdout);
-    if (source_image->lseek(i, SEEK_SET) < 0) {
-      error = true;
+  BX_THREAD_CREATE(convert_reader_thread, ctx, reader_thread);
+#if BX_HAVE_ZLIB
+  for (i = 0; i < workers; i++) {
+    BX_THREAD_CREATE(convert_worker_thread, ctx, worker_thread[i]);
+  }
+#endif
+  while (1) {
+    convert_chunk_t *chunk = &ctx->chunk[seq % CONVERT_QUEUE_SIZE];
+    BX_LOCK(ctx->lock);
+    while (chunk->state != CHUNK_READY) {
+      BX_UNLOCK(ctx->lock);
+      bx_wait_sem(&ctx->writer_sem);
+      BX_LOCK(ctx->lock);
+    }
+    BX_UNLOCK(ctx->lock);
+    if (chunk->eof || chunk->error) {
+      error = chunk->error;
       break;
     }
-    if ((source_image->read(buffer, 512) == 512) &&
-        (memcmp(buffer, null_sector, 512) != 0)) {
-      if (dest_image->lseek(i, SEEK_SET) < 0) {
-        error = true;
-        break;
-      }
-      if (dest_image->write(buffer, 512) < 0) {
-        error = true;
-        break;
+    if (ctx->cluster_size > 0) {
+      Bit32u cs = ctx->cluster_size;
+      for (Bit32u off = 0; (off < chunk->len) && !error; off += cs) {
+        Bit32u n = (chunk->len - off < cs) ? (chunk->len - off) : cs;
+        Bit32u zlen = (n == cs) ? chunk->zlen[off / cs] : 0;
+        if ((zlen > 0) &&
+            ((qcow2_image_t*)dest_image)->write_compressed(chunk->offset + off, chunk->zdata + off, zlen)) {
+          written += cs;
+        } else {
+          error = !write_data(dest_image, chunk->offset + off, chunk->data + off, n, &written);
+        }
       }
+    } else {
+      error = !write_data(dest_image, chunk->offset, chunk->data, chunk->len, &written);
     }
-    s++;
+    if (error)
+      break;
+    int percent = (int)((chunk->offset + chunk->len) * 100 / ctx->size);
+    if (percent != last_percent) {
+      printf("\x8\x8\x8\x8\x8%3d%%]", percent);
+      fflush(stdout);
+      last_percent = percent;
+    }
+    BX_LOCK(ctx->lock);
+    chunk->state = CHUNK_FREE;
+    BX_UNLOCK(ctx->lock);
+    bx_set_sem(&ctx->reader_sem);
+    seq++;
+  }
+
+  // stop the threads (they are already finished if no error occured)
+  BX_LOCK(ctx->lock);
+  ctx->abort = 1;
+  BX_UNLOCK(ctx->lock);
+  bx_set_sem(&ctx->reader_sem);
+  bx_set_sem(&ctx->worker_sem);
+  BX_THREAD_JOIN(reader_thread);
+#if BX_HAVE_ZLIB
+  for (i = 0; i < workers; i++) {
+    BX_THREAD_JOIN(worker_thread[i]);
   }
+#endif
+  Bit64u elapsed = get_time_usec() - start_time;
 
   source_image->close();
   dest_image->close();
   delete dest_image;
   delete source_image;
+  for (i = 0; i < CONVERT_QUEUE_SIZE; i++) {
+    delete [] ctx->chunk[i].data;
+    delete [] ctx->chunk[i].zdata;
+    delete [] ctx->chunk[i].zlen;
+  }
+  bx_destroy_sem(&ctx->reader_sem);
+  bx_destroy_sem(&ctx->worker_sem);
+  bx_destroy_sem(&ctx->writer_sem);
+  BX_FINI_MUTEX(ctx->lock);
 
   if (error) {
+    delete ctx;
     fatal("image conversion failed");
   } else {
-    printf(" Done.\n");
+    if (elapsed == 0) elapsed = 1;
+    printf(" Done.\n\n%.1f MB converted (%.1f MB data) in %.2f seconds, %.1f MB/s\n",
+           (double)ctx->size / 1048576.0, (double)written / 1048576.0,
+           (double)elapsed / 1000000.0,
+           (double)ctx->size / 1048576.0 / ((double)elapsed / 1000000.0));
+    delete ctx;
   }
 }
 
@@ -557,6 +902,9 @@ void print_usage()
     "                or gigabytes (G)\n"
     "  -imgmode=...  create/convert: hard disk image mode (default = flat)\n"
     "  -sectsize=... create: hard disk sector size (default = 512)\n"
+    "  -backing=...  create: qcow2 backing file for a thin clone (the default\n"
+    "                size is the size of the backing file)\n"
+    "  -compress     convert: compress the data clusters of a qcow2 image\n"
     "  -b            convert/resize: create a backup of the source image\n"
     "                commit: create backups of the base image and redolog file\n"
     "  -q            quiet mode (don't prompt for user input)\n"
@@ -582,7 +930,7 @@ void set_default_values()
         bx_imagemode = 0;
         bx_interactive = 1;
       }
-      if (bx_hdsize == 0) {
+      if ((bx_hdsize == 0) && (bx_backing_file[0] == 0)) {
         bx_hdsize = 10;
         bx_interactive = 1;
       }
@@ -617,11 +965,13 @@ int parse_cmdline(int argc, char *argv[])
   bx_hdsize = 0;
   bx_imagemode = -1;
   bx_backup = 0;
+  bx_compress = 0;
   bx_interactive = 1;
   bx_sectsize_idx = 0;
   bx_sectsize_val = 512;
   bx_filename_1[0] = 0;
   bx_filename_2[0] = 0;
+  bx_backing_file[0] = 0;
   while ((arg < argc) && (ret == 1)) {
     // parse next arg
     if (!strcmp("--help", argv[arg]) || !strncmp("/?", argv[arg], 2)) {
@@ -689,6 +1039,13 @@ int parse_cmdline(int argc, char *argv[])
         bx_sectsize_val = atoi(sectsize_choices[bx_sectsize_idx]);
       }
     }
+    else if (!strncmp("-backing=", argv[arg], 9)) {
+      strcpy(bx_backing_file, &argv[arg][9]);
+      bx_hdimage = 1;
+    }
+    else if (!strcmp("-compress", argv[arg])) {
+      bx_compress = 1;
+    }
     else if (!strcmp("-b", argv[arg])) {
       bx_backup = 1;
     }
@@ -719,6 +1076,22 @@ int parse_cmdline(int argc, char *argv[])
       bx_interactive = 1;
       printf("\nERROR; Filename missing - switching to interactive mode.\n\n");
     }
+    if ((bx_backing_file[0] != 0) && ((bximage_func != BXIMAGE_FUNC_CREATE_IMAGE) ||
+        strcmp(hdmode_choices[bx_imagemode], "qcow2"))) {
+      printf("Option -backing requires -func=create and -imgmode=qcow2\n\n");
+      ret = 0;
+    }
+    if (bx_compress && ((bximage_func != BXIMAGE_FUNC_CONVERT_IMAGE) ||
+        strcmp(hdmode_choices[bx_imagemode], "qcow2"))) {
+      printf("Option -compress requires -func=convert and -imgmode=qcow2\n\n");
+      ret = 0;
+    }
+#if !BX_HAVE_ZLIB
+    if (bx_compress) {
+      printf("Option -compress requires zlib support\n\n");
+      ret = 0;
+    }
+#endif
     if ((bximage_func == BXIMAGE_FUNC_COMMIT_UNDOABLE) && (fnargs == 1)) {
       snprintf(bx_filename_2, 520, "%s%s", bx_filename_1, UNDOABLE_REDOLOG_EXTENSION);
     }
@@ -977,6 +1350,10 @@ int CDECL main(int argc, char *argv[])
         } else {
           int heads = 16, spt = 63;
 
+          if ((bx_hdsize == 0) && (bx_backing_file[0] != 0)) {
+            if (!get_backing_image_size(bx_filename_1, bx_backing_file, &bx_hdsize))
+              fatal("ERROR: cannot open backing file");
+          }
           if (bx_sectsize_val == 512) {
             sprintf(bochsrc_line, "ata0-master: type=disk, path=\"%s\", mode=%s",
                     bx_filename_1, hdmode_choices[bx_imagemode]);
@@ -53,6 +53,7 @@
 #define BXPN_MEM_SIZE                    "memory.standard.ram.guest"
 #define BXPN_HOST_MEM_SIZE               "memory.standard.ram.host"
 #define BXPN_MEM_BLOCK_SIZE              "memory.standard.ram.block_size"
+#define BXPN_MEM_FILE                    "memory.standard.ram.file"
 #define BXPN_ROMIMAGE                    "memory.standard.rom"
 #define BXPN_ROM_PATH                    "memory.standard.rom.file"
 #define BXPN_ROM_ADDRESS                 "memory.standard.rom.address"
@@ -162,6 +163,16 @@
 #define BXPN_PORT_E9_HACK_ALL_RINGS      "misc.port_e9_hack.all_rings"
 #define BXPN_IODEBUG_ALL_RINGS           "misc.iodebug_all_rings"
 #define BXPN_GDBSTUB                     "misc.gdbstub"
+#define BXPN_INSTRUMENT                  "misc.instrument"
+#define BXPN_INSTRUMENT_MODULE           "misc.instrument.module"
+#define BXPN_INSTRUMENT_OPTIONS          "misc.instrument.options"
+#define BXPN_PROFILER                    "misc.profiler"
+#define BXPN_PROFILER_ENABLED            "misc.profiler.enabled"
+#define BXPN_PROFILER_FILE               "misc.profiler.file"
+#define BXPN_PROFILER_FORMAT             "misc.profiler.format"
+#define BXPN_PROFILER_PERIOD             "misc.profiler.period"
+#define BXPN_PROFILER_DEPTH              "misc.profiler.depth"
+#define BXPN_PROFILER_SYMBOLS            "misc.profiler.symbols"
 #define BXPN_LOG_FILENAME                "log.filename"
 #define BXPN_LOG_PREFIX                  "log.prefix"
 #define BXPN_DEBUGGER_LOG_FILENAME       "log.debugger_filename"
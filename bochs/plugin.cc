@@ -1011,6 +1011,9 @@ plugin_t bx_builtin_plugins[] = {
 #if BX_WITH_SDL2
   BUILTIN_GUI_PLUGIN_ENTRY(sdl2),
 #endif
+#if BX_WITH_SHMEM
+  BUILTIN_GUI_PLUGIN_ENTRY(shmem),
+#endif
 #if BX_WITH_TERM
   BUILTIN_GUI_PLUGIN_ENTRY(term),
 #endif
@@ -1135,6 +1138,7 @@ plugin_t bx_builtin_plugins[] = {
   BUILTIN_USB_PLUGIN_ENTRY(usb_msd),
   BUILTIN_USB_PLUGIN_ENTRY(usb_printer),
 #endif
+  BUILTIN_IMG_PLUGIN_ENTRY(qcow2),
   BUILTIN_IMG_PLUGIN_ENTRY(vmware3),
   BUILTIN_IMG_PLUGIN_ENTRY(vmware4),
   BUILTIN_IMG_PLUGIN_ENTRY(vbox),
@@ -228,6 +228,8 @@ extern "C" {
 #define DEV_pci_set_irq(a,b,c) bx_devices.pluginPci2IsaBridge->pci_set_irq(a,b,c)
 #define DEV_pci_set_base_mem(a,b,c,d,e,f) \
   (bx_devices.pci_set_base_mem(a,b,c,d,e,f))
+#define DEV_pci_set_base_mem_da(a,b,c,d,e,f,g) \
+  (bx_devices.pci_set_base_mem(a,b,c,d,e,f,g))
 #define DEV_pci_set_base_io(a,b,c,d,e,f,g,h) \
   (bx_devices.pci_set_base_io(a,b,c,d,e,f,g,h))
 #define DEV_ide_bmdma_present() bx_devices.pluginPciIdeController->bmdma_present()
@@ -247,6 +249,14 @@ extern "C" {
     bx_devices.mem->registerMemoryHandlers(param,rh,wh,b,e)
 #define DEV_unregister_memory_handlers(param,b,e) \
     bx_devices.mem->unregisterMemoryHandlers(param,b,e)
+#define DEV_register_memory_handlers_da(param,rh,wh,da,b,e) \
+    bx_devices.mem->registerMemoryHandlers(param,rh,wh,da,b,e)
+#define DEV_register_write_tracking(b,e) \
+    bx_devices.mem->registerWriteTracking(b,e)
+#define DEV_unregister_write_tracking(h) \
+    bx_devices.mem->unregisterWriteTracking(h)
+#define DEV_get_dirty_pages(h,bitmap) \
+    bx_devices.mem->getDirtyPages(h,bitmap)
 #define DEV_mem_set_memory_type(a,b,c) \
     bx_devices.mem->set_memory_type((memory_area_t)a,b,c)
 #define DEV_mem_set_bios_write(a) bx_devices.mem->set_bios_write(a)
@@ -453,6 +463,7 @@ PLUGIN_ENTRY_FOR_GUI_MODULE(nogui);
 PLUGIN_ENTRY_FOR_GUI_MODULE(rfb);
 PLUGIN_ENTRY_FOR_GUI_MODULE(sdl);
 PLUGIN_ENTRY_FOR_GUI_MODULE(sdl2);
+PLUGIN_ENTRY_FOR_GUI_MODULE(shmem);
 PLUGIN_ENTRY_FOR_GUI_MODULE(term);
 PLUGIN_ENTRY_FOR_GUI_MODULE(vncsrv);
 PLUGIN_ENTRY_FOR_GUI_MODULE(win32);
@@ -485,6 +496,7 @@ PLUGIN_ENTRY_FOR_MODULE(usb_hub);
 PLUGIN_ENTRY_FOR_MODULE(usb_msd);
 PLUGIN_ENTRY_FOR_MODULE(usb_printer);
 // disk image plugins
+PLUGIN_ENTRY_FOR_IMG_MODULE(qcow2);
 PLUGIN_ENTRY_FOR_IMG_MODULE(vmware3);
 PLUGIN_ENTRY_FOR_IMG_MODULE(vmware4);
 PLUGIN_ENTRY_FOR_IMG_MODULE(vbox);
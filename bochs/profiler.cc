@@ -0,0 +1,559 @@
+/////////////////////////////////////////////////////////////////////////
+// $Id$
+/////////////////////////////////////////////////////////////////////////
+//
+//  Copyright (C) 2025  The Bochs Project
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+//
+/////////////////////////////////////////////////////////////////////////
+
+// Sampling guest profiler
+//
+// Every 'period' instructions a timer records the instruction pointer, CR3
+// and CPL of each CPU and walks the guest stack through the frame pointer
+// chain. The simulation thread only copies the values into a lock-free
+// single producer / single consumer queue. A separate thread symbolizes the
+// samples (System.map or ELF symbol tables) and writes them in the folded
+// stack format (flamegraph.pl, speedscope) or in the "perf script" format.
+
+#include "bochs.h"
+#include "param_names.h"
+#include "cpu/cpu.h"
+#include "gui/siminterface.h"
+#include "memory/memory-bochs.h"
+#include "pc_system.h"
+#include "bxthread.h"
+
+#define LOG_THIS profilerlog->
+
+#define BX_PROF_FORMAT_FOLDED 0
+#define BX_PROF_FORMAT_PERF   1
+
+#define BX_PROF_MAX_DEPTH   64
+#define BX_PROF_QUEUE_SIZE  1024
+
+// frames further apart than this end the stack walk
+#define BX_PROF_MAX_FRAME_SIZE  0x100000
+
+typedef struct {
+  Bit64u time;     // emulated time in usec
+  Bit64u cr3;
+  Bit16u cpu;
+  Bit8u cpl;
+  Bit8u halted;
+  unsigned depth;  // valid entries in pc[], pc[0] is the sampled instruction
+  bx_address pc[BX_PROF_MAX_DEPTH+1];
+} bx_prof_sample_t;
+
+typedef struct {
+  Bit64u addr;
+  Bit64u size;     // 0 if unknown (System.map)
+  char *name;
+  const char *file;
+} bx_prof_symbol_t;
+
+typedef struct {
+  char *stack;
+  Bit64u count;
+} bx_prof_stack_t;
+
+static logfunctions *profilerlog;
+
+static bool profiler_active = 0;
+static unsigned format;
+static unsigned max_depth;
+static Bit32u period;
+static FILE *outfile;
+
+// the sample queue, written by the simulation thread only
+static bx_prof_sample_t *queue;
+static volatile Bit32u rpos, wpos;
+static Bit64u samples, dropped;
+
+BX_THREAD_VAR(profiler_thread_var);
+static bx_thread_sem_t profiler_sem;
+static volatile bool thread_stop;
+
+// the data below is used by the profiler thread only
+static bx_prof_symbol_t *symbols;
+static unsigned num_symbols, max_symbols;
+static char **symbol_files;
+static unsigned num_symbol_files;
+
+static bx_prof_stack_t *stacks;
+static unsigned stacks_size, stacks_used;
+
+// little endian field accessors for the ELF reader
+static Bit16u get16(const Bit8u *p) { return p[0] | (p[1] << 8); }
+static Bit32u get32(const Bit8u *p) { return get16(p) | ((Bit32u) get16(p + 2) << 16); }
+static Bit64u get64(const Bit8u *p) { return get32(p) | ((Bit64u) get32(p + 4) << 32); }
+
+static void add_symbol(Bit64u addr, Bit64u size, const char *name, const char *file)
+{
+  if (num_symbols == max_symbols) {
+    max_symbols = max_symbols ? max_symbols * 2 : 4096;
+    symbols = (bx_prof_symbol_t*) realloc(symbols, max_symbols * sizeof(bx_prof_symbol_t));
+  }
+  symbols[num_symbols].addr = addr;
+  symbols[num_symbols].size = size;
+  symbols[num_symbols].name = strdup(name);
+  symbols[num_symbols].file = file;
+  num_symbols++;
+}
+
+static bool read_at(FILE *fp, Bit64u offset, void *buf, size_t len)
+{
+  return !fseek(fp, (long) offset, SEEK_SET) && (fread(buf, 1, len, fp) == len);
+}
+
+// function symbols from the .symtab (or .dynsym) section of an ELF file
+static bool load_elf_symbols(FILE *fp, const char *file)
+{
+  Bit8u ehdr[64];
+
+  if (! read_at(fp, 0, ehdr, sizeof(ehdr)) || ehdr[5] != 1) {
+    BX_ERROR(("%s: only little endian ELF files are supported", file));
+    return 0;
+  }
+  bool elf64 = (ehdr[4] == 2);
+  Bit64u shoff = elf64 ? get64(ehdr + 0x28) : get32(ehdr + 0x20);
+  unsigned shentsize = get16(ehdr + (elf64 ? 0x3a : 0x2e));
+  unsigned shnum = get16(ehdr + (elf64 ? 0x3c : 0x30));
+  if (shoff == 0 || shnum == 0 || shentsize < (elf64 ? 64U : 40U))
+    return 0;
+
+  Bit8u *shdrs = new Bit8u[shnum * shentsize];
+  if (! read_at(fp, shoff, shdrs, shnum * shentsize)) {
+    delete [] shdrs;
+    return 0;
+  }
+
+  // prefer the full symbol table over the dynamic one
+  const Bit8u *symtab = NULL;
+  for (unsigned n=0; n < shnum; n++) {
+    const Bit8u *sh = shdrs + n * shentsize;
+    Bit32u type = get32(sh + 4);
+    if (type == 2 /* SHT_SYMTAB */ || (type == 11 /* SHT_DYNSYM */ && symtab == NULL))
+      symtab = sh;
+  }
+
+  bool ret = 0;
+  if (symtab != NULL) {
+    Bit64u sym_offset = elf64 ? get64(symtab + 0x18) : get32(symtab + 0x10);
+    Bit64u sym_size   = elf64 ? get64(symtab + 0x20) : get32(symtab + 0x14);
+    unsigned link = get32(symtab + (elf64 ? 0x28 : 0x18));
+    const Bit8u *strtab = (link < shnum) ? shdrs + link * shentsize : NULL;
+    if (strtab != NULL) {
+      Bit64u str_offset = elf64 ? get64(strtab + 0x18) : get32(strtab + 0x10);
+      Bit64u str_size   = elf64 ? get64(strtab + 0x20) : get32(strtab + 0x14);
+      Bit8u *syms = new Bit8u[sym_size];
+      char *strs = new char[str_size + 1];
+      if (read_at(fp, sym_offset, syms, sym_size) && read_at(fp, str_offset, strs, str_size)) {
+        strs[str_size] = 0;
+        unsigned entsize = elf64 ? 24 : 16;
+        for (Bit64u off = 0; off + entsize <= sym_size; off += entsize) {
+          const Bit8u *sym = syms + off;
+          Bit32u name = get32(sym);
+          Bit8u info = sym[elf64 ? 4 : 12];
+          Bit16u shndx = get16(sym + (elf64 ? 6 : 14));
+          Bit64u value = elf64 ? get64(sym + 8) : get32(sym + 4);
+          Bit64u size = elf64 ? get64(sym + 16) : get32(sym + 8);
+          // STT_FUNC symbols defined in a section
+          if ((info & 0xf) == 2 && shndx != 0 && value != 0 && name < str_size)
+            add_symbol(value, size, strs + name, file);
+        }
+        ret = 1;
+      }
+      delete [] syms;
+      delete [] strs;
+    }
+  }
+  delete [] shdrs;
+  return ret;
+}
+
+// text symbols from a System.map or 'nm' style file: "address type name"
+static bool load_map_symbols(FILE *fp, const char *file)
+{
+  char line[512], name[512], type;
+  Bit64u addr;
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (sscanf(line, FMT_LL "x %c %511s", &addr, &type, name) != 3)
+      continue;
+    if (type == 't' || type == 'T' || type == 'w' || type == 'W')
+      add_symbol(addr, 0, name, file);
+  }
+  return 1;
+}
+
+static int symbol_compare(const void *a, const void *b)
+{
+  Bit64u addr_a = ((const bx_prof_symbol_t*) a)->addr;
+  Bit64u addr_b = ((const bx_prof_symbol_t*) b)->addr;
+  return (addr_a > addr_b) - (addr_a < addr_b);
+}
+
+// 'list' is a list of System.map / ELF files separated by ';'
+static void load_symbols(const char *list)
+{
+  char *files = strdup(list), *next;
+
+  for (char *path = files; path != NULL; path = next) {
+    next = strchr(path, ';');
+    if (next != NULL)
+      *next++ = 0;
+    if (*path == 0)
+      continue;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+      BX_ERROR(("cannot open symbol file '%s'", path));
+      continue;
+    }
+    // the file name without the directory is used as DSO name in perf output
+    const char *base = strrchr(path, '/');
+#ifdef WIN32
+    if (strrchr(path, '\\') > base)
+      base = strrchr(path, '\\');
+#endif
+    symbol_files = (char**) realloc(symbol_files, (num_symbol_files + 1) * sizeof(char*));
+    char *file = symbol_files[num_symbol_files++] = strdup(base ? base + 1 : path);
+
+    unsigned before = num_symbols;
+    char magic[4];
+    bool ok;
+    if (fread(magic, 1, 4, fp) == 4 && !memcmp(magic, "\177ELF", 4)) {
+      ok = load_elf_symbols(fp, file);
+    } else {
+      rewind(fp);
+      ok = load_map_symbols(fp, file);
+    }
+    fclose(fp);
+    if (ok)
+      BX_INFO(("loaded %u symbols from '%s'", num_symbols - before, path));
+    else
+      BX_ERROR(("failed to read symbols from '%s'", path));
+  }
+  free(files);
+
+  if (num_symbols > 0)
+    qsort(symbols, num_symbols, sizeof(bx_prof_symbol_t), symbol_compare);
+}
+
+static const bx_prof_symbol_t *find_symbol(Bit64u addr)
+{
+  if (num_symbols == 0 || addr < symbols[0].addr)
+    return NULL;
+
+  // last symbol starting at or below 'addr'
+  unsigned lo = 0, hi = num_symbols - 1;
+  while (lo < hi) {
+    unsigned mid = (lo + hi + 1) / 2;
+    if (symbols[mid].addr <= addr)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  const bx_prof_symbol_t *sym = &symbols[lo];
+  if (sym->size != 0 && addr >= sym->addr + sym->size)
+    return NULL;
+  return sym;
+}
+
+// the return addresses point after the call, look up the call instruction
+static const bx_prof_symbol_t *find_frame_symbol(const bx_prof_sample_t *s, unsigned n)
+{
+  return find_symbol(n ? s->pc[n] - 1 : s->pc[n]);
+}
+
+// FNV-1a hash, linear probing
+static bx_prof_stack_t *lookup_stack(const char *stack)
+{
+  Bit32u hash = 2166136261U;
+  for (const char *p = stack; *p; p++)
+    hash = (hash ^ (Bit8u) *p) * 16777619U;
+
+  unsigned idx = hash & (stacks_size - 1);
+  while (stacks[idx].stack != NULL && strcmp(stacks[idx].stack, stack))
+    idx = (idx + 1) & (stacks_size - 1);
+  return &stacks[idx];
+}
+
+static void add_stack(const char *stack)
+{
+  if (2 * (stacks_used + 1) > stacks_size) {
+    bx_prof_stack_t *old = stacks;
+    unsigned old_size = stacks_size;
+    stacks_size = stacks_size ? stacks_size * 2 : 4096;
+    stacks = new bx_prof_stack_t[stacks_size];
+    memset(stacks, 0, stacks_size * sizeof(bx_prof_stack_t));
+    for (unsigned n=0; n < old_size; n++) {
+      if (old[n].stack != NULL)
+        *lookup_stack(old[n].stack) = old[n];
+    }
+    delete [] old;
+  }
+
+  bx_prof_stack_t *entry = lookup_stack(stack);
+  if (entry->stack == NULL) {
+    entry->stack = strdup(stack);
+    entry->count = 0;
+    stacks_used++;
+  }
+  entry->count++;
+}
+
+// one line per distinct stack, frames from the root to the sampled
+// instruction: "[kernel];start_kernel;do_idle 1234"
+static void fold_sample(const bx_prof_sample_t *s)
+{
+  char stack[BX_PROF_MAX_DEPTH * 80 + 64], *p = stack, *end = stack + sizeof(stack);
+
+  if (s->halted) {
+    add_stack("[idle]");
+    return;
+  }
+
+  if (s->cpl == 0)
+    p += snprintf(p, end - p, "[kernel]");
+  else
+    p += snprintf(p, end - p, "[user cr3=" FMT_LL "x]", s->cr3);
+
+  for (int n = s->depth - 1; n >= 0 && p < end; n--) {
+    const bx_prof_symbol_t *sym = find_frame_symbol(s, n);
+    if (sym != NULL)
+      p += snprintf(p, end - p, ";%s", sym->name);
+    else
+      p += snprintf(p, end - p, ";0x" FMT_LL "x", (Bit64u) s->pc[n]);
+  }
+  add_stack(stack);
+}
+
+// the "perf script" text format, as read by stackcollapse-perf.pl and
+// the usual perf viewers; the pid is the page frame number of CR3
+static void print_perf_sample(const bx_prof_sample_t *s)
+{
+  fprintf(outfile, "%s %u [%03u] " FMT_LL "u.%06u: %u instructions:\n",
+          s->halted ? "idle" : (s->cpl == 0 ? "kernel" : "user"),
+          (unsigned) (s->cr3 >> 12), s->cpu, s->time / 1000000,
+          (unsigned) (s->time % 1000000), period);
+  for (unsigned n=0; n < s->depth; n++) {
+    const bx_prof_symbol_t *sym = find_frame_symbol(s, n);
+    if (sym != NULL)
+      fprintf(outfile, "\t" FMT_LL "x %s+0x" FMT_LL "x (%s)\n", (Bit64u) s->pc[n],
+              sym->name, (Bit64u) s->pc[n] - sym->addr, sym->file);
+    else
+      fprintf(outfile, "\t" FMT_LL "x [unknown] ([unknown])\n", (Bit64u) s->pc[n]);
+  }
+  fprintf(outfile, "\n");
+}
+
+static void process_samples(void)
+{
+  while (rpos != wpos) {
+    BX_MEMORY_BARRIER();
+    const bx_prof_sample_t *s = &queue[rpos % BX_PROF_QUEUE_SIZE];
+    if (format == BX_PROF_FORMAT_PERF)
+      print_perf_sample(s);
+    else
+      fold_sample(s);
+    BX_MEMORY_BARRIER();
+    rpos++;
+  }
+}
+
+static BX_THREAD_FUNC(profiler_thread, indata)
+{
+  while (! thread_stop) {
+    bx_wait_sem(&profiler_sem);
+    process_samples();
+  }
+  process_samples();
+  BX_THREAD_EXIT;
+}
+
+// side effect free read of guest memory through the current page tables
+static bool read_linear(BX_CPU_C *cpu, bx_address laddr, unsigned len, Bit8u *buf)
+{
+  while (len > 0) {
+    bx_phy_address paddr;
+    unsigned n = 0x1000 - PAGE_OFFSET(laddr);
+    if (n > len) n = len;
+    if (! cpu->dbg_xlate_linear2phy(laddr, &paddr))
+      return 0;
+    if (! BX_MEM(0)->dbg_fetch_mem(cpu, paddr, n, buf))
+      return 0;
+    laddr += n;
+    buf += n;
+    len -= n;
+  }
+  return 1;
+}
+
+// walk the saved frame pointer chain: [fp] is the caller's frame pointer
+// and [fp+size] the return address
+static unsigned unwind_stack(BX_CPU_C *cpu, bx_address *pc, unsigned depth)
+{
+  unsigned mode = cpu->get_cpu_mode(), size, n = 0;
+  bx_address fp, ss_base, cs_base;
+
+  if (mode == BX_MODE_IA32_REAL || mode == BX_MODE_IA32_V8086)
+    return 0;
+
+#if BX_SUPPORT_X86_64
+  if (mode == BX_MODE_LONG_64) {
+    fp = cpu->get_reg64(BX_64BIT_REG_RBP);
+    size = 8;
+  }
+  else
+#endif
+  {
+    fp = cpu->get_reg32(BX_32BIT_REG_EBP);
+    size = 4;
+  }
+  ss_base = cpu->get_segment_base(BX_SEG_REG_SS);
+  cs_base = cpu->get_segment_base(BX_SEG_REG_CS);
+
+  while (n < depth && fp != 0 && (fp & (size - 1)) == 0) {
+    Bit8u frame[16];
+    if (! read_linear(cpu, ss_base + fp, 2 * size, frame))
+      break;
+    bx_address next_fp = (size == 8) ? get64(frame) : get32(frame);
+    bx_address ret = (size == 8) ? get64(frame + 8) : get32(frame + 4);
+    if (ret == 0)
+      break;
+    pc[n++] = cs_base + ret;
+    // the stack grows down, the caller's frame must be above this one
+    if (next_fp <= fp || next_fp - fp > BX_PROF_MAX_FRAME_SIZE)
+      break;
+    fp = next_fp;
+  }
+  return n;
+}
+
+static void profiler_timer_handler(void *this_ptr)
+{
+  Bit64u time = bx_pc_system.time_usec();
+
+  for (unsigned n=0; n < BX_SMP_PROCESSORS; n++) {
+    if (wpos - rpos == BX_PROF_QUEUE_SIZE) {
+      // the profiler thread cannot keep up, drop the sample
+      dropped++;
+      continue;
+    }
+    BX_CPU_C *cpu = BX_CPU(n);
+    bx_prof_sample_t *s = &queue[wpos % BX_PROF_QUEUE_SIZE];
+    s->time = time;
+    s->cr3 = cpu->cr3;
+    s->cpu = n;
+    s->cpl = cpu->get_cpl();
+    s->halted = (cpu->activity_state != BX_CPU_C::BX_ACTIVITY_STATE_ACTIVE);
+    s->depth = 0;
+    if (! s->halted) {
+      s->pc[0] = cpu->get_laddr(BX_SEG_REG_CS, cpu->get_instruction_pointer());
+      s->depth = 1 + unwind_stack(cpu, &s->pc[1], max_depth);
+    }
+    BX_MEMORY_BARRIER();
+    wpos++;
+    samples++;
+    // wake up the profiler thread every quarter of the queue
+    if ((wpos % (BX_PROF_QUEUE_SIZE / 4)) == 0)
+      bx_set_sem(&profiler_sem);
+  }
+}
+
+void bx_profiler_init(void)
+{
+  static const char *format_names[] = { "folded", "perf", NULL };
+
+  if (profilerlog == NULL) {
+    profilerlog = new logfunctions();
+    profilerlog->put("PROF");
+  }
+
+  if (! SIM->get_param_bool(BXPN_PROFILER_ENABLED)->get())
+    return;
+
+  const char *filename = SIM->get_param_string(BXPN_PROFILER_FILE)->getptr();
+  outfile = fopen(filename, "w");
+  if (outfile == NULL) {
+    BX_ERROR(("cannot create profile '%s', profiler disabled", filename));
+    return;
+  }
+
+  format = SIM->get_param_enum(BXPN_PROFILER_FORMAT)->get();
+  max_depth = SIM->get_param_num(BXPN_PROFILER_DEPTH)->get();
+  if (max_depth > BX_PROF_MAX_DEPTH)
+    max_depth = BX_PROF_MAX_DEPTH;
+  load_symbols(SIM->get_param_string(BXPN_PROFILER_SYMBOLS)->getptr());
+
+  queue = new bx_prof_sample_t[BX_PROF_QUEUE_SIZE];
+  rpos = wpos = 0;
+  samples = dropped = 0;
+  thread_stop = 0;
+  bx_create_sem(&profiler_sem);
+  BX_THREAD_CREATE(profiler_thread, NULL, profiler_thread_var);
+
+  period = SIM->get_param_num(BXPN_PROFILER_PERIOD)->get();
+  bx_pc_system.register_timer_ticks(NULL, profiler_timer_handler, period, 1, 1, "profiler");
+  profiler_active = 1;
+
+  BX_INFO(("sampling every %u instructions, stack depth %u, %s format to '%s'",
+           period, max_depth, format_names[format], filename));
+}
+
+void bx_profiler_exit(void)
+{
+  if (! profiler_active)
+    return;
+  profiler_active = 0;
+
+  // the timer is removed by bx_pc_system.exit()
+  thread_stop = 1;
+  bx_set_sem(&profiler_sem);
+  BX_THREAD_JOIN(profiler_thread_var);
+  bx_destroy_sem(&profiler_sem);
+
+  if (format == BX_PROF_FORMAT_FOLDED) {
+    for (unsigned n=0; n < stacks_size; n++) {
+      if (stacks[n].stack != NULL) {
+        fprintf(outfile, "%s " FMT_LL "u\n", stacks[n].stack, stacks[n].count);
+        free(stacks[n].stack);
+      }
+    }
+    delete [] stacks;
+    stacks = NULL;
+    stacks_size = stacks_used = 0;
+  }
+  fclose(outfile);
+  outfile = NULL;
+
+  BX_INFO((FMT_LL "u samples written, " FMT_LL "u dropped", samples, dropped));
+
+  for (unsigned n=0; n < num_symbols; n++)
+    free(symbols[n].name);
+  free(symbols);
+  symbols = NULL;
+  num_symbols = max_symbols = 0;
+  for (unsigned n=0; n < num_symbol_files; n++)
+    free(symbol_files[n]);
+  free(symbol_files);
+  symbol_files = NULL;
+  num_symbol_files = 0;
+
+  delete [] queue;
+  queue = NULL;
+}